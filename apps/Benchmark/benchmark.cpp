@@ -0,0 +1,926 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @file
+ * Command line benchmarks for the facade.
+ *
+ * Each benchmark is a mode selected with --mode and prints its results as a table on stdout.
+ */
+
+#include <stdlib.h>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <fstream>
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <boost/bind.hpp>
+#include <boost/atomic.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+#include <boost/program_options.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <utFacade/AdvancedFacade.h>
+#include <utFacade/FacadePool.h>
+#include <utFacade/TexturePacking.h>
+#include <utFacade/BulkCopy.h>
+#include <utFacade/Config.h>
+#ifdef HAVE_OPENCV
+#include <utFacade/ImageEncoder.h>
+#endif
+#include <utUtil/Exception.h>
+#include <utUtil/Logging.h>
+#include <utUtil/OS.h>
+
+#include "StandInServer.h"
+
+using namespace Ubitrack;
+
+
+namespace {
+
+/** command line options shared by all benchmarks */
+struct BenchmarkOptions
+{
+	std::string sComponentsPath;
+	std::string sUtqlFile;
+	std::string sSinkName;
+	unsigned int nFacades;
+	unsigned int nDuration;
+	unsigned int nCycles;
+	std::string sUpdateFile;
+	unsigned int nRequests;
+	unsigned short port;
+	unsigned int nWidth;
+	unsigned int nHeight;
+	unsigned int nFrames;
+	unsigned int nWorkers;
+	int quality;
+	unsigned int nElements;
+};
+
+
+/** counts events arriving at an application push sink */
+struct EventCounter
+{
+	EventCounter()
+		: nEvents( 0 )
+	{}
+
+	void receive( const Measurement::Pose& )
+	{ nEvents.fetch_add( 1, boost::memory_order_relaxed ); }
+
+	boost::atomic< unsigned long long > nEvents;
+};
+
+
+/** seconds elapsed since a start time */
+double secondsSince( const boost::posix_time::ptime& start )
+{
+	return ( boost::posix_time::microsec_clock::universal_time() - start ).total_microseconds() * 1e-6;
+}
+
+
+/**
+ * Runs the same dataflow in 1, 2, 4, ... facades at the same time and reports the
+ * throughput at a pose push sink, to see how the process scales with the number of
+ * concurrently hosted dataflows.
+ */
+int runFacadeScaling( const BenchmarkOptions& options )
+{
+	if ( options.sUtqlFile.empty() || options.sSinkName.empty() )
+	{
+		std::cerr << "facade-scaling needs --utql and --sink (name of an ApplicationPushSinkPose)" << std::endl;
+		return 1;
+	}
+
+	if ( options.nFacades < 1 )
+	{
+		std::cerr << "facade-scaling needs at least one facade (--facades)" << std::endl;
+		return 1;
+	}
+
+	std::cout << std::setw( 8 ) << "facades" << std::setw( 12 ) << "create [s]" << std::setw( 14 ) << "events/s"
+		<< std::setw( 18 ) << "events/s/facade" << std::setw( 13 ) << "destroy [s]" << std::endl;
+
+	std::vector< unsigned int > counts;
+	for ( unsigned int n = 1; n < options.nFacades; n *= 2 )
+		counts.push_back( n );
+	counts.push_back( options.nFacades );
+
+	for ( std::vector< unsigned int >::iterator itCount = counts.begin(); itCount != counts.end(); itCount++ )
+	{
+		Facade::FacadePool pool( options.sComponentsPath );
+
+		// create all facades concurrently
+		std::map< std::string, std::string > stations;
+		for ( unsigned int i = 0; i < *itCount; i++ )
+		{
+			std::ostringstream name;
+			name << "station" << i;
+			stations[ name.str() ] = options.sUtqlFile;
+		}
+
+		boost::posix_time::ptime createStart( boost::posix_time::microsec_clock::universal_time() );
+		pool.createAll( stations, false );
+		double createTime = secondsSince( createStart );
+
+		// attach counters and start
+		std::vector< boost::shared_ptr< EventCounter > > counters;
+		std::vector< std::string > names( pool.names() );
+		for ( std::vector< std::string >::iterator it = names.begin(); it != names.end(); it++ )
+		{
+			boost::shared_ptr< EventCounter > pCounter( new EventCounter );
+			counters.push_back( pCounter );
+			boost::shared_ptr< Facade::AdvancedFacade > pFacade( pool.get( *it ) );
+			pFacade->setCallback< Measurement::Pose >( options.sSinkName, boost::bind( &EventCounter::receive, pCounter.get(), _1 ) );
+			pFacade->startDataflow();
+		}
+
+		boost::posix_time::ptime runStart( boost::posix_time::microsec_clock::universal_time() );
+		Util::sleep( options.nDuration * 1000 );
+		double runTime = secondsSince( runStart );
+
+		unsigned long long nTotal = 0;
+		for ( std::vector< boost::shared_ptr< EventCounter > >::iterator it = counters.begin(); it != counters.end(); it++ )
+			nTotal += (*it)->nEvents.load();
+
+		// destroy all facades concurrently
+		boost::posix_time::ptime destroyStart( boost::posix_time::microsec_clock::universal_time() );
+		pool.destroyAll();
+		double destroyTime = secondsSince( destroyStart );
+
+		double rate = nTotal / runTime;
+		std::cout << std::setw( 8 ) << *itCount << std::setw( 12 ) << std::fixed << std::setprecision( 3 ) << createTime
+			<< std::setw( 14 ) << std::setprecision( 0 ) << rate << std::setw( 18 ) << rate / *itCount
+			<< std::setw( 13 ) << std::setprecision( 3 ) << destroyTime << std::endl;
+	}
+
+	return 0;
+}
+
+/** duration of suspend and resume calls, and time until events arrive again */
+struct CycleTimes
+{
+	CycleTimes()
+		: suspend( 0 )
+		, resume( 0 )
+		, firstEvent( 0 )
+		, maxFirstEvent( 0 )
+	{}
+
+	double suspend;
+	double resume;
+	double firstEvent;
+	double maxFirstEvent;
+};
+
+
+/**
+ * Interrupts and continues the dataflow \c nCycles times, either with pause/resume or with a full
+ * stop/start, and measures the calls and the time until the next event arrives at the sink.
+ */
+CycleTimes measureCycles( Facade::AdvancedFacade& facade, EventCounter& counter, bool bPause, unsigned int nCycles )
+{
+	CycleTimes times;
+	for ( unsigned int i = 0; i < nCycles; i++ )
+	{
+		boost::posix_time::ptime suspendStart( boost::posix_time::microsec_clock::universal_time() );
+		if ( bPause )
+			facade.pause();
+		else
+			facade.stopDataflow();
+		times.suspend += secondsSince( suspendStart );
+
+		// let events pile up, as they would during a reconfiguration
+		Util::sleep( 50 );
+
+		unsigned long long nBefore = counter.nEvents.load();
+		boost::posix_time::ptime resumeStart( boost::posix_time::microsec_clock::universal_time() );
+		if ( bPause )
+			facade.resume();
+		else
+			facade.startDataflow();
+		times.resume += secondsSince( resumeStart );
+
+		while ( counter.nEvents.load() == nBefore && secondsSince( resumeStart ) < 5.0 )
+			boost::this_thread::yield();
+		double firstEvent = secondsSince( resumeStart );
+		times.firstEvent += firstEvent;
+		times.maxFirstEvent = std::max( times.maxFirstEvent, firstEvent );
+	}
+
+	times.suspend /= nCycles;
+	times.resume /= nCycles;
+	times.firstEvent /= nCycles;
+	return times;
+}
+
+
+/**
+ * Compares pause/resume with a full stopDataflow/startDataflow cycle.
+ */
+int runRestart( const BenchmarkOptions& options )
+{
+	if ( options.sUtqlFile.empty() || options.sSinkName.empty() )
+	{
+		std::cerr << "restart needs --utql and --sink (name of an ApplicationPushSinkPose)" << std::endl;
+		return 1;
+	}
+
+	Facade::AdvancedFacade facade( options.sComponentsPath );
+	facade.loadDataflow( options.sUtqlFile );
+
+	EventCounter counter;
+	facade.setCallback< Measurement::Pose >( options.sSinkName, boost::bind( &EventCounter::receive, &counter, _1 ) );
+	facade.startDataflow();
+	Util::sleep( 1000 );
+
+	unsigned int nCycles = std::max( options.nCycles, 1u );
+	CycleTimes restart( measureCycles( facade, counter, false, nCycles ) );
+	CycleTimes pause( measureCycles( facade, counter, true, nCycles ) );
+
+	boost::posix_time::ptime drainStart( boost::posix_time::microsec_clock::universal_time() );
+	bool bDrained = facade.stop( 1000 );
+	double drainTime = secondsSince( drainStart );
+
+	std::cout << std::setw( 14 ) << "method" << std::setw( 16 ) << "suspend [ms]" << std::setw( 15 ) << "resume [ms]"
+		<< std::setw( 20 ) << "first event [ms]" << std::setw( 18 ) << "max first [ms]" << std::endl;
+	std::cout << std::fixed << std::setprecision( 3 );
+	std::cout << std::setw( 14 ) << "stop/start" << std::setw( 16 ) << restart.suspend * 1e3 << std::setw( 15 ) << restart.resume * 1e3
+		<< std::setw( 20 ) << restart.firstEvent * 1e3 << std::setw( 18 ) << restart.maxFirstEvent * 1e3 << std::endl;
+	std::cout << std::setw( 14 ) << "pause/resume" << std::setw( 16 ) << pause.suspend * 1e3 << std::setw( 15 ) << pause.resume * 1e3
+		<< std::setw( 20 ) << pause.firstEvent * 1e3 << std::setw( 18 ) << pause.maxFirstEvent * 1e3 << std::endl;
+	std::cout << std::endl << "drain-aware stop: " << drainTime * 1e3 << "ms" << ( bDrained ? "" : " (timed out)" ) << std::endl;
+
+	return 0;
+}
+
+/** reads a whole file */
+std::string readFile( const std::string& sFile )
+{
+	std::ifstream stream( sFile.c_str(), std::ios::in | std::ios::binary );
+	if ( !stream )
+		UBITRACK_THROW( "Cannot open " + sFile );
+
+	std::ostringstream contents;
+	contents << stream.rdbuf();
+	return contents.str();
+}
+
+
+/** answers requests alternately with each of a list of UTQL responses */
+class CannedResponder
+{
+public:
+	CannedResponder( const std::vector< std::string >& responses )
+		: m_responses( responses )
+		, m_nNext( 0 )
+	{}
+
+	std::string operator()( const std::string& )
+	{ return m_responses[ m_nNext.fetch_add( 1 ) % m_responses.size() ]; }
+
+protected:
+	std::vector< std::string > m_responses;
+	boost::atomic< unsigned long > m_nNext;
+};
+
+
+/** response files given on the command line, --update is optional */
+std::vector< std::string > loadResponses( const BenchmarkOptions& options )
+{
+	std::vector< std::string > responses;
+	responses.push_back( readFile( options.sUtqlFile ) );
+	if ( !options.sUpdateFile.empty() )
+		responses.push_back( readFile( options.sUpdateFile ) );
+	return responses;
+}
+
+
+/** collects the round trip times of asynchronous server requests */
+class ResponseTracker
+{
+public:
+	ResponseTracker()
+		: m_nErrors( 0 )
+	{}
+
+	/** callback for \\c AdvancedFacade::sendUtqlToServerAsync, bind the send time */
+	void done( boost::posix_time::ptime sendTime, unsigned int, const std::string& sError )
+	{
+		double latency = secondsSince( sendTime );
+		boost::mutex::scoped_lock l( m_mutex );
+		m_latencies.push_back( latency );
+		if ( !sError.empty() )
+			m_nErrors++;
+		m_changed.notify_all();
+	}
+
+	/** waits until \\c n responses have arrived in total, returns false on timeout */
+	bool waitFor( std::size_t n, unsigned int timeout )
+	{
+		boost::system_time deadline( boost::get_system_time() + boost::posix_time::seconds( timeout ) );
+		boost::mutex::scoped_lock l( m_mutex );
+		while ( m_latencies.size() < n )
+			if ( !m_changed.timed_wait( l, deadline ) )
+				return m_latencies.size() >= n;
+		return true;
+	}
+
+	/** returns the collected latencies and forgets them */
+	std::vector< double > take( unsigned long& nErrors )
+	{
+		boost::mutex::scoped_lock l( m_mutex );
+		std::vector< double > latencies;
+		latencies.swap( m_latencies );
+		nErrors = m_nErrors;
+		m_nErrors = 0;
+		return latencies;
+	}
+
+protected:
+	std::vector< double > m_latencies;
+	unsigned long m_nErrors;
+	boost::mutex m_mutex;
+	boost::condition_variable m_changed;
+};
+
+
+/** prints one row of the reconfiguration table, latencies in seconds */
+void printLatencies( const std::string& sPhase, std::vector< double > latencies, unsigned long nErrors, double totalTime )
+{
+	std::cout << std::setw( 12 ) << sPhase << std::setw( 10 ) << latencies.size() << std::setw( 8 ) << nErrors;
+	if ( latencies.empty() )
+	{
+		std::cout << std::endl;
+		return;
+	}
+
+	std::sort( latencies.begin(), latencies.end() );
+	double sum = 0;
+	for ( std::vector< double >::iterator it = latencies.begin(); it != latencies.end(); it++ )
+		sum += *it;
+
+	std::cout << std::fixed << std::setprecision( 3 )
+		<< std::setw( 12 ) << sum / latencies.size() * 1e3
+		<< std::setw( 12 ) << latencies[ latencies.size() / 2 ] * 1e3
+		<< std::setw( 12 ) << latencies[ std::min( latencies.size() - 1, latencies.size() * 99 / 100 ) ] * 1e3
+		<< std::setw( 12 ) << latencies.back() * 1e3
+		<< std::setw( 12 ) << std::setprecision( 0 ) << latencies.size() / totalTime << std::endl;
+}
+
+
+/** the request sent for each update. The stand-in server ignores its contents */
+const char* g_reconfigurationRequest = "<UTQLRequest></UTQLRequest>";
+
+
+/**
+ * Measures end-to-end reconfiguration through the client-server path against a local
+ * stand-in server: round trip of single requests, throughput of pipelined requests, and
+ * recovery after the server drops the connection.
+ *
+ * Each response replaces the running dataflow with the --utql file, alternating with the
+ * --update file if given, so the figures include applying the patch to the running dataflow.
+ */
+int runReconfiguration( const BenchmarkOptions& options )
+{
+	if ( options.sUtqlFile.empty() )
+	{
+		std::cerr << "reconfiguration needs --utql (UTQL response sent by the stand-in server), optionally --update" << std::endl;
+		return 1;
+	}
+
+	CannedResponder responder( loadResponses( options ) );
+	Testing::StandInServer server( boost::ref( responder ), options.port );
+
+	Facade::AdvancedFacade facade( options.sComponentsPath );
+	facade.connectToServer( server.address() );
+	facade.startDataflow();
+
+	ResponseTracker tracker;
+	unsigned int nRequests = std::max( options.nRequests, 1u );
+	unsigned long nErrors;
+
+	// the first response builds the dataflow, which is not what we want to measure
+	facade.sendUtqlToServerAsync( g_reconfigurationRequest, boost::bind( &ResponseTracker::done, &tracker,
+		boost::posix_time::microsec_clock::universal_time(), _1, _2 ) );
+	if ( !tracker.waitFor( 1, 30 ) )
+	{
+		std::cerr << "No response from the stand-in server" << std::endl;
+		return 1;
+	}
+	tracker.take( nErrors );
+
+	std::cout << std::setw( 12 ) << "phase" << std::setw( 10 ) << "requests" << std::setw( 8 ) << "errors"
+		<< std::setw( 12 ) << "mean [ms]" << std::setw( 12 ) << "p50 [ms]" << std::setw( 12 ) << "p99 [ms]"
+		<< std::setw( 12 ) << "max [ms]" << std::setw( 12 ) << "updates/s" << std::endl;
+
+	// one request at a time
+	boost::posix_time::ptime start( boost::posix_time::microsec_clock::universal_time() );
+	for ( unsigned int i = 0; i < nRequests; i++ )
+	{
+		facade.sendUtqlToServerAsync( g_reconfigurationRequest, boost::bind( &ResponseTracker::done, &tracker,
+			boost::posix_time::microsec_clock::universal_time(), _1, _2 ) );
+		tracker.waitFor( i + 1, 30 );
+	}
+	double totalTime = secondsSince( start );
+	std::vector< double > latencies( tracker.take( nErrors ) );
+	printLatencies( "sequential", latencies, nErrors, totalTime );
+
+	// all requests at once
+	start = boost::posix_time::microsec_clock::universal_time();
+	for ( unsigned int i = 0; i < nRequests; i++ )
+		facade.sendUtqlToServerAsync( g_reconfigurationRequest, boost::bind( &ResponseTracker::done, &tracker,
+			boost::posix_time::microsec_clock::universal_time(), _1, _2 ) );
+	tracker.waitFor( nRequests, 60 );
+	totalTime = secondsSince( start );
+	latencies = tracker.take( nErrors );
+	printLatencies( "pipelined", latencies, nErrors, totalTime );
+
+	// the request is queued while the connection is down and repeated after reconnecting
+	start = boost::posix_time::microsec_clock::universal_time();
+	server.dropConnections();
+	while ( facade.isConnectedToServer() && secondsSince( start ) < 5.0 )
+		boost::this_thread::yield();
+	facade.sendUtqlToServerAsync( g_reconfigurationRequest, boost::bind( &ResponseTracker::done, &tracker, start, _1, _2 ) );
+	bool bRecovered = tracker.waitFor( 1, 30 );
+	latencies = tracker.take( nErrors );
+	printLatencies( "reconnect", latencies, nErrors, secondsSince( start ) );
+
+	std::cout << std::endl << "server answered " << server.requestCount() << " requests" << std::endl;
+	if ( !bRecovered )
+		std::cout << "no response after dropping the connection" << std::endl;
+
+	facade.disconnectFromServer();
+	facade.stopDataflow();
+	return 0;
+}
+
+
+/**
+ * Runs the stand-in server alone for --duration seconds, to connect other applications to it.
+ */
+int runStandInServer( const BenchmarkOptions& options )
+{
+	if ( options.sUtqlFile.empty() )
+	{
+		std::cerr << "stand-in-server needs --utql (UTQL response sent for each request), optionally --update" << std::endl;
+		return 1;
+	}
+
+	CannedResponder responder( loadResponses( options ) );
+	Testing::StandInServer server( boost::ref( responder ), options.port );
+	std::cout << "stand-in server listening on " << server.address() << " for " << options.nDuration << "s" << std::endl;
+
+	Util::sleep( options.nDuration * 1000 );
+
+	std::cout << "answered " << server.requestCount() << " requests" << std::endl;
+	return 0;
+}
+
+/** the per-pixel loop the C# bindings used before packARGB32, as the baseline */
+void packARGB32Legacy( const unsigned char* src, int widthStep, int width, int height, unsigned int* dst, int texWidth, unsigned char alpha )
+{
+	unsigned int a = alpha;
+	a = a << 24;
+	for ( int i = 0; i < height; i++ )
+	{
+		unsigned int* row = dst + i * texWidth;
+		const unsigned char* p = src + i * widthStep;
+		for ( int j = 0; j < width; j++ )
+		{
+			unsigned int r = *p++;
+			unsigned int g = *p++;
+			unsigned int b = *p++;
+			*row++ = a | r << 16 | g << 8 | b;
+		}
+	}
+}
+
+
+/** prints one row of the texture packing table */
+void printPackingResult( const std::string& sMethod, double seconds, unsigned int nFrames, unsigned long long nPixels, double baseline )
+{
+	double frameTime = seconds / nFrames;
+	std::cout << std::setw( 16 ) << sMethod << std::fixed << std::setprecision( 3 ) << std::setw( 12 ) << frameTime * 1e3
+		<< std::setw( 12 ) << std::setprecision( 0 ) << nPixels / frameTime * 1e-6
+		<< std::setw( 10 ) << std::setprecision( 2 ) << baseline / frameTime << std::endl;
+}
+
+
+/**
+ * Compares the ARGB32 texture packing kernels with the former scalar loop of the C# bindings
+ * on a synthetic RGB image.
+ */
+int runTexturePacking( const BenchmarkOptions& options )
+{
+	int width = options.nWidth;
+	int height = options.nHeight;
+	unsigned int nFrames = std::max( options.nFrames, 1u );
+	unsigned long long nPixels = (unsigned long long)width * height;
+
+	// rows padded to 4 bytes, as in most camera images
+	int widthStep = ( width * 3 + 3 ) & ~3;
+	std::vector< unsigned char > image( std::size_t( widthStep ) * height );
+	for ( std::size_t i = 0; i < image.size(); i++ )
+		image[ i ] = static_cast< unsigned char >( i * 7919 );
+	std::vector< unsigned int > texture( nPixels );
+
+	std::cout << width << "x" << height << " RGB, " << nFrames << " frames, best kernel: " << Facade::texturePackingKernel() << std::endl;
+	std::cout << std::setw( 16 ) << "method" << std::setw( 12 ) << "frame [ms]" << std::setw( 12 ) << "MPixel/s" << std::setw( 10 ) << "speedup" << std::endl;
+
+	boost::posix_time::ptime start( boost::posix_time::microsec_clock::universal_time() );
+	for ( unsigned int i = 0; i < nFrames; i++ )
+		packARGB32Legacy( &image[ 0 ], widthStep, width, height, &texture[ 0 ], width, 255 );
+	double baseline = secondsSince( start ) / nFrames;
+	printPackingResult( "legacy loop", baseline * nFrames, nFrames, nPixels, baseline );
+
+	const char* kernels[] = { "scalar", "ssse3", "avx2" };
+	for ( unsigned int k = 0; k < sizeof( kernels ) / sizeof( kernels[ 0 ] ); k++ )
+	{
+		if ( !Facade::setTexturePackingKernel( kernels[ k ] ) )
+		{
+			std::cout << std::setw( 16 ) << kernels[ k ] << "  not supported" << std::endl;
+			continue;
+		}
+
+		for ( int parallel = 0; parallel < 2; parallel++ )
+		{
+			start = boost::posix_time::microsec_clock::universal_time();
+			for ( unsigned int i = 0; i < nFrames; i++ )
+				Facade::packARGB32( &image[ 0 ], widthStep, width, height, Facade::TEXTURE_RGB, 8, &texture[ 0 ], width * 4, 255, false, parallel != 0 );
+			printPackingResult( std::string( kernels[ k ] ) + ( parallel ? " threads" : "" ), secondsSince( start ), nFrames, nPixels, baseline );
+		}
+	}
+
+	Facade::setTexturePackingKernel( 0 );
+	return 0;
+}
+
+
+/** element access as generated by SWIG's %array_class, one native call per double */
+struct DoubleArrayAccess
+{
+	static void setitem( double* array, int index, double value )
+	{ array[ index ] = value; }
+};
+
+/** called through a volatile pointer, so that it is not inlined, like a P/Invoke call */
+void ( * volatile g_setitem )( double*, int, double ) = &DoubleArrayAccess::setitem;
+
+
+/** prints one row of the bulk copy table */
+void printCopyResult( const std::string& sMethod, double seconds, unsigned int nFrames, unsigned long long nValues, double baseline )
+{
+	double frameTime = seconds / nFrames;
+	std::cout << std::setw( 24 ) << sMethod << std::fixed << std::setprecision( 3 ) << std::setw( 12 ) << frameTime * 1e6
+		<< std::setw( 12 ) << std::setprecision( 1 ) << nValues / frameTime * 1e-6
+		<< std::setw( 10 ) << std::setprecision( 2 ) << baseline / frameTime << std::endl;
+}
+
+
+/**
+ * Compares copying position lists, pose lists and matrices element by element, as the C#
+ * bindings do through doubleArrayClass, with the bulk copies of BulkCopy.h, which fill a pinned
+ * array in one call. Images are packed into a texture by the former loop of the C# bindings and
+ * by copyImageARGB32.
+ */
+int runBulkCopy( const BenchmarkOptions& options )
+{
+	unsigned int nFrames = std::max( options.nFrames, 1u ) * 100;
+	std::size_t nElements = std::max( options.nElements, 1u );
+
+	Facade::SimplePositionList3D positions;
+	Facade::SimpleErrorPositionList3D errorPositions;
+	positions.values.resize( nElements );
+	errorPositions.values.resize( nElements );
+	for ( std::size_t i = 0; i < nElements; i++ )
+	{
+		positions.values[ i ].x = errorPositions.values[ i ].x = i * 0.1;
+		positions.values[ i ].y = errorPositions.values[ i ].y = i * 0.2;
+		positions.values[ i ].z = errorPositions.values[ i ].z = i * 0.3;
+		for ( int j = 0; j < 9; j++ )
+			errorPositions.values[ i ].covariance[ j ] = j;
+	}
+	typedef Facade::SimpleMatrix3x4 M;
+	double M::* const matrixElements[ 12 ] = { &M::e11, &M::e12, &M::e13, &M::e14, &M::e21, &M::e22, &M::e23, &M::e24, &M::e31, &M::e32, &M::e33, &M::e34 };
+
+	std::vector< Facade::SimplePose > poses( nElements );
+	std::vector< Facade::SimpleMatrix3x4 > matrices( nElements );
+	std::vector< std::vector< double > > poseValues( nElements, std::vector< double >( 7, 0.0 ) );
+	for ( std::size_t i = 0; i < nElements; i++ )
+	{
+		Facade::SimplePose& p( poses[ i ] );
+		p.tx = poseValues[ i ][ 0 ] = i * 0.1;
+		p.ty = poseValues[ i ][ 1 ] = i * 0.2;
+		p.tz = poseValues[ i ][ 2 ] = i * 0.3;
+		p.rx = p.ry = p.rz = 0.0;
+		p.rw = poseValues[ i ][ 6 ] = 1.0;
+
+		for ( int j = 0; j < 12; j++ )
+			matrices[ i ].*matrixElements[ j ] = i + j * 0.1;
+	}
+	std::vector< double > buffer( nElements * 12 );
+
+	std::cout << nElements << " elements, " << nFrames << " copies per method" << std::endl;
+	std::cout << std::setw( 24 ) << "method" << std::setw( 12 ) << "copy [us]" << std::setw( 12 ) << "Mdouble/s" << std::setw( 10 ) << "speedup" << std::endl;
+
+	// 3D positions
+	boost::posix_time::ptime start( boost::posix_time::microsec_clock::universal_time() );
+	for ( unsigned int f = 0; f < nFrames; f++ )
+		for ( std::size_t i = 0; i < nElements; i++ )
+		{
+			const SimplePosition3DValue& v( positions.values[ i ] );
+			g_setitem( &buffer[ 0 ], int( 3 * i ), v.x );
+			g_setitem( &buffer[ 0 ], int( 3 * i + 1 ), v.y );
+			g_setitem( &buffer[ 0 ], int( 3 * i + 2 ), v.z );
+		}
+	double baseline = secondsSince( start ) / nFrames;
+	printCopyResult( "positions per element", baseline * nFrames, nFrames, nElements * 3, baseline );
+
+	start = boost::posix_time::microsec_clock::universal_time();
+	for ( unsigned int f = 0; f < nFrames; f++ )
+		Facade::copyPositionList( positions, &buffer[ 0 ], nElements );
+	printCopyResult( "positions bulk", secondsSince( start ), nFrames, nElements * 3, baseline );
+
+	// 3D positions with covariance
+	start = boost::posix_time::microsec_clock::universal_time();
+	for ( unsigned int f = 0; f < nFrames; f++ )
+		for ( std::size_t i = 0; i < nElements; i++ )
+		{
+			const SimpleErrorPosition3DValue& v( errorPositions.values[ i ] );
+			g_setitem( &buffer[ 0 ], int( 12 * i ), v.x );
+			g_setitem( &buffer[ 0 ], int( 12 * i + 1 ), v.y );
+			g_setitem( &buffer[ 0 ], int( 12 * i + 2 ), v.z );
+			for ( int j = 0; j < 9; j++ )
+				g_setitem( &buffer[ 0 ], int( 12 * i + 3 + j ), v.covariance[ j ] );
+		}
+	baseline = secondsSince( start ) / nFrames;
+	printCopyResult( "error positions per elem", baseline * nFrames, nFrames, nElements * 12, baseline );
+
+	start = boost::posix_time::microsec_clock::universal_time();
+	for ( unsigned int f = 0; f < nFrames; f++ )
+		Facade::copyPositionList( errorPositions, &buffer[ 0 ], nElements );
+	printCopyResult( "error positions bulk", secondsSince( start ), nFrames, nElements * 12, baseline );
+
+	// poses of a pose list
+	start = boost::posix_time::microsec_clock::universal_time();
+	for ( unsigned int f = 0; f < nFrames; f++ )
+		for ( std::size_t i = 0; i < nElements; i++ )
+		{
+			const Facade::SimplePose& p( poses[ i ] );
+			g_setitem( &buffer[ 0 ], int( 7 * i ), p.tx );
+			g_setitem( &buffer[ 0 ], int( 7 * i + 1 ), p.ty );
+			g_setitem( &buffer[ 0 ], int( 7 * i + 2 ), p.tz );
+			g_setitem( &buffer[ 0 ], int( 7 * i + 3 ), p.rx );
+			g_setitem( &buffer[ 0 ], int( 7 * i + 4 ), p.ry );
+			g_setitem( &buffer[ 0 ], int( 7 * i + 5 ), p.rz );
+			g_setitem( &buffer[ 0 ], int( 7 * i + 6 ), p.rw );
+		}
+	baseline = secondsSince( start ) / nFrames;
+	printCopyResult( "poses per element", baseline * nFrames, nFrames, nElements * 7, baseline );
+
+#ifdef ENABLE_BASICFACADE
+	Facade::BasicPoseListMeasurement poseList( 0, poseValues );
+	start = boost::posix_time::microsec_clock::universal_time();
+	for ( unsigned int f = 0; f < nFrames; f++ )
+		Facade::copyPoseList( poseList, &buffer[ 0 ], nElements );
+	printCopyResult( "pose list bulk", secondsSince( start ), nFrames, nElements * 7, baseline );
+#endif
+
+	// 3x4 matrices, one copy per matrix
+	start = boost::posix_time::microsec_clock::universal_time();
+	for ( unsigned int f = 0; f < nFrames; f++ )
+		for ( std::size_t i = 0; i < nElements; i++ )
+		{
+			for ( int j = 0; j < 12; j++ )
+				g_setitem( &buffer[ 0 ], int( 12 * i + j ), matrices[ i ].*matrixElements[ j ] );
+		}
+	baseline = secondsSince( start ) / nFrames;
+	printCopyResult( "3x4 matrices per element", baseline * nFrames, nFrames, nElements * 12, baseline );
+
+	start = boost::posix_time::microsec_clock::universal_time();
+	for ( unsigned int f = 0; f < nFrames; f++ )
+		for ( std::size_t i = 0; i < nElements; i++ )
+			Facade::copyMatrix( matrices[ i ], &buffer[ 12 * i ] );
+	printCopyResult( "3x4 matrices bulk", secondsSince( start ), nFrames, nElements * 12, baseline );
+
+	// RGB images into an ARGB32 texture, rows padded to 4 bytes
+	unsigned int nImageFrames = std::max( options.nFrames, 1u );
+	int width = options.nWidth;
+	int height = options.nHeight;
+	unsigned long long nPixels = (unsigned long long)width * height;
+	int widthStep = ( width * 3 + 3 ) & ~3;
+	std::vector< unsigned char > pixels( std::size_t( widthStep ) * height );
+	for ( std::size_t i = 0; i < pixels.size(); i++ )
+		pixels[ i ] = static_cast< unsigned char >( i * 7919 );
+	Facade::SimpleImage image = { width, height, int( pixels.size() ), widthStep, 8, 3, &pixels[ 0 ], 0 };
+	std::vector< unsigned int > texture( nPixels );
+
+	std::cout << std::endl << width << "x" << height << " RGB, " << nImageFrames << " frames per method" << std::endl;
+	std::cout << std::setw( 16 ) << "method" << std::setw( 12 ) << "frame [ms]" << std::setw( 12 ) << "MPixel/s" << std::setw( 10 ) << "speedup" << std::endl;
+
+	start = boost::posix_time::microsec_clock::universal_time();
+	for ( unsigned int i = 0; i < nImageFrames; i++ )
+		packARGB32Legacy( &pixels[ 0 ], widthStep, width, height, &texture[ 0 ], width, 255 );
+	baseline = secondsSince( start ) / nImageFrames;
+	printPackingResult( "image per pixel", baseline * nImageFrames, nImageFrames, nPixels, baseline );
+
+	start = boost::posix_time::microsec_clock::universal_time();
+	for ( unsigned int i = 0; i < nImageFrames; i++ )
+		Facade::copyImageARGB32( image, &texture[ 0 ], width * 4, 255, false );
+	printPackingResult( "image bulk", secondsSince( start ), nImageFrames, nPixels, baseline );
+
+	return 0;
+}
+
+
+#ifdef HAVE_OPENCV
+/** counts the encoded images and their size */
+struct EncodedImageCounter
+{
+	EncodedImageCounter()
+		: nImages( 0 )
+		, nBytes( 0 )
+	{}
+
+	void receive( const Facade::EncodedImage& image )
+	{
+		nImages.fetch_add( 1, boost::memory_order_relaxed );
+		nBytes.fetch_add( image.data.size(), boost::memory_order_relaxed );
+	}
+
+	boost::atomic< unsigned long long > nImages;
+	boost::atomic< unsigned long long > nBytes;
+};
+
+
+/**
+ * Measures the throughput of the image encoder with 1, 2, 4, ... workers on a synthetic RGB
+ * image, for fast PNG and for JPEG at the given quality.
+ */
+int runImageEncoding( const BenchmarkOptions& options )
+{
+	int width = options.nWidth;
+	int height = options.nHeight;
+	unsigned int nFrames = std::max( options.nFrames, 1u );
+	unsigned int nMaxWorkers = options.nWorkers ? options.nWorkers : std::max( boost::thread::hardware_concurrency(), 1u );
+
+	// smooth gradients with some noise, which compresses roughly like camera images
+	boost::shared_ptr< Vision::Image > pImage( new Vision::Image( width, height, 3 ) );
+	pImage->set_pixelFormat( Vision::Image::RGB );
+	for ( int y = 0; y < height; y++ )
+	{
+		unsigned char* row = pImage->Mat().ptr( y );
+		for ( int x = 0; x < width; x++ )
+		{
+			unsigned int noise = ( x * 7919 + y * 104729 ) >> 3 & 7;
+			row[ 3 * x ] = static_cast< unsigned char >( x * 255 / width + noise );
+			row[ 3 * x + 1 ] = static_cast< unsigned char >( y * 255 / height + noise );
+			row[ 3 * x + 2 ] = static_cast< unsigned char >( ( x + y ) / 8 + noise );
+		}
+	}
+	Measurement::ImageMeasurement image( Measurement::now(), pImage );
+	double megabytes = double( width ) * height * 3 * 1e-6;
+
+	std::cout << width << "x" << height << " RGB, " << nFrames << " frames per run" << std::endl;
+	std::cout << std::setw( 8 ) << "codec" << std::setw( 9 ) << "workers" << std::setw( 10 ) << "frames/s"
+		<< std::setw( 10 ) << "MB/s in" << std::setw( 10 ) << "ratio" << std::setw( 10 ) << "speedup" << std::endl;
+
+	for ( int codec = 0; codec < 2; codec++ )
+	{
+		double singleWorkerRate = 0.0;
+		for ( unsigned int nWorkers = 1; ; nWorkers = std::min( nWorkers * 2, nMaxWorkers ) )
+		{
+			EncodedImageCounter counter;
+			boost::posix_time::ptime start( boost::posix_time::microsec_clock::universal_time() );
+			{
+				Facade::ImageEncoder encoder( codec ? Facade::ImageEncoder::JPEG : Facade::ImageEncoder::PNG,
+					codec ? options.quality : 1, nWorkers, nFrames, boost::bind( &EncodedImageCounter::receive, &counter, _1 ) );
+				for ( unsigned int i = 0; i < nFrames; i++ )
+					encoder.encode( image );
+				encoder.flush();
+			}
+			double rate = counter.nImages / secondsSince( start );
+			if ( nWorkers == 1 )
+				singleWorkerRate = rate;
+
+			std::cout << std::setw( 8 ) << ( codec ? "jpeg" : "png" ) << std::setw( 9 ) << nWorkers
+				<< std::fixed << std::setprecision( 1 ) << std::setw( 10 ) << rate << std::setw( 10 ) << rate * megabytes
+				<< std::setprecision( 3 ) << std::setw( 10 ) << counter.nBytes / ( counter.nImages * megabytes * 1e6 )
+				<< std::setprecision( 2 ) << std::setw( 10 ) << rate / singleWorkerRate << std::endl;
+
+			if ( nWorkers >= nMaxWorkers )
+				break;
+		}
+	}
+
+	return 0;
+}
+#endif // HAVE_OPENCV
+
+} // anonymous namespace
+
+
+int main( int ac, char** av )
+{
+	try
+	{
+		// initialize logging
+		Util::initLogging();
+
+		BenchmarkOptions options;
+		std::string sMode;
+
+		namespace po = boost::program_options;
+		po::options_description poDesc( "Allowed options", 80 );
+		poDesc.add_options()
+			( "help", "print this help message" )
+			( "mode", po::value< std::string >( &sMode ), "benchmark to run: facade-scaling, restart, reconfiguration, stand-in-server, texture-packing, bulk-copy, image-encoding" )
+			( "components_path", po::value< std::string >( &options.sComponentsPath ), "Directory from which to load components" )
+			( "utql", po::value< std::string >( &options.sUtqlFile ), "UTQL dataflow file used by the benchmark" )
+			( "sink", po::value< std::string >( &options.sSinkName ), "name of the ApplicationPushSinkPose at which events are counted" )
+			( "facades", po::value< unsigned int >( &options.nFacades )->default_value( 16 ), "maximum number of concurrent facades" )
+			( "duration", po::value< unsigned int >( &options.nDuration )->default_value( 5 ), "measurement duration per run in seconds" )
+			( "cycles", po::value< unsigned int >( &options.nCycles )->default_value( 20 ), "number of interruptions for the restart benchmark" )
+			( "update", po::value< std::string >( &options.sUpdateFile ), "UTQL response alternating with --utql for the stand-in server" )
+			( "requests", po::value< unsigned int >( &options.nRequests )->default_value( 100 ), "number of requests per phase of the reconfiguration benchmark" )
+			( "port", po::value< unsigned short >( &options.port )->default_value( 0 ), "port of the stand-in server, 0 for any free port" )
+			( "width", po::value< unsigned int >( &options.nWidth )->default_value( 1920 ), "image width for the image benchmarks" )
+			( "height", po::value< unsigned int >( &options.nHeight )->default_value( 1080 ), "image height for the image benchmarks" )
+			( "frames", po::value< unsigned int >( &options.nFrames )->default_value( 200 ), "number of frames per method for the image benchmarks" )
+			( "workers", po::value< unsigned int >( &options.nWorkers )->default_value( 0 ), "maximum number of encoder threads, 0 for one per hardware thread" )
+			( "quality", po::value< int >( &options.quality )->default_value( 90 ), "JPEG quality of the image encoding benchmark" )
+			( "elements", po::value< unsigned int >( &options.nElements )->default_value( 1000 ), "number of list elements for the bulk copy benchmark" )
+		;
+
+		po::variables_map poOptions;
+		try
+		{
+			po::store( po::command_line_parser( ac, av ).options( poDesc ).run(), poOptions );
+			po::notify( poOptions );
+		}
+		catch( std::exception& e )
+		{
+			std::cerr << "Error parsing command line parameters : " << e.what() << std::endl;
+			std::cerr << "Try utBenchmark --help for help" << std::endl;
+			return 1;
+		}
+
+		if ( poOptions.count( "help" ) || sMode.empty() )
+		{
+			std::cout << "Syntax: utBenchmark --mode <benchmark> [options]" << std::endl << std::endl;
+			std::cout << poDesc << std::endl;
+			return 1;
+		}
+
+		if ( sMode == "facade-scaling" )
+			return runFacadeScaling( options );
+		if ( sMode == "restart" )
+			return runRestart( options );
+		if ( sMode == "reconfiguration" )
+			return runReconfiguration( options );
+		if ( sMode == "stand-in-server" )
+			return runStandInServer( options );
+		if ( sMode == "texture-packing" )
+			return runTexturePacking( options );
+		if ( sMode == "bulk-copy" )
+			return runBulkCopy( options );
+#ifdef HAVE_OPENCV
+		if ( sMode == "image-encoding" )
+			return runImageEncoding( options );
+#endif
+
+		std::cerr << "Unknown benchmark mode " << sMode << std::endl;
+		return 1;
+	}
+	catch( Util::Exception& e )
+	{
+		std::cerr << "exception occurred: " << e << std::endl;
+		return 1;
+	}
+}
@@ -25,6 +25,8 @@
 #include <stdlib.h>
 #include <signal.h>
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
 #ifdef _WIN32
 #include <conio.h>
 #endif
@@ -42,6 +44,57 @@ using namespace Ubitrack;
 bool bStop = false;
 
 
+#ifdef __linux__
+/** parses a CPU list like "0,2-3" into an affinity mask. Only CPUs 0-63 can be selected */
+unsigned long long parseCpuList( const std::string& sList )
+{
+	unsigned long long mask = 0;
+	std::istringstream ss( sList );
+	std::string sRange;
+	while ( std::getline( ss, sRange, ',' ) )
+	{
+		unsigned int first, last;
+		char dash;
+		std::istringstream range( sRange );
+		if ( !( range >> first ) )
+			throw std::runtime_error( "invalid CPU list \"" + sList + "\"" );
+		last = first;
+		if ( range >> dash && !( dash == '-' && range >> last ) )
+			throw std::runtime_error( "invalid CPU list \"" + sList + "\"" );
+		if ( last < first )
+			throw std::runtime_error( "invalid CPU range \"" + sRange + "\" in CPU list \"" + sList + "\"" );
+		if ( last >= 64 )
+			throw std::runtime_error( "CPU list \"" + sList + "\" contains CPUs above 63, which cannot be selected" );
+		for ( unsigned int i = first; i <= last; i++ )
+			mask |= 1ULL << i;
+	}
+	if ( !mask )
+		throw std::runtime_error( "CPU list \"" + sList + "\" selects no CPU" );
+	return mask;
+}
+
+
+/** builds the scheduling parameters of one thread type from the command line */
+Facade::ThreadScheduling parseScheduling( const std::string& sPolicy, int priority, const std::string& sCpus )
+{
+	Facade::ThreadScheduling scheduling;
+	if ( priority > 0 )
+	{
+		if ( sPolicy == "fifo" )
+			scheduling.policy = Facade::ThreadScheduling::SCHEDULE_FIFO;
+		else if ( sPolicy == "rr" )
+			scheduling.policy = Facade::ThreadScheduling::SCHEDULE_RR;
+		else
+			throw std::runtime_error( "unknown scheduling policy \"" + sPolicy + "\", use fifo or rr" );
+		scheduling.priority = priority;
+	}
+	if ( !sCpus.empty() )
+		scheduling.cpuMask = parseCpuList( sCpus );
+	return scheduling;
+}
+#endif
+
+
 void ctrlC ( int i )
 {
 	bStop = true;
@@ -64,6 +117,7 @@ int main( int ac, char** av )
 		std::string sExtraUtqlFile;
 		std::string sComponentsPath;
 		bool bNoExit;
+		Facade::FacadeOptions facadeOptions;
 
 		try
 		{
@@ -82,6 +136,16 @@ int main( int ac, char** av )
 				#ifdef _WIN32
 				( "priority", po::value< int >( 0 ),"set priority of console thread, -1: lower, 0: normal, 1: higher, 2: real time (needs admin)" )
 				#endif
+				#ifdef __linux__
+				( "sched-policy", po::value< std::string >()->default_value( "fifo" ), "real-time scheduling policy for the priorities below: fifo or rr" )
+				( "dispatcher-priority", po::value< int >()->default_value( 0 ), "real-time priority (1-99) of the event queue threads, 0: normal scheduling" )
+				( "network-priority", po::value< int >()->default_value( 0 ), "real-time priority (1-99) of the server connection thread, 0: normal scheduling" )
+				( "worker-priority", po::value< int >()->default_value( 0 ), "real-time priority (1-99) of the facade worker threads, 0: normal scheduling" )
+				( "dispatcher-cpus", po::value< std::string >()->default_value( "" ), "CPUs for the event queue threads, e.g. 2,3 or 2-3" )
+				( "network-cpus", po::value< std::string >()->default_value( "" ), "CPUs for the server connection thread" )
+				( "worker-cpus", po::value< std::string >()->default_value( "" ), "CPUs for the facade worker threads" )
+				( "mlock", "lock all process memory to avoid page faults (needs CAP_IPC_LOCK or a sufficient memlock limit)" )
+				#endif
 			;
 			
 			// specify default options
@@ -117,6 +181,17 @@ int main( int ac, char** av )
 			}
 			#endif
 
+			#ifdef __linux__
+			const std::string& sPolicy( poOptions[ "sched-policy" ].as< std::string >() );
+			facadeOptions.dispatcherScheduling = parseScheduling( sPolicy, poOptions[ "dispatcher-priority" ].as< int >(), 
+				poOptions[ "dispatcher-cpus" ].as< std::string >() );
+			facadeOptions.networkScheduling = parseScheduling( sPolicy, poOptions[ "network-priority" ].as< int >(), 
+				poOptions[ "network-cpus" ].as< std::string >() );
+			facadeOptions.workerScheduling = parseScheduling( sPolicy, poOptions[ "worker-priority" ].as< int >(), 
+				poOptions[ "worker-cpus" ].as< std::string >() );
+			facadeOptions.lockMemory = poOptions.count( "mlock" ) != 0;
+			#endif
+
 			bNoExit = poOptions.count( "noexit" ) != 0;
 			
 			// print help message if nothing specified
@@ -138,7 +213,7 @@ int main( int ac, char** av )
 		
 		// configure ubitrack
 		std::cout << "Loading components..." << std::endl << std::flush;
-		Facade::AdvancedFacade utFacade( sComponentsPath );
+		Facade::AdvancedFacade utFacade( facadeOptions, sComponentsPath );
 
 		if ( sServerAddress.empty() )
 		{
@@ -10,8 +10,11 @@ SWIG */
 %{
 #include <string>
 #include <sstream>
+#include <stdexcept>
 #include <utFacade/Config.h>
 #include <utFacade/SimpleFacade.h>
+#include <utFacade/TexturePacking.h>
+#include <utFacade/BulkCopy.h>
 #include <utUtil/Logging.h>
 #include <utUtil/Exception.h>
 
@@ -137,6 +140,10 @@ generate generic type wrapper classes of style SWITTYPE_p_<xxx>. */
 
 %include ../../src/utFacade/SimpleVectorTypes.h
 
+/* used by SimpleImage.retain() */
+%ignore Ubitrack::Facade::retainCallbackImage;
+%ignore Ubitrack::Facade::releaseCallbackImage;
+
 %include ../../src/utFacade/SimpleDatatypes.h
 %include ../../src/utFacade/SimpleFacade.h
 
@@ -161,68 +168,626 @@ generate generic type wrapper classes of style SWITTYPE_p_<xxx>. */
 	{ return $self->imageData; }
 	// removed all const from alpha, a, r,g,b , android problem
 	void copyImageDataToARGB32Pointer( void * where, int texWidth, int texHeight, unsigned char alpha )
-	{ 
-		unsigned int* where2 = (unsigned int*) where;
-		unsigned int a = alpha;
-		a = a << 24;
-		
-		for (int i = 0; i < $self->height; i++)
-        	{
-			unsigned int* where3 = where2 + i * texWidth;
-			unsigned char* bytePointer = $self->imageData + i * $self->widthStep;
-			for (int j = 0; j < $self->width; j++)
-			{
-				unsigned int r = *bytePointer;
-				bytePointer++;
-				unsigned int g = *bytePointer;
-				bytePointer++;
-				unsigned int b = *bytePointer;
-				bytePointer++;
-				*where3 = a |  r << 16 | g << 8 | b;
-				++where3;
-				
-			}
-		}
-		
-	}
+	{ Ubitrack::Facade::copyImageARGB32( *$self, where, texWidth * 4, alpha, false ); }
 
 	void copyImageDataToARGB32PointerFlipVertical( void * where, int texWidth, int texHeight, unsigned char alpha )
-	{ 
-		unsigned int* where2 = (unsigned int*) where;
-		unsigned int a = alpha;
-		a = a << 24;
-		int height_1 = $self->height - 1;
-		for (int i = 0; i < $self->height; i++)
-        	{
-			unsigned int* where3 = where2 + i * texWidth;
-			unsigned char* bytePointer = $self->imageData + (height_1 - i ) * $self->widthStep;
-			for (int j = 0; j < $self->width; j++)
-			{
-				unsigned int r = *bytePointer;
-				bytePointer++;
-				unsigned int g = *bytePointer;
-				bytePointer++;
-				unsigned int b = *bytePointer;
-				bytePointer++;
-				*where3 = a |  r << 16 | g << 8 | b;
-				++where3;
-				
-			}
-		}
-		
-	}
+	{ Ubitrack::Facade::copyImageARGB32( *$self, where, texWidth * 4, alpha, true ); }
+
+	/** packs the image into a texture of rows of dstStride bytes, e.g. a pinned Color32[] */
+	bool copyToARGB32( void * dst, int dstStride, unsigned char alpha, bool flipVertical )
+	{ return Ubitrack::Facade::copyImageARGB32( *$self, dst, dstStride, alpha, flipVertical ); }
 
 	
 	
 	
 	
 	}
+
+/* Bulk copies into caller memory, e.g. a pinned double[] or the pointer of a Span<double>.
+The list copies take the capacity in elements and return the number of elements copied. */
+
+%cs_marshal_intptr(void*, dst)
+
+%extend Ubitrack::Facade::SimplePosition2DList {
+	int copyTo( void * dst, int capacity )
+	{ return static_cast< int >( Ubitrack::Facade::copyPositionList( *$self, static_cast< double* >( dst ), capacity ) ); }
+}
+
+%extend Ubitrack::Facade::SimplePositionList3D {
+	int copyTo( void * dst, int capacity )
+	{ return static_cast< int >( Ubitrack::Facade::copyPositionList( *$self, static_cast< double* >( dst ), capacity ) ); }
+}
+
+%extend Ubitrack::Facade::SimpleErrorPositionList3D {
+	int copyTo( void * dst, int capacity )
+	{ return static_cast< int >( Ubitrack::Facade::copyPositionList( *$self, static_cast< double* >( dst ), capacity ) ); }
+}
+
+%extend Ubitrack::Facade::SimplePose {
+	void copyTo( void * dst )
+	{ Ubitrack::Facade::copyPose( *$self, static_cast< double* >( dst ) ); }
+}
+
+%extend Ubitrack::Facade::SimpleMatrix3x3 {
+	void copyTo( void * dst )
+	{ Ubitrack::Facade::copyMatrix( *$self, static_cast< double* >( dst ) ); }
+}
+
+%extend Ubitrack::Facade::SimpleMatrix3x4 {
+	void copyTo( void * dst )
+	{ Ubitrack::Facade::copyMatrix( *$self, static_cast< double* >( dst ) ); }
+}
+
+%extend Ubitrack::Facade::SimpleMatrix4x4 {
+	void copyTo( void * dst )
+	{ Ubitrack::Facade::copyMatrix( *$self, static_cast< double* >( dst ) ); }
+}
 	
 	
 	
 	
 #endif
 
+#ifdef SWIGJAVA
+
+/* Zero-copy access from Java: the typemaps below turn a memory range into a direct
+java.nio buffer (JNI NewDirectByteBuffer) in native byte order. The buffer aliases the
+memory of the object it was obtained from and keeps the Java proxy of that object
+reachable as long as the buffer itself is, so the proxy cannot be finalized under it.
+The proxy must not be delete()d explicitly while the buffer is in use. Views of objects
+passed to a receiver callback are only valid during the callback, use SimpleImage.retain()
+to keep an image beyond it. */
+
+%pragma(java) modulecode=%{
+	/** keeps the owner of the memory of a direct buffer reachable until the buffer is collected */
+	private static final class BufferOwner extends java.lang.ref.PhantomReference< java.nio.Buffer > {
+		private final Object owner;
+
+		BufferOwner( java.nio.Buffer buffer, Object owner ) {
+			super( buffer, bufferQueue );
+			this.owner = owner;
+		}
+	}
+
+	private static final java.lang.ref.ReferenceQueue< java.nio.Buffer > bufferQueue = new java.lang.ref.ReferenceQueue< java.nio.Buffer >();
+
+	/* identity semantics, unlike a map keyed by the buffers, whose equals compares contents */
+	private static final java.util.Set< BufferOwner > bufferOwners = 
+		java.util.Collections.synchronizedSet( new java.util.HashSet< BufferOwner >() );
+
+	static < B extends java.nio.Buffer > B retainBufferOwner( B buffer, Object owner ) {
+		java.lang.ref.Reference< ? extends java.nio.Buffer > collected;
+		while ( ( collected = bufferQueue.poll() ) != null )
+			bufferOwners.remove( collected );
+		if ( buffer != null )
+			bufferOwners.add( new BufferOwner( buffer, owner ) );
+		return buffer;
+	}
+%}
+
+%{
+#ifdef HAVE_OPENCV
+#include <utMeasurement/Measurement.h>
+#include <utVision/Image.h>
+#endif
+
+/** a range of bytes returned to Java as a direct ByteBuffer */
+struct JavaByteView
+{
+	void* pData;
+	jlong nBytes;
+};
+
+/** a range of doubles returned to Java as a direct DoubleBuffer */
+struct JavaDoubleView
+{
+	double* pData;
+	jlong nValues;
+};
+
+static JavaByteView makeJavaByteView( void* pData, std::size_t nBytes )
+{
+	JavaByteView view = { pData, static_cast< jlong >( nBytes ) };
+	return view;
+}
+
+static JavaDoubleView makeJavaDoubleView( double* pData, std::size_t nValues )
+{
+	JavaDoubleView view = { pData, static_cast< jlong >( nValues ) };
+	return view;
+}
+
+// the views treat consecutive double members as arrays
+static_assert( sizeof( SimplePosition2DValue ) == 2 * sizeof( double ), "SimplePosition2DValue is padded" );
+static_assert( sizeof( SimplePosition3DValue ) == 3 * sizeof( double ), "SimplePosition3DValue is padded" );
+static_assert( sizeof( SimpleErrorPosition3DValue ) == 12 * sizeof( double ), "SimpleErrorPosition3DValue is padded" );
+static_assert( offsetof( Ubitrack::Facade::SimpleErrorPose, co66 ) == 42 * sizeof( double ), "SimpleErrorPose is padded" );
+static_assert( offsetof( Ubitrack::Facade::SimpleMatrix3x4, e34 ) == 11 * sizeof( double ), "SimpleMatrix3x4 is padded" );
+%}
+
+%typemap(jni) JavaByteView, JavaDoubleView "jobject"
+%typemap(jtype) JavaByteView, JavaDoubleView "java.nio.ByteBuffer"
+%typemap(jstype) JavaByteView "java.nio.ByteBuffer"
+%typemap(jstype) JavaDoubleView "java.nio.DoubleBuffer"
+%typemap(out) JavaByteView %{ $result = $1.pData && $1.nBytes ? jenv->NewDirectByteBuffer( $1.pData, $1.nBytes ) : 0; %}
+%typemap(out) JavaDoubleView %{ $result = $1.pData && $1.nValues ? jenv->NewDirectByteBuffer( $1.pData, $1.nValues * sizeof( double ) ) : 0; %}
+%typemap(javaout) JavaByteView {
+		java.nio.ByteBuffer buffer = $jnicall;
+		return buffer == null ? null : $module.retainBufferOwner( buffer.order( java.nio.ByteOrder.nativeOrder() ), this );
+	}
+%typemap(javaout) JavaDoubleView {
+		java.nio.ByteBuffer buffer = $jnicall;
+		return buffer == null ? null : $module.retainBufferOwner( buffer.order( java.nio.ByteOrder.nativeOrder() ).asDoubleBuffer(), this );
+	}
+
+/* keeps the image of a SimpleImageReceiver callback alive, without copying the pixels */
+%inline %{
+namespace Ubitrack { namespace Facade {
+
+class SimpleImageHandle
+{
+public:
+	/** retains the measurement of an image passed to a callback, use SimpleImage.retain() */
+	SimpleImageHandle( const SimpleImage& image );
+
+	~SimpleImageHandle();
+
+	int getWidth() const
+	{ return m_image.width; }
+
+	int getHeight() const
+	{ return m_image.height; }
+
+	int getWidthStep() const
+	{ return m_image.widthStep; }
+
+	int getDepth() const
+	{ return m_image.depth; }
+
+	int getChannels() const
+	{ return m_image.nChannels; }
+
+	unsigned long long int getTimestamp() const
+	{ return m_image.timestamp; }
+
+	/** the pixels, widthStep * height bytes, keeps the handle alive */
+	JavaByteView getImageBuffer()
+	{ return makeJavaByteView( m_image.imageData, m_image.imageSize ); }
+
+private:
+	SimpleImageHandle( const SimpleImageHandle& );
+	SimpleImageHandle& operator=( const SimpleImageHandle& );
+
+	SimpleImage m_image;
+	void* m_pMeasurement;
+};
+
+} } // namespace Ubitrack::Facade
+%}
+
+%{
+namespace Ubitrack { namespace Facade {
+
+SimpleImageHandle::SimpleImageHandle( const SimpleImage& image )
+	: m_image( image )
+	, m_pMeasurement( retainCallbackImage( image ) )
+{
+	// without a measurement, the pixels would not outlive the callback
+	if ( !m_pMeasurement )
+	{
+		m_image.imageData = 0;
+		m_image.imageSize = 0;
+	}
+}
+
+SimpleImageHandle::~SimpleImageHandle()
+{
+	releaseCallbackImage( m_pMeasurement );
+}
+
+} } // namespace Ubitrack::Facade
+%}
+
+%newobject Ubitrack::Facade::SimpleImage::retain;
+
+%extend Ubitrack::Facade::SimpleImage {
+	/** the pixels, only valid during the callback */
+	JavaByteView getImageBuffer()
+	{ return makeJavaByteView( $self->imageData, $self->imageSize ); }
+
+	/** keeps the image after the callback returned, call it inside the callback */
+	Ubitrack::Facade::SimpleImageHandle* retain()
+	{ return new Ubitrack::Facade::SimpleImageHandle( *$self ); }
+}
+
+%extend Ubitrack::Facade::SimplePose {
+	/** tx, ty, tz, rx, ry, rz, rw */
+	JavaDoubleView getValueBuffer()
+	{ return makeJavaDoubleView( &$self->tx, 7 ); }
+}
+
+%extend Ubitrack::Facade::SimpleErrorPose {
+	/** tx, ty, tz, rx, ry, rz, rw */
+	JavaDoubleView getValueBuffer()
+	{ return makeJavaDoubleView( &$self->tx, 7 ); }
+
+	/** the 6x6 covariance, row by row */
+	JavaDoubleView getCovarianceBuffer()
+	{ return makeJavaDoubleView( &$self->co11, 36 ); }
+}
+
+%extend Ubitrack::Facade::SimplePosition3D {
+	JavaDoubleView getValueBuffer()
+	{ return makeJavaDoubleView( &$self->x, 3 ); }
+}
+
+%extend Ubitrack::Facade::SimpleErrorPosition3D {
+	JavaDoubleView getValueBuffer()
+	{ return makeJavaDoubleView( &$self->x, 3 ); }
+
+	/** the 3x3 covariance, row by row */
+	JavaDoubleView getCovarianceBuffer()
+	{ return makeJavaDoubleView( $self->covariance, 9 ); }
+}
+
+%extend Ubitrack::Facade::SimpleMatrix3x3 {
+	JavaDoubleView getValueBuffer()
+	{ return makeJavaDoubleView( $self->values, 9 ); }
+}
+
+%extend Ubitrack::Facade::SimpleMatrix3x4 {
+	/** e11 ... e34, row by row */
+	JavaDoubleView getValueBuffer()
+	{ return makeJavaDoubleView( &$self->e11, 12 ); }
+}
+
+%extend Ubitrack::Facade::SimpleMatrix4x4 {
+	JavaDoubleView getValueBuffer()
+	{ return makeJavaDoubleView( $self->values, 16 ); }
+}
+
+%extend Ubitrack::Facade::SimplePosition2DList {
+	/** x, y of all positions, invalidated when the list changes size */
+	JavaDoubleView getValueBuffer()
+	{ return makeJavaDoubleView( $self->values.empty() ? 0 : &$self->values[ 0 ].x, 2 * $self->values.size() ); }
+}
+
+%extend Ubitrack::Facade::SimplePositionList3D {
+	/** x, y, z of all positions, invalidated when the list changes size */
+	JavaDoubleView getValueBuffer()
+	{ return makeJavaDoubleView( $self->values.empty() ? 0 : &$self->values[ 0 ].x, 3 * $self->values.size() ); }
+}
+
+%extend Ubitrack::Facade::SimpleErrorPositionList3D {
+	/** x, y, z and the 9 covariance elements of all positions, invalidated when the list changes size */
+	JavaDoubleView getValueBuffer()
+	{ return makeJavaDoubleView( $self->values.empty() ? 0 : &$self->values[ 0 ].x, 12 * $self->values.size() ); }
+}
+
+#endif
+
+#ifdef ENABLE_BASICFACADE
+
+/* The BasicFacade hands out measurements as std::shared_ptr, so the target language holds a
+reference and nothing is converted field by field. Measurement values are read with one call
+per measurement through the get( size, data ) and getCovariance( size, data ) bulk copies. */
+
+%{
+#include <utFacade/BasicFacade.h>
+%}
+
+%include "std_shared_ptr.i"
+
+%shared_ptr(Ubitrack::Facade::BasicMeasurement)
+%shared_ptr(Ubitrack::Facade::BasicScalarIntMeasurement)
+%shared_ptr(Ubitrack::Facade::BasicScalarDoubleMeasurement)
+%shared_ptr(Ubitrack::Facade::BasicVectorMeasurement< 2 >)
+%shared_ptr(Ubitrack::Facade::BasicVectorMeasurement< 3 >)
+%shared_ptr(Ubitrack::Facade::BasicVectorMeasurement< 4 >)
+%shared_ptr(Ubitrack::Facade::BasicVectorMeasurement< 8 >)
+%shared_ptr(Ubitrack::Facade::BasicMatrixMeasurement< 3, 3 >)
+%shared_ptr(Ubitrack::Facade::BasicMatrixMeasurement< 3, 4 >)
+%shared_ptr(Ubitrack::Facade::BasicMatrixMeasurement< 4, 4 >)
+%shared_ptr(Ubitrack::Facade::BasicPoseMeasurement)
+%shared_ptr(Ubitrack::Facade::BasicRotationMeasurement)
+%shared_ptr(Ubitrack::Facade::BasicErrorVectorMeasurement< 2 >)
+%shared_ptr(Ubitrack::Facade::BasicErrorVectorMeasurement< 3 >)
+%shared_ptr(Ubitrack::Facade::BasicErrorPoseMeasurement)
+%shared_ptr(Ubitrack::Facade::BasicScalarIntListMeasurement)
+%shared_ptr(Ubitrack::Facade::BasicScalarDoubleListMeasurement)
+%shared_ptr(Ubitrack::Facade::BasicVectorListMeasurement< 2 >)
+%shared_ptr(Ubitrack::Facade::BasicVectorListMeasurement< 3 >)
+%shared_ptr(Ubitrack::Facade::BasicPoseListMeasurement)
+%shared_ptr(Ubitrack::Facade::BasicErrorVectorListMeasurement< 2 >)
+%shared_ptr(Ubitrack::Facade::BasicErrorVectorListMeasurement< 3 >)
+%shared_ptr(Ubitrack::Facade::BasicErrorPoseListMeasurement)
+%shared_ptr(Ubitrack::Facade::BasicCameraIntrinsicsMeasurement)
+#ifdef HAVE_OPENCV
+%shared_ptr(Ubitrack::Facade::BasicImageMeasurement)
+#endif
+
+/* bulk copies go to and from primitive arrays. The size of get( size, data ) and
+getCovariance( size, data ) is the length of the array, so it cannot exceed the array */
+#ifdef SWIGJAVA
+%define %java_sized_array(CTYPE, JNIARRAY, JNIELEMENT, JNINAME, JAVATYPE)
+%typemap(jni) (unsigned int size, CTYPE* data) "JNIARRAY"
+%typemap(jtype) (unsigned int size, CTYPE* data) "JAVATYPE"
+%typemap(jstype) (unsigned int size, CTYPE* data) "JAVATYPE"
+%typemap(javain) (unsigned int size, CTYPE* data) "$javainput"
+%typemap(in) (unsigned int size, CTYPE* data) {
+	if ( !$input )
+	{
+		SWIG_JavaThrowException( jenv, SWIG_JavaNullPointerException, "array is null" );
+		return $null;
+	}
+	$1 = static_cast< unsigned int >( JCALL1( GetArrayLength, jenv, $input ) );
+	$2 = reinterpret_cast< CTYPE* >( JCALL2( Get##JNINAME##ArrayElements, jenv, $input, 0 ) );
+}
+%typemap(freearg) (unsigned int size, CTYPE* data)
+%{ JCALL3( Release##JNINAME##ArrayElements, jenv, $input, reinterpret_cast< JNIELEMENT* >( $2 ), 0 ); %}
+%enddef
+
+%java_sized_array(double, jdoubleArray, jdouble, Double, double[])
+%java_sized_array(int, jintArray, jint, Int, int[])
+%java_sized_array(unsigned char, jbyteArray, jbyte, Byte, byte[])
+#else
+%apply double OUTPUT[] { double* data };
+%apply int OUTPUT[] { int* data };
+%apply unsigned char INOUT[] { unsigned char* data };
+
+/* a multi-argument typemap cannot pass the length of a marshalled array, so the raw copies
+stay internal and the proxies add overloads that pass it */
+%csmethodmodifiers get( unsigned int size, double* data ) "internal";
+%csmethodmodifiers get( unsigned int size, int* data ) "internal";
+%csmethodmodifiers get( unsigned int size, unsigned char* data ) "internal";
+%csmethodmodifiers getCovariance( unsigned int size, double* data ) "internal";
+
+%define %csharp_sized_get(BMT, CSTYPE)
+%typemap(cscode) BMT %{
+  public bool get(CSTYPE[] data) { return get((uint)data.Length, data); }
+%}
+%enddef
+
+%define %csharp_sized_get_covariance(BMT)
+%typemap(cscode) BMT %{
+  public bool get(double[] data) { return get((uint)data.Length, data); }
+  public bool getCovariance(double[] data) { return getCovariance((uint)data.Length, data); }
+%}
+%enddef
+
+%csharp_sized_get(Ubitrack::Facade::BasicVectorMeasurement< 2 >, double)
+%csharp_sized_get(Ubitrack::Facade::BasicVectorMeasurement< 3 >, double)
+%csharp_sized_get(Ubitrack::Facade::BasicVectorMeasurement< 4 >, double)
+%csharp_sized_get(Ubitrack::Facade::BasicVectorMeasurement< 8 >, double)
+%csharp_sized_get(Ubitrack::Facade::BasicMatrixMeasurement< 3, 3 >, double)
+%csharp_sized_get(Ubitrack::Facade::BasicMatrixMeasurement< 3, 4 >, double)
+%csharp_sized_get(Ubitrack::Facade::BasicMatrixMeasurement< 4, 4 >, double)
+%csharp_sized_get(Ubitrack::Facade::BasicPoseMeasurement, double)
+%csharp_sized_get(Ubitrack::Facade::BasicRotationMeasurement, double)
+%csharp_sized_get(Ubitrack::Facade::BasicScalarIntListMeasurement, int)
+%csharp_sized_get(Ubitrack::Facade::BasicScalarDoubleListMeasurement, double)
+%csharp_sized_get(Ubitrack::Facade::BasicVectorListMeasurement< 2 >, double)
+%csharp_sized_get(Ubitrack::Facade::BasicVectorListMeasurement< 3 >, double)
+%csharp_sized_get(Ubitrack::Facade::BasicPoseListMeasurement, double)
+%csharp_sized_get_covariance(Ubitrack::Facade::BasicErrorVectorMeasurement< 2 >)
+%csharp_sized_get_covariance(Ubitrack::Facade::BasicErrorVectorMeasurement< 3 >)
+%csharp_sized_get_covariance(Ubitrack::Facade::BasicErrorPoseMeasurement)
+%csharp_sized_get_covariance(Ubitrack::Facade::BasicErrorVectorListMeasurement< 2 >)
+%csharp_sized_get_covariance(Ubitrack::Facade::BasicErrorVectorListMeasurement< 3 >)
+%csharp_sized_get_covariance(Ubitrack::Facade::BasicErrorPoseListMeasurement)
+#ifdef HAVE_OPENCV
+%csmethodmodifiers Ubitrack::Facade::BasicImageMeasurement::BasicImageMeasurement( unsigned long long int, int, int, int, int, unsigned int, unsigned char*, Ubitrack::Facade::BasicImageMeasurement::PixelFormat ) "internal";
+%typemap(cscode) Ubitrack::Facade::BasicImageMeasurement %{
+  public BasicImageMeasurement(ulong ts, int width, int height, int depth, int channels, byte[] data, BasicImageMeasurement.PixelFormat pixelFormat)
+    : this(ts, width, height, depth, channels, (uint)data.Length, data, pixelFormat) {}
+  public bool get(byte[] data) { return get((uint)data.Length, data); }
+%}
+#endif
+#endif
+
+#ifdef HAVE_OPENCV
+/* images from an array always copy it, and the array has to hold the whole frame. The C++
+constructor may keep the pointer (copy_data = false) and does not know the array length */
+%include "exception.i"
+%ignore Ubitrack::Facade::BasicImageMeasurement::BasicImageMeasurement( unsigned long long int const, int, int, int, int, unsigned char*, Ubitrack::Facade::BasicImageMeasurement::PixelFormat, bool );
+
+%exception Ubitrack::Facade::BasicImageMeasurement::BasicImageMeasurement {
+	try
+	{
+		$action
+	}
+	catch ( const std::length_error& e )
+	{
+		SWIG_exception( SWIG_ValueError, e.what() );
+	}
+}
+
+%extend Ubitrack::Facade::BasicImageMeasurement {
+	BasicImageMeasurement( unsigned long long int ts, int width, int height, int depth, int channels, unsigned int size, unsigned char* data,
+		Ubitrack::Facade::BasicImageMeasurement::PixelFormat pixelFormat )
+	{
+		// CV_16U and CV_32F, the C++ constructor takes all other depths as 8 bit
+		unsigned long long channelBytes = depth == 2 ? 2 : ( depth == 5 ? 4 : 1 );
+		if ( width < 0 || height < 0 || channels < 0 || size < channelBytes * width * height * channels )
+			throw std::length_error( "array is smaller than the image" );
+		return new Ubitrack::Facade::BasicImageMeasurement( ts, width, height, depth, channels, data, pixelFormat, true );
+	}
+}
+#endif
+
+%apply int& OUTPUT { int& v };
+%apply double& OUTPUT { double& v };
+%apply float& OUTPUT { float& v };
+
+/* internals and std::function callbacks cannot be used from the target language */
+%ignore *::m_pPrivate;
+%ignore Ubitrack::Facade::BasicPullSink::BasicPullSink;
+%ignore Ubitrack::Facade::BasicPushSink::BasicPushSink;
+%ignore Ubitrack::Facade::BasicPushSink::registerCallback;
+%ignore Ubitrack::Facade::BasicPushSource::BasicPushSource;
+
+/* sinks and sources are created by the facade and owned by the caller */
+%newobject Ubitrack::Facade::BasicFacade::getPullSink;
+%newobject Ubitrack::Facade::BasicFacade::getPushSink;
+%newobject Ubitrack::Facade::BasicFacade::getPushSource;
+
+%feature("director") Ubitrack::Facade::BasicDataflowObserver;
+%feature("director") Ubitrack::Facade::BasicMeasurementReceiver;
+
+%include ../../src/utFacade/ThreadScheduling.h
+%include ../../src/utFacade/FacadeOptions.h
+%include ../../src/utFacade/FacadeStatistics.h
+%include ../../src/utFacade/BasicFacadeTypes.h
+%include ../../src/utFacade/BasicFacadeComponents.h
+%include ../../src/utFacade/BasicFacade.h
+
+%template(IntVector) std::vector< int >;
+%template(FloatVector) std::vector< float >;
+%template(DoubleVector) std::vector< double >;
+%template(DoubleVectorVector) std::vector< std::vector< double > >;
+%template(UnsignedLongLongVector) std::vector< unsigned long long >;
+%template(EndpointStatisticsVector) std::vector< Ubitrack::Facade::EndpointStatistics >;
+%template(EventDomainStatisticsVector) std::vector< Ubitrack::Facade::EventDomainStatistics >;
+
+/* receives the measurements of a push sink on the dataflow thread */
+%inline %{
+namespace Ubitrack { namespace Facade {
+
+template< class BMT >
+class BasicMeasurementReceiver
+{
+public:
+	virtual ~BasicMeasurementReceiver()
+	{}
+
+	virtual void receiveMeasurement( std::shared_ptr< BMT > measurement ) = 0;
+};
+
+} } // namespace Ubitrack::Facade
+%}
+
+%{
+template< class BMT >
+static void setBasicPushSinkReceiver( Ubitrack::Facade::BasicPushSink< BMT >& sink, Ubitrack::Facade::BasicMeasurementReceiver< BMT >* pReceiver )
+{
+	if ( pReceiver )
+		sink.registerCallback( [ pReceiver ]( std::shared_ptr< BMT >& m ) { pReceiver->receiveMeasurement( m ); } );
+	else
+		sink.unregisterCallback();
+}
+%}
+
+/* wraps the receiver, sinks and source of one measurement type and the facade methods creating them */
+%define %basic_facade_endpoints(NAME, BMT)
+%extend Ubitrack::Facade::BasicPushSink< BMT > {
+	/** sets the receiver of the measurements, which must stay alive until it is replaced. null removes it */
+	void setReceiver( Ubitrack::Facade::BasicMeasurementReceiver< BMT >* pReceiver )
+	{ setBasicPushSinkReceiver( *$self, pReceiver ); }
+}
+%template(Basic##NAME##Receiver) Ubitrack::Facade::BasicMeasurementReceiver< BMT >;
+%template(Basic##NAME##PullSink) Ubitrack::Facade::BasicPullSink< BMT >;
+%template(Basic##NAME##PushSink) Ubitrack::Facade::BasicPushSink< BMT >;
+%template(Basic##NAME##PushSource) Ubitrack::Facade::BasicPushSource< BMT >;
+%extend Ubitrack::Facade::BasicFacade {
+	%template(get##NAME##PullSink) getPullSink< BMT >;
+	%template(get##NAME##PushSink) getPushSink< BMT >;
+	%template(get##NAME##PushSource) getPushSource< BMT >;
+}
+%enddef
+
+#ifdef SWIGCSHARP
+/* bulk copies into pinned caller memory without marshaling, size is in doubles (bytes for images) */
+%define %basic_copy_to(BMT)
+%extend BMT {
+	bool copyTo( void * dst, int size )
+	{ return $self->get( size, static_cast< double* >( dst ) ); }
+}
+%enddef
+
+/* list copies take the capacity in elements and return the number of elements copied */
+%define %basic_list_copy_to(BMT, FUNCTION)
+%extend BMT {
+	int copyTo( void * dst, int capacity )
+	{ return static_cast< int >( Ubitrack::Facade::FUNCTION( *$self, static_cast< double* >( dst ), capacity ) ); }
+}
+%enddef
+
+%basic_copy_to(Ubitrack::Facade::BasicVectorMeasurement< 2 >)
+%basic_copy_to(Ubitrack::Facade::BasicVectorMeasurement< 3 >)
+%basic_copy_to(Ubitrack::Facade::BasicVectorMeasurement< 4 >)
+%basic_copy_to(Ubitrack::Facade::BasicMatrixMeasurement< 3, 3 >)
+%basic_copy_to(Ubitrack::Facade::BasicMatrixMeasurement< 3, 4 >)
+%basic_copy_to(Ubitrack::Facade::BasicMatrixMeasurement< 4, 4 >)
+%basic_copy_to(Ubitrack::Facade::BasicPoseMeasurement)
+%basic_copy_to(Ubitrack::Facade::BasicRotationMeasurement)
+%basic_list_copy_to(Ubitrack::Facade::BasicVectorListMeasurement< 2 >, copyPositionList)
+%basic_list_copy_to(Ubitrack::Facade::BasicVectorListMeasurement< 3 >, copyPositionList)
+%basic_list_copy_to(Ubitrack::Facade::BasicPoseListMeasurement, copyPoseList)
+
+#ifdef HAVE_OPENCV
+%extend Ubitrack::Facade::BasicImageMeasurement {
+	/** packs the image into a texture of rows of dstStride bytes, e.g. a pinned Color32[] */
+	bool copyToARGB32( void * dst, int dstStride, unsigned char alpha, bool flipVertical )
+	{ return Ubitrack::Facade::copyImageARGB32( *$self, dst, dstStride, alpha, flipVertical ); }
+}
+#endif
+#endif
+
+%template(BasicVector2Measurement) Ubitrack::Facade::BasicVectorMeasurement< 2 >;
+%template(BasicVector3Measurement) Ubitrack::Facade::BasicVectorMeasurement< 3 >;
+%template(BasicVector4Measurement) Ubitrack::Facade::BasicVectorMeasurement< 4 >;
+%template(BasicVector8Measurement) Ubitrack::Facade::BasicVectorMeasurement< 8 >;
+%template(BasicMatrix3x3Measurement) Ubitrack::Facade::BasicMatrixMeasurement< 3, 3 >;
+%template(BasicMatrix3x4Measurement) Ubitrack::Facade::BasicMatrixMeasurement< 3, 4 >;
+%template(BasicMatrix4x4Measurement) Ubitrack::Facade::BasicMatrixMeasurement< 4, 4 >;
+%template(BasicErrorVector2Measurement) Ubitrack::Facade::BasicErrorVectorMeasurement< 2 >;
+%template(BasicErrorVector3Measurement) Ubitrack::Facade::BasicErrorVectorMeasurement< 3 >;
+%template(BasicVectorList2Measurement) Ubitrack::Facade::BasicVectorListMeasurement< 2 >;
+%template(BasicVectorList3Measurement) Ubitrack::Facade::BasicVectorListMeasurement< 3 >;
+%template(BasicErrorVectorList2Measurement) Ubitrack::Facade::BasicErrorVectorListMeasurement< 2 >;
+%template(BasicErrorVectorList3Measurement) Ubitrack::Facade::BasicErrorVectorListMeasurement< 3 >;
+
+%basic_facade_endpoints(ScalarInt, Ubitrack::Facade::BasicScalarIntMeasurement)
+%basic_facade_endpoints(ScalarDouble, Ubitrack::Facade::BasicScalarDoubleMeasurement)
+%basic_facade_endpoints(Vector2, Ubitrack::Facade::BasicVectorMeasurement< 2 >)
+%basic_facade_endpoints(Vector3, Ubitrack::Facade::BasicVectorMeasurement< 3 >)
+%basic_facade_endpoints(Vector4, Ubitrack::Facade::BasicVectorMeasurement< 4 >)
+%basic_facade_endpoints(Vector8, Ubitrack::Facade::BasicVectorMeasurement< 8 >)
+%basic_facade_endpoints(Matrix3x3, Ubitrack::Facade::BasicMatrixMeasurement< 3, 3 >)
+%basic_facade_endpoints(Matrix3x4, Ubitrack::Facade::BasicMatrixMeasurement< 3, 4 >)
+%basic_facade_endpoints(Matrix4x4, Ubitrack::Facade::BasicMatrixMeasurement< 4, 4 >)
+%basic_facade_endpoints(Pose, Ubitrack::Facade::BasicPoseMeasurement)
+%basic_facade_endpoints(Rotation, Ubitrack::Facade::BasicRotationMeasurement)
+%basic_facade_endpoints(ErrorVector2, Ubitrack::Facade::BasicErrorVectorMeasurement< 2 >)
+%basic_facade_endpoints(ErrorVector3, Ubitrack::Facade::BasicErrorVectorMeasurement< 3 >)
+%basic_facade_endpoints(ErrorPose, Ubitrack::Facade::BasicErrorPoseMeasurement)
+%basic_facade_endpoints(ScalarIntList, Ubitrack::Facade::BasicScalarIntListMeasurement)
+%basic_facade_endpoints(ScalarDoubleList, Ubitrack::Facade::BasicScalarDoubleListMeasurement)
+%basic_facade_endpoints(VectorList2, Ubitrack::Facade::BasicVectorListMeasurement< 2 >)
+%basic_facade_endpoints(VectorList3, Ubitrack::Facade::BasicVectorListMeasurement< 3 >)
+%basic_facade_endpoints(PoseList, Ubitrack::Facade::BasicPoseListMeasurement)
+%basic_facade_endpoints(ErrorVectorList2, Ubitrack::Facade::BasicErrorVectorListMeasurement< 2 >)
+%basic_facade_endpoints(ErrorVectorList3, Ubitrack::Facade::BasicErrorVectorListMeasurement< 3 >)
+%basic_facade_endpoints(ErrorPoseList, Ubitrack::Facade::BasicErrorPoseListMeasurement)
+%basic_facade_endpoints(CameraIntrinsics, Ubitrack::Facade::BasicCameraIntrinsicsMeasurement)
+
+#ifdef HAVE_OPENCV
+%basic_facade_endpoints(Image, Ubitrack::Facade::BasicImageMeasurement)
+
+#ifdef SWIGJAVA
+%extend Ubitrack::Facade::BasicImageMeasurement {
+	/**
+	 * the pixels without copying, getStep() * getDimY() bytes. The buffer holds a reference to
+	 * the measurement until it is collected, as long as delete() is not called on the measurement
+	 */
+	JavaByteView getDataBuffer()
+	{ return makeJavaByteView( $self->getDataPtr(), $self->getStep() * $self->getDimY() ); }
+}
+#endif
+#endif
+
+#endif // ENABLE_BASICFACADE
+
 /* also wrap the dataflow generation (pattern matching) */
 %inline %{
 namespace Ubitrack { namespace Graph {
@@ -0,0 +1,668 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @file
+ * Python bindings of the \c BasicFacade, built with pybind11.
+ *
+ * Measurements are shared with Python, never converted field by field. Values, lists and
+ * covariances are returned as NumPy arrays filled by a single bulk copy, images are exposed
+ * through the buffer protocol without copying the pixels.
+ *
+ * The GIL is released whenever a call may block on the dataflow, so pull sinks, loading and
+ * starting the dataflow do not stall other Python threads.
+ */
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+#include <stdexcept>
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+
+#include <utFacade/Config.h>
+#include <utFacade/BasicFacade.h>
+
+namespace py = pybind11;
+using namespace Ubitrack::Facade;
+
+
+namespace {
+
+typedef py::array_t< double, py::array::c_style | py::array::forcecast > DoubleArray;
+
+/** values of a vector, pose or rotation measurement as a 1D array, None if it is empty */
+template< class BMT >
+py::object vectorValues( BMT& m )
+{
+	py::array_t< double > a( static_cast< py::ssize_t >( m.size() ) );
+	if ( !m.get( static_cast< unsigned int >( a.size() ), a.mutable_data() ) )
+		return py::none();
+	return std::move( a );
+}
+
+/** values of a matrix measurement as a 2D array */
+template< class BMT >
+py::object matrixValues( BMT& m )
+{
+	py::array_t< double > a( std::vector< py::ssize_t >{ m.getDimX(), m.getDimY() } );
+	if ( !m.get( static_cast< unsigned int >( a.size() ), a.mutable_data() ) )
+		return py::none();
+	return std::move( a );
+}
+
+/** values of a list measurement as a 2D array with one row per element */
+template< class BMT >
+py::object listValues( BMT& m )
+{
+	py::array_t< double > a( std::vector< py::ssize_t >{ static_cast< py::ssize_t >( m.elementCount() ), m.size() } );
+	if ( !m.get( static_cast< unsigned int >( a.size() ), a.mutable_data() ) )
+		return py::none();
+	return std::move( a );
+}
+
+/** covariance of an error measurement as a 2D array, of a list of them as a 3D array */
+template< class BMT >
+py::object covariance( BMT& m, py::ssize_t dim, bool bList )
+{
+	std::vector< py::ssize_t > shape;
+	if ( bList )
+		shape.push_back( static_cast< py::ssize_t >( m.elementCount() ) );
+	shape.push_back( dim );
+	shape.push_back( dim );
+
+	py::array_t< double > a( shape );
+	if ( !m.getCovariance( static_cast< unsigned int >( a.size() ), a.mutable_data() ) )
+		return py::none();
+	return std::move( a );
+}
+
+/** creates a measurement from a flat array holding one value */
+template< class BMT >
+std::shared_ptr< BMT > fromArray( unsigned long long ts, DoubleArray a )
+{
+	if ( a.size() != BMT().size() )
+		throw py::value_error( "expected " + std::to_string( BMT().size() ) + " values" );
+	return std::make_shared< BMT >( ts, std::vector< double >( a.data(), a.data() + a.size() ) );
+}
+
+/** creates a list measurement from a 2D array with one row per element */
+template< class BMT >
+std::shared_ptr< BMT > listFromArray( unsigned long long ts, DoubleArray a )
+{
+	py::ssize_t dim = BMT().size();
+	if ( a.ndim() != 2 || a.shape( 1 ) != dim )
+		throw py::value_error( "expected an array of shape (n, " + std::to_string( dim ) + ")" );
+
+	std::vector< std::vector< double > > v( a.shape( 0 ) );
+	for ( py::ssize_t i = 0; i < a.shape( 0 ); i++ )
+		v[ i ].assign( a.data( i, 0 ), a.data( i, 0 ) + dim );
+	return std::make_shared< BMT >( ts, v );
+}
+
+/** a Python callable that can be copied and destroyed without holding the GIL */
+std::shared_ptr< py::function > sharedCallback( const py::function& f )
+{
+	return std::shared_ptr< py::function >( new py::function( f ), []( py::function* p )
+	{
+		py::gil_scoped_acquire gil;
+		delete p;
+	} );
+}
+
+/** reports the exception being handled as unraisable. Call with the GIL held, from a catch block */
+void discardException( const char* sContext )
+{
+	try
+	{
+		throw;
+	}
+	catch ( py::error_already_set& e )
+	{
+		e.discard_as_unraisable( sContext );
+		return;
+	}
+	catch ( const std::exception& e )
+	{
+		PyErr_SetString( PyExc_RuntimeError, e.what() );
+	}
+	catch ( ... )
+	{
+		PyErr_SetString( PyExc_RuntimeError, "unknown C++ exception" );
+	}
+	py::error_already_set().discard_as_unraisable( sContext );
+}
+
+/** calls a Python callback from a dataflow thread. Exceptions cannot propagate there and are reported */
+template< class... Args >
+void invokeCallback( const py::function& f, Args&&... args )
+{
+	py::gil_scoped_acquire gil;
+	try
+	{
+		f( std::forward< Args >( args )... );
+	}
+	catch ( ... )
+	{
+		discardException( "ubitrack push sink callback" );
+	}
+}
+
+/**
+ * Holder of the endpoints, deletes them without the GIL. Destroying a push sink waits for a
+ * running delivery, which may be waiting for the GIL in invokeCallback.
+ */
+struct GilReleasingDelete
+{
+	template< class T >
+	void operator()( T* p ) const
+	{
+		py::gil_scoped_release release;
+		delete p;
+	}
+};
+
+template< class T >
+using EndpointHolder = std::unique_ptr< T, GilReleasingDelete >;
+
+
+/**
+ * Collects the events of several push sinks and enters Python once per frame.
+ *
+ * A frame ends when an event with a different timestamp arrives or when \c maxDelay
+ * milliseconds have passed since its first event. The callback receives a list of
+ * (name, measurement) tuples and runs on a thread of the batch, so the dataflow threads
+ * never wait for the GIL.
+ */
+class PushSinkBatch
+{
+public:
+	PushSinkBatch( const py::function& callback, unsigned int maxDelay )
+		: m_pState( std::make_shared< State >( sharedCallback( callback ), maxDelay ) )
+	{
+		m_thread = std::thread( &PushSinkBatch::deliveryThread, m_pState );
+	}
+
+	~PushSinkBatch()
+	{
+		py::gil_scoped_release release;
+		close();
+
+		// destroyed by its own callback: the thread keeps the state alive until the callback has returned
+		if ( m_thread.joinable() )
+			m_thread.detach();
+	}
+
+	/** routes the events of a sink into this batch, replacing its callback */
+	template< class BMT >
+	void add( BasicPushSink< BMT >& sink, const std::string& sName )
+	{
+		std::shared_ptr< State > pState( m_pState );
+		{
+			std::lock_guard< std::mutex > l( pState->mutex );
+			pState->unregister.push_back( [ &sink ]() { sink.unregisterCallback(); } );
+		}
+		sink.registerCallback( [ pState, sName ]( std::shared_ptr< BMT >& m )
+		{ pState->push( sName, m, m->time() ); } );
+	}
+
+	/** detaches from all sinks and stops delivering. Pending events are dropped */
+	void close()
+	{
+		std::vector< std::function< void() > > unregister;
+		{
+			std::lock_guard< std::mutex > l( m_pState->mutex );
+			m_pState->bStop = true;
+			unregister.swap( m_pState->unregister );
+			m_pState->changed.notify_all();
+		}
+
+		for ( std::size_t i = 0; i < unregister.size(); i++ )
+			unregister[ i ]();
+
+		// the callback may close the batch itself, the thread ends when it returns
+		if ( m_thread.joinable() && m_thread.get_id() != std::this_thread::get_id() )
+			m_thread.join();
+	}
+
+protected:
+	typedef std::vector< std::pair< std::string, std::shared_ptr< BasicMeasurement > > > Frame;
+
+	/** shared with the delivery thread and the sink callbacks, so it outlives a batch destroyed by its own callback */
+	struct State
+	{
+		State( const std::shared_ptr< py::function >& pCallback, unsigned int maxDelay )
+			: pCallback( pCallback )
+			, maxDelay( std::chrono::milliseconds( maxDelay ) )
+			, frameTime( 0 )
+			, bStop( false )
+		{}
+
+		void push( const std::string& sName, const std::shared_ptr< BasicMeasurement >& m, unsigned long long ts )
+		{
+			std::lock_guard< std::mutex > l( mutex );
+			if ( bStop )
+				return;
+
+			if ( !pending.empty() && ts != frameTime )
+			{
+				ready.push_back( Frame() );
+				ready.back().swap( pending );
+			}
+
+			if ( pending.empty() )
+			{
+				frameTime = ts;
+				frameStart = std::chrono::steady_clock::now();
+			}
+			pending.push_back( std::make_pair( sName, m ) );
+			changed.notify_one();
+		}
+
+		std::shared_ptr< py::function > pCallback;
+		std::chrono::steady_clock::duration maxDelay;
+
+		/** the frame being collected, its timestamp and arrival of its first event */
+		Frame pending;
+		unsigned long long frameTime;
+		std::chrono::steady_clock::time_point frameStart;
+
+		/** complete frames waiting for delivery */
+		std::deque< Frame > ready;
+
+		std::vector< std::function< void() > > unregister;
+		bool bStop;
+		std::mutex mutex;
+		std::condition_variable changed;
+	};
+
+	static void deliveryThread( std::shared_ptr< State > pState )
+	{
+		State& state( *pState );
+		std::unique_lock< std::mutex > l( state.mutex );
+		while ( !state.bStop )
+		{
+			if ( state.ready.empty() && !state.pending.empty() && std::chrono::steady_clock::now() - state.frameStart >= state.maxDelay )
+			{
+				state.ready.push_back( Frame() );
+				state.ready.back().swap( state.pending );
+			}
+
+			if ( state.ready.empty() )
+			{
+				if ( state.pending.empty() )
+					state.changed.wait( l );
+				else
+					state.changed.wait_until( l, state.frameStart + state.maxDelay );
+				continue;
+			}
+
+			Frame frame;
+			frame.swap( state.ready.front() );
+			state.ready.pop_front();
+			l.unlock();
+
+			{
+				py::gil_scoped_acquire gil;
+				try
+				{
+					py::list events;
+					for ( std::size_t i = 0; i < frame.size(); i++ )
+						events.append( py::make_tuple( frame[ i ].first, frame[ i ].second ) );
+					( *state.pCallback )( events );
+				}
+				catch ( ... )
+				{
+					discardException( "ubitrack push sink batch callback" );
+				}
+			}
+
+			l.lock();
+		}
+	}
+
+	std::shared_ptr< State > m_pState;
+	std::thread m_thread;
+};
+
+
+/** binds a measurement class, derived from BasicMeasurement and held by std::shared_ptr */
+template< class BMT >
+py::class_< BMT, BasicMeasurement, std::shared_ptr< BMT > > bindMeasurement( py::module& m, const char* sName )
+{
+	return py::class_< BMT, BasicMeasurement, std::shared_ptr< BMT > >( m, sName )
+		.def( py::init<>() );
+}
+
+template< class BMT >
+void bindVector( py::module& m, const char* sName )
+{
+	bindMeasurement< BMT >( m, sName )
+		.def( py::init( &fromArray< BMT > ), py::arg( "timestamp" ), py::arg( "values" ) )
+		.def( "values", &vectorValues< BMT > );
+}
+
+template< class BMT >
+void bindMatrix( py::module& m, const char* sName )
+{
+	bindMeasurement< BMT >( m, sName )
+		.def( py::init( &fromArray< BMT > ), py::arg( "timestamp" ), py::arg( "values" ) )
+		.def( "values", &matrixValues< BMT > );
+}
+
+template< class BMT >
+void bindErrorVector( py::module& m, const char* sName, py::ssize_t covarianceDim )
+{
+	bindMeasurement< BMT >( m, sName )
+		.def( "values", &vectorValues< BMT > )
+		.def( "covariance", [ covarianceDim ]( BMT& e ) { return covariance( e, covarianceDim, false ); } );
+}
+
+template< class BMT >
+void bindList( py::module& m, const char* sName )
+{
+	bindMeasurement< BMT >( m, sName )
+		.def( py::init( &listFromArray< BMT > ), py::arg( "timestamp" ), py::arg( "values" ) )
+		.def( "__len__", &BMT::elementCount )
+		.def( "values", &listValues< BMT > );
+}
+
+template< class BMT >
+void bindErrorList( py::module& m, const char* sName, py::ssize_t covarianceDim )
+{
+	bindMeasurement< BMT >( m, sName )
+		.def( "__len__", &BMT::elementCount )
+		.def( "values", &listValues< BMT > )
+		.def( "covariance", [ covarianceDim ]( BMT& e ) { return covariance( e, covarianceDim, true ); } );
+}
+
+
+/**
+ * Binds the sinks and the source of one measurement type and the facade methods creating them,
+ * e.g. getPosePullSink returning a BasicPosePullSink.
+ */
+template< class BMT >
+void bindEndpoints( py::module& m, py::class_< BasicFacade >& facade, py::class_< PushSinkBatch >& batch, const std::string& sName )
+{
+	typedef BasicPullSink< BMT > PullSink;
+	typedef BasicPushSink< BMT > PushSink;
+	typedef BasicPushSource< BMT > PushSource;
+
+	py::class_< PullSink, EndpointHolder< PullSink > >( m, ( "Basic" + sName + "PullSink" ).c_str() )
+		.def( "get", &PullSink::get, py::arg( "timestamp" ), py::call_guard< py::gil_scoped_release >() );
+
+	py::class_< PushSink, EndpointHolder< PushSink > >( m, ( "Basic" + sName + "PushSink" ).c_str() )
+		.def( "registerCallback", []( PushSink& sink, const py::function& f )
+		{
+			std::shared_ptr< py::function > pCallback( sharedCallback( f ) );
+			py::gil_scoped_release release;
+			sink.registerCallback( [ pCallback ]( std::shared_ptr< BMT >& measurement )
+			{ invokeCallback( *pCallback, measurement ); } );
+		}, py::arg( "callback" ) )
+		.def( "unregisterCallback", &PushSink::unregisterCallback, py::call_guard< py::gil_scoped_release >() );
+
+	py::class_< PushSource, EndpointHolder< PushSource > >( m, ( "Basic" + sName + "PushSource" ).c_str() )
+		.def( "send", &PushSource::send, py::arg( "measurement" ), py::call_guard< py::gil_scoped_release >() );
+
+	// the facade hands out new objects, the Python wrapper owns them and keeps the facade alive.
+	// They are deleted by EndpointHolder, without the GIL
+	facade
+		.def( ( "get" + sName + "PullSink" ).c_str(), &BasicFacade::getPullSink< BMT >,
+			py::arg( "name" ), py::return_value_policy::take_ownership, py::keep_alive< 0, 1 >() )
+		.def( ( "get" + sName + "PushSink" ).c_str(), &BasicFacade::getPushSink< BMT >,
+			py::arg( "name" ), py::return_value_policy::take_ownership, py::keep_alive< 0, 1 >() )
+		.def( ( "get" + sName + "PushSource" ).c_str(), &BasicFacade::getPushSource< BMT >,
+			py::arg( "name" ), py::return_value_policy::take_ownership, py::keep_alive< 0, 1 >() );
+
+	// the batch detaches from the sink when closed, so keep the sink alive until then
+	batch.def( "add", []( PushSinkBatch& b, PushSink& sink, const std::string& sEventName )
+	{
+		py::gil_scoped_release release;
+		b.add( sink, sEventName );
+	}, py::arg( "sink" ), py::arg( "name" ), py::keep_alive< 1, 2 >() );
+}
+
+#ifdef HAVE_OPENCV
+/** describes the pixels of an image for the buffer protocol, rows x columns x channels */
+py::buffer_info imageBuffer( BasicImageMeasurement& image )
+{
+	if ( !image.isValid() || !image.getDataPtr() )
+		throw py::value_error( "image measurement is empty" );
+
+	py::ssize_t channels = image.getChannels();
+	py::ssize_t elementSize = image.getPixelSize() / 8 / channels;
+
+	std::string format;
+	switch ( elementSize )
+	{
+	case 1: format = py::format_descriptor< unsigned char >::format(); break;
+	case 2: format = py::format_descriptor< unsigned short >::format(); break;
+	case 4: format = py::format_descriptor< float >::format(); break;
+	case 8: format = py::format_descriptor< double >::format(); break;
+	default: throw py::value_error( "unsupported pixel size" );
+	}
+
+	return py::buffer_info( image.getDataPtr(), elementSize, format, 3,
+		{ static_cast< py::ssize_t >( image.getDimY() ), static_cast< py::ssize_t >( image.getDimX() ), channels },
+		{ static_cast< py::ssize_t >( image.getStep() ), elementSize * channels, elementSize } );
+}
+#endif
+
+} // anonymous namespace
+
+
+PYBIND11_MODULE( ubitrack, m )
+{
+	m.doc() = "Ubitrack BasicFacade bindings";
+
+	m.def( "initUbitrackLogging", &initUbitrackLogging, py::arg( "filename" ) );
+
+	py::class_< BasicMeasurement, std::shared_ptr< BasicMeasurement > > measurement( m, "BasicMeasurement" );
+	measurement
+		.def( "time", &BasicMeasurement::time )
+		.def( "isValid", &BasicMeasurement::isValid )
+		.def( "getDataType", &BasicMeasurement::getDataType )
+		.def( "size", &BasicMeasurement::size )
+		.def( "getDimX", &BasicMeasurement::getDimX )
+		.def( "getDimY", &BasicMeasurement::getDimY )
+		.def( "getDimZ", &BasicMeasurement::getDimZ );
+
+	py::enum_< BasicMeasurement::DataType >( measurement, "DataType" )
+		.value( "SCALARI", BasicMeasurement::SCALARI )
+		.value( "SCALARD", BasicMeasurement::SCALARD )
+		.value( "VECTORD", BasicMeasurement::VECTORD )
+		.value( "MATRIXD", BasicMeasurement::MATRIXD )
+		.value( "POSE", BasicMeasurement::POSE )
+		.value( "QUATERNION", BasicMeasurement::QUATERNION )
+		.value( "ERROR_VECTOR", BasicMeasurement::ERROR_VECTOR )
+		.value( "ERROR_POSE", BasicMeasurement::ERROR_POSE )
+		.value( "CAMERA_INTRINSICS", BasicMeasurement::CAMERA_INTRINSICS )
+#ifdef HAVE_OPENCV
+		.value( "IMAGE", BasicMeasurement::IMAGE )
+#endif
+		.value( "SCALARI_LIST", BasicMeasurement::SCALARI_LIST )
+		.value( "SCALARD_LIST", BasicMeasurement::SCALARD_LIST )
+		.value( "VECTORD_LIST", BasicMeasurement::VECTORD_LIST )
+		.value( "MATRIXD_LIST", BasicMeasurement::MATRIXD_LIST )
+		.value( "POSE_LIST", BasicMeasurement::POSE_LIST )
+		.value( "QUATERNION_LIST", BasicMeasurement::QUATERNION_LIST )
+		.value( "ERROR_VECTOR_LIST", BasicMeasurement::ERROR_VECTOR_LIST )
+		.value( "ERROR_POSE_LIST", BasicMeasurement::ERROR_POSE_LIST );
+
+	// single measurements
+	bindMeasurement< BasicScalarIntMeasurement >( m, "BasicScalarIntMeasurement" )
+		.def( py::init< unsigned long long, int >(), py::arg( "timestamp" ), py::arg( "value" ) )
+		.def( "value", []( BasicScalarIntMeasurement& s ) -> py::object
+		{
+			int v;
+			if ( !s.get( v ) )
+				return py::none();
+			return py::int_( v );
+		} );
+
+	bindMeasurement< BasicScalarDoubleMeasurement >( m, "BasicScalarDoubleMeasurement" )
+		.def( py::init< unsigned long long, double >(), py::arg( "timestamp" ), py::arg( "value" ) )
+		.def( "value", []( BasicScalarDoubleMeasurement& s ) -> py::object
+		{
+			double v;
+			if ( !s.get( v ) )
+				return py::none();
+			return py::float_( v );
+		} );
+
+	bindVector< BasicVectorMeasurement< 2 > >( m, "BasicVector2Measurement" );
+	bindVector< BasicVectorMeasurement< 3 > >( m, "BasicVector3Measurement" );
+	bindVector< BasicVectorMeasurement< 4 > >( m, "BasicVector4Measurement" );
+	bindVector< BasicVectorMeasurement< 8 > >( m, "BasicVector8Measurement" );
+	bindMatrix< BasicMatrixMeasurement< 3, 3 > >( m, "BasicMatrix3x3Measurement" );
+	bindMatrix< BasicMatrixMeasurement< 3, 4 > >( m, "BasicMatrix3x4Measurement" );
+	bindMatrix< BasicMatrixMeasurement< 4, 4 > >( m, "BasicMatrix4x4Measurement" );
+	bindVector< BasicPoseMeasurement >( m, "BasicPoseMeasurement" );
+	bindVector< BasicRotationMeasurement >( m, "BasicRotationMeasurement" );
+	bindErrorVector< BasicErrorVectorMeasurement< 2 > >( m, "BasicErrorVector2Measurement", 2 );
+	bindErrorVector< BasicErrorVectorMeasurement< 3 > >( m, "BasicErrorVector3Measurement", 3 );
+	bindErrorVector< BasicErrorPoseMeasurement >( m, "BasicErrorPoseMeasurement", 6 );
+
+	// list measurements
+	bindMeasurement< BasicScalarIntListMeasurement >( m, "BasicScalarIntListMeasurement" )
+		.def( "__len__", &BasicScalarIntListMeasurement::elementCount )
+		.def( "values", []( BasicScalarIntListMeasurement& l ) -> py::object
+		{
+			py::array_t< int > a( static_cast< py::ssize_t >( l.elementCount() ) );
+			if ( !l.get( static_cast< unsigned int >( a.size() ), a.mutable_data() ) )
+				return py::none();
+			return std::move( a );
+		} );
+
+	bindMeasurement< BasicScalarDoubleListMeasurement >( m, "BasicScalarDoubleListMeasurement" )
+		.def( "__len__", &BasicScalarDoubleListMeasurement::elementCount )
+		.def( "values", []( BasicScalarDoubleListMeasurement& l ) -> py::object
+		{
+			py::array_t< double > a( static_cast< py::ssize_t >( l.elementCount() ) );
+			if ( !l.get( static_cast< unsigned int >( a.size() ), a.mutable_data() ) )
+				return py::none();
+			return std::move( a );
+		} );
+
+	bindList< BasicVectorListMeasurement< 2 > >( m, "BasicVectorList2Measurement" );
+	bindList< BasicVectorListMeasurement< 3 > >( m, "BasicVectorList3Measurement" );
+	bindList< BasicPoseListMeasurement >( m, "BasicPoseListMeasurement" );
+	bindErrorList< BasicErrorVectorListMeasurement< 2 > >( m, "BasicErrorVectorList2Measurement", 2 );
+	bindErrorList< BasicErrorVectorListMeasurement< 3 > >( m, "BasicErrorVectorList3Measurement", 3 );
+	bindErrorList< BasicErrorPoseListMeasurement >( m, "BasicErrorPoseListMeasurement", 6 );
+
+	bindMeasurement< BasicCameraIntrinsicsMeasurement >( m, "BasicCameraIntrinsicsMeasurement" );
+
+#ifdef HAVE_OPENCV
+	py::class_< BasicImageMeasurement, BasicMeasurement, std::shared_ptr< BasicImageMeasurement > > image( m, "BasicImageMeasurement", py::buffer_protocol() );
+	py::enum_< BasicImageMeasurement::PixelFormat >( image, "PixelFormat" )
+		.value( "UNKNOWN_PIXELFORMAT", BasicImageMeasurement::UNKNOWN_PIXELFORMAT )
+		.value( "LUMINANCE", BasicImageMeasurement::LUMINANCE )
+		.value( "RGB", BasicImageMeasurement::RGB )
+		.value( "BGR", BasicImageMeasurement::BGR )
+		.value( "RGBA", BasicImageMeasurement::RGBA )
+		.value( "BGRA", BasicImageMeasurement::BGRA )
+		.value( "YUV422", BasicImageMeasurement::YUV422 )
+		.value( "YUV411", BasicImageMeasurement::YUV411 )
+		.value( "RAW", BasicImageMeasurement::RAW )
+		.value( "DEPTH", BasicImageMeasurement::DEPTH );
+
+	// numpy.asarray( image ) and image.pixels() are views of the image, which stays alive as long as they do
+	image
+		.def( py::init<>() )
+		.def_buffer( &imageBuffer )
+		.def( "pixels", []( py::object self ) { return py::array( imageBuffer( self.cast< BasicImageMeasurement& >() ), self ); } )
+		.def( "getPixelFormat", &BasicImageMeasurement::getPixelFormat )
+		.def( "getOrigin", &BasicImageMeasurement::getOrigin )
+		.def( "getChannels", &BasicImageMeasurement::getChannels )
+		.def( "getStep", &BasicImageMeasurement::getStep )
+		.def( "setTime", &BasicImageMeasurement::setTime, py::arg( "timestamp" ) );
+#endif
+
+	py::class_< PushSinkBatch > batch( m, "PushSinkBatch" );
+	batch
+		.def( py::init< const py::function&, unsigned int >(), py::arg( "callback" ), py::arg( "maxDelay" ) = 5 )
+		.def( "close", &PushSinkBatch::close, py::call_guard< py::gil_scoped_release >() );
+
+	py::class_< BasicFacade > facade( m, "BasicFacade" );
+	facade
+		.def( py::init< const char*, bool >(), py::arg( "componentPath" ) = UBITRACK_COMPONENTS_PATH, py::arg( "dropEvents" ) = true )
+		.def_static( "now", &BasicFacade::now )
+		.def( "currentTime", &BasicFacade::currentTime )
+		.def( "getLastError", &BasicFacade::getLastError )
+		.def( "loadDataflow", &BasicFacade::loadDataflow, py::arg( "file" ), py::arg( "replace" ) = true,
+			py::call_guard< py::gil_scoped_release >() )
+		.def( "loadDataflowString", &BasicFacade::loadDataflowString, py::arg( "dataflow" ), py::arg( "replace" ) = true,
+			py::call_guard< py::gil_scoped_release >() )
+		.def( "clearDataflow", &BasicFacade::clearDataflow, py::call_guard< py::gil_scoped_release >() )
+		.def( "startDataflow", &BasicFacade::startDataflow, py::call_guard< py::gil_scoped_release >() )
+		.def( "stopDataflow", static_cast< void ( BasicFacade::* )() >( &BasicFacade::stopDataflow ),
+			py::call_guard< py::gil_scoped_release >() )
+		.def( "stopDataflow", static_cast< bool ( BasicFacade::* )( unsigned int ) >( &BasicFacade::stopDataflow ),
+			py::arg( "drainTimeout" ), py::call_guard< py::gil_scoped_release >() )
+		.def( "pauseDataflow", &BasicFacade::pauseDataflow, py::call_guard< py::gil_scoped_release >() )
+		.def( "resumeDataflow", &BasicFacade::resumeDataflow, py::call_guard< py::gil_scoped_release >() )
+		.def( "waitForIdle", &BasicFacade::waitForIdle, py::call_guard< py::gil_scoped_release >() )
+		.def( "connectToServer", &BasicFacade::connectToServer, py::arg( "address" ),
+			py::call_guard< py::gil_scoped_release >() )
+		.def( "sendUtqlToServerString", &BasicFacade::sendUtqlToServerString, py::arg( "utql" ),
+			py::call_guard< py::gil_scoped_release >() )
+#ifdef HAVE_OPENCV
+		.def( "getLatestImage", []( BasicFacade& f, const char* sSinkName )
+		{ return f.getLatestImage( sSinkName ); }, py::arg( "name" ), py::call_guard< py::gil_scoped_release >() )
+#endif
+		;
+
+	bindEndpoints< BasicScalarIntMeasurement >( m, facade, batch, "ScalarInt" );
+	bindEndpoints< BasicScalarDoubleMeasurement >( m, facade, batch, "ScalarDouble" );
+	bindEndpoints< BasicVectorMeasurement< 2 > >( m, facade, batch, "Vector2" );
+	bindEndpoints< BasicVectorMeasurement< 3 > >( m, facade, batch, "Vector3" );
+	bindEndpoints< BasicVectorMeasurement< 4 > >( m, facade, batch, "Vector4" );
+	bindEndpoints< BasicVectorMeasurement< 8 > >( m, facade, batch, "Vector8" );
+	bindEndpoints< BasicMatrixMeasurement< 3, 3 > >( m, facade, batch, "Matrix3x3" );
+	bindEndpoints< BasicMatrixMeasurement< 3, 4 > >( m, facade, batch, "Matrix3x4" );
+	bindEndpoints< BasicMatrixMeasurement< 4, 4 > >( m, facade, batch, "Matrix4x4" );
+	bindEndpoints< BasicPoseMeasurement >( m, facade, batch, "Pose" );
+	bindEndpoints< BasicRotationMeasurement >( m, facade, batch, "Rotation" );
+	bindEndpoints< BasicErrorVectorMeasurement< 2 > >( m, facade, batch, "ErrorVector2" );
+	bindEndpoints< BasicErrorVectorMeasurement< 3 > >( m, facade, batch, "ErrorVector3" );
+	bindEndpoints< BasicErrorPoseMeasurement >( m, facade, batch, "ErrorPose" );
+	bindEndpoints< BasicScalarIntListMeasurement >( m, facade, batch, "ScalarIntList" );
+	bindEndpoints< BasicScalarDoubleListMeasurement >( m, facade, batch, "ScalarDoubleList" );
+	bindEndpoints< BasicVectorListMeasurement< 2 > >( m, facade, batch, "VectorList2" );
+	bindEndpoints< BasicVectorListMeasurement< 3 > >( m, facade, batch, "VectorList3" );
+	bindEndpoints< BasicPoseListMeasurement >( m, facade, batch, "PoseList" );
+	bindEndpoints< BasicErrorVectorListMeasurement< 2 > >( m, facade, batch, "ErrorVectorList2" );
+	bindEndpoints< BasicErrorVectorListMeasurement< 3 > >( m, facade, batch, "ErrorVectorList3" );
+	bindEndpoints< BasicErrorPoseListMeasurement >( m, facade, batch, "ErrorPoseList" );
+	bindEndpoints< BasicCameraIntrinsicsMeasurement >( m, facade, batch, "CameraIntrinsics" );
+#ifdef HAVE_OPENCV
+	bindEndpoints< BasicImageMeasurement >( m, facade, batch, "Image" );
+#endif
+}
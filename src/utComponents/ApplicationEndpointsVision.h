@@ -36,18 +36,411 @@
 #ifndef __UBITRACK_COMPONENTS_APPLICATIONENDPOINTSVISION_H_INCLUDED__
 #define __UBITRACK_COMPONENTS_APPLICATIONENDPOINTSVISION_H_INCLUDED__
 
+#include <set>
+#include <sstream>
+#include <algorithm>
+#include <boost/thread/mutex.hpp>
+#include <boost/atomic.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <utComponents/ApplicationPushSink.h>
 #include <utComponents/ApplicationPullSink.h>
 #include <utComponents/ApplicationPushSource.h>
 #include <utComponents/ApplicationPullSource.h>
+#include <utGraph/UTQLSubgraph.h>
+#include <utUtil/Exception.h>
 #include <utVision/Image.h>
+#include <utFacade/SharedFrameRing.h>
+#include <opencv2/imgproc.hpp>
 
 
 namespace Ubitrack { namespace Components {
 
-typedef ApplicationPushSink< Measurement::ImageMeasurement > ApplicationPushSinkVisionImage;
-typedef ApplicationPullSink< Measurement::ImageMeasurement > ApplicationPullSinkVisionImage;
-typedef ApplicationPushSource< Measurement::ImageMeasurement > ApplicationPushSourceVisionImage;
+/**
+ * Registers the image queue length requested by one image endpoint.
+ *
+ * This is a process-global knob. The dataflow takes the queue limit from
+ * \c EventTypeTraits::getMaxQueueLength, which has no access to the port or the component, so
+ * the longest queue requested by any existing image endpoint applies to every image port of
+ * every facade in the process, including ports between other components. An endpoint asking
+ * for 10 images therefore lets any image port hold up to 10 images, with the memory this takes.
+ * The limit drops again when the endpoint is destroyed. Without endpoints requesting more, it
+ * stays at one image.
+ */
+class ImageQueueLength
+{
+public:
+	/** reads the \c queueLength attribute of an image endpoint, 1 if absent */
+	explicit ImageQueueLength( boost::shared_ptr< Graph::UTQLSubgraph > subgraph )
+		: m_nLength( 1 )
+	{
+		if ( subgraph && subgraph->m_DataflowAttributes.hasAttribute( "queueLength" ) )
+			subgraph->m_DataflowAttributes.getAttributeData( "queueLength", m_nLength );
+		if ( m_nLength < 1 )
+			UBITRACK_THROW( "queueLength of an image endpoint must be at least 1" );
+
+		boost::mutex::scoped_lock l( mutex() );
+		requests().insert( m_nLength );
+		update();
+	}
+
+	~ImageQueueLength()
+	{
+		boost::mutex::scoped_lock l( mutex() );
+		requests().erase( requests().find( m_nLength ) );
+		update();
+	}
+
+	/** the queue length requested by this endpoint */
+	int length() const
+	{ return m_nLength; }
+
+	/** the queue length currently applied to image events */
+	static int maximum()
+	{ return current().load( boost::memory_order_relaxed ); }
+
+protected:
+	static boost::mutex& mutex()
+	{
+		static boost::mutex m;
+		return m;
+	}
+
+	static std::multiset< int >& requests()
+	{
+		static std::multiset< int > r;
+		return r;
+	}
+
+	static boost::atomic< int >& current()
+	{
+		static boost::atomic< int > n( 1 );
+		return n;
+	}
+
+	/** called with the mutex held */
+	static void update()
+	{ current().store( requests().empty() ? 1 : *requests().rbegin(), boost::memory_order_relaxed ); }
+
+	int m_nLength;
+};
+
+
+/**
+ * Region of interest and scale applied by the image sinks before images reach the application.
+ *
+ * The region is cut out of the image in memory row order and then resized with area
+ * interpolation (default) or bilinear interpolation. Reduced images are new images, the
+ * images in the dataflow are not touched. Packed and raw formats (YUV422, YUV411, RAW) pass
+ * unchanged, as their pixels cannot be resized independently.
+ *
+ * @par Configuration
+ * - \c roi: "x y width height", a width or height of 0 extends the region to the image border
+ * - \c scale: factor in (0, 1], default 1
+ * - \c interpolation: \c area (default) or \c linear
+ *
+ * The settings can be changed at any time, see \c BasicFacade::setImageReduction.
+ */
+class ImageReduction
+{
+public:
+	/** the reduction settings, all defaults mean no reduction */
+	struct Settings
+	{
+		Settings()
+			: roiX( 0 )
+			, roiY( 0 )
+			, roiWidth( 0 )
+			, roiHeight( 0 )
+			, scale( 1.0 )
+			, bLinear( false )
+		{}
+
+		bool isActive() const
+		{ return roiX > 0 || roiY > 0 || roiWidth > 0 || roiHeight > 0 || scale != 1.0; }
+
+		int roiX;
+		int roiY;
+		int roiWidth;
+		int roiHeight;
+		double scale;
+
+		/** bilinear instead of area interpolation */
+		bool bLinear;
+	};
+
+	explicit ImageReduction( boost::shared_ptr< Graph::UTQLSubgraph > subgraph )
+	{
+		if ( !subgraph )
+			return;
+
+		Settings settings;
+		if ( subgraph->m_DataflowAttributes.hasAttribute( "roi" ) )
+		{
+			std::istringstream roi( subgraph->m_DataflowAttributes.getAttributeString( "roi" ) );
+			if ( !( roi >> settings.roiX >> settings.roiY >> settings.roiWidth >> settings.roiHeight ) )
+				UBITRACK_THROW( "roi of an image sink must be \"x y width height\"" );
+		}
+
+		if ( subgraph->m_DataflowAttributes.hasAttribute( "scale" ) )
+			subgraph->m_DataflowAttributes.getAttributeData( "scale", settings.scale );
+
+		if ( subgraph->m_DataflowAttributes.hasAttribute( "interpolation" ) )
+		{
+			std::string sInterpolation( subgraph->m_DataflowAttributes.getAttributeString( "interpolation" ) );
+			if ( sInterpolation == "linear" )
+				settings.bLinear = true;
+			else if ( sInterpolation != "area" )
+				UBITRACK_THROW( "Unknown interpolation \"" + sInterpolation + "\" of an image sink" );
+		}
+
+		setReduction( settings );
+	}
+
+	virtual ~ImageReduction()
+	{}
+
+	/** changes the settings, effective for the next image */
+	void setReduction( const Settings& settings )
+	{
+		if ( settings.roiX < 0 || settings.roiY < 0 || settings.roiWidth < 0 || settings.roiHeight < 0 )
+			UBITRACK_THROW( "roi of an image sink must not be negative" );
+		if ( !( settings.scale > 0.0 && settings.scale <= 1.0 ) )
+			UBITRACK_THROW( "scale of an image sink must be in (0, 1]" );
+
+		boost::mutex::scoped_lock l( m_reductionMutex );
+		m_reduction = settings;
+	}
+
+	/** the current settings */
+	Settings reduction() const
+	{
+		boost::mutex::scoped_lock l( m_reductionMutex );
+		return m_reduction;
+	}
+
+	/** returns the reduced image, or \c m itself if there is nothing to reduce */
+	Measurement::ImageMeasurement reduce( const Measurement::ImageMeasurement& m ) const
+	{
+		Settings settings( reduction() );
+		if ( !m || !settings.isActive() )
+			return m;
+
+		const Vision::Image& src( *m );
+		if ( src.pixelFormat() == Vision::Image::YUV422 || src.pixelFormat() == Vision::Image::YUV411 ||
+			src.pixelFormat() == Vision::Image::RAW || src.width() <= 0 || src.height() <= 0 )
+			return m;
+
+		// clip the region to the image, keeping at least one pixel
+		int x = std::min( settings.roiX, src.width() - 1 );
+		int y = std::min( settings.roiY, src.height() - 1 );
+		int width = settings.roiWidth > 0 ? std::min( settings.roiWidth, src.width() - x ) : src.width() - x;
+		int height = settings.roiHeight > 0 ? std::min( settings.roiHeight, src.height() - y ) : src.height() - y;
+
+		int dstWidth = std::max( 1, static_cast< int >( width * settings.scale + 0.5 ) );
+		int dstHeight = std::max( 1, static_cast< int >( height * settings.scale + 0.5 ) );
+		if ( x == 0 && y == 0 && dstWidth == src.width() && dstHeight == src.height() )
+			return m;
+
+		cv::Mat roi( src.Mat(), cv::Rect( x, y, width, height ) );
+		boost::shared_ptr< Vision::Image > pDst( new Vision::Image( dstWidth, dstHeight, src.channels(), src.depth(), src.origin() ) );
+		pDst->set_pixelFormat( src.pixelFormat() );
+
+		if ( dstWidth == width && dstHeight == height )
+			roi.copyTo( pDst->Mat() );
+		else
+			cv::resize( roi, pDst->Mat(), cv::Size( dstWidth, dstHeight ), 0, 0,
+				settings.bLinear ? cv::INTER_LINEAR : cv::INTER_AREA );
+
+		return Measurement::ImageMeasurement( m.time(), pDst );
+	}
+
+protected:
+	Settings m_reduction;
+	mutable boost::mutex m_reductionMutex;
+};
+
+
+/**
+ * @ingroup dataflow_components
+ * Application push sink for images.
+ *
+ * @par Configuration
+ * - \c queueLength: number of images that may wait for this sink in the dataflow, default 1.
+ *   See \c ImageQueueLength for how it combines with other image endpoints.
+ * - \c mode: \c queue (default) delivers every image to the callback. \c mailbox keeps only the
+ *   newest image for \c latest() and calls no callback, so slow readers never hold up the dataflow.
+ *   \c sharedMemory copies every image into a \c Facade::SharedFrameRingWriter for other processes
+ *   and calls no callback either.
+ * - \c sharedMemoryName: name of the shared memory in \c sharedMemory mode
+ * - \c sharedMemorySlots: number of frames kept in the shared memory, default 3
+ * - \c roi, \c scale, \c interpolation: see \c ImageReduction. Applies in all modes.
+ */
+class ApplicationPushSinkVisionImage
+	: public ApplicationPushSink< Measurement::ImageMeasurement >
+	, public ImageReduction
+{
+public:
+	ApplicationPushSinkVisionImage( const std::string& nm, boost::shared_ptr< Graph::UTQLSubgraph > subgraph )
+		: ApplicationPushSink< Measurement::ImageMeasurement >( nm, subgraph )
+		, ImageReduction( subgraph )
+		, m_queueLength( subgraph )
+		, m_mode( QUEUE )
+		, m_nSequence( 0 )
+		, m_nSharedMemorySlots( 3 )
+	{
+		if ( subgraph && subgraph->m_DataflowAttributes.hasAttribute( "mode" ) )
+		{
+			std::string sMode( subgraph->m_DataflowAttributes.getAttributeString( "mode" ) );
+			if ( sMode == "mailbox" )
+				m_mode = MAILBOX;
+			else if ( sMode == "sharedMemory" )
+				m_mode = SHARED_MEMORY;
+			else if ( sMode != "queue" )
+				UBITRACK_THROW( "Unknown mode \"" + sMode + "\" of ApplicationPushSinkVisionImage " + nm );
+		}
+
+		if ( m_mode == SHARED_MEMORY )
+		{
+			m_sSharedMemoryName = subgraph->m_DataflowAttributes.getAttributeString( "sharedMemoryName" );
+			if ( m_sSharedMemoryName.empty() )
+				UBITRACK_THROW( "ApplicationPushSinkVisionImage " + nm + " needs a sharedMemoryName in sharedMemory mode" );
+			if ( subgraph->m_DataflowAttributes.hasAttribute( "sharedMemorySlots" ) )
+				subgraph->m_DataflowAttributes.getAttributeData( "sharedMemorySlots", m_nSharedMemorySlots );
+			if ( m_nSharedMemorySlots < 2 )
+				UBITRACK_THROW( "sharedMemorySlots of ApplicationPushSinkVisionImage " + nm + " must be at least 2" );
+		}
+	}
+
+	/** true if the sink keeps the newest image instead of calling the callback */
+	bool isMailbox() const
+	{ return m_mode == MAILBOX; }
+
+	/**
+	 * Returns the newest image in mailbox mode, an empty measurement if none has arrived yet.
+	 *
+	 * @param pSequence if given, receives the number of images received so far, to detect new images
+	 */
+	Measurement::ImageMeasurement latest( unsigned long long* pSequence = 0 ) const
+	{
+		boost::mutex::scoped_lock l( m_mailboxMutex );
+		if ( pSequence )
+			*pSequence = m_nSequence;
+		return m_latest;
+	}
+
+protected:
+	enum Mode { QUEUE, MAILBOX, SHARED_MEMORY };
+
+	void pushHandler( const Measurement::ImageMeasurement& m )
+	{
+		if ( m_mode == QUEUE )
+		{
+			ApplicationPushSink< Measurement::ImageMeasurement >::pushHandler( reduce( m ) );
+			return;
+		}
+
+		if ( m_mode == SHARED_MEMORY )
+		{
+			countEvent();
+			publish( reduce( m ) );
+			return;
+		}
+
+		countEvent();
+
+		// the replaced image is released outside the lock
+		Measurement::ImageMeasurement previous( reduce( m ) );
+		{
+			boost::mutex::scoped_lock l( m_mailboxMutex );
+			m_latest.swap( previous );
+			m_nSequence++;
+		}
+	}
+
+	/** copies an image into the shared memory, replacing the ring by a larger one if needed */
+	void publish( const Measurement::ImageMeasurement& m )
+	{
+		if ( !m )
+			return;
+
+		const cv::Mat& mat( m->Mat() );
+		std::size_t rowBytes = mat.cols * mat.elemSize();
+		try
+		{
+			if ( !m_pRing || rowBytes * mat.rows > m_pRing->slotCapacity() )
+			{
+				// readers of the old ring see it closed and open the new one
+				m_pRing.reset();
+				m_pRing.reset( new Facade::SharedFrameRingWriter( m_sSharedMemoryName, m_nSharedMemorySlots, rowBytes * mat.rows ) );
+			}
+
+			m_pRing->write( m.time(), m->width(), m->height(), m->pixelFormat(), m->channels(), m->depth(), m->origin(),
+				rowBytes, mat.ptr(), mat.step );
+		}
+		catch ( const boost::interprocess::interprocess_exception& e )
+		{
+#ifndef APPLICATIONPUSHSINK_NOLOGGING
+			LOG4CPP_ERROR( m_logger, "Cannot publish image of " << getName() << " in shared memory \""
+				<< m_sSharedMemoryName << "\": " << e.what() );
+#endif
+		}
+	}
+
+	ImageQueueLength m_queueLength;
+	Mode m_mode;
+
+	Measurement::ImageMeasurement m_latest;
+	unsigned long long m_nSequence;
+	mutable boost::mutex m_mailboxMutex;
+
+	std::string m_sSharedMemoryName;
+	unsigned int m_nSharedMemorySlots;
+	boost::scoped_ptr< Facade::SharedFrameRingWriter > m_pRing;
+};
+
+
+/**
+ * @ingroup dataflow_components
+ * Application push source for images.
+ *
+ * @par Configuration
+ * \c queueLength: number of images that may wait at the consumers of this source, default 1.
+ * See \c ImageQueueLength for how it combines with other image endpoints.
+ */
+class ApplicationPushSourceVisionImage
+	: public ApplicationPushSource< Measurement::ImageMeasurement >
+{
+public:
+	ApplicationPushSourceVisionImage( const std::string& nm, boost::shared_ptr< Graph::UTQLSubgraph > subgraph )
+		: ApplicationPushSource< Measurement::ImageMeasurement >( nm, subgraph )
+		, m_queueLength( subgraph )
+	{}
+
+protected:
+	ImageQueueLength m_queueLength;
+};
+
+/**
+ * @ingroup dataflow_components
+ * Application pull sink for images.
+ *
+ * @par Configuration
+ * \c roi, \c scale, \c interpolation: see \c ImageReduction.
+ */
+class ApplicationPullSinkVisionImage
+	: public ApplicationPullSink< Measurement::ImageMeasurement >
+	, public ImageReduction
+{
+public:
+	ApplicationPullSinkVisionImage( const std::string& nm, boost::shared_ptr< Graph::UTQLSubgraph > subgraph )
+		: ApplicationPullSink< Measurement::ImageMeasurement >( nm, subgraph )
+		, ImageReduction( subgraph )
+	{}
+
+	Measurement::ImageMeasurement get( Measurement::Timestamp t )
+	{ return reduce( ApplicationPullSink< Measurement::ImageMeasurement >::get( t ) ); }
+};
+
 typedef ApplicationPullSource< Measurement::ImageMeasurement > ApplicationPullSourceVisionImage;
 
 } } // namespace Ubitrack::Components
@@ -66,9 +459,9 @@ struct EventTypeTraits< Measurement::ImageMeasurement >
 	unsigned long long getPriority( const Measurement::ImageMeasurement& m ) const
 	{ return m.time(); }
 
-	/** the maximum queue length for images is 1! */
+	/** one image unless image endpoints request more, see \c Components::ImageQueueLength */
 	int getMaxQueueLength() const
-	{ return 1; }
+	{ return Components::ImageQueueLength::maximum(); }
 };
 
 } }
@@ -44,6 +44,7 @@
 #include <utDataflow/Component.h>
 #include <utDataflow/ComponentFactory.h>
 #include <utMeasurement/Measurement.h>
+#include "EndpointCounters.h"
 
 namespace Ubitrack { namespace Components {
 
@@ -82,6 +83,7 @@ using namespace Dataflow;
 template < class EventType >
 class ApplicationPullSink
 	: public Component
+	, public EndpointCounters
 {
 public:
 	/**
@@ -104,9 +106,12 @@ public:
 	 * @return Event as requested.
 	 * @throws Ubitrack::Util::Exception if the connected pull supplier cannot deliver data
 	 */
-    EventType get( Ubitrack::Measurement::Timestamp t )
+    virtual EventType get( Ubitrack::Measurement::Timestamp t )
     {
-      return m_InPort.get ( t );
+      Measurement::Timestamp tRequest( countEvent() );
+      EventType e( m_InPort.get ( t ) );
+      countLatency( tRequest );
+      return e;
     }
 
 protected:
@@ -47,6 +47,7 @@
 #include <utDataflow/Component.h>
 #include <utMeasurement/Measurement.h>
 #include <utUtil/SimpleStringOArchive.h>
+#include "EndpointCounters.h"
 // no counterpart in SimpleFacade yet
 //#include <utFacade/SimpleDatatypes.h>
 #ifndef APPLICATIONPUSHSINK_NOLOGGING
@@ -111,6 +112,7 @@ template <class EventType>
 class ApplicationPullSource
 	: public Component
 	, public ApplicationPullSourceBase
+	, public EndpointCounters
 {
 public:
 	/**
@@ -162,7 +164,12 @@ protected:
 		LOG4CPP_DEBUG( m_logger, getName() << " requested event" );
 #endif
 		if( m_callback )
-			return m_callback( t );
+		{
+			Measurement::Timestamp tRequest( countEvent() );
+			EventType e( m_callback( t ) );
+			countLatency( tRequest );
+			return e;
+		}
 #ifndef APPLICATIONPULLSOURCE_NOLOGGING
 		else
 			LOG4CPP_INFO( m_logger, "ApplicationPullSource " << getName() << " has no consumer connected" );
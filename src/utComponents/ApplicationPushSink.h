@@ -48,6 +48,7 @@
 #include <utMeasurement/Measurement.h>
 #include <utUtil/SimpleStringOArchive.h>
 #include <utFacade/SimpleDatatypes.h>
+#include "EndpointCounters.h"
 #ifndef APPLICATIONPUSHSINK_NOLOGGING
 #include <log4cpp/Category.hh>
 #endif
@@ -109,6 +110,7 @@ template <class EventType>
 class ApplicationPushSink
 	: public Component
 	, public ApplicationPushSinkBase
+	, public EndpointCounters
 {
 public:
 	/**
@@ -153,14 +155,18 @@ protected:
 	 * @param m the received event.
 	 * @todo calls user code. wrap with try{} block..
 	 */
-	void pushHandler( const EventType& m )
+	virtual void pushHandler( const EventType& m )
 	{
 #ifndef APPLICATIONPUSHSINK_NOLOGGING
 		LOG4CPP_DEBUG( m_logger, getName() << " received event" );
 #endif
 
+		Measurement::Timestamp tReceived( countEvent() );
 		if( m_callback )
+		{
 			m_callback( m );
+			countLatency( tReceived );
+		}
 #ifndef APPLICATIONPUSHSINK_NOLOGGING
 		else
 			LOG4CPP_INFO( m_logger, "ApplicationPushSink " << getName() << " has no consumer connected" );
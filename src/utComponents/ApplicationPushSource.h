@@ -38,12 +38,15 @@
 #include <iostream>
 
 #include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/atomic.hpp>
 
 #include <utDataflow/PushSupplier.h>
 #include <utDataflow/Component.h>
 #include <utMeasurement/Measurement.h>
 #include <utFacade/SimpleDatatypes.h>
 #include <utUtil/SimpleStringIArchive.h>
+#include "EndpointCounters.h"
 
 #include <log4cpp/Category.hh>
 
@@ -58,6 +61,43 @@ namespace Ubitrack { namespace Components {
 
 using namespace Dataflow;
 
+/**
+ * Common base class for application push sources.
+ * Allows replacing the clock used to timestamp events without a time.
+ */
+class ApplicationPushSourceBase
+{
+public:
+	/** type of a clock */
+	typedef boost::function< Measurement::Timestamp() > ClockType;
+
+	ApplicationPushSourceBase()
+		: m_bEnabled( true )
+	{}
+
+	/** sets the clock for timestamping events, an empty function selects the system clock */
+	void setClock( const ClockType& clock )
+	{ m_clock = clock; }
+
+	/** a disabled source discards events sent by the application, e.g. while the dataflow is being stopped */
+	void setEnabled( bool bEnabled )
+	{ m_bEnabled.store( bEnabled ); }
+
+	/** virtual destructor. always good to have one. */
+	virtual ~ApplicationPushSourceBase()
+	{}
+
+protected:
+	/** returns the current time of the clock */
+	Measurement::Timestamp currentTime() const
+	{ return m_clock ? m_clock() : Measurement::now(); }
+
+	ClockType m_clock;
+
+	boost::atomic< bool > m_bEnabled;
+};
+
+
 /**
  * @ingroup dataflow_components
  * This is an source component which may be used to interface
@@ -80,6 +120,8 @@ template< class EventType >
 class ApplicationPushSource 
 	: public Component
 	, public Facade::SimpleStringReceiver
+	, public ApplicationPushSourceBase
+	, public EndpointCounters
 {
 public:
 	// type of callback
@@ -102,7 +144,14 @@ public:
 	 * @param evt the event to send
 	 */
 	void send( const EventType& evt )
-	{ m_outPort.send( evt ); }
+	{
+		if ( !m_bEnabled.load( boost::memory_order_relaxed ) )
+			return;
+
+		Measurement::Timestamp tSend( countEvent() );
+		m_outPort.send( evt );
+		countLatency( tSend );
+	}
 	
 	/**
 	 * Get the callback.
@@ -111,7 +160,7 @@ public:
 	 * @return callback function for the user application.
 	 */
 	CallbackType getCallback ()
-	{ return boost::bind( &PushSupplier< EventType >::send, &m_outPort, _1 ); }
+	{ return boost::bind( &ApplicationPushSource< EventType >::send, this, _1 ); }
 
 	/**
 	 * Method to call to send stringified data.
@@ -128,9 +177,9 @@ public:
 			
 			// add timestamp if necessary
 			if ( !e.time() )
-				e = EventType( Measurement::now(), e );
+				e = EventType( currentTime(), e );
 			
-			m_outPort.send( e );
+			send( e );
 		}
 		catch ( const std::runtime_error& )
 		{}
@@ -200,7 +249,7 @@ public:
 	void receivePose( const Facade::SimplePose& pose ) throw()
 	{
 		// convert SimplePose to Measurement::Pose
-		m_outPort.send( Measurement::Pose( pose.timestamp,
+		send( Measurement::Pose( pose.timestamp,
 			Math::Pose(
 				Math::Quaternion( pose.rx, pose.ry, pose.rz, pose.rw ),
 				Math::Vector< double, 3 >( pose.tx, pose.ty, pose.tz )
@@ -234,7 +283,7 @@ public:
 	void receivePosition2D( const Facade::SimplePosition2D& position2d ) throw()
 	{
 		// convert SimplePosition2D to Measurement::Position2D
-		m_outPort.send( Measurement::Position2D( position2d.timestamp,
+		send( Measurement::Position2D( position2d.timestamp,
 			Math::Vector< double, 2 >(position2d.x, position2d.y)
 			) );
 		LOG4CPP_INFO( m_logger, "ApplicationPushSourcePosition2D receivePosition2D: x=" << position2d.x << " y=" << position2d.y );
@@ -264,7 +313,7 @@ public:
 	void receivePosition3D( const Facade::SimplePosition3D& position3d ) throw()
 	{
 		// convert SimplePosition2D to Measurement::Position2D
-		m_outPort.send( Measurement::Position( position3d.timestamp,
+		send( Measurement::Position( position3d.timestamp,
 			Math::Vector< double, 3 >(position3d.x, position3d.y, position3d.z)
 			) );
 		LOG4CPP_INFO( m_logger, "ApplicationPushSourcePosition3D receivePosition3D: x=" << position3d.x << " y=" << position3d.y<< " z=" << position3d.z  );
@@ -298,7 +347,7 @@ public:
 	void receiveButton( const Facade::SimpleButton& button ) throw()
 	{
 		// convert SimpleButton to Measurement::Button
-		m_outPort.send( Measurement::Button( button.timestamp,
+		send( Measurement::Button( button.timestamp,
 											 Math::Scalar<int>( button.event ) ) );
 	}
 
@@ -330,7 +379,7 @@ public:
 			newValues.push_back(Math::Vector< double, 3 >(values[i].x,values[i].y,values[i].z));
 		}
 		
-		m_outPort.send( Measurement::PositionList( positionlist3d.timestamp,
+		send( Measurement::PositionList( positionlist3d.timestamp,
 			newValues
 			) );
 		LOG4CPP_INFO( m_logger, "ApplicationPushSourcePositionList receivePosition3DList: " );
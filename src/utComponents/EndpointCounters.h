@@ -0,0 +1,143 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+
+/**
+ * @ingroup dataflow_components
+ * @file
+ * Lock-free event and latency counters for the application endpoints.
+ */
+#ifndef __UBITRACK_COMPONENTS_ENDPOINTCOUNTERS_H_INCLUDED__
+#define __UBITRACK_COMPONENTS_ENDPOINTCOUNTERS_H_INCLUDED__
+
+#include <boost/atomic.hpp>
+#include <utMeasurement/Measurement.h>
+
+namespace Ubitrack { namespace Components {
+
+/**
+ * Counters collected by the application endpoints (push/pull sinks and sources).
+ *
+ * All updates are relaxed atomic operations, so the counters can stay enabled in production.
+ * Latencies are the time spent in the application callback (push sink, pull source) or in
+ * the dataflow (pull sink, push source), in nanoseconds, collected in a log2 histogram.
+ */
+class EndpointCounters
+{
+public:
+	/** 
+	 * number of histogram buckets. Bucket 0 counts latencies below 2 ns, bucket i > 0 counts 
+	 * latencies in [2^i, 2^(i+1)) ns, and the last bucket also counts all larger latencies.
+	 */
+	static const unsigned int HISTOGRAM_BUCKETS = 40;
+
+	/** the values of the counters at one point in time */
+	struct Values
+	{
+		unsigned long long nEvents;
+		unsigned long long firstEventTime;
+		unsigned long long lastEventTime;
+		unsigned long long nLatencies;
+		unsigned long long latencySum;
+		unsigned long long latencyMax;
+		unsigned long long histogram[ HISTOGRAM_BUCKETS ];
+	};
+
+	EndpointCounters()
+		: m_nEvents( 0 )
+		, m_firstEventTime( 0 )
+		, m_lastEventTime( 0 )
+		, m_nLatencies( 0 )
+		, m_latencySum( 0 )
+		, m_latencyMax( 0 )
+	{
+		for ( unsigned int i = 0; i < HISTOGRAM_BUCKETS; i++ )
+			m_histogram[ i ].store( 0, boost::memory_order_relaxed );
+	}
+
+	virtual ~EndpointCounters()
+	{}
+
+	/** counts one event, returns the current time for a subsequent \c countLatency */
+	Measurement::Timestamp countEvent()
+	{
+		Measurement::Timestamp t( Measurement::now() );
+		m_nEvents.fetch_add( 1, boost::memory_order_relaxed );
+
+		// only the first events pay for the compare-exchange
+		unsigned long long expected = 0;
+		if ( m_firstEventTime.load( boost::memory_order_relaxed ) == 0 )
+			m_firstEventTime.compare_exchange_strong( expected, t, boost::memory_order_relaxed );
+		m_lastEventTime.store( t, boost::memory_order_relaxed );
+		return t;
+	}
+
+	/** records the time elapsed since \c tStart, as returned by \c countEvent */
+	void countLatency( Measurement::Timestamp tStart )
+	{
+		Measurement::Timestamp t( Measurement::now() );
+		unsigned long long latency = t > tStart ? t - tStart : 0;
+
+		m_nLatencies.fetch_add( 1, boost::memory_order_relaxed );
+		m_latencySum.fetch_add( latency, boost::memory_order_relaxed );
+
+		unsigned long long oldMax = m_latencyMax.load( boost::memory_order_relaxed );
+		while ( latency > oldMax && !m_latencyMax.compare_exchange_weak( oldMax, latency, boost::memory_order_relaxed ) )
+			;
+
+		// floor( log2( latency ) ), latencies of 0 ns go to bucket 0
+		unsigned int bucket = 0;
+		while ( latency > 1 && bucket < HISTOGRAM_BUCKETS - 1 )
+		{
+			latency >>= 1;
+			bucket++;
+		}
+		m_histogram[ bucket ].fetch_add( 1, boost::memory_order_relaxed );
+	}
+
+	/** reads all counters. The values are not a consistent snapshot if events arrive concurrently */
+	void readCounters( Values& values ) const
+	{
+		values.nEvents = m_nEvents.load( boost::memory_order_relaxed );
+		values.firstEventTime = m_firstEventTime.load( boost::memory_order_relaxed );
+		values.lastEventTime = m_lastEventTime.load( boost::memory_order_relaxed );
+		values.nLatencies = m_nLatencies.load( boost::memory_order_relaxed );
+		values.latencySum = m_latencySum.load( boost::memory_order_relaxed );
+		values.latencyMax = m_latencyMax.load( boost::memory_order_relaxed );
+		for ( unsigned int i = 0; i < HISTOGRAM_BUCKETS; i++ )
+			values.histogram[ i ] = m_histogram[ i ].load( boost::memory_order_relaxed );
+	}
+
+protected:
+	boost::atomic< unsigned long long > m_nEvents;
+	boost::atomic< unsigned long long > m_firstEventTime;
+	boost::atomic< unsigned long long > m_lastEventTime;
+	boost::atomic< unsigned long long > m_nLatencies;
+	boost::atomic< unsigned long long > m_latencySum;
+	boost::atomic< unsigned long long > m_latencyMax;
+	boost::atomic< unsigned long long > m_histogram[ HISTOGRAM_BUCKETS ];
+};
+
+} } // namespace Ubitrack::Components
+
+#endif //__UBITRACK_COMPONENTS_ENDPOINTCOUNTERS_H_INCLUDED__
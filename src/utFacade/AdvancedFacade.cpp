@@ -31,6 +31,8 @@
 
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <set>
 #include <log4cpp/Category.hh>
 
 #include <utUtil/Exception.h>
@@ -44,7 +46,7 @@
 #include <utDataflow/ComponentFactory.h>
 #include <boost/asio.hpp>
 #include <boost/bind.hpp>
-#include <utClientServer/TcpConnection.h>
+#include "ServerConnection.h"
 #include <utDataflow/DataflowNetwork.h>
 #include <utFacade/Config.h>
 #ifdef _WIN32
@@ -59,8 +61,21 @@
 static log4cpp::Category& logger( log4cpp::Category::getInstance( "Ubitrack.Facade.AdvancedFacade" ) );
 
 static const char* g_defaultPort = "3000";
+
+// seconds to wait for a dispatcher thread to run the task applying its scheduling
+static const int g_dispatcherTimeout = 5;
 unsigned int Ubitrack::Facade::AdvancedFacade::m_instanceCount = 0;
 
+// protects the event domain bookkeeping shared by all facades
+static boost::mutex g_domainMutex;
+
+// event domains released by destroyed facades, reused before new ones are allocated.
+// An event queue keeps the drop policy it was created with, so ids are only reused with the same policy.
+static std::map< bool, std::vector< unsigned int > > g_freeDomains;
+
+// number of facades currently alive
+static unsigned int g_nLiveFacades = 0;
+
 namespace Ubitrack { namespace Facade {
 
 void initGPU() {
@@ -83,52 +98,83 @@ void initGPU() {
 // XXX duplicated constructor for now until i've found a better solution (Ulrich Eck)
 AdvancedFacade::AdvancedFacade( bool drop_events, const std::string& sComponentPath )
 	: m_bStarted( false )
+	, m_bPaused( false )
 	, m_bDropEvents( drop_events )
 	, m_pIoService( new boost::asio::io_service )
+	, m_bAsyncNotify( false )
+	, m_nUndeliveredDeltas( 0 )
+	, m_bStopNotifier( false )
+	, m_virtualTime( 0 )
 {
-	// automatically select eventDomain
-	m_eventDomain = m_instanceCount;
-	m_instanceCount++;
+	m_options.dropEvents = drop_events;
 
-	if ( !sComponentPath.empty() )
-		m_pComponentFactory.reset( new Dataflow::ComponentFactory( sComponentPath ) );
-	else
-	{
-#ifdef _WIN32
-		try
-		{
-			// try "ubitrack"-directory relative to ubitrack.dll
-			HMODULE hModule = GetModuleHandle( "Ubitrack.dll" );
-			if ( !hModule )
-				UBITRACK_THROW( "No ubitrack.dll loaded" );
-			char modulePath[ 256 ];
-			DWORD pathLen = GetModuleFileName( hModule, modulePath, 256 );
-			// just strip the ".dll" from the name
-			std::string compPath( modulePath, pathLen - 4 );
-			m_pComponentFactory.reset( new Dataflow::ComponentFactory( compPath ) );
-		}
-		catch( Util::Exception& e )
-		{
-			LOG4CPP_INFO( logger, e )
-		}
-#endif
-
-		// try compile-time prefix
-		if ( !m_pComponentFactory )
-			m_pComponentFactory.reset( new Dataflow::ComponentFactory( UBITRACK_COMPONENTS_PATH ) );
-	}
+	initComponentFactory( sComponentPath );
 
+	// automatically select eventDomain
+	m_eventDomain = acquireEventDomain( true, m_bDropEvents );
 }
 
 AdvancedFacade::AdvancedFacade( const std::string& sComponentPath )
 		: m_bStarted( false )
+		, m_bPaused( false )
 		, m_bDropEvents( true )
 		, m_pIoService( new boost::asio::io_service )
+		, m_bAsyncNotify( false )
+		, m_nUndeliveredDeltas( 0 )
+		, m_bStopNotifier( false )
+		, m_virtualTime( 0 )
+{
+	initComponentFactory( sComponentPath );
+
+	// automatically select eventDomain
+	m_eventDomain = acquireEventDomain( true, m_bDropEvents );
+}
+
+AdvancedFacade::AdvancedFacade( const FacadeOptions& options, const std::string& sComponentPath )
+	: m_options( options )
+	, m_bStarted( false )
+	, m_bPaused( false )
+	, m_bDropEvents( options.dropEvents && !options.virtualClock )
+	, m_pIoService( new boost::asio::io_service )
+	, m_bAsyncNotify( false )
+	, m_nUndeliveredDeltas( 0 )
+	, m_bStopNotifier( false )
+	, m_virtualTime( options.virtualClockStart )
 {
+	if ( m_options.virtualClock )
+	{
+		// offline processing must not lose events
+		m_options.dropEvents = false;
+		if ( m_options.dropPolicy != FacadeOptions::DELIVER_SYNCHRONOUS && m_options.dropPolicy != FacadeOptions::DROP_NONE )
+		{
+			LOG4CPP_INFO( logger, "Virtual clock mode, delivering application events with policy DROP_NONE" );
+			m_options.dropPolicy = FacadeOptions::DROP_NONE;
+		}
+	}
+
+	// fail early with a clear message instead of when the threads are started
+	checkThreadScheduling( options.dispatcherScheduling );
+	checkThreadScheduling( options.networkScheduling );
+	checkThreadScheduling( options.workerScheduling );
+	if ( options.lockMemory )
+		lockProcessMemory();
+
+	initComponentFactory( sComponentPath );
+
 	// automatically select eventDomain
-	m_eventDomain = m_instanceCount;
-	m_instanceCount++;
+	m_eventDomain = acquireEventDomain( true, m_bDropEvents );
+
+	if ( m_options.dropPolicy != FacadeOptions::DELIVER_SYNCHRONOUS )
+	{
+		LOG4CPP_INFO( logger, "Delivering application events through a queue, policy " << m_options.dropPolicy 
+			<< ", capacity " << m_options.eventQueueCapacity );
+		m_pDeliveryQueue.reset( new EventDeliveryQueue( m_options.dropPolicy, m_options.eventQueueCapacity, m_options.workerScheduling ) );
+	}
+}
 
+
+void AdvancedFacade::initComponentFactory( const std::string& sComponentPath )
+{
 	if ( !sComponentPath.empty() )
 		m_pComponentFactory.reset( new Dataflow::ComponentFactory( sComponentPath ) );
 	else
@@ -156,7 +202,6 @@ AdvancedFacade::AdvancedFacade( const std::string& sComponentPath )
 		if ( !m_pComponentFactory )
 			m_pComponentFactory.reset( new Dataflow::ComponentFactory( UBITRACK_COMPONENTS_PATH ) );
 	}
-
 }
 
 
@@ -164,7 +209,7 @@ AdvancedFacade::~AdvancedFacade()
 {
 	LOG4CPP_DEBUG( logger, "~AdvancedFacade" );
 
-	// kill server connection
+	// kill server connection first, so no reconfiguration arrives while stopping
 	if ( m_pNetworkThread )
 	{
 		LOG4CPP_DEBUG( logger, "Stopping network thread" );
@@ -172,7 +217,24 @@ AdvancedFacade::~AdvancedFacade()
 		m_pNetworkThread->join();
 	}
 
-	m_pTcpConnection.reset();
+	m_pServerConnection.reset();
+
+	// deliver outstanding observer notifications
+	stopObserverNotification();
+
+	// stop only the event queues of this facade, other facades keep running
+	if ( m_bStarted )
+	{
+		try
+		{
+			stopDataflow();
+		}
+		catch ( const Util::Exception& e )
+		{ LOG4CPP_WARN( logger, "Caught exception stopping dataflow: " << e ); }
+	}
+
+	// no more application callbacks from here on
+	m_pDeliveryQueue.reset();
 	
 	// kill data flow network
 	LOG4CPP_DEBUG( logger, "Removing data flow network" );
@@ -181,6 +243,8 @@ AdvancedFacade::~AdvancedFacade()
 	//Dataflow::EventQueue::singleton().clear();
 
 	
+	releaseEventDomains();
+	
 	LOG4CPP_DEBUG( logger, "AdvancedFacade destroyed" );
 }
 
@@ -210,25 +274,110 @@ void AdvancedFacade::loadDataflow( std::istream& stream, bool bReplace )
 	if ( doc->isRequest() )
 		doc = Graph::generateDataflow( *doc );
 
-	// notify observers of deletions
-	for ( ObserverList::iterator itObserver = m_observers.begin(); itObserver != m_observers.end(); itObserver++ )
+	// one load at a time, so no other patch resumes the event domains suspended below
+	boost::recursive_mutex::scoped_lock lLoad( m_loadMutex );
+
+	// a running dataflow is patched instead of restarted. Only the event domains of the
+	// components the patch removes, replaces or connects to are suspended, all others run on.
+	std::set< std::string > touched;
+	std::vector< unsigned int > touchedIds;
+	{
+		boost::recursive_mutex::scoped_lock l( m_dataflowMutex );
+		if ( bReplace || !m_pDataflowNetwork || !m_bStarted )
+		{
+			patchDataflow( doc, bReplace, false, std::set< std::string >() );
+			return;
+		}
+
+		touched = touchedEventDomains( *doc );
+		for ( std::set< std::string >::iterator it = touched.begin(); it != touched.end(); it++ )
+		{
+			m_suspendedDomains.insert( *it );
+			touchedIds.push_back( eventDomain( *it ).id );
+		}
+	}
+
+	// waits for the events in dispatch, so not locked: their callbacks may use the facade.
+	// Queued events are kept.
+	for ( std::vector< unsigned int >::iterator it = touchedIds.begin(); it != touchedIds.end(); it++ )
+	{
+		LOG4CPP_DEBUG( logger, "Suspending event domain " << *it );
+		Dataflow::EventQueue::singleton( *it, m_bDropEvents ).stop();
+	}
+
+	boost::recursive_mutex::scoped_lock l( m_dataflowMutex );
+	try
+	{
+		// the dataflow may have been stopped or cleared in the meantime
+		bool bLive = m_pDataflowNetwork && m_bStarted;
+		std::set< std::string > oldDomains;
+		for ( EventDomainMap::iterator it = m_eventDomains.begin(); it != m_eventDomains.end(); it++ )
+			oldDomains.insert( it->first );
+
+		if ( bLive )
+			detachComponents( *doc );
+		patchDataflow( doc, false, bLive, oldDomains );
+	}
+	catch ( ... )
+	{
+		try
+		{
+			resumeSuspendedDomains( touched );
+		}
+		catch ( const Util::Exception& e )
+		{ LOG4CPP_WARN( logger, "Caught exception resuming event domains: " << e ); }
+		throw;
+	}
+
+	resumeSuspendedDomains( touched );
+}
+
+
+void AdvancedFacade::patchDataflow( boost::shared_ptr< Graph::UTQLDocument > doc, bool bReplace, bool bLive, 
+	const std::set< std::string >& oldDomains )
+{
+	// collect removed and added components
+	boost::shared_ptr< DataflowDelta > pRemoved( new DataflowDelta );
+	boost::shared_ptr< DataflowDelta > pAdded( new DataflowDelta );
+	{
+		boost::mutex::scoped_lock lLookup( m_lookupMutex );
+		if ( bReplace )
+		{
+			m_componentDomains.clear();
+			m_componentPatterns.clear();
+		}
 		for ( Graph::UTQLDocument::SubgraphList::iterator it = doc->m_Subgraphs.begin(); it != doc->m_Subgraphs.end(); it++ )
 			if ( (*it)->empty() )
 			{
-				try
-				{ 
-					LOG4CPP_TRACE( logger, "notifying observer of deletion of " << (*it)->m_Name << "/" << (*it)->m_ID );
-					(*itObserver)->notifyDeleteComponent( (*it)->m_Name, (*it)->m_ID ); 
-				}
-				catch ( const Util::Exception& e )
-				{ LOG4CPP_WARN( logger, "Caught exception calling observer: " << e ); }
-				catch ( ... )
-				{ LOG4CPP_WARN( logger, "Caught exception calling observer" ); }
+				pRemoved->removed.push_back( DataflowDelta::Entry( (*it)->m_Name, (*it)->m_ID ) );
+				m_componentDomains.erase( (*it)->m_ID );
+				m_componentPatterns.erase( (*it)->m_ID );
 			}
-	
+			else
+			{
+				pAdded->added.push_back( DataflowDelta::Entry( (*it)->m_Name, (*it)->m_ID, *it ) );
+				m_componentPatterns[ (*it)->m_ID ] = (*it)->m_Name;
+			}
+	}
+
+	// components may be placed into a separate event domain by a dataflow attribute
+	for ( Graph::UTQLDocument::SubgraphList::iterator it = doc->m_Subgraphs.begin(); it != doc->m_Subgraphs.end(); it++ )
+		if ( !(*it)->empty() && (*it)->m_DataflowAttributes.hasAttribute( "eventDomain" ) )
+			setComponentEventDomain( (*it)->m_ID, (*it)->m_DataflowAttributes.getAttributeString( "eventDomain" ) );
+
+	// notify observers of deletions
+	if ( !m_bAsyncNotify && !pRemoved->empty() )
+		notifyObservers( *pRemoved );
+
 	if ( bReplace || !m_pDataflowNetwork )
 	{
-		m_pDataflowNetwork.reset();
+		// the old network is destroyed without the lookup mutex held
+		boost::shared_ptr< Dataflow::DataflowNetwork > pOld;
+		{
+			boost::mutex::scoped_lock lLookup( m_lookupMutex );
+			pOld.swap( m_pDataflowNetwork );
+		}
+		pOld.reset();
 
 		// create a new data flow network
 		boost::shared_ptr< Dataflow::DataflowNetwork > pDfn( new Dataflow::DataflowNetwork( *m_pComponentFactory ) );
@@ -237,81 +386,535 @@ void AdvancedFacade::loadDataflow( std::istream& stream, bool bReplace )
 		pDfn->processUTQLResponse( doc );
 
 		// finally, copy to global pointer (here for exception safety)
-		m_pDataflowNetwork = pDfn;
-		
+		{
+			boost::mutex::scoped_lock lLookup( m_lookupMutex );
+			m_pDataflowNetwork = pDfn;
+		}
+
 		if ( m_bStarted )
 			startDataflow();
 	}
 	else
+	{
+		boost::mutex::scoped_lock lLookup( m_lookupMutex );
 		m_pDataflowNetwork->processUTQLResponse( doc );
+	}
 
-	// notify observers of additions
-	for ( ObserverList::iterator itObserver = m_observers.begin(); itObserver != m_observers.end(); itObserver++ )
-		for ( Graph::UTQLDocument::SubgraphList::iterator it = doc->m_Subgraphs.begin(); it != doc->m_Subgraphs.end(); it++ )
-			if ( !(*it)->empty() )
-			{
-				try
-				{ 
-					LOG4CPP_TRACE( logger, "notifying observer of addition of " << (*it)->m_Name << "/" << (*it)->m_ID );
-					(*itObserver)->notifyAddComponent( (*it)->m_Name, (*it)->m_ID, **it ); 
-				}
-				catch ( const Util::Exception& e )
-				{ LOG4CPP_WARN( logger, "Caught exception calling observer: " << e ); }
-				catch ( ... )
-				{ LOG4CPP_WARN( logger, "Caught exception calling observer" ); }
-			}
+	if ( m_options.virtualClock )
+		attachVirtualClock( *pAdded );
+
+	if ( bLive )
+		startComponents( *pAdded, oldDomains );
+
+	if ( !m_bAsyncNotify )
+	{
+		// notify observers of additions
+		if ( !pAdded->empty() )
+			notifyObservers( *pAdded );
+	}
+	else if ( !pRemoved->empty() || !pAdded->empty() )
+	{
+		// hand both lists to the notification thread as one delta
+		pAdded->removed.swap( pRemoved->removed );
+
+		boost::mutex::scoped_lock l( m_notifyMutex );
+		if ( !m_pNotifierThread )
+		{
+			m_bStopNotifier = false;
+			m_pNotifierThread.reset( new boost::thread( boost::bind( &AdvancedFacade::notifierThread, this ) ) );
+		}
+		m_pendingDeltas.push_back( pAdded );
+		m_nUndeliveredDeltas++;
+		m_notifyCondition.notify_all();
+	}
+}
+
+
+void AdvancedFacade::addDataflowObserver( DataflowObserver* pObserver )
+{
+	boost::recursive_mutex::scoped_lock l( m_observerMutex );
+	m_observers.push_back( pObserver );
+}
+
+
+void AdvancedFacade::removeDataflowObserver( DataflowObserver* pObserver )
+{
+	boost::recursive_mutex::scoped_lock l( m_observerMutex );
+	m_observers.remove( pObserver );
+}
+
+
+void AdvancedFacade::notifyObservers( const DataflowDelta& delta )
+{
+	boost::recursive_mutex::scoped_lock l( m_observerMutex );
+
+	// copy, as observers may unregister themselves during the notification
+	ObserverList observers( m_observers );
+	for ( ObserverList::iterator itObserver = observers.begin(); itObserver != observers.end(); itObserver++ )
+	{
+		try
+		{
+			LOG4CPP_TRACE( logger, "notifying observer of " << delta.removed.size() << " deletions and " << delta.added.size() << " additions" );
+			(*itObserver)->notifyDataflowChanged( delta );
+		}
+		catch ( const Util::Exception& e )
+		{ LOG4CPP_WARN( logger, "Caught exception calling observer: " << e ); }
+		catch ( ... )
+		{ LOG4CPP_WARN( logger, "Caught exception calling observer" ); }
+	}
+}
+
+
+void AdvancedFacade::setAsyncObserverNotification( bool bAsync )
+{
+	if ( !bAsync )
+		flushObserverNotifications();
+	m_bAsyncNotify = bAsync;
+}
+
+
+void AdvancedFacade::flushObserverNotifications()
+{
+	boost::mutex::scoped_lock l( m_notifyMutex );
+	while ( m_nUndeliveredDeltas > 0 )
+		m_notifyCondition.wait( l );
+}
+
+
+void AdvancedFacade::stopObserverNotification()
+{
+	{
+		boost::mutex::scoped_lock l( m_notifyMutex );
+		if ( !m_pNotifierThread )
+			return;
+		m_bStopNotifier = true;
+		m_notifyCondition.notify_all();
+	}
+
+	m_pNotifierThread->join();
+	m_pNotifierThread.reset();
+}
+
+
+void AdvancedFacade::notifierThread()
+{
+	LOG4CPP_DEBUG( logger, "Observer notification thread started" );
+
+	if ( !m_options.workerScheduling.isDefault() )
+	{
+		try
+		{
+			applyThreadScheduling( m_options.workerScheduling );
+		}
+		catch ( const Util::Exception& e )
+		{ LOG4CPP_ERROR( logger, "Cannot apply scheduling to the observer notification thread: " << e ); }
+	}
+
+	boost::mutex::scoped_lock l( m_notifyMutex );
+	while ( true )
+	{
+		while ( m_pendingDeltas.empty() && !m_bStopNotifier )
+			m_notifyCondition.wait( l );
+
+		// pending deltas are delivered before stopping
+		if ( m_pendingDeltas.empty() )
+			break;
+
+		boost::shared_ptr< DataflowDelta > pDelta( m_pendingDeltas.front() );
+		m_pendingDeltas.pop_front();
+
+		l.unlock();
+		notifyObservers( *pDelta );
+		l.lock();
+
+		m_nUndeliveredDeltas--;
+		m_notifyCondition.notify_all();
+	}
+
+	LOG4CPP_DEBUG( logger, "Observer notification thread stopped" );
 }
 
 
 void AdvancedFacade::clearDataflow()
 {
+	boost::recursive_mutex::scoped_lock l( m_dataflowMutex );
 	if ( m_bStarted )
 		stopDataflow();
 		
-	m_pDataflowNetwork.reset();
+	// the network is destroyed without the lookup mutex held
+	boost::shared_ptr< Dataflow::DataflowNetwork > pOld;
+	{
+		boost::mutex::scoped_lock lLookup( m_lookupMutex );
+		pOld.swap( m_pDataflowNetwork );
+	}
 }
 
 
 void AdvancedFacade::startDataflow()
 {
 	LOG4CPP_DEBUG( logger, "AdvancedFacade::startDataflow" );
+	boost::recursive_mutex::scoped_lock l( m_dataflowMutex );
 
 	// start the event queue
 	if ( m_pDataflowNetwork )
 	{
 		Dataflow::EventQueue::singleton(m_eventDomain, m_bDropEvents).clear(); // FIXME
 		m_pDataflowNetwork->assignEventDomain(m_eventDomain);
+		assignComponentEventDomains();
 		m_pDataflowNetwork->startNetwork();
-		Dataflow::EventQueue::singleton(m_eventDomain, m_bDropEvents).start();
+
+		try
+		{
+			eventDomain( std::string() );
+			for ( EventDomainMap::iterator it = m_eventDomains.begin(); it != m_eventDomains.end(); it++ )
+				startEventDomain( it->first, it->second );
+		}
+		catch ( ... )
+		{
+			// do not leave the dataflow half-started
+			try
+			{
+				stopDataflow();
+			}
+			catch ( const Util::Exception& e )
+			{ LOG4CPP_WARN( logger, "Caught exception stopping dataflow: " << e ); }
+			throw;
+		}
 	}
 	m_bStarted = true;
+	m_bPaused = false;
 }
 
 
 void AdvancedFacade::stopDataflow()
 {
 	LOG4CPP_DEBUG( logger, "AdvancedFacade::stopDataflow" );
-		
+	boost::recursive_mutex::scoped_lock l( m_dataflowMutex );
+
 	// stop the event queue
 	if ( m_pDataflowNetwork )
 	{
 		Dataflow::EventQueue::singleton(m_eventDomain, m_bDropEvents).stop();
+		for ( EventDomainMap::iterator it = m_eventDomains.begin(); it != m_eventDomains.end(); it++ )
+			if ( it->second.id != m_eventDomain )
+				Dataflow::EventQueue::singleton( it->second.id, m_bDropEvents ).stop();
+
 		m_pDataflowNetwork->stopNetwork();
+
 		Dataflow::EventQueue::singleton(m_eventDomain, m_bDropEvents).clear(); // FIXME
+		for ( EventDomainMap::iterator it = m_eventDomains.begin(); it != m_eventDomains.end(); it++ )
+			if ( it->second.id != m_eventDomain )
+				Dataflow::EventQueue::singleton( it->second.id, m_bDropEvents ).clear();
+
+		// the queues are empty, so the probes can go
+		for ( EventDomainMap::iterator it = m_eventDomains.begin(); it != m_eventDomains.end(); it++ )
+			if ( it->second.pProbe )
+			{
+				it->second.pProbe->cancel();
+				it->second.pProbe.reset();
+			}
 	}
+
+	// discard events the application has not received yet
+	if ( m_pDeliveryQueue )
+		m_pDeliveryQueue->clear();
 	m_bStarted = false;
+	m_bPaused = false;
 }
 
 
-void AdvancedFacade::connectToServer( const std::string& sAddress )
+void AdvancedFacade::pause()
 {
-	LOG4CPP_DEBUG( logger, "AdvancedFacade::connectToServer " << sAddress );
+	boost::recursive_mutex::scoped_lock l( m_dataflowMutex );
+	if ( !m_bStarted || m_bPaused || !m_pDataflowNetwork )
+		return;
+
+	LOG4CPP_DEBUG( logger, "AdvancedFacade::pause" );
+	for ( EventDomainMap::iterator it = m_eventDomains.begin(); it != m_eventDomains.end(); it++ )
+		Dataflow::EventQueue::singleton( it->second.id, m_bDropEvents ).stop();
+	m_bPaused = true;
+}
 
-	using boost::asio::ip::tcp;
-	
-	// split address into host and port
-	std::string sHost( sAddress );
-	std::string sPort( g_defaultPort );
+
+std::set< std::string > AdvancedFacade::touchedEventDomains( const Graph::UTQLDocument& doc ) const
+{
+	std::set< std::string > domains;
+	for ( Graph::UTQLDocument::SubgraphList::const_iterator it = doc.m_Subgraphs.begin(); it != doc.m_Subgraphs.end(); it++ )
+	{
+		// removed and replaced components
+		if ( m_componentPatterns.find( (*it)->m_ID ) != m_componentPatterns.end() )
+			domains.insert( componentDomainName( (*it)->m_ID ) );
+
+		// running components whose outputs the new components are connected to
+		for ( Graph::UTQLSubgraph::EdgeMap::const_iterator itEdge = (*it)->m_Edges.begin(); itEdge != (*it)->m_Edges.end(); itEdge++ )
+		{
+			const std::string& sSource( itEdge->second->m_EdgeReference.getSubgraphId() );
+			if ( itEdge->second->isInput() && m_componentPatterns.find( sSource ) != m_componentPatterns.end() )
+				domains.insert( componentDomainName( sSource ) );
+		}
+	}
+	return domains;
+}
+
+
+std::string AdvancedFacade::componentDomainName( const std::string& sComponentName ) const
+{
+	ComponentDomainMap::const_iterator it = m_componentDomains.find( sComponentName );
+	return it != m_componentDomains.end() ? it->second : std::string();
+}
+
+
+void AdvancedFacade::resumeSuspendedDomains( const std::set< std::string >& domains )
+{
+	std::set< std::string > resumable;
+	for ( std::set< std::string >::const_iterator it = domains.begin(); it != domains.end(); it++ )
+	{
+		m_suspendedDomains.erase( m_suspendedDomains.find( *it ) );
+		if ( m_suspendedDomains.find( *it ) == m_suspendedDomains.end() )
+			resumable.insert( *it );
+	}
+
+	if ( m_bStarted && !m_bPaused )
+		resumeEventDomains( resumable );
+}
+
+
+void AdvancedFacade::resumeEventDomains( const std::set< std::string >& domains )
+{
+	try
+	{
+		for ( std::set< std::string >::const_iterator it = domains.begin(); it != domains.end(); it++ )
+			startEventDomain( *it, eventDomain( *it ), false );
+	}
+	catch ( ... )
+	{
+		// do not leave some domains running, the facade is paused in all of them
+		for ( EventDomainMap::iterator it = m_eventDomains.begin(); it != m_eventDomains.end(); it++ )
+			Dataflow::EventQueue::singleton( it->second.id, m_bDropEvents ).stop();
+		m_bPaused = true;
+		throw;
+	}
+}
+
+
+void AdvancedFacade::resume()
+{
+	boost::recursive_mutex::scoped_lock l( m_dataflowMutex );
+	if ( !m_bPaused )
+		return;
+
+	LOG4CPP_DEBUG( logger, "AdvancedFacade::resume" );
+	std::set< std::string > domains;
+	for ( EventDomainMap::iterator it = m_eventDomains.begin(); it != m_eventDomains.end(); it++ )
+		domains.insert( it->first );
+
+	// stays paused in all domains on failure
+	resumeEventDomains( domains );
+	m_bPaused = false;
+}
+
+
+bool AdvancedFacade::stop( unsigned int drainTimeout )
+{
+	{
+		boost::recursive_mutex::scoped_lock l( m_dataflowMutex );
+		if ( !m_bStarted )
+			return true;
+
+		LOG4CPP_DEBUG( logger, "AdvancedFacade::stop, draining for at most " << drainTimeout << "ms" );
+		resume();
+		enablePushSources( false );
+	}
+
+	// not locked while waiting, callbacks may still use the facade
+	bool bDrained = drainQueues( boost::get_system_time() + boost::posix_time::milliseconds( drainTimeout ) );
+	if ( !bDrained )
+		LOG4CPP_WARN( logger, "Event queues not empty after " << drainTimeout << "ms, discarding remaining events" );
+
+	boost::recursive_mutex::scoped_lock l( m_dataflowMutex );
+	try
+	{
+		stopDataflow();
+	}
+	catch ( ... )
+	{
+		enablePushSources( true );
+		throw;
+	}
+	enablePushSources( true );
+	return bDrained;
+}
+
+
+bool AdvancedFacade::drainQueues( const boost::posix_time::ptime& deadline )
+{
+	// the probes of the started domains serve as barriers
+	typedef std::vector< std::pair< unsigned int, boost::shared_ptr< EventDomainProbe > > > ProbeList;
+	ProbeList probes;
+	bool bPaused;
+	{
+		boost::recursive_mutex::scoped_lock l( m_dataflowMutex );
+		if ( !m_pDataflowNetwork || !m_bStarted )
+			return true;
+
+		bPaused = m_bPaused;
+		for ( EventDomainMap::iterator it = m_eventDomains.begin(); it != m_eventDomains.end(); it++ )
+			if ( it->second.pProbe )
+				probes.push_back( std::make_pair( it->second.id, it->second.pProbe ) );
+	}
+
+	// callbacks may push new events, so repeat until everything stays empty
+	bool bIdle = false;
+	while ( !bIdle )
+	{
+		bIdle = true;
+		for ( ProbeList::iterator it = probes.begin(); it != probes.end(); it++ )
+		{
+			Dataflow::EventQueue& queue( Dataflow::EventQueue::singleton( it->first, m_bDropEvents ) );
+			if ( queue.getCurrentQueueLength() > 0 )
+			{
+				// nothing is dispatched while paused
+				if ( bPaused )
+					return false;
+				bIdle = false;
+			}
+
+			// an empty queue may still have an event in dispatch, which the barrier waits for
+			if ( !bPaused && !it->second->waitDispatched( deadline ) )
+				return false;
+			if ( queue.getCurrentQueueLength() > 0 )
+				bIdle = false;
+		}
+
+		if ( m_pDeliveryQueue )
+		{
+			EventDeliveryQueue::KeyCounters before( m_pDeliveryQueue->getTotalCounters() );
+			if ( !m_pDeliveryQueue->waitEmpty( deadline ) )
+				return false;
+			if ( before.nQueued || m_pDeliveryQueue->getTotalCounters().nEnqueued != before.nEnqueued )
+				bIdle = false;
+		}
+	}
+	return true;
+}
+
+
+void AdvancedFacade::enablePushSources( bool bEnable )
+{
+	boost::recursive_mutex::scoped_lock l( m_dataflowMutex );
+	if ( !m_pDataflowNetwork )
+		return;
+
+	for ( ComponentPatternMap::iterator it = m_componentPatterns.begin(); it != m_componentPatterns.end(); it++ )
+	{
+		boost::shared_ptr< Dataflow::Component > pComponent;
+		try
+		{
+			pComponent = m_pDataflowNetwork->componentByName< Dataflow::Component >( it->first );
+		}
+		catch ( const Util::Exception& )
+		{}
+
+		if ( Components::ApplicationPushSourceBase* pSource = dynamic_cast< Components::ApplicationPushSourceBase* >( pComponent.get() ) )
+			pSource->setEnabled( bEnable );
+	}
+}
+
+
+void AdvancedFacade::setComponentEventDomain( const std::string& sComponentName, const std::string& sDomainName )
+{
+	boost::recursive_mutex::scoped_lock l( m_dataflowMutex );
+	if ( !sDomainName.empty() )
+		eventDomain( sDomainName );
+
+	boost::mutex::scoped_lock lLookup( m_lookupMutex );
+	if ( sDomainName.empty() )
+		m_componentDomains.erase( sComponentName );
+	else
+		m_componentDomains[ sComponentName ] = sDomainName;
+}
+
+
+void AdvancedFacade::setEventDomainScheduling( const std::string& sDomainName, const ThreadScheduling& scheduling )
+{
+	checkThreadScheduling( scheduling );
+
+	boost::recursive_mutex::scoped_lock l( m_dataflowMutex );
+	eventDomain( sDomainName ).scheduling = scheduling;
+}
+
+
+AdvancedFacade::EventDomain& AdvancedFacade::eventDomain( const std::string& sDomainName )
+{
+	EventDomainMap::iterator it = m_eventDomains.find( sDomainName );
+	if ( it != m_eventDomains.end() )
+		return it->second;
+
+	EventDomain domain;
+	domain.scheduling = m_options.dispatcherScheduling;
+	if ( sDomainName.empty() )
+		domain.id = m_eventDomain;
+	else
+	{
+		// named domains draw from the same counter as the facades
+		domain.id = acquireEventDomain( false, m_bDropEvents );
+		LOG4CPP_INFO( logger, "Created event domain \"" << sDomainName << "\" with id " << domain.id );
+	}
+
+	boost::mutex::scoped_lock lLookup( m_lookupMutex );
+	return m_eventDomains.insert( std::make_pair( sDomainName, domain ) ).first->second;
+}
+
+
+void AdvancedFacade::assignComponentEventDomains()
+{
+	for ( ComponentDomainMap::iterator it = m_componentDomains.begin(); it != m_componentDomains.end(); it++ )
+	{
+		try
+		{
+			boost::shared_ptr< Dataflow::Component > pComponent( 
+				m_pDataflowNetwork->componentByName< Dataflow::Component >( it->first ) );
+			if ( pComponent )
+				pComponent->setEventDomain( eventDomain( it->second ).id );
+		}
+		catch ( const Util::Exception& e )
+		{ LOG4CPP_WARN( logger, "Cannot assign component " << it->first << " to event domain " << it->second << ": " << e ); }
+	}
+}
+
+
+void AdvancedFacade::startEventDomain( const std::string& sDomainName, EventDomain& domain, bool bClear )
+{
+	// a live patch restarts the domain when it is done
+	if ( m_suspendedDomains.find( sDomainName ) != m_suspendedDomains.end() )
+		return;
+
+	Dataflow::EventQueue& queue( Dataflow::EventQueue::singleton( domain.id, m_bDropEvents ) );
+	if ( bClear && domain.id != m_eventDomain )
+		queue.clear();
+
+	if ( !domain.pProbe )
+		domain.pProbe.reset( new EventDomainProbe( domain.id ) );
+	queue.start();
+
+	if ( domain.scheduling.isDefault() )
+		return;
+
+	// the event queue does not expose its dispatcher thread, so a task dispatched ahead of the
+	// queued events applies the scheduling. It only waits for the event in dispatch, if any.
+	LOG4CPP_INFO( logger, "Applying scheduling to the dispatcher thread of event domain \"" << sDomainName << "\"" );
+	void (*apply)( const ThreadScheduling& ) = &applyThreadScheduling;
+	if ( !domain.pProbe->call( boost::bind( apply, domain.scheduling ), 
+		boost::get_system_time() + boost::posix_time::seconds( g_dispatcherTimeout ), true ) )
+		UBITRACK_THROW( "Dispatcher thread of event domain \"" + sDomainName + "\" did not respond" );
+}
+
+
+/** splits a server address into host and port */
+static void splitServerAddress( const std::string& sAddress, std::string& sHost, std::string& sPort )
+{
+	sHost = sAddress;
+	sPort = g_defaultPort;
 
 	std::string::size_type iSplit = sAddress.find( ':', 0 );
 	if ( iSplit != std::string::npos )
@@ -319,36 +922,90 @@ void AdvancedFacade::connectToServer( const std::string& sAddress )
 		sHost = sAddress.substr( 0, iSplit );
 		sPort = sAddress.substr( iSplit + 1, std::string::npos );
 	}
+}
 
-	// resolve host name
-	tcp::resolver resolver( *m_pIoService );
-	tcp::resolver::query query ( sHost, sPort );
-	tcp::resolver::iterator endpoint_iterator = resolver.resolve( query );
-	tcp::resolver::iterator end;
 
-	// connect to host
-	boost::shared_ptr< tcp::socket > pSocket( new tcp::socket( *m_pIoService ) );
-	boost::system::error_code error = boost::asio::error::host_not_found;
-	while ( error && endpoint_iterator != end )
-	{
-		pSocket->close();
-		pSocket->connect( *endpoint_iterator++, error );
-	}
-	
-	if ( error )
+void AdvancedFacade::connectToServer( const std::string& sAddress )
+{
+	LOG4CPP_DEBUG( logger, "AdvancedFacade::connectToServer " << sAddress );
+
+	std::string sHost, sPort;
+	splitServerAddress( sAddress, sHost, sPort );
+
+	ServerConnection& connection( serverConnection() );
+	connection.connect( sHost, sPort );
+
+	std::string sError;
+	if ( !connection.waitConnected( 0, sError ) )
 	{
-		UBITRACK_THROW( "Cannot connect to server \"" + sHost + "\" at port \"" + sPort + "\"" );
+		connection.close();
+		UBITRACK_THROW( sError );
 	}
+}
 
-	LOG4CPP_INFO( logger, "Connected to server " << sAddress );
 
-	// create & initialize Ubitrack TcpConnection object
-	m_pTcpConnection.reset( new ClientServer::TcpConnection( pSocket ) );
-	m_pTcpConnection->setReceiver( boost::bind( &AdvancedFacade::receiveUtqlResponse, this, _1 ) );
+void AdvancedFacade::connectToServerAsync( const std::string& sAddress )
+{
+	LOG4CPP_DEBUG( logger, "AdvancedFacade::connectToServerAsync " << sAddress );
+
+	std::string sHost, sPort;
+	splitServerAddress( sAddress, sHost, sPort );
+	serverConnection().connect( sHost, sPort );
+}
+
+
+void AdvancedFacade::disconnectFromServer()
+{
+	if ( m_pServerConnection )
+		m_pServerConnection->close();
+}
+
+
+bool AdvancedFacade::isConnectedToServer() const
+{
+	return m_pServerConnection && m_pServerConnection->isConnected();
+}
+
+
+void AdvancedFacade::setServerStateCallback( const ServerStateCallback& callback )
+{
+	serverConnection().setStateCallback( callback );
+}
+
+
+std::size_t AdvancedFacade::pendingServerRequests() const
+{
+	return m_pServerConnection ? m_pServerConnection->pendingRequests() : 0;
+}
+
+
+ServerConnection& AdvancedFacade::serverConnection()
+{
+	if ( !m_pServerConnection )
+		m_pServerConnection.reset( new ServerConnection( *m_pIoService, 
+			boost::bind( &AdvancedFacade::receiveUtqlResponse, this, _1 ) ) );
 
 	// start network thread
 	if ( !m_pNetworkThread )
-		m_pNetworkThread.reset( new boost::thread( boost::bind( &boost::asio::io_service::run, m_pIoService.get() ) ) );
+		m_pNetworkThread.reset( new boost::thread( boost::bind( &AdvancedFacade::networkThread, this ) ) );
+
+	return *m_pServerConnection;
+}
+
+
+void AdvancedFacade::networkThread()
+{
+	if ( !m_options.networkScheduling.isDefault() )
+	{
+		try
+		{
+			applyThreadScheduling( m_options.networkScheduling );
+		}
+		catch ( const Util::Exception& e )
+		{ LOG4CPP_ERROR( logger, "Cannot apply scheduling to the network thread: " << e ); }
+	}
+
+	m_pIoService->run();
 }
 
 
@@ -356,11 +1013,10 @@ void AdvancedFacade::sendUtqlToServer( const std::string& sUtqlFile )
 {
 	LOG4CPP_INFO( logger, "About to send file " << sUtqlFile << " to server" );
 
-	// load Utql from file
-	std::ifstream input( sUtqlFile.c_str() );
+	std::ifstream input( sUtqlFile.c_str(), std::ios::in | std::ios::binary );
 	if ( !input.good() )
 		UBITRACK_THROW( "Unable to open file " + sUtqlFile );
-	
+
 	sendUtqlToServer( input );
 }
 
@@ -369,31 +1025,55 @@ void AdvancedFacade::sendUtqlToServer( std::istream& stream )
 {
 	LOG4CPP_DEBUG( logger, "sending stream to server" );
 
-	// copy stream content to a string...
-	std::string buffer;
-	while ( stream.good() && !stream.eof() )
+	// copy stream content to a string, with a single allocation if the stream is seekable
+	boost::shared_ptr< std::string > pBuffer( new std::string );
+	std::string& buffer( *pBuffer );
+	std::streampos start( stream.tellg() );
+	if ( start != std::streampos( -1 ) && stream.seekg( 0, std::ios::end ) )
 	{
-		std::string tmp;
-		std::getline( stream, tmp );
-		buffer += tmp;
-		buffer += "\n";
+		std::streamoff size( stream.tellg() - start );
+		stream.seekg( start );
+		if ( size > 0 )
+		{
+			buffer.resize( static_cast< std::size_t >( size ) );
+			stream.read( &buffer[ 0 ], size );
+			buffer.resize( static_cast< std::size_t >( stream.gcount() ) );
+		}
+	}
+	else
+	{
+		stream.clear();
+		std::ostringstream content;
+		content << stream.rdbuf();
+		buffer = content.str();
 	}
 
-	sendUtqlToServerString( buffer );
+	sendUtqlBuffer( pBuffer, ServerResponseCallback() );
 }
 
 
 void AdvancedFacade::sendUtqlToServerString( const std::string& buffer )
 {
 	LOG4CPP_DEBUG( logger, "sending string to server" );
-	LOG4CPP_TRACE( logger, "sending:\n" << buffer );
-	
-	// check connection
-	if ( !m_pTcpConnection || m_pTcpConnection->badConnection() )
+	sendUtqlBuffer( boost::shared_ptr< const std::string >( new std::string( buffer ) ), ServerResponseCallback() );
+}
+
+
+unsigned int AdvancedFacade::sendUtqlToServerAsync( const std::string& sUtql, const ServerResponseCallback& callback )
+{
+	return sendUtqlBuffer( boost::shared_ptr< const std::string >( new std::string( sUtql ) ), callback );
+}
+
+
+unsigned int AdvancedFacade::sendUtqlBuffer( boost::shared_ptr< const std::string > pBuffer, const ServerResponseCallback& callback )
+{
+	LOG4CPP_TRACE( logger, "sending:\n" << *pBuffer );
+
+	// requests are queued while reconnecting, but there must be a server to send them to
+	if ( !m_pServerConnection )
 		UBITRACK_THROW( "no connection to server" );
 	
-	// send to server
-	m_pTcpConnection->send( buffer );
+	return m_pServerConnection->send( pBuffer, callback );
 }
 
 
@@ -406,18 +1086,241 @@ void AdvancedFacade::receiveUtqlResponse( boost::shared_ptr< Ubitrack::ClientSer
 	LOG4CPP_DEBUG( logger, "received:\n" << result );
 	std::istringstream input( result );
 
-	bool bPrevStarted = m_bStarted;
-	if ( bPrevStarted )
-		stopDataflow();
-	
+	// applied as a live patch, components not touched by the response keep running
 	loadDataflow( input, false );
-	
-	if ( bPrevStarted )
-		startDataflow();
 }
 
+Measurement::Timestamp AdvancedFacade::currentTime() const
+{
+	if ( m_options.virtualClock )
+		return m_virtualTime.load();
+	return Measurement::now();
+}
+
+
+void AdvancedFacade::setClock( Measurement::Timestamp t )
+{
+	if ( !m_options.virtualClock )
+		UBITRACK_THROW( "Facade was not created with a virtual clock" );
+	m_virtualTime.store( t );
+}
+
+
+void AdvancedFacade::advanceClock( Measurement::Timestamp delta )
+{
+	if ( !m_options.virtualClock )
+		UBITRACK_THROW( "Facade was not created with a virtual clock" );
+	m_virtualTime.fetch_add( delta );
+}
+
+
+void AdvancedFacade::waitForIdle()
+{
+	drainQueues( boost::posix_time::ptime( boost::posix_time::pos_infin ) );
+}
+
+
+void AdvancedFacade::detachComponents( const Graph::UTQLDocument& doc )
+{
+	for ( Graph::UTQLDocument::SubgraphList::const_iterator it = doc.m_Subgraphs.begin(); it != doc.m_Subgraphs.end(); it++ )
+	{
+		// only removed and replaced components
+		if ( m_componentPatterns.find( (*it)->m_ID ) == m_componentPatterns.end() )
+			continue;
+
+		boost::shared_ptr< Dataflow::Component > pComponent;
+		try
+		{
+			pComponent = m_pDataflowNetwork->componentByName< Dataflow::Component >( (*it)->m_ID );
+		}
+		catch ( const Util::Exception& )
+		{}
+
+		if ( !pComponent )
+			continue;
+
+		LOG4CPP_DEBUG( logger, "Stopping component " << (*it)->m_ID );
+		pComponent->stop();
+
+		// drop events still queued for the component
+		Dataflow::EventQueue::singleton( pComponent->getEventDomain(), m_bDropEvents ).removeComponent( pComponent.get() );
+		if ( m_pDeliveryQueue )
+			m_pDeliveryQueue->purge( pComponent.get() );
+	}
+}
+
+
+void AdvancedFacade::startComponents( const DataflowDelta& delta, const std::set< std::string >& oldDomains )
+{
+	std::set< std::string > startedDomains( oldDomains );
+	for ( DataflowDelta::EntryList::const_iterator it = delta.added.begin(); it != delta.added.end(); it++ )
+	{
+		boost::shared_ptr< Dataflow::Component > pComponent;
+		try
+		{
+			pComponent = m_pDataflowNetwork->componentByName< Dataflow::Component >( it->sComponentName );
+		}
+		catch ( const Util::Exception& e )
+		{ LOG4CPP_WARN( logger, "Cannot start component " << it->sComponentName << ": " << e ); }
+
+		if ( !pComponent )
+			continue;
+
+		std::string sDomainName( componentDomainName( it->sComponentName ) );
+		EventDomain& domain( eventDomain( sDomainName ) );
+		pComponent->setEventDomain( domain.id );
+		if ( startedDomains.insert( sDomainName ).second && !m_bPaused )
+			startEventDomain( sDomainName, domain );
+
+		LOG4CPP_DEBUG( logger, "Starting component " << it->sComponentName );
+		pComponent->start();
+	}
+}
+
+
+void AdvancedFacade::attachVirtualClock( const DataflowDelta& delta )
+{
+	for ( DataflowDelta::EntryList::const_iterator it = delta.added.begin(); it != delta.added.end(); it++ )
+	{
+		boost::shared_ptr< Dataflow::Component > pComponent;
+		try
+		{
+			pComponent = m_pDataflowNetwork->componentByName< Dataflow::Component >( it->sComponentName );
+		}
+		catch ( const Util::Exception& )
+		{}
+
+		if ( Components::ApplicationPushSourceBase* pSource = dynamic_cast< Components::ApplicationPushSourceBase* >( pComponent.get() ) )
+			pSource->setClock( boost::bind( &AdvancedFacade::currentTime, this ) );
+	}
+}
+
+
+void AdvancedFacade::getStatistics( FacadeStatistics& stats )
+{
+	boost::mutex::scoped_lock l( m_lookupMutex );
+	stats.domains.clear();
+	stats.endpoints.clear();
+
+	// the default domain and all named domains
+	std::map< std::string, EventDomainStatistics > domains;
+	domains[ std::string() ].domainId = m_eventDomain;
+	for ( EventDomainMap::iterator it = m_eventDomains.begin(); it != m_eventDomains.end(); it++ )
+	{
+		domains[ it->first ].domainName = it->first;
+		domains[ it->first ].domainId = it->second.id;
+	}
+
+	if ( m_pDataflowNetwork )
+	{
+		for ( ComponentPatternMap::iterator it = m_componentPatterns.begin(); it != m_componentPatterns.end(); it++ )
+		{
+			boost::shared_ptr< Dataflow::Component > pComponent;
+			try
+			{
+				pComponent = m_pDataflowNetwork->componentByName< Dataflow::Component >( it->first );
+			}
+			catch ( const Util::Exception& )
+			{}
+
+			// only application endpoints have counters
+			Components::EndpointCounters* pCounters = dynamic_cast< Components::EndpointCounters* >( pComponent.get() );
+			if ( !pCounters )
+				continue;
+
+			Components::EndpointCounters::Values values;
+			pCounters->readCounters( values );
+
+			EndpointStatistics endpoint;
+			endpoint.componentName = it->first;
+			endpoint.patternName = it->second;
+			endpoint.domainName = componentDomainName( it->first );
+			endpoint.events = values.nEvents;
+			if ( values.nEvents > 1 && values.lastEventTime > values.firstEventTime )
+				endpoint.rate = ( values.nEvents - 1 ) * 1e9 / ( values.lastEventTime - values.firstEventTime );
+			endpoint.latencyCount = values.nLatencies;
+			if ( values.nLatencies )
+				endpoint.meanLatency = double( values.latencySum ) / values.nLatencies;
+			endpoint.maxLatency = values.latencyMax;
+			endpoint.latencyHistogram.assign( values.histogram, values.histogram + Components::EndpointCounters::HISTOGRAM_BUCKETS );
+			stats.endpoints.push_back( endpoint );
+
+			// push sinks hand events from their domain to the application
+			if ( !dynamic_cast< Components::ApplicationPushSinkBase* >( pComponent.get() ) )
+				continue;
+
+			EventDomainStatistics& domain( domains[ endpoint.domainName ] );
+			domain.sinkEvents += values.nEvents;
+			if ( m_pDeliveryQueue )
+			{
+				EventDeliveryQueue::KeyCounters counters( m_pDeliveryQueue->getCounters( pComponent.get() ) );
+				domain.sinkDelivered += counters.nDelivered;
+				domain.sinkPending += counters.nQueued;
+				// events arriving without callback are lost, too
+				domain.sinkDropped += counters.nDropped + ( values.nEvents - std::min( values.nEvents, counters.nEnqueued ) );
+			}
+			else
+			{
+				domain.sinkDelivered += values.nLatencies;
+				domain.sinkDropped += values.nEvents - std::min( values.nEvents, values.nLatencies );
+			}
+		}
+
+		for ( std::map< std::string, EventDomainStatistics >::iterator it = domains.begin(); it != domains.end(); it++ )
+			it->second.queueDepth = Dataflow::EventQueue::singleton( it->second.domainId, m_bDropEvents ).getCurrentQueueLength();
+	}
+
+	for ( std::map< std::string, EventDomainStatistics >::iterator it = domains.begin(); it != domains.end(); it++ )
+		stats.domains.push_back( it->second );
+}
+
+
 void AdvancedFacade::killEverything(){
-	Dataflow::EventQueue::destroyEventQueue();
+	{
+		boost::mutex::scoped_lock l( g_domainMutex );
+		if ( g_nLiveFacades <= 1 )
+		{
+			Dataflow::EventQueue::destroyEventQueue();
+			return;
+		}
+	}
+
+	// the event queues are shared by all facades, so only stop ours
+	LOG4CPP_WARN( logger, "Other facades are still alive, only stopping the event queues of this facade" );
+	boost::recursive_mutex::scoped_lock l( m_dataflowMutex );
+	if ( m_bStarted )
+		stopDataflow();
+}
+
+
+unsigned int AdvancedFacade::acquireEventDomain( bool bNewFacade, bool bDropEvents )
+{
+	boost::mutex::scoped_lock l( g_domainMutex );
+	if ( bNewFacade )
+		g_nLiveFacades++;
+
+	std::vector< unsigned int >& freeDomains( g_freeDomains[ bDropEvents ] );
+	if ( !freeDomains.empty() )
+	{
+		unsigned int domain = freeDomains.back();
+		freeDomains.pop_back();
+		return domain;
+	}
+
+	return m_instanceCount++;
+}
+
+
+void AdvancedFacade::releaseEventDomains()
+{
+	boost::mutex::scoped_lock l( g_domainMutex );
+	g_nLiveFacades--;
+
+	std::vector< unsigned int >& freeDomains( g_freeDomains[ m_bDropEvents ] );
+	freeDomains.push_back( m_eventDomain );
+	for ( EventDomainMap::iterator it = m_eventDomains.begin(); it != m_eventDomains.end(); it++ )
+		if ( it->second.id != m_eventDomain )
+			freeDomains.push_back( it->second.id );
 }
 
 
@@ -34,21 +34,34 @@
 #include <utFacade/utFacade.h>
 #include <istream>
 #include <list>
+#include <map>
+#include <set>
+#include <deque>
 #include <boost/thread.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/atomic.hpp>
 #include <utClientServer/ClientServerConnection.h>
 #include <utDataflow/DataflowNetwork.h>
 
 #include "../utComponents/ApplicationPushSink.h"
 #include "../utComponents/ApplicationPushSource.h"
 
+#include "FacadeOptions.h"
+#include "EventDeliveryQueue.h"
+#include "ThreadScheduling.h"
+#include "FacadeStatistics.h"
+#include "EventDomainProbe.h"
+
 // lots of forward decls to avoid applications having to deal with these internals
 namespace Ubitrack { 
 	namespace Dataflow {
 		class ComponentFactory;
 	}
-	namespace ClientServer {
-		class TcpConnection;
+	namespace Graph {
+		class UTQLDocument;
+	}
+	namespace Facade {
+		class ServerConnection;
 	}
 }
 
@@ -70,6 +83,7 @@ void UTFACADE_EXPORT initGPU();
 
 // forward decls
 class DataflowObserver;
+struct DataflowDelta;
 
 
 /**
@@ -87,6 +101,14 @@ public:
 	AdvancedFacade( bool dropEvents, const std::string& sComponentPath = std::string() );
 	AdvancedFacade( const std::string& sComponentPath = std::string());
 
+	/**
+	 * Initializes the Ubitrack library with explicit options.
+	 *
+	 * @param options event queue and delivery options
+	 * @param sComponentPath Path to component directory. Uses default directory if none is specified
+	 */
+	AdvancedFacade( const FacadeOptions& options, const std::string& sComponentPath = std::string() );
+
  	/**
 	 * Destroys the dataflow network and removes all ubitrack resources
 	 */
@@ -107,7 +129,9 @@ public:
 	 *
 	 * @param sDfUtql stream of dataflow description
 	 * @param bReplace if true, replaces the existing data flow network with the new one. 
-	 *   Otherwise, the new file is considered as an update.
+	 *   Otherwise, the new file is considered as an update. In a running dataflow, event
+	 *   dispatch is suspended while the update is applied, but only in the event domains of
+	 *   the components it removes, replaces or connects to. Queued events are kept.
 	 */
 	void loadDataflow( std::istream& stream, bool bReplace = true );	
 	
@@ -118,16 +142,92 @@ public:
 	/** starts components and the event queue */
 	void startDataflow();
 	
-	/** stops components and the event queue */
+	/** 
+	 * stops components and the event queue. No dataflow event or application callback of this 
+	 * facade is in progress when it returns, unless it is called from such a callback.
+	 */
 	void stopDataflow();
 
+	/**
+	 * Suspends event dispatch in all event domains of the facade. Components keep running and
+	 * their events are queued until \c resume, so resuming is much cheaper than a restart.
+	 */
+	void pause();
+
+	/** resumes event dispatch after \c pause. Stays paused if an event queue cannot be restarted. */
+	void resume();
+
+	/** returns true between \c startDataflow and \c stopDataflow */
+	bool isStarted() const
+	{ return m_bStarted; }
+
+	/** returns true between \c pause and \c resume */
+	bool isPaused() const
+	{ return m_bPaused; }
+
+	/**
+	 * Stops the dataflow after processing the queued events. Application push sources reject
+	 * new events while draining. Waits for the completion of the events in dispatch, without
+	 * polling the queues.
+	 *
+	 * @param drainTimeout maximum time in milliseconds to wait for the queues to run empty
+	 * @return false if events were still queued after the timeout and have been discarded
+	 */
+	bool stop( unsigned int drainTimeout );
+
+
+	/**
+	 * Moves a component into a named event domain, which is served by its own dispatcher thread.
+	 * Components without a domain stay in the facade's default domain. Takes effect on the next 
+	 * \c startDataflow.
+	 *
+	 * The same can be done in UTQL by setting the dataflow attribute \c eventDomain of a pattern.
+	 *
+	 * @param sComponentName id of the component
+	 * @param sDomainName name of the event domain, empty for the default domain
+	 */
+	void setComponentEventDomain( const std::string& sComponentName, const std::string& sDomainName );
+
+	/**
+	 * Sets priority and CPU affinity of the dispatcher thread of an event domain.
+	 * Takes effect on the next \c startDataflow. Only supported on Linux.
+	 * Throws if the process lacks the privileges for the requested scheduling.
+	 *
+	 * @param sDomainName name of the event domain, empty for the default domain
+	 * @param scheduling scheduling parameters
+	 */
+	void setEventDomainScheduling( const std::string& sDomainName, const ThreadScheduling& scheduling );
+
 	
+	/** called with the id of a request and an error message, which is empty if the response was applied */
+	typedef boost::function< void( unsigned int, const std::string& ) > ServerResponseCallback;
+
+	/** called with true when connected to the server, with false and a reason when the connection fails or breaks */
+	typedef boost::function< void( bool, const std::string& ) > ServerStateCallback;
+
 	/** 
-	 * connect to a ubitrack server.
+	 * connect to a ubitrack server. Blocks until connected and throws if the attempt fails.
+	 * If the connection breaks later, it is re-established automatically.
 	 * @param sAddress format: <hostname> [":" <port>]
 	 */
 	void connectToServer( const std::string& sAddress );
 
+	/**
+	 * starts connecting to a ubitrack server and returns immediately. Failed attempts and broken
+	 * connections are retried with increasing delays. UTQL sent in the meantime is queued.
+	 * @param sAddress format: <hostname> [":" <port>]
+	 */
+	void connectToServerAsync( const std::string& sAddress );
+
+	/** closes the connection to the server and stops reconnecting */
+	void disconnectFromServer();
+
+	/** true while the connection to the server is up */
+	bool isConnectedToServer() const;
+
+	/** sets a callback for changes of the server connection, called on the network thread */
+	void setServerStateCallback( const ServerStateCallback& callback );
+
 	/**
 	 * sends the contents of a file to a connected ubitrack server.
 	 */
@@ -142,11 +242,25 @@ public:
 	 * sends a string to a connected ubitrack server.
 	 */
 	void sendUtqlToServerString( const std::string& buffer );
+
+	/**
+	 * Sends a UTQL request to the server without waiting for the response. Several requests
+	 * may be outstanding; responses are matched to requests in order.
+	 *
+	 * @param sUtql the UTQL request
+	 * @param callback called on the network thread after the response has been loaded
+	 * @return id of the request, passed to the callback
+	 */
+	unsigned int sendUtqlToServerAsync( const std::string& sUtql, const ServerResponseCallback& callback = ServerResponseCallback() );
+
+	/** number of requests sent to the server and not answered yet */
+	std::size_t pendingServerRequests() const;
 	
 	
 	/**
 	 * Returns a pointer to a component.
-	 * Throws an exception if not found.
+	 * Throws an exception if not found. Never waits for a dataflow reconfiguration to complete,
+	 * so it may be called from dataflow callbacks.
 	 *
 	 * @param ComponentClass class of the component to find
 	 * @param sComponentName name of the component to find
@@ -154,7 +268,10 @@ public:
 	 */
 	template< class ComponentClass >
 	boost::shared_ptr< ComponentClass > componentByName( const std::string& sComponentName )
-	{ return m_pDataflowNetwork->componentByName< ComponentClass >( sComponentName ); }
+	{
+		boost::mutex::scoped_lock l( m_lookupMutex );
+		return m_pDataflowNetwork->componentByName< ComponentClass >( sComponentName );
+	}
 	
 	/**
 	 * Sets a callback on an \c ApplicationPushSink.
@@ -166,7 +283,54 @@ public:
 	 */
 	template< class EventType >
 	void setCallback( const std::string& sComponentName, boost::function< void( const EventType& ) > callback )
-	{ componentByName< Components::ApplicationPushSink< EventType > >( sComponentName )->setCallback( callback ); }
+	{
+		boost::shared_ptr< Components::ApplicationPushSink< EventType > > pSink( 
+			componentByName< Components::ApplicationPushSink< EventType > >( sComponentName ) );
+		const Dataflow::Component* key( pSink.get() );
+		if ( m_pDeliveryQueue && callback )
+			callback = m_pDeliveryQueue->wrap( key, callback );
+		else if ( m_pDeliveryQueue )
+			m_pDeliveryQueue->purge( key );
+		pSink->setCallback( callback );
+	}
+
+	/**
+	 * Returns the current time of the facade: the virtual clock if enabled in the
+	 * \c FacadeOptions, the system clock otherwise.
+	 */
+	Measurement::Timestamp currentTime() const;
+
+	/**
+	 * Sets the virtual clock, e.g. to the start of a recording. The clock starts at
+	 * \c FacadeOptions::virtualClockStart.
+	 * Throws if the facade was not created with \c FacadeOptions::virtualClock.
+	 */
+	void setClock( Measurement::Timestamp t );
+
+	/**
+	 * Advances the virtual clock by \c delta nanoseconds.
+	 * Throws if the facade was not created with \c FacadeOptions::virtualClock.
+	 */
+	void advanceClock( Measurement::Timestamp delta );
+
+	/**
+	 * Blocks until the event queues of this facade and the application delivery queue are
+	 * empty and no event is being dispatched, so the next measurements can be pushed without
+	 * piling up events. Used to step through recorded data in virtual clock mode. Does not
+	 * wait for the event queues while the facade is paused.
+	 */
+	void waitForIdle();
+
+	/** returns the options the facade was constructed with */
+	const FacadeOptions& getOptions() const
+	{ return m_options; }
+
+	/** 
+	 * returns the queue delivering events to application callbacks, 
+	 * or NULL if callbacks are called synchronously 
+	 */
+	EventDeliveryQueue* getDeliveryQueue()
+	{ return m_pDeliveryQueue.get(); }
 
 	
 	/**
@@ -174,19 +338,51 @@ public:
 	 *
 	 * @param pObserver pointer to DataflowObserver
 	 */
-	void addDataflowObserver( DataflowObserver* pObserver )
-	{ m_observers.push_back( pObserver ); }
+	void addDataflowObserver( DataflowObserver* pObserver );
 	
 	/**
-	 * Removes a data flow observer from the observer list
+	 * Removes a data flow observer from the observer list.
+	 * If a notification is currently being delivered, this blocks until it is finished, so the
+	 * observer may be destroyed as soon as this method returns.
 	 *
 	 * @param pObserver pointer to DataflowObserver
 	 */
-	void removeDataflowObserver( DataflowObserver* pObserver )
-	{ m_observers.remove( pObserver ); }
+	void removeDataflowObserver( DataflowObserver* pObserver );
+
+	/**
+	 * Enables or disables asynchronous observer notification.
+	 *
+	 * When enabled, \c loadDataflow does not call the observers itself. Instead, all removed and
+	 * added components are collected into one \c DataflowDelta which is delivered to
+	 * \c DataflowObserver::notifyDataflowChanged on a background thread after the load has
+	 * completed. Deltas are delivered in the order of the loads.
+	 */
+	void setAsyncObserverNotification( bool bAsync );
+
+	/** waits until all pending asynchronous observer notifications have been delivered */
+	void flushObserverNotifications();
 	
+	/**
+	 * Takes a snapshot of the event domain and application endpoint statistics.
+	 * Does not wait for a concurrent start, stop or reconfiguration of the dataflow, so it may
+	 * be called from dataflow callbacks.
+	 *
+	 * @param stats receives the statistics
+	 */
+	void getStatistics( FacadeStatistics& stats );
+
+	/**
+	 * Destroys all event queues. If other facades are still alive, only the event queues of
+	 * this facade are stopped, as the queues are shared process-wide.
+	 */
 	void killEverything();
 protected:
+	/** construction options */
+	FacadeOptions m_options;
+
+	/** queue decoupling application callbacks from the dataflow, if enabled in the options */
+	boost::scoped_ptr< EventDeliveryQueue > m_pDeliveryQueue;
+
 	/** a component factory */
 	boost::scoped_ptr< Dataflow::ComponentFactory > m_pComponentFactory;
 	
@@ -196,18 +392,39 @@ protected:
 	/** has the data flow network been started? */
 	bool m_bStarted;
 
+	/** is event dispatch suspended? */
+	bool m_bPaused;
+
 	/** should the EventQueue drop events ? **/
 	bool m_bDropEvents;
 	
 	/** Boost ASIO IO service for client-server communication */
 	boost::scoped_ptr< boost::asio::io_service > m_pIoService;
 	
-	/** ubitrack TCP connection object for communication with the server */
-	boost::shared_ptr< ClientServer::TcpConnection > m_pTcpConnection;
+	/** connection to the ubitrack server */
+	boost::scoped_ptr< ServerConnection > m_pServerConnection;
 	
 	/** thread for the network */
 	boost::shared_ptr< boost::thread > m_pNetworkThread;
 
+	/** stops the running components that a dataflow patch removes or replaces */
+	void detachComponents( const Graph::UTQLDocument& doc );
+
+	/** assigns event domains to the components added by a dataflow patch and starts them */
+	void startComponents( const DataflowDelta& delta, const std::set< std::string >& oldDomains );
+
+	/** makes the push sources among the added components use the virtual clock */
+	void attachVirtualClock( const DataflowDelta& delta );
+
+	/** main loop of the network thread */
+	void networkThread();
+
+	/** creates the server connection and starts the network thread */
+	ServerConnection& serverConnection();
+
+	/** queues a request for the server */
+	unsigned int sendUtqlBuffer( boost::shared_ptr< const std::string > pBuffer, const ServerResponseCallback& callback );
+
 	/** handles a response from the ubitrack server */
 	void receiveUtqlResponse( boost::shared_ptr< Ubitrack::ClientServer::ClientServerConnection::BufferType > pBuffer );
 
@@ -217,6 +434,21 @@ protected:
 	/** list of data flow observers */
 	ObserverList m_observers;
 
+	/** 
+	 * protects the observer list. Held while notifications are delivered, recursive so that 
+	 * observers may (un-)register from within a notification
+	 */
+	boost::recursive_mutex m_observerMutex;
+
+	/** delivers a delta to all registered observers */
+	void notifyObservers( const DataflowDelta& delta );
+
+	/**
+	 * delivers the pending notifications and stops the notification thread.
+	 * Classes that are themselves observers must call this in their destructor.
+	 */
+	void stopObserverNotification();
+
 private:
 	/*
 	 * EventQueue Domain
@@ -224,10 +456,153 @@ private:
 	unsigned int m_eventDomain;
 
 	/*
-	 * global counter for automatic assignment of eventDomains
+	 * global counter for automatic assignment of eventDomains, only accessed through acquireEventDomain
 	 */
 	static unsigned int m_instanceCount;
 
+	/** 
+	 * returns an unused event domain id, thread-safe.
+	 * @param bNewFacade true if called from a facade constructor
+	 * @param bDropEvents drop policy of the event queue, ids of released domains are only reused with the same policy
+	 */
+	static unsigned int acquireEventDomain( bool bNewFacade, bool bDropEvents );
+
+	/** returns the event domain ids of this facade for reuse, called on destruction */
+	void releaseEventDomains();
+
+	/** deliver observer notifications asynchronously? */
+	bool m_bAsyncNotify;
+
+	/** deltas waiting to be delivered by the notification thread */
+	std::deque< boost::shared_ptr< DataflowDelta > > m_pendingDeltas;
+
+	/** number of deltas queued or currently being delivered */
+	std::size_t m_nUndeliveredDeltas;
+
+	/** tells the notification thread to terminate */
+	bool m_bStopNotifier;
+
+	boost::mutex m_notifyMutex;
+	boost::condition_variable m_notifyCondition;
+
+	/** thread delivering asynchronous observer notifications */
+	boost::shared_ptr< boost::thread > m_pNotifierThread;
+
+	/** main loop of the notification thread */
+	void notifierThread();
+
+	/** creates the component factory for the given or the default component directory */
+	void initComponentFactory( const std::string& sComponentPath );
+
+	/** an event domain with its own event queue */
+	struct EventDomain
+	{
+		EventDomain()
+			: id( 0 )
+		{}
+
+		unsigned int id;
+		ThreadScheduling scheduling;
+
+		/** runs tasks on the dispatcher thread, exists while the dataflow is started */
+		boost::shared_ptr< EventDomainProbe > pProbe;
+	};
+
+	/** named event domains, the empty name denotes the default domain */
+	typedef std::map< std::string, EventDomain > EventDomainMap;
+	EventDomainMap m_eventDomains;
+
+	/** pattern names of all components in the network, by component id */
+	typedef std::map< std::string, std::string > ComponentPatternMap;
+	ComponentPatternMap m_componentPatterns;
+
+	/** event domain names of components not in the default domain */
+	typedef std::map< std::string, std::string > ComponentDomainMap;
+	ComponentDomainMap m_componentDomains;
+
+	/**
+	 * Serializes changes of the network and the event domains: loading (also server pushes on
+	 * the network thread), starting, stopping and pausing. Protects the network pointer,
+	 * \c m_bStarted, \c m_bPaused and the maps above. Recursive, as these operations
+	 * call each other.
+	 */
+	boost::recursive_mutex m_dataflowMutex;
+
+	/**
+	 * Taken in addition to \c m_dataflowMutex while the network pointer, the components of the
+	 * network or the maps above change, and by \c componentByName and \c getStatistics instead
+	 * of it. Never held while waiting for a dispatcher, so dataflow callbacks can always take it.
+	 */
+	mutable boost::mutex m_lookupMutex;
+
+	/** serializes \c loadDataflow, held while event domains are suspended for a live patch */
+	boost::recursive_mutex m_loadMutex;
+
+	/**
+	 * event domains suspended by live patches in progress, once per patch. They are not
+	 * started by \c startDataflow or \c resume until all of these patches are done.
+	 */
+	std::multiset< std::string > m_suspendedDomains;
+
+	/** current time of the virtual clock, see \c FacadeOptions::virtualClock */
+	boost::atomic< Measurement::Timestamp > m_virtualTime;
+
+	/** returns a named event domain, allocating a new id if it does not exist yet */
+	EventDomain& eventDomain( const std::string& sDomainName );
+
+	/** moves components into their named event domains */
+	void assignComponentEventDomains();
+
+	/**
+	 * Starts the event queue of a domain and applies the scheduling parameters to its thread.
+	 * The scheduling is applied by a probe task running ahead of the queued events.
+	 * Throws if the scheduling cannot be applied, leaving the queue running.
+	 *
+	 * @param bClear discard events still queued for a domain other than the default one
+	 */
+	void startEventDomain( const std::string& sDomainName, EventDomain& domain, bool bClear = true );
+
+	/**
+	 * Waits until the event queues and the delivery queue are empty and no event is in dispatch.
+	 * Uses a barrier task of the \c EventDomainProbe of each domain instead of polling.
+	 *
+	 * @return false if the deadline passed first
+	 */
+	bool drainQueues( const boost::posix_time::ptime& deadline );
+
+	/** 
+	 * returns the event domains of the running components that a dataflow patch removes,
+	 * replaces or connects new components to
+	 */
+	std::set< std::string > touchedEventDomains( const Graph::UTQLDocument& doc ) const;
+
+	/** returns the event domain name of a component, empty for the default domain */
+	std::string componentDomainName( const std::string& sComponentName ) const;
+
+	/**
+	 * restarts the event queues of the given domains. On failure all event queues of the
+	 * facade are stopped and it is left paused.
+	 */
+	void resumeEventDomains( const std::set< std::string >& domains );
+
+	/**
+	 * ends the suspension of domains by a live patch and restarts those no other patch
+	 * suspends, unless the dataflow was paused or stopped meanwhile
+	 */
+	void resumeSuspendedDomains( const std::set< std::string >& domains );
+
+	/**
+	 * applies a dataflow document to the network, called by \c loadDataflow with the mutex locked
+	 *
+	 * @param bLive patch the running network, with the touched event domains suspended
+	 * @param oldDomains event domains that existed before the patch
+	 */
+	void patchDataflow( boost::shared_ptr< Graph::UTQLDocument > doc, bool bReplace, bool bLive, 
+		const std::set< std::string >& oldDomains );
+
+	/** lets the application push sources accept or reject events */
+	void enablePushSources( bool bEnable );
+
 };
 
 
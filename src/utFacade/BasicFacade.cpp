@@ -41,6 +41,7 @@
 #ifdef HAVE_OPENCV
 #include <utVision/Image.h>
 #include <utVision/OpenCLManager.h>
+#include "../utComponents/ApplicationEndpointsVision.h"
 #endif
 
 #include "BasicFacadeTypesPrivate.h"
@@ -66,6 +67,11 @@ namespace Ubitrack {
                 , m_pBasicObserver( 0 )
         {}
 
+        BasicFacadePrivate::BasicFacadePrivate( const char* sComponentPath, const FacadeOptions& options )
+                : AdvancedFacade( options, sComponentPath )
+                , m_pBasicObserver( 0 )
+        {}
+
         // translate from DataflowObserver to BasicDataflowObserver
         void BasicFacadePrivate::notifyAddComponent( const std::string & sPatternName, const std::string & sComponentName, const Graph::UTQLSubgraph& )
         {
@@ -79,6 +85,41 @@ namespace Ubitrack {
                 m_pBasicObserver->notifyDeleteComponent( sPatternName.c_str(), sComponentName.c_str() );
         }
 
+        void BasicFacadePrivate::notifyDataflowChanged( const DataflowDelta& delta )
+        {
+            if ( !m_pBasicObserver )
+                return;
+
+            // forward the whole delta in a single call to the observer
+            BasicDataflowDelta basicDelta;
+            for ( DataflowDelta::EntryList::const_iterator it = delta.removed.begin(); it != delta.removed.end(); it++ )
+                basicDelta.addRemoved( it->sPatternName.c_str(), it->sComponentName.c_str() );
+            for ( DataflowDelta::EntryList::const_iterator it = delta.added.begin(); it != delta.added.end(); it++ )
+                basicDelta.addAdded( it->sPatternName.c_str(), it->sComponentName.c_str() );
+
+            m_pBasicObserver->notifyDataflowChanged( basicDelta );
+        }
+
+        BasicFacadePrivate::~BasicFacadePrivate()
+        {
+            // this object is an observer itself, so pending notifications must be delivered while it is still alive
+            stopObserverNotification();
+
+            // the mirror callbacks of the pose table refer to members, stop dispatching before they are destroyed
+            if ( m_bStarted )
+            {
+                try
+                {
+                    stopDataflow();
+                }
+                catch ( const Ubitrack::Util::Exception& e )
+                {
+                    LOG4CPP_WARN( logger, "Caught exception stopping dataflow: " << e );
+                }
+            }
+            m_pPoseTable.reset();
+        }
+
 
         BasicFacade::BasicFacade( const char* sComponentPath, bool drop_events ) throw()
                 : m_pPrivate( 0 )
@@ -97,6 +138,23 @@ namespace Ubitrack {
         }
 
 
+        BasicFacade::BasicFacade( const char* sComponentPath, const FacadeOptions& options ) throw()
+                : m_pPrivate( 0 )
+                , m_sError( 0 )
+        {
+            try
+            {
+                m_pPrivate = new BasicFacadePrivate( sComponentPath, options );
+                LOG4CPP_TRACE( logger, "BasicFacadePrivate created successfully" );
+            }
+            catch ( const Ubitrack::Util::Exception& e )
+            {
+                LOG4CPP_ERROR( logger, "Caught exception constructing BasicFacade: " << e );
+                setError( e.what() );
+            }
+        }
+
+
         BasicFacade::~BasicFacade()
         {
             delete m_pPrivate;
@@ -110,6 +168,60 @@ namespace Ubitrack {
         }
 
 
+        unsigned long long int BasicFacade::currentTime() throw()
+        {
+            return m_pPrivate->currentTime();
+        }
+
+
+        bool BasicFacade::setClock( unsigned long long int timestamp ) throw()
+        {
+            try
+            {
+                m_pPrivate->setClock( timestamp );
+            }
+            catch ( const Ubitrack::Util::Exception& e )
+            {
+                LOG4CPP_ERROR( logger, "Caught exception in BasicFacade::setClock: " << e );
+                setError( e.what() );
+                return false;
+            }
+
+            return true;
+        }
+
+
+        bool BasicFacade::advanceClock( unsigned long long int delta ) throw()
+        {
+            try
+            {
+                m_pPrivate->advanceClock( delta );
+            }
+            catch ( const Ubitrack::Util::Exception& e )
+            {
+                LOG4CPP_ERROR( logger, "Caught exception in BasicFacade::advanceClock: " << e );
+                setError( e.what() );
+                return false;
+            }
+
+            return true;
+        }
+
+
+        void BasicFacade::waitForIdle() throw()
+        {
+            try
+            {
+                m_pPrivate->waitForIdle();
+            }
+            catch ( const Ubitrack::Util::Exception& e )
+            {
+                LOG4CPP_ERROR( logger, "Caught exception in BasicFacade::waitForIdle: " << e );
+                setError( e.what() );
+            }
+        }
+
+
         bool BasicFacade::loadDataflow( const char* sDfSrg, bool replace ) throw()
         {
             try
@@ -160,6 +272,23 @@ namespace Ubitrack {
         }
 
 
+        bool BasicFacade::setEventDomainScheduling( const char* sDomainName, const ThreadScheduling& scheduling ) throw()
+        {
+            try
+            {
+                m_pPrivate->setEventDomainScheduling( sDomainName, scheduling );
+            }
+            catch ( const Ubitrack::Util::Exception& e )
+            {
+                LOG4CPP_ERROR( logger, "Caught exception in BasicFacade::setEventDomainScheduling: " << e );
+                setError( e.what() );
+                return false;
+            }
+
+            return true;
+        }
+
+
         void BasicFacade::startDataflow() throw()
         {
             try
@@ -190,6 +319,49 @@ namespace Ubitrack {
         }
 
 
+        bool BasicFacade::stopDataflow( unsigned int drainTimeout ) throw()
+        {
+            try
+            {
+                return m_pPrivate->stop( drainTimeout );
+            }
+            catch ( const Ubitrack::Util::Exception& e )
+            {
+                LOG4CPP_ERROR( logger, "Caught exception in BasicFacade::stopDataflow: " << e );
+                setError( e.what() );
+            }
+            return false;
+        }
+
+
+        void BasicFacade::pauseDataflow() throw()
+        {
+            try
+            {
+                m_pPrivate->pause();
+            }
+            catch ( const Ubitrack::Util::Exception& e )
+            {
+                LOG4CPP_ERROR( logger, "Caught exception in BasicFacade::pauseDataflow: " << e );
+                setError( e.what() );
+            }
+        }
+
+
+        void BasicFacade::resumeDataflow() throw()
+        {
+            try
+            {
+                m_pPrivate->resume();
+            }
+            catch ( const Ubitrack::Util::Exception& e )
+            {
+                LOG4CPP_ERROR( logger, "Caught exception in BasicFacade::resumeDataflow: " << e );
+                setError( e.what() );
+            }
+        }
+
+
         void BasicFacade::connectToServer( const char* sAddress ) throw()
         {
             try
@@ -232,6 +404,47 @@ namespace Ubitrack {
         }
 
 
+        void BasicFacade::connectToServerAsync( const char* sAddress ) throw()
+        {
+            try
+            {
+                m_pPrivate->connectToServerAsync( sAddress );
+            }
+            catch ( const Ubitrack::Util::Exception& e )
+            {
+                LOG4CPP_ERROR( logger, "Caught exception in BasicFacade::connectToServerAsync: " << e );
+                setError( e.what() );
+            }
+        }
+
+
+        bool BasicFacade::isConnectedToServer() throw()
+        {
+            return m_pPrivate->isConnectedToServer();
+        }
+
+
+        unsigned int BasicFacade::sendUtqlToServerStringAsync( const char* buffer ) throw()
+        {
+            try
+            {
+                return m_pPrivate->sendUtqlToServerAsync( buffer );
+            }
+            catch ( const Ubitrack::Util::Exception& e )
+            {
+                LOG4CPP_ERROR( logger, "Caught exception in BasicFacade::sendUtqlToServerStringAsync: " << e );
+                setError( e.what() );
+            }
+            return 0;
+        }
+
+
+        unsigned int BasicFacade::getPendingServerRequests() throw()
+        {
+            return static_cast< unsigned int >( m_pPrivate->pendingServerRequests() );
+        }
+
+
         void BasicFacade::setDataflowObserver( BasicDataflowObserver* pObserver ) throw()
         {
             if ( !m_pPrivate->m_pBasicObserver )
@@ -247,6 +460,163 @@ namespace Ubitrack {
         }
 
 
+        void BasicFacade::setAsyncDataflowNotification( bool bAsync ) throw()
+        {
+            m_pPrivate->setAsyncObserverNotification( bAsync );
+        }
+
+
+        void BasicFacade::flushDataflowNotifications() throw()
+        {
+            m_pPrivate->flushObserverNotifications();
+        }
+
+
+        FacadeStatistics BasicFacade::getStatistics() throw()
+        {
+            FacadeStatistics stats;
+            try
+            {
+                m_pPrivate->getStatistics( stats );
+            }
+            catch ( const Ubitrack::Util::Exception& e )
+            {
+                LOG4CPP_ERROR( logger, "Caught exception in BasicFacade::getStatistics: " << e );
+                setError( e.what() );
+            }
+            return stats;
+        }
+
+
+        bool BasicFacade::createSharedPoseTable( const char* sTableName, unsigned int nEntries ) throw()
+        {
+            try
+            {
+                // the sinks call the mirror without synchronization, see closeSharedPoseTable
+                if ( m_pPrivate->m_pPoseTable && m_pPrivate->isStarted() && !m_pPrivate->isPaused() )
+                    UBITRACK_THROW( "Cannot replace the shared pose table while the dataflow is running, stop or pause it first" );
+
+                m_pPrivate->m_pPoseTable.reset();
+                m_pPrivate->m_pPoseTable.reset( new SharedPoseTableMirror( *m_pPrivate, sTableName, nEntries ) );
+            }
+            catch ( const Ubitrack::Util::Exception& e )
+            {
+                LOG4CPP_ERROR( logger, "Caught exception in BasicFacade::createSharedPoseTable: " << e );
+                setError( e.what() );
+                return false;
+            }
+
+            return true;
+        }
+
+
+        bool BasicFacade::mirrorToSharedPoseTable( const char* sSinkName ) throw()
+        {
+            try
+            {
+                if ( !m_pPrivate->m_pPoseTable )
+                    UBITRACK_THROW( "No shared pose table, call createSharedPoseTable first" );
+                m_pPrivate->m_pPoseTable->addSink( sSinkName );
+            }
+            catch ( const Ubitrack::Util::Exception& e )
+            {
+                LOG4CPP_ERROR( logger, "Caught exception in BasicFacade::mirrorToSharedPoseTable: " << e );
+                setError( e.what() );
+                return false;
+            }
+
+            return true;
+        }
+
+
+        void BasicFacade::closeSharedPoseTable() throw()
+        {
+            // a dispatcher may be inside a mirror callback or copying it while the callbacks are removed
+            if ( m_pPrivate->m_pPoseTable && m_pPrivate->isStarted() && !m_pPrivate->isPaused() )
+            {
+                LOG4CPP_ERROR( logger, "Cannot close the shared pose table while the dataflow is running" );
+                setError( "Cannot close the shared pose table while the dataflow is running, stop or pause it first" );
+                return;
+            }
+
+            m_pPrivate->m_pPoseTable.reset();
+        }
+
+
+#ifdef HAVE_OPENCV
+        std::shared_ptr< BasicImageMeasurement > BasicFacade::acquireImageBuffer( int width, int height,
+            BasicImageMeasurement::PixelFormat format, unsigned long long int ts ) throw()
+        {
+            try
+            {
+                boost::shared_ptr< Vision::Image > pImage( m_pPrivate->m_imageBufferPool.acquire( width, height,
+                    static_cast< Vision::Image::PixelFormat >( format ) ) );
+                return std::make_shared< BasicImageMeasurement >( ts,
+                    new BasicImageMeasurementPrivate( Measurement::ImageMeasurement( ts, pImage ) ) );
+            }
+            catch ( const Ubitrack::Util::Exception& e )
+            {
+                LOG4CPP_ERROR( logger, "Caught exception in BasicFacade::acquireImageBuffer: " << e );
+                setError( e.what() );
+            }
+            return std::shared_ptr< BasicImageMeasurement >();
+        }
+
+
+        std::shared_ptr< BasicImageMeasurement > BasicFacade::getLatestImage( const char* sSinkName,
+            unsigned long long int* pSequence ) throw()
+        {
+            try
+            {
+                boost::shared_ptr< Components::ApplicationPushSinkVisionImage > pSink(
+                    m_pPrivate->componentByName< Components::ApplicationPushSinkVisionImage >( sSinkName ) );
+                if ( !pSink->isMailbox() )
+                    UBITRACK_THROW( std::string( "Image sink " ) + sSinkName + " is not in mailbox mode" );
+
+                Measurement::ImageMeasurement m( pSink->latest( pSequence ) );
+                if ( m )
+                    return std::make_shared< BasicImageMeasurement >( m.time(), new BasicImageMeasurementPrivate( m ) );
+            }
+            catch ( const Ubitrack::Util::Exception& e )
+            {
+                LOG4CPP_ERROR( logger, "Caught exception in BasicFacade::getLatestImage: " << e );
+                setError( e.what() );
+            }
+            return std::shared_ptr< BasicImageMeasurement >();
+        }
+
+
+        bool BasicFacade::setImageReduction( const char* sSinkName, int roiX, int roiY, int roiWidth, int roiHeight,
+            double scale, bool bLinear ) throw()
+        {
+            try
+            {
+                boost::shared_ptr< Components::ImageReduction > pSink( boost::dynamic_pointer_cast< Components::ImageReduction >(
+                    m_pPrivate->componentByName< Dataflow::Component >( sSinkName ) ) );
+                if ( !pSink )
+                    UBITRACK_THROW( std::string( "Component " ) + sSinkName + " is not an image sink" );
+
+                Components::ImageReduction::Settings settings;
+                settings.roiX = roiX;
+                settings.roiY = roiY;
+                settings.roiWidth = roiWidth;
+                settings.roiHeight = roiHeight;
+                settings.scale = scale;
+                settings.bLinear = bLinear;
+                pSink->setReduction( settings );
+            }
+            catch ( const Ubitrack::Util::Exception& e )
+            {
+                LOG4CPP_ERROR( logger, "Caught exception in BasicFacade::setImageReduction: " << e );
+                setError( e.what() );
+                return false;
+            }
+
+            return true;
+        }
+#endif
+
+
         const char* BasicFacade::getLastError() throw()
         {
             if ( m_pPrivate )
@@ -37,6 +37,8 @@
 #include <string>
 #include <memory>
 
+#include "FacadeOptions.h"
+#include "FacadeStatistics.h"
 #include "BasicFacadeTypes.h"
 #include "BasicFacadeComponents.h"
 // Do not add additional includes here
@@ -69,11 +71,44 @@ namespace Ubitrack {
             */
             BasicFacade( const char* sComponentPath, bool dropEvents=true ) throw();
 
+            /*
+            * Initializes the Ubitrack library with explicit options, e.g. to deliver
+            * events to push sink callbacks through a bounded queue with a drop policy.
+            *
+            * @param sComponentPath Path to component directory. Uses default directory if none is specified
+            * @param options event queue and delivery options
+            */
+            BasicFacade( const char* sComponentPath, const FacadeOptions& options ) throw();
+
             /** destroys the data flow */
             ~BasicFacade();
 
             static unsigned long long int now();
 
+            /**
+            * returns the current time of this facade. Same as \c now() unless the facade was
+            * created with \c FacadeOptions::virtualClock.
+            */
+            unsigned long long int currentTime() throw();
+
+            /**
+            * sets the virtual clock, e.g. to the start of a recording.
+            * @return false if the facade was not created with a virtual clock
+            */
+            bool setClock( unsigned long long int timestamp ) throw();
+
+            /**
+            * advances the virtual clock by \c delta nanoseconds.
+            * @return false if the facade was not created with a virtual clock
+            */
+            bool advanceClock( unsigned long long int delta ) throw();
+
+            /**
+            * blocks until all events pushed so far have been processed and delivered.
+            * Used to step through recorded data in virtual clock mode.
+            */
+            void waitForIdle() throw();
+
 
             /**
             * Loads and instantiates a dataflow network from an XML file
@@ -95,12 +130,38 @@ namespace Ubitrack {
             void clearDataflow() throw();
 
 
+            /**
+            * Sets real-time priority and CPU affinity of the dispatcher thread of an event domain.
+            * Takes effect on the next \c startDataflow. Only supported on Linux.
+            * Scheduling of the network and worker threads is set with the \c FacadeOptions.
+            *
+            * @param sDomainName name of the event domain, empty for the default domain
+            * @param scheduling scheduling parameters
+            * @return false if the process lacks the privileges, see \c getLastError
+            */
+            bool setEventDomainScheduling( const char* sDomainName, const ThreadScheduling& scheduling ) throw();
+
             /** starts components and the event queue */
             void startDataflow() throw();
 
             /** stops components and the event queue */
             void stopDataflow() throw();
 
+            /**
+            * stops components and the event queue after processing the queued events.
+            * Push sources reject new events while draining.
+            *
+            * @param drainTimeout maximum time in milliseconds to wait for the queues to run empty
+            * @return false if events had to be discarded after the timeout
+            */
+            bool stopDataflow( unsigned int drainTimeout ) throw();
+
+            /** suspends event dispatch, components keep running and their events are queued */
+            void pauseDataflow() throw();
+
+            /** resumes event dispatch after \c pauseDataflow */
+            void resumeDataflow() throw();
+
 
             /**
             * connect to a ubitrack server.
@@ -118,6 +179,26 @@ namespace Ubitrack {
             */
             void sendUtqlToServerString( const char* buffer ) throw();
 
+            /**
+            * starts connecting to a ubitrack server and returns immediately.
+            * Failed attempts and broken connections are retried with increasing delays.
+            * @param sAddress format: <hostname> [":" <port>]
+            */
+            void connectToServerAsync( const char* sAddress ) throw();
+
+            /** true while the connection to the server is up */
+            bool isConnectedToServer() throw();
+
+            /**
+            * sends a string to the server without waiting for the response. Requests are
+            * queued while the connection is down and answered in order.
+            * @return id of the request, 0 on error
+            */
+            unsigned int sendUtqlToServerStringAsync( const char* buffer ) throw();
+
+            /** number of requests sent to the server and not answered yet */
+            unsigned int getPendingServerRequests() throw();
+
 
             /**
             * Get notifications when new dataflow components are created or deleted
@@ -131,6 +212,92 @@ namespace Ubitrack {
             */
             void removeDataflowObserver() throw();
 
+            /**
+            * deliver observer notifications as one batched delta on a background thread after each load
+            * instead of calling the observer synchronously for every component.
+            * See BasicDataflowObserver::notifyDataflowChanged.
+            */
+            void setAsyncDataflowNotification( bool bAsync ) throw();
+
+            /** waits until all pending asynchronous observer notifications have been delivered */
+            void flushDataflowNotifications() throw();
+
+            /**
+            * returns a snapshot of the per event domain and per endpoint statistics.
+            * The counters are always collected; taking the snapshot is cheap but not free.
+            */
+            FacadeStatistics getStatistics() throw();
+
+            /**
+            * creates a table of the latest measurements in named shared memory, which other processes
+            * read without blocking through SharedPoseTableReader (utFacade/SharedPoseTable.h).
+            * Replaces a table created before, which fails while the dataflow is running and not paused.
+            *
+            * @param sTableName name of the shared memory object
+            * @param nEntries maximum number of mirrored sinks
+            * @return false on error, see getLastError()
+            */
+            bool createSharedPoseTable( const char* sTableName, unsigned int nEntries ) throw();
+
+            /**
+            * mirrors a push sink of poses, error poses, positions, error positions or rotations into
+            * the shared pose table. The table is updated on the dataflow thread and takes the
+            * callback of the sink, replacing a callback registered by the application. A callback
+            * registered later replaces the mirror in turn. Fails while the dataflow is running and
+            * not paused, and for sinks that are mirrored already.
+            *
+            * @return false on error, see getLastError()
+            */
+            bool mirrorToSharedPoseTable( const char* sSinkName ) throw();
+
+            /**
+            * removes the shared pose table and the callbacks of the mirrored sinks. Fails while the
+            * dataflow is running and not paused, see getLastError(). Destroying the facade closes
+            * the table after stopping the dataflow.
+            */
+            void closeSharedPoseTable() throw();
+
+#ifdef HAVE_OPENCV
+            /**
+            * borrows an image with an uninitialized pixel buffer from a pool owned by the facade.
+            * Fill it through getDataPtr() and send it through a BasicPushSource without copying.
+            * The buffer returns to the pool when the last reference to the image, in the dataflow
+            * or in the application, is dropped.
+            *
+            * @return the image or an empty pointer if the format has no fixed pixel size, see getLastError()
+            */
+            std::shared_ptr< BasicImageMeasurement > acquireImageBuffer( int width, int height,
+                BasicImageMeasurement::PixelFormat format, unsigned long long int ts = 0 ) throw();
+
+            /**
+            * returns the newest image of an ApplicationPushSinkVisionImage configured with mode "mailbox".
+            * The image is shared with the sink, not copied.
+            *
+            * @param sSinkName name of the sink component
+            * @param pSequence if given, receives the number of images the sink has received, to detect new images
+            * @return the image or an empty pointer if none has arrived yet or on error, see getLastError()
+            */
+            std::shared_ptr< BasicImageMeasurement > getLatestImage( const char* sSinkName,
+                unsigned long long int* pSequence = 0 ) throw();
+
+            /**
+            * sets the region of interest and scale an image sink (ApplicationPushSinkVisionImage or
+            * ApplicationPullSinkVisionImage) applies before handing images to the application.
+            * Overrides the roi, scale and interpolation attributes of the sink.
+            *
+            * @param sSinkName name of the sink component
+            * @param roiX left column of the region
+            * @param roiY top row of the region, in memory row order
+            * @param roiWidth width of the region, 0 extends it to the right image border
+            * @param roiHeight height of the region, 0 extends it to the bottom image border
+            * @param scale factor in (0, 1] applied to the region
+            * @param bLinear bilinear instead of area interpolation
+            * @return false on error, see getLastError()
+            */
+            bool setImageReduction( const char* sSinkName, int roiX, int roiY, int roiWidth, int roiHeight,
+                double scale = 1.0, bool bLinear = false ) throw();
+#endif
+
             /** returns the description of the last error or 0 if there was no error so far. */
             const char* getLastError() throw();
 
@@ -53,7 +53,7 @@ namespace Ubitrack {
         template< typename BMT >
         BasicPullSink< BMT >::~BasicPullSink() {
             if (m_pPrivate) {
-                free(m_pPrivate);
+                delete m_pPrivate;
             }
         }
 
@@ -83,7 +83,7 @@ namespace Ubitrack {
         template< typename BMT >
         BasicPushSink< BMT >::~BasicPushSink() {
             if (m_pPrivate) {
-                free(m_pPrivate);
+                delete m_pPrivate;
             }
         }
 
@@ -112,7 +112,7 @@ namespace Ubitrack {
         template< typename BMT >
         BasicPullSource< BMT >::~BasicPullSource() {
             if (m_pPrivate) {
-                free(m_pPrivate);
+                delete m_pPrivate;
             }
         }
 
@@ -141,7 +141,7 @@ namespace Ubitrack {
         template< typename BMT >
         BasicPushSource< BMT >::~BasicPushSource() {
             if (m_pPrivate) {
-                free(m_pPrivate);
+                delete m_pPrivate;
             }
         }
 
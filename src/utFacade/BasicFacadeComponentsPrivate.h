@@ -62,7 +62,7 @@ namespace Ubitrack { namespace Facade {
             : m_component(facade->componentByName< component_type >(name)) {}
 
             ~BasicPullSinkPrivate() {
-                m_component.clear();
+                m_component.reset();
             }
 
             std::shared_ptr<BMT> get(unsigned long long int const ts) {
@@ -86,20 +86,32 @@ namespace Ubitrack { namespace Facade {
             typedef typename Components::ApplicationPushSink< measurement_type > component_type;
 
             BasicPushSinkPrivate(const char* name, BasicFacadePrivate* facade)
-                    : m_component(facade->componentByName< component_type >(name)) {}
+                    : m_component(facade->componentByName< component_type >(name))
+                    , m_pDeliveryQueue(facade->getDeliveryQueue())
+                    , m_bRegistered(false) {}
 
             ~BasicPushSinkPrivate() {
-                m_component.clear();
+                // the component and the queued events refer to this object, unregistering drops both
+                if (m_bRegistered)
+                    unregisterCallback();
+                m_component.reset();
             }
 
             void registerCallback(typename BasicPushSink< BMT >::CallbackType cb) {
                 m_slot = cb;
-                m_component->setCallback(boost::bind( &BasicPushSinkPrivate::pushHandler, this, _1 ) );
+                boost::function< void( const measurement_type& ) > handler( boost::bind( &BasicPushSinkPrivate::pushHandler, this, _1 ) );
+                if (m_pDeliveryQueue)
+                    handler = m_pDeliveryQueue->wrap(deliveryKey(), handler);
+                m_component->setCallback(handler);
+                m_bRegistered = true;
             }
 
             void unregisterCallback() {
                 if (m_component) {
 					m_component->setCallback(NULL);
+                    m_bRegistered = false;
+                    if (m_pDeliveryQueue)
+                        m_pDeliveryQueue->purge(deliveryKey());
 #if defined (COMPILER_USE_CXX11) && defined (WIN32)
                     m_slot = nullptr;
 #else
@@ -117,6 +129,17 @@ namespace Ubitrack { namespace Facade {
 
             boost::shared_ptr< component_type >  m_component;
             typename BasicPushSink< BMT >::CallbackType m_slot;
+
+            /** facade queue for application events, NULL for synchronous delivery */
+            EventDeliveryQueue* m_pDeliveryQueue;
+
+            /** the component calls this object */
+            bool m_bRegistered;
+
+            /** events are queued per sink component */
+            const void* deliveryKey() const {
+                return static_cast< const Dataflow::Component* >(m_component.get());
+            }
         };
 
         /*
@@ -129,20 +152,26 @@ namespace Ubitrack { namespace Facade {
             typedef typename Components::ApplicationPullSource< measurement_type > component_type;
 
             BasicPullSourcePrivate(const char* name, BasicFacadePrivate* facade)
-                    : m_component(facade->componentByName< component_type >(name)) {}
+                    : m_component(facade->componentByName< component_type >(name))
+                    , m_bRegistered(false) {}
 
             ~BasicPullSourcePrivate() {
-                m_component.clear();
+                // the component refers to this object
+                if (m_bRegistered)
+                    unregisterCallback();
+                m_component.reset();
             }
 
             void registerCallback(typename BasicPullSource< BMT >::CallbackType cb) {
                 m_slot = cb;
                 m_component->setCallback(boost::bind( &BasicPullSourcePrivate::pullHandler, this, _1 ) );
+                m_bRegistered = true;
             }
 
             void unregisterCallback() {
                 if (m_component) {
 					m_component->setCallback(NULL);
+                    m_bRegistered = false;
 #if defined (COMPILER_USE_CXX11) && defined (WIN32)
                     m_slot = nullptr;
 #else
@@ -165,6 +194,9 @@ namespace Ubitrack { namespace Facade {
 
             boost::shared_ptr< component_type >  m_component;
             typename BasicPullSource< BMT >::CallbackType m_slot;
+
+            /** the component calls this object */
+            bool m_bRegistered;
         };
 
         /*
@@ -180,7 +212,7 @@ namespace Ubitrack { namespace Facade {
                     : m_component(facade->componentByName< component_type >(name)) {}
 
             ~BasicPushSourcePrivate() {
-                m_component.clear();
+                m_component.reset();
             }
 
             void send(const std::shared_ptr<BMT>& bm) {
@@ -37,6 +37,11 @@
 #include "AdvancedFacade.h"
 #include "DataflowObserver.h"
 #include "BasicFacadeComponentsPrivate.h"
+#include "SharedPoseTableMirror.h"
+
+#ifdef HAVE_OPENCV
+#include "ImageBufferPool.h"
+#endif
 
 
 namespace Ubitrack {
@@ -47,12 +52,23 @@ namespace Ubitrack {
         {
         public:
             BasicFacadePrivate( const char* sComponentPath, bool drop_event=true );
+            BasicFacadePrivate( const char* sComponentPath, const FacadeOptions& options );
+            ~BasicFacadePrivate();
 
             // translate from DataflowObserver to SimpleDataflowObserver
             void notifyAddComponent( const std::string & sPatternName, const std::string & sComponentName, const Graph::UTQLSubgraph& );
             void notifyDeleteComponent( const std::string & sPatternName, const std::string & sComponentName );
+            void notifyDataflowChanged( const DataflowDelta& delta );
 
             BasicDataflowObserver* m_pBasicObserver;
+
+            /** mirrors push sinks into shared memory, see BasicFacade::createSharedPoseTable */
+            boost::scoped_ptr< SharedPoseTableMirror > m_pPoseTable;
+
+#ifdef HAVE_OPENCV
+            /** recycles the pixel buffers of images acquired by the application */
+            ImageBufferPool m_imageBufferPool;
+#endif
         };
 
     }
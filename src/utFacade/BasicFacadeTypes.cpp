@@ -31,12 +31,123 @@
 #include <utFacade/Config.h>
 #ifdef ENABLE_BASICFACADE
 
+#include <utUtil/Logging.h>
+#include <utUtil/Exception.h>
+
 #include "BasicFacadeTypesPrivate.h"
 #include <algorithm>
 
+#ifdef HAVE_OPENCV
+#include "ImageConversion.h"
+#endif
+
+static log4cpp::Category& logger( log4cpp::Category::getInstance( "Ubitrack.Facade.BasicFacadeTypes" ) );
+
 namespace Ubitrack {
 namespace Facade {
 
+namespace {
+
+/* logs and returns false if a caller buffer of size elements is smaller than required */
+bool checkBufferSize(std::size_t size, std::size_t required, const char* sFunction)
+{
+    if (size < required) {
+        LOG4CPP_ERROR( logger, sFunction << ": buffer of " << size << " elements is too small for " << required << " elements" );
+        return false;
+    }
+    return true;
+}
+
+/* the copyValues overloads write one value to data and return the number of doubles written */
+unsigned int copyValues(const Math::Scalar<double>& v, double* data)
+{
+    data[0] = v;
+    return 1;
+}
+
+template<int LEN>
+unsigned int copyValues(const Math::Vector<double, LEN>& v, double* data)
+{
+    for (unsigned int i = 0; i < LEN; i++) {
+        data[i] = v(i);
+    }
+    return LEN;
+}
+
+template<int ROWS, int COLS>
+unsigned int copyValues(const Math::Matrix<double, ROWS, COLS>& m, double* data)
+{
+    for (unsigned int i = 0; i < ROWS; i++) {
+        for (unsigned int j = 0; j < COLS; j++) {
+            data[i*COLS+j] = m(i, j);
+        }
+    }
+    return ROWS*COLS;
+}
+
+unsigned int copyValues(const Math::Quaternion& q, double* data)
+{
+    data[0] = q.x();
+    data[1] = q.y();
+    data[2] = q.z();
+    data[3] = q.w();
+    return 4;
+}
+
+unsigned int copyValues(const Math::Pose& p, double* data)
+{
+    copyValues(p.translation(), data);
+    copyValues(p.rotation(), data+3);
+    return 7;
+}
+
+template<int LEN>
+unsigned int copyValues(const Math::ErrorVector<double, LEN>& v, double* data)
+{
+    return copyValues(v.value, data);
+}
+
+/* the copyCovariance overloads write the covariance of one value row-major and return the number of doubles written */
+template<int LEN>
+unsigned int copyCovariance(const Math::ErrorVector<double, LEN>& v, double* data)
+{
+    return copyValues(v.covariance, data);
+}
+
+unsigned int copyCovariance(const Math::ErrorPose& p, double* data)
+{
+    const Math::Matrix< double, 6, 6 >& cv = p.covariance();
+    return copyValues(cv, data);
+}
+
+/* copies the values of all elements of a list measurement */
+template<class T>
+bool copyListValues(const std::vector<T>& list, unsigned int elementSize, unsigned int size, double* data, const char* sFunction)
+{
+    if (!checkBufferSize(size, list.size()*elementSize, sFunction)) {
+        return false;
+    }
+    for (std::size_t i = 0; i < list.size(); ++i) {
+        data += copyValues(list[i], data);
+    }
+    return true;
+}
+
+/* copies the covariances of all elements of a list measurement */
+template<class T>
+bool copyListCovariance(const std::vector<T>& list, unsigned int elementSize, unsigned int size, double* data, const char* sFunction)
+{
+    if (!checkBufferSize(size, list.size()*elementSize, sFunction)) {
+        return false;
+    }
+    for (std::size_t i = 0; i < list.size(); ++i) {
+        data += copyCovariance(list[i], data);
+    }
+    return true;
+}
+
+} // anonymous namespace
+
 /*
  * Single Measurements
  */
@@ -158,6 +269,21 @@ bool BasicVectorMeasurement<LEN>::get(std::vector<float>& v)
     return false;
 }
 
+template<int LEN>
+bool BasicVectorMeasurement<LEN>::get(unsigned int size, double* data)
+{
+    if (m_pPrivate) {
+        if (m_pPrivate->m_measurement) {
+            if (!checkBufferSize(size, this->size(), "BasicVectorMeasurement::get")) {
+                return false;
+            }
+            copyValues(*(m_pPrivate->m_measurement), data);
+            return true;
+        }
+    }
+    return false;
+}
+
 // Mat
 template<int ROWS, int COLS>
 BasicMatrixMeasurement<ROWS, COLS>::BasicMatrixMeasurement(unsigned long long int const ts,
@@ -215,6 +341,21 @@ bool BasicMatrixMeasurement<ROWS, COLS>::get(std::vector<float>& v)
     return false;
 }
 
+template<int ROWS, int COLS>
+bool BasicMatrixMeasurement<ROWS, COLS>::get(unsigned int size, double* data)
+{
+    if (m_pPrivate) {
+        if (m_pPrivate->m_measurement) {
+            if (!checkBufferSize(size, this->size(), "BasicMatrixMeasurement::get")) {
+                return false;
+            }
+            copyValues(*(m_pPrivate->m_measurement), data);
+            return true;
+        }
+    }
+    return false;
+}
+
 // Pose
 BasicPoseMeasurement::BasicPoseMeasurement(unsigned long long int const ts, BasicPoseMeasurementPrivate* _pPrivate)
         :BasicMeasurement(ts), m_pPrivate(_pPrivate) { }
@@ -277,6 +418,20 @@ bool BasicPoseMeasurement::get(std::vector<float>& v)
     return false;
 }
 
+bool BasicPoseMeasurement::get(unsigned int size, double* data)
+{
+    if (m_pPrivate) {
+        if (m_pPrivate->m_measurement) {
+            if (!checkBufferSize(size, this->size(), "BasicPoseMeasurement::get")) {
+                return false;
+            }
+            copyValues(*(m_pPrivate->m_measurement), data);
+            return true;
+        }
+    }
+    return false;
+}
+
 // Rotation
 BasicRotationMeasurement::BasicRotationMeasurement(unsigned long long int const ts,
         BasicRotationMeasurementPrivate* _pPrivate)
@@ -330,6 +485,20 @@ bool BasicRotationMeasurement::get(std::vector<float>& v)
     return false;
 }
 
+bool BasicRotationMeasurement::get(unsigned int size, double* data)
+{
+    if (m_pPrivate) {
+        if (m_pPrivate->m_measurement) {
+            if (!checkBufferSize(size, this->size(), "BasicRotationMeasurement::get")) {
+                return false;
+            }
+            copyValues(*(m_pPrivate->m_measurement), data);
+            return true;
+        }
+    }
+    return false;
+}
+
 // ErrorVec
 template<int LEN>
 BasicErrorVectorMeasurement<LEN>::BasicErrorVectorMeasurement(unsigned long long int const ts,
@@ -386,6 +555,36 @@ bool BasicErrorVectorMeasurement<LEN>::getCovariance(std::vector<double>& v)
     return false;
 }
 
+template<int LEN>
+bool BasicErrorVectorMeasurement<LEN>::get(unsigned int size, double* data)
+{
+    if (m_pPrivate) {
+        if (m_pPrivate->m_measurement) {
+            if (!checkBufferSize(size, this->size(), "BasicErrorVectorMeasurement::get")) {
+                return false;
+            }
+            copyValues(*(m_pPrivate->m_measurement), data);
+            return true;
+        }
+    }
+    return false;
+}
+
+template<int LEN>
+bool BasicErrorVectorMeasurement<LEN>::getCovariance(unsigned int size, double* data)
+{
+    if (m_pPrivate) {
+        if (m_pPrivate->m_measurement) {
+            if (!checkBufferSize(size, LEN*LEN, "BasicErrorVectorMeasurement::getCovariance")) {
+                return false;
+            }
+            copyCovariance(*(m_pPrivate->m_measurement), data);
+            return true;
+        }
+    }
+    return false;
+}
+
 // ErrorPose
 BasicErrorPoseMeasurement::BasicErrorPoseMeasurement(unsigned long long int const ts,
         BasicErrorPoseMeasurementPrivate* _pPrivate)
@@ -469,6 +668,34 @@ bool BasicErrorPoseMeasurement::getCovariance(std::vector<double>& v)
 }
 
 
+bool BasicErrorPoseMeasurement::get(unsigned int size, double* data)
+{
+    if (m_pPrivate) {
+        if (m_pPrivate->m_measurement) {
+            if (!checkBufferSize(size, this->size(), "BasicErrorPoseMeasurement::get")) {
+                return false;
+            }
+            copyValues(*(m_pPrivate->m_measurement), data);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BasicErrorPoseMeasurement::getCovariance(unsigned int size, double* data)
+{
+    if (m_pPrivate) {
+        if (m_pPrivate->m_measurement) {
+            if (!checkBufferSize(size, 36, "BasicErrorPoseMeasurement::getCovariance")) {
+                return false;
+            }
+            copyCovariance(*(m_pPrivate->m_measurement), data);
+            return true;
+        }
+    }
+    return false;
+}
+
 /*
  * List Measurements
  */
@@ -505,6 +732,31 @@ bool BasicScalarIntListMeasurement::get(std::vector<int>& v)
     return false;
 }
 
+unsigned int BasicScalarIntListMeasurement::elementCount()
+{
+    if (m_pPrivate) {
+        return static_cast<unsigned int>(m_pPrivate->elementCount());
+    }
+    return 0;
+}
+
+bool BasicScalarIntListMeasurement::get(unsigned int size, int* data)
+{
+    if (m_pPrivate) {
+        if (m_pPrivate->m_measurement) {
+            std::vector< Math::Scalar<int> >* m = m_pPrivate->m_measurement.get();
+            if (!checkBufferSize(size, m->size(), "BasicScalarIntListMeasurement::get")) {
+                return false;
+            }
+            for (unsigned int i = 0; i < m->size(); ++i) {
+                data[i] = m->at(i);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
 // ScalarDouble
 BasicScalarDoubleListMeasurement::BasicScalarDoubleListMeasurement(unsigned long long int const ts,
         BasicScalarDoubleListMeasurementPrivate* _pPrivate)
@@ -550,6 +802,24 @@ bool BasicScalarDoubleListMeasurement::get(std::vector<float>& v)
     return false;
 }
 
+unsigned int BasicScalarDoubleListMeasurement::elementCount()
+{
+    if (m_pPrivate) {
+        return static_cast<unsigned int>(m_pPrivate->elementCount());
+    }
+    return 0;
+}
+
+bool BasicScalarDoubleListMeasurement::get(unsigned int size, double* data)
+{
+    if (m_pPrivate) {
+        if (m_pPrivate->m_measurement) {
+            return copyListValues(*(m_pPrivate->m_measurement), this->size(), size, data, "BasicScalarDoubleListMeasurement::get");
+        }
+    }
+    return false;
+}
+
 // Vec
 template<int LEN>
 BasicVectorListMeasurement<LEN>::BasicVectorListMeasurement(unsigned long long int const ts,
@@ -610,6 +880,26 @@ bool BasicVectorListMeasurement<LEN>::get(std::vector< std::vector<float> >& v)
     return false;
 }
 
+template<int LEN>
+unsigned int BasicVectorListMeasurement<LEN>::elementCount()
+{
+    if (m_pPrivate) {
+        return static_cast<unsigned int>(m_pPrivate->elementCount());
+    }
+    return 0;
+}
+
+template<int LEN>
+bool BasicVectorListMeasurement<LEN>::get(unsigned int size, double* data)
+{
+    if (m_pPrivate) {
+        if (m_pPrivate->m_measurement) {
+            return copyListValues(*(m_pPrivate->m_measurement), this->size(), size, data, "BasicVectorListMeasurement::get");
+        }
+    }
+    return false;
+}
+
 // Pose
 BasicPoseListMeasurement::BasicPoseListMeasurement(unsigned long long int const ts, BasicPoseListMeasurementPrivate* _pPrivate)
         :BasicMeasurement(ts), m_pPrivate(_pPrivate) { }
@@ -678,6 +968,24 @@ bool BasicPoseListMeasurement::get(std::vector< std::vector<float> >& v)
     return false;
 }
 
+unsigned int BasicPoseListMeasurement::elementCount()
+{
+    if (m_pPrivate) {
+        return static_cast<unsigned int>(m_pPrivate->elementCount());
+    }
+    return 0;
+}
+
+bool BasicPoseListMeasurement::get(unsigned int size, double* data)
+{
+    if (m_pPrivate) {
+        if (m_pPrivate->m_measurement) {
+            return copyListValues(*(m_pPrivate->m_measurement), this->size(), size, data, "BasicPoseListMeasurement::get");
+        }
+    }
+    return false;
+}
+
 // ErrorVec
 template<int LEN>
 BasicErrorVectorListMeasurement<LEN>::BasicErrorVectorListMeasurement(unsigned long long int const ts,
@@ -740,6 +1048,37 @@ bool BasicErrorVectorListMeasurement<LEN>::getCovariance(std::vector< std::vecto
     return false;
 }
 
+template<int LEN>
+unsigned int BasicErrorVectorListMeasurement<LEN>::elementCount()
+{
+    if (m_pPrivate) {
+        return static_cast<unsigned int>(m_pPrivate->elementCount());
+    }
+    return 0;
+}
+
+template<int LEN>
+bool BasicErrorVectorListMeasurement<LEN>::get(unsigned int size, double* data)
+{
+    if (m_pPrivate) {
+        if (m_pPrivate->m_measurement) {
+            return copyListValues(*(m_pPrivate->m_measurement), this->size(), size, data, "BasicErrorVectorListMeasurement::get");
+        }
+    }
+    return false;
+}
+
+template<int LEN>
+bool BasicErrorVectorListMeasurement<LEN>::getCovariance(unsigned int size, double* data)
+{
+    if (m_pPrivate) {
+        if (m_pPrivate->m_measurement) {
+            return copyListCovariance(*(m_pPrivate->m_measurement), LEN*LEN, size, data, "BasicErrorVectorListMeasurement::getCovariance");
+        }
+    }
+    return false;
+}
+
 // ErrorPose
 BasicErrorPoseListMeasurement::BasicErrorPoseListMeasurement(unsigned long long int const ts,
         BasicErrorPoseListMeasurementPrivate* _pPrivate)
@@ -833,6 +1172,34 @@ bool BasicErrorPoseListMeasurement::getCovariance(std::vector< std::vector<doubl
 }
 
 
+unsigned int BasicErrorPoseListMeasurement::elementCount()
+{
+    if (m_pPrivate) {
+        return static_cast<unsigned int>(m_pPrivate->elementCount());
+    }
+    return 0;
+}
+
+bool BasicErrorPoseListMeasurement::get(unsigned int size, double* data)
+{
+    if (m_pPrivate) {
+        if (m_pPrivate->m_measurement) {
+            return copyListValues(*(m_pPrivate->m_measurement), this->size(), size, data, "BasicErrorPoseListMeasurement::get");
+        }
+    }
+    return false;
+}
+
+bool BasicErrorPoseListMeasurement::getCovariance(unsigned int size, double* data)
+{
+    if (m_pPrivate) {
+        if (m_pPrivate->m_measurement) {
+            return copyListCovariance(*(m_pPrivate->m_measurement), 36, size, data, "BasicErrorPoseListMeasurement::getCovariance");
+        }
+    }
+    return false;
+}
+
 /*
  * Composite Measurements
  */
@@ -996,7 +1363,7 @@ unsigned int BasicImageMeasurement::getChannels() const {
 }
 
 unsigned int BasicImageMeasurement::getByteCount() const {
-    return size() * getPixelSize();
+    return getDimX() * getDimY() * getPixelSize() / 8;
 }
 
 unsigned int BasicImageMeasurement::getStep() const {
@@ -1017,21 +1384,53 @@ unsigned char* BasicImageMeasurement::getDataPtr() const {
     return NULL;
 }
 
-bool BasicImageMeasurement::get(unsigned int size, unsigned char* data) {
+void BasicImageMeasurement::setTime(unsigned long long int const ts) {
+    m_timestamp = ts;
     if (m_pPrivate) {
         if (m_pPrivate->m_measurement) {
-            Measurement::ImageMeasurement& m = m_pPrivate->m_measurement;
-            unsigned int frame_bytes = getByteCount();
+            m_pPrivate->m_measurement.time(ts);
+        }
+    }
+}
 
-            if (size < frame_bytes) {
-                frame_bytes = size;
+bool BasicImageMeasurement::get(unsigned int size, unsigned char* data) {
+    if (m_pPrivate) {
+        if (m_pPrivate->m_measurement) {
+            if (size < getByteCount()) {
+                LOG4CPP_ERROR( logger, "BasicImageMeasurement::get: buffer of " << size << " bytes is too small for " << getByteCount() << " bytes" );
+                return false;
             }
+            return copyTo(data, getDimX() * getPixelSize() / 8, getPixelFormat());
+        }
+    }
+    return false;
+}
 
-            unsigned char* srcData = (unsigned char*) m->Mat().data;
-            unsigned char* dstData = (unsigned char*) data;
-            memcpy(dstData, srcData, sizeof(unsigned char)*frame_bytes);
+bool BasicImageMeasurement::copyTo(unsigned char* dst, unsigned int dstStride, PixelFormat dstFormat, bool flipVertical) const {
+    if (m_pPrivate) {
+        if (m_pPrivate->m_measurement) {
+            const cv::Mat& src = m_pPrivate->m_measurement->Mat();
+            Vision::Image::PixelFormat srcFormat = m_pPrivate->m_measurement->pixelFormat();
+            int type = src.type();
+            if (dstFormat != (PixelFormat)srcFormat) {
+                int channels, depth;
+                if (!pixelFormatLayout((Vision::Image::PixelFormat)dstFormat, channels, depth)) {
+                    LOG4CPP_ERROR( logger, "BasicImageMeasurement::copyTo: unsupported destination pixel format " << dstFormat );
+                    return false;
+                }
+                type = CV_MAKETYPE(depth, channels);
+            }
 
-            return true;
+            try {
+                cv::Mat dstMat(src.rows, src.cols, type, dst, dstStride);
+                convertImage(src, srcFormat, dstMat, (Vision::Image::PixelFormat)dstFormat, flipVertical);
+                return true;
+            } catch (const std::exception& e) {
+                // Util::Exception, but also cv::Exception from the conversion
+                LOG4CPP_ERROR( logger, "BasicImageMeasurement::copyTo: " << e.what() );
+            } catch (...) {
+                LOG4CPP_ERROR( logger, "BasicImageMeasurement::copyTo: unknown exception" );
+            }
         }
     }
     return false;
@@ -33,6 +33,7 @@
 #include <utFacade/utFacade.h>
 #include <utFacade/Config.h>
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace Ubitrack {
@@ -193,6 +194,9 @@ public:
     bool get(std::vector<double>& v);
     bool get(std::vector<float>& v);
 
+    /* copy values into a buffer of size doubles, same order as get(). size must be at least size() */
+    bool get(unsigned int size, double* data);
+
 //        private:
     BasicVectorMeasurementPrivate<LEN>* m_pPrivate;
 };
@@ -217,6 +221,9 @@ public:
     bool get(std::vector<double>& v);
     bool get(std::vector<float>& v);
 
+    /* copy values into a buffer of size doubles, row-major. size must be at least size() */
+    bool get(unsigned int size, double* data);
+
 //        private:
     BasicMatrixMeasurementPrivate<ROWS, COLS>* m_pPrivate;
 };
@@ -240,6 +247,9 @@ public:
     bool get(std::vector<double>& v);
     bool get(std::vector<float>& v);
 
+    /* copy values into a buffer of size doubles, [x, y, z, rx, ry, rz, rw]. size must be at least size() */
+    bool get(unsigned int size, double* data);
+
 //        private:
     BasicPoseMeasurementPrivate* m_pPrivate;
 };
@@ -263,6 +273,9 @@ public:
     bool get(std::vector<double>& v);
     bool get(std::vector<float>& v);
 
+    /* copy values into a buffer of size doubles, [rx, ry, rz, rw]. size must be at least size() */
+    bool get(unsigned int size, double* data);
+
 //        private:
     BasicRotationMeasurementPrivate* m_pPrivate;
 };
@@ -290,6 +303,12 @@ public:
     /* get NxN covariance-matrix as vector N*N row-major */
     bool getCovariance(std::vector<double>& v);
 
+    /* copy values into a buffer of size doubles, same order as get(). size must be at least size() */
+    bool get(unsigned int size, double* data);
+
+    /* copy the covariance, row-major, into a buffer of size doubles. size must be at least getDimX()*getDimX() */
+    bool getCovariance(unsigned int size, double* data);
+
 //        private:
     BasicErrorVectorMeasurementPrivate<LEN>* m_pPrivate;
 };
@@ -317,6 +336,12 @@ public:
     /* get 7x7 covariance-matrix as vector N*N row-major */
     bool getCovariance(std::vector<double>& v);
 
+    /* copy values into a buffer of size doubles, [x, y, z, rx, ry, rz, rw]. size must be at least size() */
+    bool get(unsigned int size, double* data);
+
+    /* copy the 6x6 covariance, row-major, into a buffer of size doubles. size must be at least 36 */
+    bool getCovariance(unsigned int size, double* data);
+
     //        private:
     BasicErrorPoseMeasurementPrivate* m_pPrivate;
 };
@@ -344,6 +369,12 @@ public:
     /* get int v */
     bool get(std::vector< int >& v);
 
+    /* number of elements in the list */
+    virtual unsigned int elementCount();
+
+    /* copy all elements into a buffer of size ints. size must be at least elementCount() */
+    bool get(unsigned int size, int* data);
+
 //        private:
     BasicScalarIntListMeasurementPrivate* m_pPrivate;
 };
@@ -365,6 +396,12 @@ public:
     bool get(std::vector<double>& v);
     bool get(std::vector<float>& v);
 
+    /* number of elements in the list */
+    virtual unsigned int elementCount();
+
+    /* copy all elements into a buffer of size doubles, one after the other. size must be at least elementCount()*size() */
+    bool get(unsigned int size, double* data);
+
 //        private:
     BasicScalarDoubleListMeasurementPrivate* m_pPrivate;
 };
@@ -388,6 +425,12 @@ public:
     bool get(std::vector< std::vector<double> >& v);
     bool get(std::vector< std::vector<float> >& v);
 
+    /* number of elements in the list */
+    virtual unsigned int elementCount();
+
+    /* copy all elements into a buffer of size doubles, one after the other. size must be at least elementCount()*size() */
+    bool get(unsigned int size, double* data);
+
 //        private:
     BasicVectorListMeasurementPrivate<LEN>* m_pPrivate;
 };
@@ -411,6 +454,12 @@ public:
     bool get(std::vector< std::vector<double> >& v);
     bool get(std::vector< std::vector<float> >& v);
 
+    /* number of elements in the list */
+    virtual unsigned int elementCount();
+
+    /* copy all elements into a buffer of size doubles, each as [x, y, z, rx, ry, rz, rw]. size must be at least elementCount()*size() */
+    bool get(unsigned int size, double* data);
+
 //        private:
     BasicPoseListMeasurementPrivate* m_pPrivate;
 };
@@ -438,6 +487,15 @@ public:
     /* get NxN covariance-matrix as vector N*N row-major */
     bool getCovariance(std::vector< std::vector<double> >& v);
 
+    /* number of elements in the list */
+    virtual unsigned int elementCount();
+
+    /* copy all elements into a buffer of size doubles, one after the other. size must be at least elementCount()*size() */
+    bool get(unsigned int size, double* data);
+
+    /* copy the covariances of all elements, row-major, into a buffer of size doubles. size must be at least elementCount()*getDimX()*getDimX() */
+    bool getCovariance(unsigned int size, double* data);
+
 //        private:
     BasicErrorVectorListMeasurementPrivate<LEN>* m_pPrivate;
 };
@@ -465,6 +523,15 @@ public:
     /* get 7x7 covariance-matrix as vector N*N row-major */
     bool getCovariance(std::vector< std::vector<double> >& v);
 
+    /* number of elements in the list */
+    virtual unsigned int elementCount();
+
+    /* copy all elements into a buffer of size doubles, each as [x, y, z, rx, ry, rz, rw]. size must be at least elementCount()*size() */
+    bool get(unsigned int size, double* data);
+
+    /* copy the 6x6 covariances of all elements, row-major, into a buffer of size doubles. size must be at least elementCount()*36 */
+    bool getCovariance(unsigned int size, double* data);
+
     //        private:
     BasicErrorPoseListMeasurementPrivate* m_pPrivate;
 };
@@ -540,14 +607,49 @@ public:
 
     unsigned char* getDataPtr() const;
 
-    /* get copy into buffer */
+    /* set the timestamp, e.g. after filling an image from BasicFacade::acquireImageBuffer */
+    void setTime( unsigned long long int const ts );
+
+    /* get copy into buffer, rows packed without padding. size must be at least getByteCount() */
     bool get( unsigned int size, unsigned char* data );
 
+    /*
+     * copy into a buffer of getDimY() rows of dstStride bytes, converting to dstFormat.
+     * Supports LUMINANCE, RGB, BGR, RGBA and BGRA from these formats and from YUV422; any format
+     * can be copied unconverted. Returns false if the conversion is not supported.
+     */
+    bool copyTo( unsigned char* dst, unsigned int dstStride, PixelFormat dstFormat, bool flipVertical = false ) const;
+
     BasicImageMeasurementPrivate* m_pPrivate;
 private:
 };
 #endif
 
+/**
+* All components removed from and added to the data flow network by one load or reconfiguration
+*/
+class UTFACADE_EXPORT BasicDataflowDelta
+{
+public:
+    unsigned int getRemovedCount() const { return static_cast< unsigned int >( m_removed.size() ); }
+    const char* getRemovedPatternName( unsigned int i ) const { return m_removed.at( i ).first.c_str(); }
+    const char* getRemovedComponentName( unsigned int i ) const { return m_removed.at( i ).second.c_str(); }
+
+    unsigned int getAddedCount() const { return static_cast< unsigned int >( m_added.size() ); }
+    const char* getAddedPatternName( unsigned int i ) const { return m_added.at( i ).first.c_str(); }
+    const char* getAddedComponentName( unsigned int i ) const { return m_added.at( i ).second.c_str(); }
+
+    void addRemoved( const char* sPatternName, const char* sComponentName )
+    { m_removed.push_back( std::make_pair( std::string( sPatternName ), std::string( sComponentName ) ) ); }
+
+    void addAdded( const char* sPatternName, const char* sComponentName )
+    { m_added.push_back( std::make_pair( std::string( sPatternName ), std::string( sComponentName ) ) ); }
+
+protected:
+    std::vector< std::pair< std::string, std::string > > m_removed;
+    std::vector< std::pair< std::string, std::string > > m_added;
+};
+
 /**
 * A Basic data flow observer
 */
@@ -560,6 +662,19 @@ public:
     /** called when a component is removed */
     virtual void notifyDeleteComponent( const char* sPatternName, const char* sComponentName ) throw() = 0;
 
+    /**
+    * called once per change of the data flow network. Override this to receive all changes in a
+    * single call, e.g. to avoid one host-language transition per component. The default
+    * implementation calls notifyDeleteComponent and notifyAddComponent for each entry.
+    */
+    virtual void notifyDataflowChanged( const BasicDataflowDelta& delta ) throw()
+    {
+        for ( unsigned int i = 0; i < delta.getRemovedCount(); i++ )
+            notifyDeleteComponent( delta.getRemovedPatternName( i ), delta.getRemovedComponentName( i ) );
+        for ( unsigned int i = 0; i < delta.getAddedCount(); i++ )
+            notifyAddComponent( delta.getAddedPatternName( i ), delta.getAddedComponentName( i ) );
+    }
+
     /** virtual destructor */
     virtual ~BasicDataflowObserver()
     {}
@@ -0,0 +1,191 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @ingroup api
+ * @file
+ * Implements the background image encoder of the \c BasicFacade.
+ */
+
+#include <utFacade/Config.h>
+#ifdef ENABLE_BASICFACADE
+#ifdef HAVE_OPENCV
+
+#include <boost/bind.hpp>
+#include <utUtil/Exception.h>
+#include <log4cpp/Category.hh>
+
+#include "BasicImageEncoder.h"
+#include "BasicFacadeTypesPrivate.h"
+#include "ImageEncoder.h"
+
+// get a logger
+static log4cpp::Category& logger( log4cpp::Category::getInstance( "Ubitrack.Facade.BasicImageEncoder" ) );
+
+namespace Ubitrack {
+namespace Facade {
+
+namespace {
+
+/** passes an encoded image to the application */
+void sendEncodedImage( const EncodedImage& image, BasicEncodedImageReceiver* pReceiver )
+{
+    pReceiver->receiveEncodedImage( image.timestamp, image.sequence, &image.data[ 0 ],
+        static_cast< unsigned int >( image.data.size() ) );
+}
+
+} // anonymous namespace
+
+
+/** private things */
+class BasicImageEncoderPrivate
+{
+public:
+    BasicImageEncoderPrivate( BasicImageEncoder::Codec codec, int level, unsigned int nWorkers, unsigned int nMaxPending,
+        const ImageEncoder::ReceiverType& receiver )
+        : m_encoder( codec == BasicImageEncoder::JPEG ? ImageEncoder::JPEG : ImageEncoder::PNG, level, nWorkers, nMaxPending, receiver )
+    {}
+
+    ImageEncoder m_encoder;
+};
+
+
+BasicImageEncoder::BasicImageEncoder( Codec codec, int level, unsigned int nWorkers, unsigned int nMaxPending,
+    BasicEncodedImageReceiver* pReceiver ) throw()
+    : m_pPrivate( 0 )
+{
+    try
+    {
+        if ( !pReceiver )
+            UBITRACK_THROW( "BasicImageEncoder needs a receiver" );
+        m_pPrivate = new BasicImageEncoderPrivate( codec, level, nWorkers, nMaxPending,
+            boost::bind( &sendEncodedImage, _1, pReceiver ) );
+    }
+    catch ( const Ubitrack::Util::Exception& e )
+    {
+        LOG4CPP_ERROR( logger, "Caught exception constructing BasicImageEncoder: " << e );
+        m_sError = e.what();
+    }
+}
+
+
+BasicImageEncoder::BasicImageEncoder( Codec codec, int level, unsigned int nWorkers, unsigned int nMaxPending,
+    const char* sFilePrefix ) throw()
+    : m_pPrivate( 0 )
+{
+    try
+    {
+        m_pPrivate = new BasicImageEncoderPrivate( codec, level, nWorkers, nMaxPending,
+            EncodedImageFileWriter( sFilePrefix ? sFilePrefix : "", codec == JPEG ? ImageEncoder::JPEG : ImageEncoder::PNG ) );
+    }
+    catch ( const Ubitrack::Util::Exception& e )
+    {
+        LOG4CPP_ERROR( logger, "Caught exception constructing BasicImageEncoder: " << e );
+        m_sError = e.what();
+    }
+}
+
+
+BasicImageEncoder::~BasicImageEncoder()
+{
+    delete m_pPrivate;
+}
+
+
+bool BasicImageEncoder::isInitialized() const
+{
+    return m_pPrivate != 0;
+}
+
+
+bool BasicImageEncoder::encode( const std::shared_ptr< BasicImageMeasurement >& image ) throw()
+{
+    if ( !m_pPrivate || !image || !image->m_pPrivate )
+        return false;
+
+    try
+    {
+        return m_pPrivate->m_encoder.encode( image->m_pPrivate->m_measurement );
+    }
+    catch ( const Ubitrack::Util::Exception& e )
+    {
+        LOG4CPP_ERROR( logger, "Caught exception in BasicImageEncoder::encode: " << e );
+        m_sError = e.what();
+    }
+    return false;
+}
+
+
+bool BasicImageEncoder::flush( unsigned int timeout ) throw()
+{
+    if ( !m_pPrivate )
+        return true;
+
+    return m_pPrivate->m_encoder.flush( timeout );
+}
+
+
+unsigned long long int BasicImageEncoder::getEncodedCount() const
+{
+    return m_pPrivate ? m_pPrivate->m_encoder.counters().nEncoded : 0;
+}
+
+
+unsigned long long int BasicImageEncoder::getDroppedCount() const
+{
+    return m_pPrivate ? m_pPrivate->m_encoder.counters().nDropped : 0;
+}
+
+
+unsigned long long int BasicImageEncoder::getFailedCount() const
+{
+    return m_pPrivate ? m_pPrivate->m_encoder.counters().nFailed : 0;
+}
+
+
+unsigned long long int BasicImageEncoder::getPendingCount() const
+{
+    return m_pPrivate ? m_pPrivate->m_encoder.counters().nPending : 0;
+}
+
+
+double BasicImageEncoder::getCompressionRatio() const
+{
+    if ( !m_pPrivate )
+        return 0.0;
+
+    ImageEncoder::Counters counters( m_pPrivate->m_encoder.counters() );
+    return counters.nBytesIn ? double( counters.nBytesOut ) / counters.nBytesIn : 0.0;
+}
+
+
+const char* BasicImageEncoder::getLastError() const
+{
+    return m_sError.c_str();
+}
+
+}
+} // namespace Ubitrack::Facade
+
+#endif // HAVE_OPENCV
+#endif // ENABLE_BASICFACADE
@@ -0,0 +1,154 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @ingroup api
+ * @file
+ * Background compression of images for recording and streaming.
+ */
+#ifndef __UBITRACK_FACADE_BASICIMAGEENCODER_H_INCLUDED__
+#define __UBITRACK_FACADE_BASICIMAGEENCODER_H_INCLUDED__
+
+#include <memory>
+#include <string>
+
+#include <utFacade/utFacade.h>
+#include <utFacade/Config.h>
+#include <utFacade/BasicFacadeTypes.h>
+
+#ifdef HAVE_OPENCV
+
+namespace Ubitrack {
+namespace Facade {
+
+// forward declarations
+class BasicImageEncoderPrivate;
+
+/**
+* Receives the images compressed by a BasicImageEncoder
+*/
+class UTFACADE_EXPORT BasicEncodedImageReceiver
+{
+public:
+    /**
+    * called on a worker thread of the encoder, in the order the images were accepted.
+    * The data is only valid during the call.
+    *
+    * @param ts timestamp of the image
+    * @param sequence number of the image among those accepted by the encoder
+    * @param data the encoded file contents
+    * @param size number of bytes in \c data
+    */
+    virtual void receiveEncodedImage( unsigned long long int ts, unsigned long long int sequence,
+        const unsigned char* data, unsigned int size ) throw() = 0;
+
+    virtual ~BasicEncodedImageReceiver()
+    {}
+};
+
+
+/**
+* Compresses images to PNG or JPEG on a pool of worker threads.
+*
+* encode() never blocks, so it can be called from the callback of an image push sink. Images
+* arriving while too many are pending are dropped.
+*/
+class UTFACADE_EXPORT BasicImageEncoder
+{
+public:
+    enum Codec { PNG, JPEG };
+
+    /**
+    * creates an encoder that passes the encoded images to a receiver.
+    *
+    * @param codec output format
+    * @param level JPEG quality from 0 to 100, or PNG compression level from 0 to 9 (1 is fast)
+    * @param nWorkers number of worker threads, 0 for one per hardware thread
+    * @param nMaxPending maximum number of images waiting or being encoded
+    * @param pReceiver receives the images, must outlive the encoder
+    */
+    BasicImageEncoder( Codec codec, int level, unsigned int nWorkers, unsigned int nMaxPending,
+        BasicEncodedImageReceiver* pReceiver ) throw();
+
+    /**
+    * creates an encoder that writes each image to a file named sFilePrefix, the timestamp and
+    * the extension of the codec. The prefix may contain a directory.
+    */
+    BasicImageEncoder( Codec codec, int level, unsigned int nWorkers, unsigned int nMaxPending,
+        const char* sFilePrefix ) throw();
+
+    /** encodes and delivers the images already accepted */
+    ~BasicImageEncoder();
+
+    /** false if the construction failed, see getLastError() */
+    bool isInitialized() const;
+
+    /**
+    * queues an image for encoding. The image is shared, not copied, and must not be modified
+    * while it is pending.
+    *
+    * @return false if the image was dropped
+    */
+    bool encode( const std::shared_ptr< BasicImageMeasurement >& image ) throw();
+
+    /**
+    * waits until all accepted images have been delivered.
+    *
+    * @param timeout maximum time to wait in milliseconds, 0 for no limit
+    * @return false on timeout
+    */
+    bool flush( unsigned int timeout = 0 ) throw();
+
+    /** number of images delivered */
+    unsigned long long int getEncodedCount() const;
+
+    /** number of images dropped because too many were pending */
+    unsigned long long int getDroppedCount() const;
+
+    /** number of images that could not be encoded */
+    unsigned long long int getFailedCount() const;
+
+    /** number of images accepted but not yet delivered */
+    unsigned long long int getPendingCount() const;
+
+    /** compressed size divided by uncompressed size of the delivered images */
+    double getCompressionRatio() const;
+
+    /** returns the reason of the last failure */
+    const char* getLastError() const;
+
+private:
+    // not copyable
+    BasicImageEncoder( const BasicImageEncoder& );
+    BasicImageEncoder& operator=( const BasicImageEncoder& );
+
+    BasicImageEncoderPrivate* m_pPrivate;
+    std::string m_sError;
+};
+
+}
+} // namespace Ubitrack::Facade
+
+#endif // HAVE_OPENCV
+
+#endif
@@ -0,0 +1,196 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+
+/**
+ * @ingroup api
+ * @file
+ * Implements the bulk copies of measurements.
+ */
+
+#include <algorithm>
+
+#include "BulkCopy.h"
+#include "TexturePacking.h"
+#ifdef ENABLE_BASICFACADE
+#include "BasicFacadeTypesPrivate.h"
+#endif
+
+namespace Ubitrack { namespace Facade {
+
+namespace {
+
+void copyValue( const SimplePosition2DValue& v, double* dst )
+{
+	dst[ 0 ] = v.x;
+	dst[ 1 ] = v.y;
+}
+
+void copyValue( const SimplePosition3DValue& v, double* dst )
+{
+	dst[ 0 ] = v.x;
+	dst[ 1 ] = v.y;
+	dst[ 2 ] = v.z;
+}
+
+void copyValue( const SimpleErrorPosition3DValue& v, double* dst )
+{
+	dst[ 0 ] = v.x;
+	dst[ 1 ] = v.y;
+	dst[ 2 ] = v.z;
+	std::copy( v.covariance, v.covariance + 9, dst + 3 );
+}
+
+#ifdef ENABLE_BASICFACADE
+template< int LEN >
+void copyValue( const Math::Vector< double, LEN >& v, double* dst )
+{
+	for ( int i = 0; i < LEN; i++ )
+		dst[ i ] = v( i );
+}
+
+void copyValue( const Math::Pose& p, double* dst )
+{
+	copyValue( p.translation(), dst );
+	const Math::Quaternion& q( p.rotation() );
+	dst[ 3 ] = q.x();
+	dst[ 4 ] = q.y();
+	dst[ 5 ] = q.z();
+	dst[ 6 ] = q.w();
+}
+#endif
+
+/** copies as many elements as fit, each taking elementSize doubles */
+template< class T >
+std::size_t copyList( const std::vector< T >& list, std::size_t elementSize, double* dst, std::size_t capacity )
+{
+	std::size_t n = std::min( list.size(), capacity );
+	for ( std::size_t i = 0; i < n; i++ )
+		copyValue( list[ i ], dst + i * elementSize );
+	return n;
+}
+
+} // anonymous namespace
+
+
+std::size_t copyPositionList( const SimplePosition2DList& list, double* dst, std::size_t capacity )
+{
+	return copyList( list.values, 2, dst, capacity );
+}
+
+
+std::size_t copyPositionList( const SimplePositionList3D& list, double* dst, std::size_t capacity )
+{
+	return copyList( list.values, 3, dst, capacity );
+}
+
+
+std::size_t copyPositionList( const SimpleErrorPositionList3D& list, double* dst, std::size_t capacity )
+{
+	return copyList( list.values, 12, dst, capacity );
+}
+
+
+void copyPose( const SimplePose& pose, double* dst )
+{
+	dst[ 0 ] = pose.tx;
+	dst[ 1 ] = pose.ty;
+	dst[ 2 ] = pose.tz;
+	dst[ 3 ] = pose.rx;
+	dst[ 4 ] = pose.ry;
+	dst[ 5 ] = pose.rz;
+	dst[ 6 ] = pose.rw;
+}
+
+
+void copyMatrix( const SimpleMatrix3x3& m, double* dst )
+{
+	std::copy( m.values, m.values + 9, dst );
+}
+
+
+void copyMatrix( const SimpleMatrix3x4& m, double* dst )
+{
+	const double values[ 12 ] = { m.e11, m.e12, m.e13, m.e14, m.e21, m.e22, m.e23, m.e24, m.e31, m.e32, m.e33, m.e34 };
+	std::copy( values, values + 12, dst );
+}
+
+
+void copyMatrix( const SimpleMatrix4x4& m, double* dst )
+{
+	std::copy( m.values, m.values + 16, dst );
+}
+
+
+bool copyImageARGB32( const SimpleImage& image, void* dst, std::size_t dstStride, unsigned char alpha, bool bFlipVertical )
+{
+	if ( !image.imageData || !dst )
+		return false;
+
+	// the bits of an IPL depth, without the sign flag
+	int bitsPerChannel = image.depth & 0xffff;
+	int format = image.nChannels == 1 ? TEXTURE_LUMINANCE : ( image.nChannels == 4 ? TEXTURE_RGBA : TEXTURE_RGB );
+	return packARGB32( image.imageData, image.widthStep, image.width, image.height, format,
+		bitsPerChannel, dst, dstStride, alpha, bFlipVertical );
+}
+
+
+#ifdef ENABLE_BASICFACADE
+std::size_t copyPositionList( const BasicVectorListMeasurement< 2 >& list, double* dst, std::size_t capacity )
+{
+	if ( !list.m_pPrivate || !list.m_pPrivate->m_measurement )
+		return 0;
+	return copyList( *list.m_pPrivate->m_measurement, 2, dst, capacity );
+}
+
+
+std::size_t copyPositionList( const BasicVectorListMeasurement< 3 >& list, double* dst, std::size_t capacity )
+{
+	if ( !list.m_pPrivate || !list.m_pPrivate->m_measurement )
+		return 0;
+	return copyList( *list.m_pPrivate->m_measurement, 3, dst, capacity );
+}
+
+
+std::size_t copyPoseList( const BasicPoseListMeasurement& list, double* dst, std::size_t capacity )
+{
+	if ( !list.m_pPrivate || !list.m_pPrivate->m_measurement )
+		return 0;
+	return copyList( *list.m_pPrivate->m_measurement, 7, dst, capacity );
+}
+
+
+#ifdef HAVE_OPENCV
+bool copyImageARGB32( const BasicImageMeasurement& image, void* dst, std::size_t dstStride, unsigned char alpha, bool bFlipVertical )
+{
+	if ( !image.getDataPtr() || !dst || !image.getChannels() )
+		return false;
+
+	int bitsPerChannel = image.getPixelSize() / image.getChannels();
+	return packARGB32( image.getDataPtr(), image.getStep(), image.getDimX(), image.getDimY(), image.getPixelFormat(),
+		bitsPerChannel, dst, dstStride, alpha, bFlipVertical );
+}
+#endif
+#endif
+
+} } // namespace Ubitrack::Facade
@@ -0,0 +1,87 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+
+/**
+ * @ingroup api
+ * @file
+ * Bulk copies of measurements into memory of the caller, for language bindings that pass
+ * pinned arrays (e.g. C# with fixed or GCHandle) instead of marshaling element by element.
+ */
+#ifndef __UBITRACK_FACADE_BULKCOPY_H_INCLUDED__
+#define __UBITRACK_FACADE_BULKCOPY_H_INCLUDED__
+
+#include <cstddef>
+#include <utFacade/utFacade.h>
+#include <utFacade/Config.h>
+#include <utFacade/SimpleDatatypes.h>
+#ifdef ENABLE_BASICFACADE
+#include <utFacade/BasicFacadeTypes.h>
+#endif
+
+namespace Ubitrack { namespace Facade {
+
+/*
+ * The list copies write the elements one after the other and copy as many elements as fit
+ * into dst, which holds capacity elements (not doubles). They return the number of elements
+ * copied. Element layouts: 2D position [x, y], 3D position [x, y, z], 3D position with error
+ * [x, y, z, 3x3 covariance row-major], pose [x, y, z, rx, ry, rz, rw].
+ */
+
+UTFACADE_EXPORT std::size_t copyPositionList( const SimplePosition2DList& list, double* dst, std::size_t capacity );
+UTFACADE_EXPORT std::size_t copyPositionList( const SimplePositionList3D& list, double* dst, std::size_t capacity );
+UTFACADE_EXPORT std::size_t copyPositionList( const SimpleErrorPositionList3D& list, double* dst, std::size_t capacity );
+
+/** copies a pose as [x, y, z, rx, ry, rz, rw] */
+UTFACADE_EXPORT void copyPose( const SimplePose& pose, double* dst );
+
+/** the matrix copies write the elements row-major */
+UTFACADE_EXPORT void copyMatrix( const SimpleMatrix3x3& m, double* dst );
+UTFACADE_EXPORT void copyMatrix( const SimpleMatrix3x4& m, double* dst );
+UTFACADE_EXPORT void copyMatrix( const SimpleMatrix4x4& m, double* dst );
+
+/**
+ * Packs an image into an ARGB32 texture with \c packARGB32. SimpleImage has no pixel format,
+ * so one channel is taken as luminance, four channels as RGBA and three as RGB. Only images
+ * with 8 bits per channel are supported.
+ *
+ * @param dst first texel of the texture, at least \c image.height rows of \c dstStride bytes
+ * @param dstStride bytes between the starts of two texture rows, at least 4 * image.width
+ * @return false if there is no image, the format or the depth is not supported or dstStride is too small
+ */
+UTFACADE_EXPORT bool copyImageARGB32( const SimpleImage& image, void* dst, std::size_t dstStride, unsigned char alpha, bool bFlipVertical );
+
+#ifdef ENABLE_BASICFACADE
+UTFACADE_EXPORT std::size_t copyPositionList( const BasicVectorListMeasurement< 2 >& list, double* dst, std::size_t capacity );
+UTFACADE_EXPORT std::size_t copyPositionList( const BasicVectorListMeasurement< 3 >& list, double* dst, std::size_t capacity );
+UTFACADE_EXPORT std::size_t copyPoseList( const BasicPoseListMeasurement& list, double* dst, std::size_t capacity );
+
+#ifdef HAVE_OPENCV
+/** packs an image into an ARGB32 texture with \c packARGB32, see the \c SimpleImage overload */
+UTFACADE_EXPORT bool copyImageARGB32( const BasicImageMeasurement& image, void* dst, std::size_t dstStride, unsigned char alpha, bool bFlipVertical );
+#endif
+#endif
+
+} } // namespace Ubitrack::Facade
+
+#endif
@@ -32,10 +32,45 @@
 #define __UBITRACK_FACADE_DATAFLOWOBSERVER_H_INCLUDED__
 
 #include <string>
+#include <vector>
+#include <boost/shared_ptr.hpp>
 #include <utGraph/UTQLSubgraph.h>
 
 namespace Ubitrack { namespace Facade {
 
+/**
+ * Describes all changes to the data flow network caused by a single load or reconfiguration.
+ */
+struct DataflowDelta
+{
+	/** one added or removed component */
+	struct Entry
+	{
+		Entry( const std::string& sPattern, const std::string& sComponent, boost::shared_ptr< Graph::UTQLSubgraph > p = boost::shared_ptr< Graph::UTQLSubgraph >() )
+			: sPatternName( sPattern )
+			, sComponentName( sComponent )
+			, pPattern( p )
+		{}
+
+		std::string sPatternName;
+		std::string sComponentName;
+
+		/** the full UTQL subgraph, only set for added components */
+		boost::shared_ptr< Graph::UTQLSubgraph > pPattern;
+	};
+
+	typedef std::vector< Entry > EntryList;
+
+	/** components removed from the network */
+	EntryList removed;
+
+	/** components added to the network */
+	EntryList added;
+
+	bool empty() const
+	{ return removed.empty() && added.empty(); }
+};
+
 /**
  * Implement this interface if you want to be notified of changes in the data flow network
  */
@@ -60,6 +95,24 @@ public:
 	 */
 	virtual void notifyDeleteComponent( const std::string& sPatternName, const std::string& sComponentName ) = 0;
 
+	/**
+	 * The facade calls this method once per change of the data flow network with all removed and
+	 * added components. The default implementation forwards each entry to \c notifyDeleteComponent
+	 * and \c notifyAddComponent, removals first.
+	 *
+	 * If asynchronous notification is enabled on the facade, this is called from the facade's
+	 * notification thread after the load has completed.
+	 *
+	 * @param delta the removed and added components
+	 */
+	virtual void notifyDataflowChanged( const DataflowDelta& delta )
+	{
+		for ( DataflowDelta::EntryList::const_iterator it = delta.removed.begin(); it != delta.removed.end(); it++ )
+			notifyDeleteComponent( it->sPatternName, it->sComponentName );
+		for ( DataflowDelta::EntryList::const_iterator it = delta.added.begin(); it != delta.added.end(); it++ )
+			notifyAddComponent( it->sPatternName, it->sComponentName, *it->pPattern );
+	}
+
 	/** virtual destructor */
 	virtual ~DataflowObserver()
 	{}	
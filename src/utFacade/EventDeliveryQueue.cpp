@@ -0,0 +1,295 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @ingroup api
+ * @file
+ * Implements the application event delivery queue.
+ */
+
+#include <log4cpp/Category.hh>
+#include <utUtil/Exception.h>
+
+#include "EventDeliveryQueue.h"
+
+// get a logger
+static log4cpp::Category& logger( log4cpp::Category::getInstance( "Ubitrack.Facade.EventDeliveryQueue" ) );
+
+namespace Ubitrack { namespace Facade {
+
+EventDeliveryQueue::EventDeliveryQueue( FacadeOptions::DropPolicy policy, unsigned int nCapacity, const ThreadScheduling& scheduling )
+	: m_policy( policy )
+	, m_nCapacity( nCapacity > 0 ? nCapacity : 1 )
+	, m_scheduling( scheduling )
+	, m_nDropped( 0 )
+	, m_bStop( false )
+{
+	if ( policy == FacadeOptions::DELIVER_SYNCHRONOUS )
+		UBITRACK_THROW( "EventDeliveryQueue cannot be used for synchronous delivery" );
+
+	m_pThread.reset( new boost::thread( boost::bind( &EventDeliveryQueue::deliveryThread, this ) ) );
+}
+
+
+EventDeliveryQueue::~EventDeliveryQueue()
+{
+	{
+		boost::mutex::scoped_lock l( m_mutex );
+		m_bStop = true;
+		m_notEmpty.notify_all();
+		m_notFull.notify_all();
+	}
+
+	m_pThread->join();
+
+	if ( m_nDropped )
+		LOG4CPP_INFO( logger, "Application event queue dropped " << m_nDropped << " events" );
+}
+
+
+void EventDeliveryQueue::enqueue( const void* key, const DeliveryType& delivery )
+{
+	boost::mutex::scoped_lock l( m_mutex );
+	if ( m_bStop )
+		return;
+
+	KeyCounters& counters( m_counters[ key ] );
+	counters.nEnqueued++;
+
+	switch ( m_policy )
+	{
+	case FacadeOptions::COALESCE_LATEST:
+		{
+			std::map< const void*, DeliveryType >::iterator it = m_latest.find( key );
+			if ( it != m_latest.end() )
+			{
+				// replace the stale event, keeping its position in the queue
+				it->second = delivery;
+				m_nDropped++;
+				counters.nDropped++;
+				return;
+			}
+
+			m_latest.insert( std::make_pair( key, delivery ) );
+			m_queue.push_back( Item( key, DeliveryType() ) );
+		}
+		break;
+
+	case FacadeOptions::DROP_NEWEST:
+		if ( m_queue.size() >= m_nCapacity )
+		{
+			m_nDropped++;
+			counters.nDropped++;
+			return;
+		}
+		m_queue.push_back( Item( key, delivery ) );
+		break;
+
+	case FacadeOptions::DROP_OLDEST:
+		while ( m_queue.size() >= m_nCapacity )
+		{
+			KeyCounters& oldest( m_counters[ m_queue.front().key ] );
+			oldest.nDropped++;
+			oldest.nQueued--;
+			m_queue.pop_front();
+			m_nDropped++;
+		}
+		m_queue.push_back( Item( key, delivery ) );
+		break;
+
+	default:
+		// DROP_NONE: block the producer, unless it is a callback running on the delivery thread itself
+		if ( boost::this_thread::get_id() != m_pThread->get_id() )
+			while ( m_queue.size() >= m_nCapacity && !m_bStop )
+				m_notFull.wait( l );
+		if ( m_bStop )
+			return;
+		m_queue.push_back( Item( key, delivery ) );
+		break;
+	}
+
+	counters.nQueued++;
+	m_notEmpty.notify_one();
+}
+
+
+void EventDeliveryQueue::purge( const void* key )
+{
+	{
+		boost::mutex::scoped_lock l( m_mutex );
+
+		std::deque< Item >::iterator it = m_queue.begin();
+		while ( it != m_queue.end() )
+			if ( it->key == key )
+				it = m_queue.erase( it );
+			else
+				it++;
+
+		m_latest.erase( key );
+
+		// keys are addresses of sinks, which may be reused after the sink is gone
+		m_counters.erase( key );
+		m_notFull.notify_all();
+	}
+
+	// wait for a delivery in progress
+	boost::recursive_mutex::scoped_lock dispatchLock( m_dispatchMutex );
+}
+
+
+void EventDeliveryQueue::clear()
+{
+	{
+		boost::mutex::scoped_lock l( m_mutex );
+		m_queue.clear();
+		m_latest.clear();
+		for ( std::map< const void*, KeyCounters >::iterator it = m_counters.begin(); it != m_counters.end(); it++ )
+			it->second.nQueued = 0;
+		m_notFull.notify_all();
+	}
+
+	// wait for a delivery in progress
+	boost::recursive_mutex::scoped_lock dispatchLock( m_dispatchMutex );
+}
+
+
+bool EventDeliveryQueue::waitEmpty( const boost::posix_time::ptime& deadline )
+{
+	if ( boost::this_thread::get_id() == m_pThread->get_id() )
+		return true;
+
+	{
+		boost::mutex::scoped_lock l( m_mutex );
+		while ( !m_queue.empty() && !m_bStop )
+			if ( deadline.is_pos_infinity() )
+				m_notFull.wait( l );
+			else if ( !m_notFull.timed_wait( l, deadline ) && !m_queue.empty() )
+				return false;
+	}
+
+	// wait for the last delivery in progress
+	boost::recursive_mutex::scoped_lock dispatchLock( m_dispatchMutex );
+	return true;
+}
+
+
+unsigned long long EventDeliveryQueue::droppedCount() const
+{
+	boost::mutex::scoped_lock l( m_mutex );
+	return m_nDropped;
+}
+
+
+EventDeliveryQueue::KeyCounters EventDeliveryQueue::getCounters( const void* key ) const
+{
+	boost::mutex::scoped_lock l( m_mutex );
+	std::map< const void*, KeyCounters >::const_iterator it = m_counters.find( key );
+	if ( it == m_counters.end() )
+		return KeyCounters();
+	return it->second;
+}
+
+
+EventDeliveryQueue::KeyCounters EventDeliveryQueue::getTotalCounters() const
+{
+	boost::mutex::scoped_lock l( m_mutex );
+	KeyCounters total;
+	for ( std::map< const void*, KeyCounters >::const_iterator it = m_counters.begin(); it != m_counters.end(); it++ )
+	{
+		total.nEnqueued += it->second.nEnqueued;
+		total.nDelivered += it->second.nDelivered;
+		total.nDropped += it->second.nDropped;
+		total.nQueued += it->second.nQueued;
+	}
+	return total;
+}
+
+
+void EventDeliveryQueue::deliveryThread()
+{
+	LOG4CPP_DEBUG( logger, "Application event delivery thread started" );
+
+	if ( !m_scheduling.isDefault() )
+	{
+		try
+		{
+			applyThreadScheduling( m_scheduling );
+		}
+		catch ( const Util::Exception& e )
+		{ LOG4CPP_ERROR( logger, "Cannot apply scheduling to the application event delivery thread: " << e ); }
+	}
+
+	while ( true )
+	{
+		boost::recursive_mutex::scoped_lock dispatchLock( m_dispatchMutex );
+		DeliveryType delivery;
+
+		{
+			boost::mutex::scoped_lock l( m_mutex );
+			while ( m_queue.empty() && !m_bStop )
+			{
+				// do not block purge() while idle
+				dispatchLock.unlock();
+				m_notEmpty.wait( l );
+				l.unlock();
+				dispatchLock.lock();
+				l.lock();
+			}
+
+			if ( m_bStop )
+				break;
+
+			Item item( m_queue.front() );
+			m_queue.pop_front();
+			m_notFull.notify_all();
+
+			KeyCounters& counters( m_counters[ item.key ] );
+			counters.nQueued--;
+			counters.nDelivered++;
+
+			if ( m_policy == FacadeOptions::COALESCE_LATEST )
+			{
+				std::map< const void*, DeliveryType >::iterator it = m_latest.find( item.key );
+				delivery.swap( it->second );
+				m_latest.erase( it );
+			}
+			else
+				delivery.swap( item.delivery );
+		}
+
+		try
+		{
+			delivery();
+		}
+		catch ( const Util::Exception& e )
+		{ LOG4CPP_WARN( logger, "Caught exception in application callback: " << e ); }
+		catch ( const std::exception& e )
+		{ LOG4CPP_WARN( logger, "Caught exception in application callback: " << e.what() ); }
+		catch ( ... )
+		{ LOG4CPP_WARN( logger, "Caught unknown exception in application callback" ); }
+	}
+
+	LOG4CPP_DEBUG( logger, "Application event delivery thread stopped" );
+}
+
+} } // namespace Ubitrack::Facade
@@ -0,0 +1,190 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @ingroup api
+ * @file
+ * A bounded queue decoupling application callbacks from the dataflow thread.
+ */
+#ifndef __UBITRACK_FACADE_EVENTDELIVERYQUEUE_H_INCLUDED__
+#define __UBITRACK_FACADE_EVENTDELIVERYQUEUE_H_INCLUDED__
+
+#include <utFacade/utFacade.h>
+#include <deque>
+#include <map>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread.hpp>
+#include <boost/noncopyable.hpp>
+
+#include "FacadeOptions.h"
+
+namespace Ubitrack { namespace Facade {
+
+/**
+ * Delivers events from application push sinks to the application on a separate thread.
+ *
+ * Each event is tagged with a key identifying the receiving sink. When the application cannot
+ * keep up, the configured \c FacadeOptions::DropPolicy decides which events are discarded, so
+ * that overload does not turn into an ever growing latency in the dataflow.
+ */
+class UTFACADE_EXPORT EventDeliveryQueue
+	: private boost::noncopyable
+{
+public:
+	/** type of a queued delivery */
+	typedef boost::function< void() > DeliveryType;
+
+	/**
+	 * creates the queue and starts the delivery thread
+	 *
+	 * @param policy overload behaviour, must not be DELIVER_SYNCHRONOUS
+	 * @param nCapacity maximum number of queued events (at least 1)
+	 * @param scheduling scheduling parameters of the delivery thread
+	 */
+	EventDeliveryQueue( FacadeOptions::DropPolicy policy, unsigned int nCapacity, 
+		const ThreadScheduling& scheduling = ThreadScheduling() );
+
+	/** stops the delivery thread, discarding undelivered events */
+	~EventDeliveryQueue();
+
+	/**
+	 * Wraps an application callback such that events are passed through the queue.
+	 *
+	 * @param key identifies the receiving sink, used for coalescing and \c purge
+	 * @param callback the application callback
+	 */
+	template< class EventType >
+	boost::function< void( const EventType& ) > wrap( const void* key, boost::function< void( const EventType& ) > callback )
+	{ return boost::bind( &EventDeliveryQueue::enqueueEvent< EventType >, this, key, callback, _1 ); }
+
+	/** queues a delivery for the given key according to the drop policy */
+	void enqueue( const void* key, const DeliveryType& delivery );
+
+	/**
+	 * Removes all undelivered events and the counters of a key and waits until a delivery for that
+	 * key which is currently in progress has finished. Must be called before the receiver of a key
+	 * is destroyed.
+	 */
+	void purge( const void* key );
+
+	/** removes all undelivered events and waits until a delivery in progress has finished */
+	void clear();
+
+	/** number of events discarded because of overload since construction */
+	unsigned long long droppedCount() const;
+
+	/** event counters of one key */
+	struct KeyCounters
+	{
+		KeyCounters()
+			: nEnqueued( 0 )
+			, nDelivered( 0 )
+			, nDropped( 0 )
+			, nQueued( 0 )
+		{}
+
+		/** events passed to \c enqueue */
+		unsigned long long nEnqueued;
+
+		/** events delivered to the callback */
+		unsigned long long nDelivered;
+
+		/** events discarded by the drop policy */
+		unsigned long long nDropped;
+
+		/** events currently waiting for delivery */
+		unsigned long long nQueued;
+	};
+
+	/**
+	 * Blocks until all queued events are delivered and no delivery is in progress.
+	 * Returns immediately when called from a callback.
+	 */
+	void waitEmpty()
+	{ waitEmpty( boost::posix_time::ptime( boost::posix_time::pos_infin ) ); }
+
+	/**
+	 * Like \c waitEmpty, but gives up when the deadline has passed.
+	 * A delivery in progress is always waited for.
+	 *
+	 * @return false if events were still queued at the deadline
+	 */
+	bool waitEmpty( const boost::posix_time::ptime& deadline );
+
+	/** returns the counters of a key (all zero for unknown keys) */
+	KeyCounters getCounters( const void* key ) const;
+
+	/** returns the sum of the counters of all keys */
+	KeyCounters getTotalCounters() const;
+
+protected:
+	template< class EventType >
+	void enqueueEvent( const void* key, const boost::function< void( const EventType& ) >& callback, const EventType& e )
+	{ enqueue( key, boost::bind( callback, e ) ); }
+
+	/** main loop of the delivery thread */
+	void deliveryThread();
+
+	/** a queued event */
+	struct Item
+	{
+		Item( const void* k, const DeliveryType& d )
+			: key( k )
+			, delivery( d )
+		{}
+
+		const void* key;
+		DeliveryType delivery;
+	};
+
+	FacadeOptions::DropPolicy m_policy;
+	std::size_t m_nCapacity;
+	ThreadScheduling m_scheduling;
+
+	/** queued events in arrival order */
+	std::deque< Item > m_queue;
+
+	/** for COALESCE_LATEST: latest undelivered event per key. m_queue then holds only the order of keys */
+	std::map< const void*, DeliveryType > m_latest;
+
+	unsigned long long m_nDropped;
+	bool m_bStop;
+
+	/** counters per key */
+	std::map< const void*, KeyCounters > m_counters;
+
+	mutable boost::mutex m_mutex;
+	boost::condition_variable m_notEmpty;
+	boost::condition_variable m_notFull;
+
+	/** held while an event is delivered. Recursive so that callbacks may unregister themselves */
+	boost::recursive_mutex m_dispatchMutex;
+
+	boost::scoped_ptr< boost::thread > m_pThread;
+};
+
+} } // namespace Ubitrack::Facade
+
+#endif
@@ -0,0 +1,187 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+
+/**
+ * @ingroup api
+ * @file
+ * Implements the event domain probe.
+ */
+
+#include <limits>
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+#include <log4cpp/Category.hh>
+#include <utUtil/Exception.h>
+
+#include "EventDomainProbe.h"
+
+// get a logger
+static log4cpp::Category& logger( log4cpp::Category::getInstance( "Ubitrack.Facade.EventDomainProbe" ) );
+
+namespace Ubitrack { namespace Facade {
+
+/** true if sequence number a is not older than b, robust against wrap-around */
+static bool notBefore( unsigned int a, unsigned int b )
+{ return static_cast< int >( a - b ) >= 0; }
+
+
+/** runs a task, storing the message of an exception */
+static void runTask( const EventDomainProbe::TaskType& task, boost::shared_ptr< std::string > pError )
+{
+	try
+	{
+		task();
+	}
+	catch ( const std::exception& e )
+	{ *pError = e.what(); }
+	catch ( ... )
+	{ *pError = "Unknown exception"; }
+}
+
+
+EventDomainProbe::EventDomainProbe( unsigned int domain )
+	: Dataflow::Component( "EventDomainProbe" + boost::lexical_cast< std::string >( domain ) )
+	, m_outPort( "Output", *this )
+	, m_inPort( "Input", *this, boost::bind( &EventDomainProbe::receiveProbe, this, _1 ) )
+	, m_bCancelled( false )
+{
+	setEventDomain( domain );
+	m_outPort.connect( m_inPort );
+	start();
+}
+
+
+void EventDomainProbe::post( const TaskType& task, bool bAhead )
+{
+	queueTask( task, bAhead );
+}
+
+
+bool EventDomainProbe::call( const TaskType& task, const boost::posix_time::ptime& deadline, bool bAhead )
+{
+	bool bDirect;
+	{
+		boost::mutex::scoped_lock l( m_mutex );
+		bDirect = m_dispatcherId == boost::this_thread::get_id();
+	}
+
+	boost::shared_ptr< std::string > pError( new std::string );
+	if ( bDirect )
+		runTask( task, pError );
+	else if ( !waitCompleted( queueTask( boost::bind( &runTask, task, pError ), bAhead ), bAhead, deadline ) )
+		return false;
+
+	if ( !pError->empty() )
+		UBITRACK_THROW( *pError );
+	return true;
+}
+
+
+bool EventDomainProbe::waitDispatched( const boost::posix_time::ptime& deadline )
+{
+	{
+		boost::mutex::scoped_lock l( m_mutex );
+		if ( m_dispatcherId == boost::this_thread::get_id() )
+			return true;
+	}
+
+	return waitCompleted( queueTask( TaskType(), false ), false, deadline );
+}
+
+
+void EventDomainProbe::cancel()
+{
+	boost::mutex::scoped_lock l( m_mutex );
+	m_bCancelled = true;
+	m_behind.tasks.clear();
+	m_ahead.tasks.clear();
+	m_completed.notify_all();
+}
+
+
+unsigned int EventDomainProbe::queueTask( const TaskType& task, bool bAhead )
+{
+	TaskQueue& queue( bAhead ? m_ahead : m_behind );
+	unsigned int nSequence;
+	{
+		boost::mutex::scoped_lock l( m_mutex );
+		nSequence = ++queue.nQueued;
+		queue.tasks.push_back( std::make_pair( nSequence, task ) );
+	}
+
+	// the largest priority puts the probe behind all events queued so far, the smallest ahead of them
+	Measurement::Timestamp priority( bAhead ? 0 : std::numeric_limits< Measurement::Timestamp >::max() );
+	m_outPort.send( Measurement::Button( priority, Math::Scalar< int >( static_cast< int >( nSequence ) ) ) );
+	return nSequence;
+}
+
+
+bool EventDomainProbe::waitCompleted( unsigned int nSequence, bool bAhead, const boost::posix_time::ptime& deadline )
+{
+	const TaskQueue& queue( bAhead ? m_ahead : m_behind );
+	boost::mutex::scoped_lock l( m_mutex );
+	while ( !notBefore( queue.nCompleted, nSequence ) )
+		if ( m_bCancelled )
+			return false;
+		else if ( deadline.is_pos_infinity() )
+			m_completed.wait( l );
+		else if ( !m_completed.timed_wait( l, deadline ) )
+			return notBefore( queue.nCompleted, nSequence );
+	return true;
+}
+
+
+void EventDomainProbe::receiveProbe( const Measurement::Button& probe )
+{
+	// probe events may be dropped by the event queue, so each one runs all tasks up to its own
+	unsigned int nSequence = static_cast< unsigned int >( static_cast< int >( *probe ) );
+	TaskQueue& queue( probe.time() == 0 ? m_ahead : m_behind );
+
+	boost::mutex::scoped_lock l( m_mutex );
+	m_dispatcherId = boost::this_thread::get_id();
+	while ( !queue.tasks.empty() && notBefore( nSequence, queue.tasks.front().first ) )
+	{
+		std::pair< unsigned int, TaskType > task( queue.tasks.front() );
+		queue.tasks.pop_front();
+
+		l.unlock();
+		if ( task.second )
+		{
+			try
+			{
+				task.second();
+			}
+			catch ( const std::exception& e )
+			{ LOG4CPP_WARN( logger, "Caught exception in task of " << getName() << ": " << e.what() ); }
+			catch ( ... )
+			{ LOG4CPP_WARN( logger, "Caught exception in task of " << getName() ); }
+		}
+		l.lock();
+
+		queue.nCompleted = task.first;
+		m_completed.notify_all();
+	}
+}
+
+} } // namespace Ubitrack::Facade
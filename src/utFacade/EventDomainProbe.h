@@ -0,0 +1,143 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+
+/**
+ * @ingroup api
+ * @file
+ * A component running facade tasks on the dispatcher thread of an event domain.
+ */
+#ifndef __UBITRACK_FACADE_EVENTDOMAINPROBE_H_INCLUDED__
+#define __UBITRACK_FACADE_EVENTDOMAINPROBE_H_INCLUDED__
+
+#include <deque>
+#include <utility>
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+#include <utDataflow/Component.h>
+#include <utDataflow/PushSupplier.h>
+#include <utDataflow/PushConsumer.h>
+#include <utMeasurement/Measurement.h>
+
+namespace Ubitrack { namespace Facade {
+
+/**
+ * Runs tasks on the dispatcher thread of an event domain.
+ *
+ * Tasks travel through the event queue of the domain like any other event, with the largest
+ * possible priority. When a task runs, the dispatch of all events queued before it has
+ * completed, which makes the probe usable as a barrier.
+ *
+ * Tasks queued ahead use the smallest priority instead and run as soon as the event in dispatch
+ * has completed, without waiting for the backlog of the domain. They are no barrier.
+ *
+ * The probe must only be destroyed while the event queue of its domain is stopped and cleared.
+ */
+class EventDomainProbe
+	: public Dataflow::Component
+{
+public:
+	/** type of a task */
+	typedef boost::function< void() > TaskType;
+
+	/**
+	 * creates the probe in an event domain
+	 *
+	 * @param domain id of the event domain
+	 */
+	explicit EventDomainProbe( unsigned int domain );
+
+	/**
+	 * queues a task for the dispatcher thread and returns immediately
+	 *
+	 * @param bAhead run the task before the events already queued
+	 */
+	void post( const TaskType& task, bool bAhead = false );
+
+	/**
+	 * Runs a task on the dispatcher thread and waits for it to complete. Runs the task directly
+	 * when called from the dispatcher thread. Exceptions thrown by the task are rethrown as
+	 * \c Util::Exception.
+	 *
+	 * @param bAhead run the task before the events already queued
+	 * @return false if the deadline passed or the probe was cancelled before the task ran
+	 */
+	bool call( const TaskType& task, const boost::posix_time::ptime& deadline, bool bAhead = false );
+
+	/**
+	 * Waits until the dispatch of all events queued in the domain before this call has completed.
+	 * Returns immediately when called from the dispatcher thread.
+	 *
+	 * @return false if the deadline passed or the probe was cancelled first
+	 */
+	bool waitDispatched( const boost::posix_time::ptime& deadline );
+
+	/** wakes up and fails all waiting calls, used when the event queue is stopped */
+	void cancel();
+
+protected:
+	/** tasks of one priority with their sequence numbers */
+	struct TaskQueue
+	{
+		TaskQueue()
+			: nQueued( 0 )
+			, nCompleted( 0 )
+		{}
+
+		std::deque< std::pair< unsigned int, TaskType > > tasks;
+
+		/** sequence number of the last queued and of the last completed task */
+		unsigned int nQueued;
+		unsigned int nCompleted;
+	};
+
+	/** queues a task and returns its sequence number */
+	unsigned int queueTask( const TaskType& task, bool bAhead );
+
+	/** waits until the task with the given sequence number has run */
+	bool waitCompleted( unsigned int nSequence, bool bAhead, const boost::posix_time::ptime& deadline );
+
+	/** handler of the input port, runs the tasks up to the sequence number of the probe event */
+	void receiveProbe( const Measurement::Button& probe );
+
+	/** sends probe events to the input port through the event queue */
+	Dataflow::PushSupplier< Measurement::Button > m_outPort;
+	Dataflow::PushConsumer< Measurement::Button > m_inPort;
+
+	/** tasks queued behind and ahead of the events of the domain */
+	TaskQueue m_behind;
+	TaskQueue m_ahead;
+
+	/** set by \c cancel */
+	bool m_bCancelled;
+
+	/** thread that ran the last task */
+	boost::thread::id m_dispatcherId;
+
+	boost::mutex m_mutex;
+	boost::condition_variable m_completed;
+};
+
+} } // namespace Ubitrack::Facade
+
+#endif
@@ -0,0 +1,118 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @ingroup api
+ * @file
+ * Construction options shared by the advanced and the basic facade.
+ */
+#ifndef __UBITRACK_FACADE_FACADEOPTIONS_H_INCLUDED__
+#define __UBITRACK_FACADE_FACADEOPTIONS_H_INCLUDED__
+
+#include <utFacade/utFacade.h>
+#include "ThreadScheduling.h"
+
+namespace Ubitrack { namespace Facade {
+
+/**
+ * Options for constructing a facade.
+ *
+ * The default-constructed options reproduce the behaviour of the plain constructors.
+ */
+struct FacadeOptions
+{
+	/**
+	 * How events arriving at application push sinks are handed to the application.
+	 */
+	enum DropPolicy
+	{
+		/** callbacks are called directly from the dataflow thread (default) */
+		DELIVER_SYNCHRONOUS = 0,
+
+		/** events are queued; the dataflow thread blocks while the queue is full */
+		DROP_NONE,
+
+		/** events are queued; a new event is discarded while the queue is full */
+		DROP_NEWEST,
+
+		/** events are queued; the oldest queued event is discarded to make room for a new one */
+		DROP_OLDEST,
+
+		/**
+		 * at most one event per push sink is queued; a new event replaces a still undelivered
+		 * one of the same sink, so the application always receives the latest value
+		 */
+		COALESCE_LATEST
+	};
+
+	FacadeOptions()
+		: dropEvents( true )
+		, eventQueueCapacity( 64 )
+		, dropPolicy( DELIVER_SYNCHRONOUS )
+		, lockMemory( false )
+		, virtualClock( false )
+		, virtualClockStart( 0 )
+	{}
+
+	/** passed on to the dataflow event queue */
+	bool dropEvents;
+
+	/** maximum number of events waiting for delivery to the application. Ignored for DELIVER_SYNCHRONOUS and COALESCE_LATEST */
+	unsigned int eventQueueCapacity;
+
+	/** delivery and overload behaviour for application push sinks */
+	DropPolicy dropPolicy;
+
+	/**
+	 * scheduling of the event queue dispatcher threads of the facade. Applies to all event
+	 * domains for which no other scheduling is set with \c AdvancedFacade::setEventDomainScheduling
+	 */
+	ThreadScheduling dispatcherScheduling;
+
+	/** scheduling of the thread handling the connection to the server */
+	ThreadScheduling networkScheduling;
+
+	/** scheduling of the worker threads delivering application events and observer notifications */
+	ThreadScheduling workerScheduling;
+
+	/** lock all memory of the process (mlockall) when the facade is created. Linux only */
+	bool lockMemory;
+
+	/**
+	 * Offline mode: timestamps generated by the facade are taken from a clock that the
+	 * application sets and advances explicitly (see \c AdvancedFacade::advanceClock), so recorded
+	 * data can be processed as fast as possible and reproducibly. No events are dropped in this
+	 * mode: \c dropEvents is ignored and dropping delivery policies are replaced by DROP_NONE.
+	 */
+	bool virtualClock;
+
+	/**
+	 * initial time of the virtual clock in nanoseconds, e.g. the first timestamp of a recording.
+	 * Defaults to 0, so runs do not depend on the time the facade was created.
+	 */
+	unsigned long long virtualClockStart;
+};
+
+} } // namespace Ubitrack::Facade
+
+#endif
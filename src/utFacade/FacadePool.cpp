@@ -0,0 +1,178 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @ingroup api
+ * @file
+ * Implements the facade pool.
+ */
+
+#include <log4cpp/Category.hh>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <utUtil/Exception.h>
+
+#include "FacadePool.h"
+
+// get a logger
+static log4cpp::Category& logger( log4cpp::Category::getInstance( "Ubitrack.Facade.FacadePool" ) );
+
+namespace Ubitrack { namespace Facade {
+
+FacadePool::FacadePool( const std::string& sComponentPath, const FacadeOptions& options )
+	: m_sComponentPath( sComponentPath )
+	, m_options( options )
+{}
+
+
+FacadePool::~FacadePool()
+{
+	destroyAll();
+}
+
+
+boost::shared_ptr< AdvancedFacade > FacadePool::create( const std::string& sName, const std::string& sUtqlFile, bool bStart )
+{
+	// reserve the name, so the (slow) construction can happen without holding the lock
+	{
+		boost::mutex::scoped_lock l( m_mutex );
+		if ( m_facades.find( sName ) != m_facades.end() )
+			UBITRACK_THROW( "Facade \"" + sName + "\" already exists" );
+		m_facades[ sName ];
+	}
+
+	boost::shared_ptr< AdvancedFacade > pFacade;
+	try
+	{
+		LOG4CPP_INFO( logger, "Creating facade " << sName );
+		pFacade.reset( new AdvancedFacade( m_options, m_sComponentPath ) );
+		if ( !sUtqlFile.empty() )
+		{
+			pFacade->loadDataflow( sUtqlFile );
+			if ( bStart )
+				pFacade->startDataflow();
+		}
+	}
+	catch ( ... )
+	{
+		boost::mutex::scoped_lock l( m_mutex );
+		m_facades.erase( sName );
+		throw;
+	}
+
+	boost::mutex::scoped_lock l( m_mutex );
+	m_facades[ sName ] = pFacade;
+	return pFacade;
+}
+
+
+void FacadePool::createWorker( const std::string& sName, const std::string& sUtqlFile, bool bStart, std::string* pError )
+{
+	try
+	{
+		create( sName, sUtqlFile, bStart );
+	}
+	catch ( const Util::Exception& e )
+	{
+		LOG4CPP_ERROR( logger, "Cannot create facade " << sName << ": " << e );
+		*pError = e.what();
+	}
+	catch ( const std::exception& e )
+	{
+		LOG4CPP_ERROR( logger, "Cannot create facade " << sName << ": " << e.what() );
+		*pError = e.what();
+	}
+}
+
+
+void FacadePool::createAll( const std::map< std::string, std::string >& utqlFiles, bool bStart )
+{
+	std::vector< std::string > errors( utqlFiles.size() );
+	boost::thread_group threads;
+
+	std::size_t i = 0;
+	for ( std::map< std::string, std::string >::const_iterator it = utqlFiles.begin(); it != utqlFiles.end(); it++, i++ )
+		threads.create_thread( boost::bind( &FacadePool::createWorker, this, it->first, it->second, bStart, &errors[ i ] ) );
+	threads.join_all();
+
+	for ( i = 0; i < errors.size(); i++ )
+		if ( !errors[ i ].empty() )
+			UBITRACK_THROW( errors[ i ] );
+}
+
+
+boost::shared_ptr< AdvancedFacade > FacadePool::get( const std::string& sName ) const
+{
+	boost::mutex::scoped_lock l( m_mutex );
+	FacadeMap::const_iterator it = m_facades.find( sName );
+	if ( it == m_facades.end() )
+		return boost::shared_ptr< AdvancedFacade >();
+	return it->second;
+}
+
+
+void FacadePool::destroy( const std::string& sName )
+{
+	boost::shared_ptr< AdvancedFacade > pFacade;
+	{
+		boost::mutex::scoped_lock l( m_mutex );
+		FacadeMap::iterator it = m_facades.find( sName );
+		if ( it == m_facades.end() || !it->second )
+			return;
+		pFacade.swap( it->second );
+		m_facades.erase( it );
+	}
+
+	// destroyed outside the lock, unless still referenced elsewhere
+	LOG4CPP_INFO( logger, "Destroying facade " << sName );
+	pFacade.reset();
+}
+
+
+void FacadePool::destroyAll()
+{
+	boost::thread_group threads;
+	std::vector< std::string > all( names() );
+	for ( std::vector< std::string >::iterator it = all.begin(); it != all.end(); it++ )
+		threads.create_thread( boost::bind( &FacadePool::destroy, this, *it ) );
+	threads.join_all();
+}
+
+
+std::vector< std::string > FacadePool::names() const
+{
+	boost::mutex::scoped_lock l( m_mutex );
+	std::vector< std::string > result;
+	for ( FacadeMap::const_iterator it = m_facades.begin(); it != m_facades.end(); it++ )
+		if ( it->second )
+			result.push_back( it->first );
+	return result;
+}
+
+
+std::size_t FacadePool::size() const
+{
+	return names().size();
+}
+
+} } // namespace Ubitrack::Facade
@@ -0,0 +1,114 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @ingroup api
+ * @file
+ * Hosts several independent dataflows in one process.
+ */
+#ifndef __UBITRACK_FACADE_FACADEPOOL_H_INCLUDED__
+#define __UBITRACK_FACADE_FACADEPOOL_H_INCLUDED__
+
+#include <utFacade/utFacade.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/noncopyable.hpp>
+
+#include "AdvancedFacade.h"
+
+namespace Ubitrack { namespace Facade {
+
+/**
+ * A thread-safe collection of named \c AdvancedFacade instances.
+ *
+ * Every facade has its own event domains, so the dataflows of different facades are
+ * dispatched by different threads and can be started, stopped and destroyed independently.
+ * Facades can be created and destroyed concurrently from several threads.
+ */
+class UTFACADE_EXPORT FacadePool
+	: private boost::noncopyable
+{
+public:
+	/**
+	 * @param sComponentPath component directory used for all facades of the pool
+	 * @param options options used for all facades of the pool
+	 */
+	FacadePool( const std::string& sComponentPath = std::string(), const FacadeOptions& options = FacadeOptions() );
+
+	/** destroys all facades */
+	~FacadePool();
+
+	/**
+	 * Creates a new facade. Throws if a facade with that name already exists.
+	 *
+	 * @param sName name of the facade, e.g. the station it serves
+	 * @param sUtqlFile if not empty, a dataflow to load into the new facade
+	 * @param bStart start the dataflow after loading
+	 */
+	boost::shared_ptr< AdvancedFacade > create( const std::string& sName, const std::string& sUtqlFile = std::string(), bool bStart = true );
+
+	/**
+	 * Creates several facades in parallel, one thread per facade.
+	 * If some of them fail, the others are still created and the first error is thrown afterwards.
+	 *
+	 * @param utqlFiles maps facade names to the dataflow files to load (may be empty strings)
+	 * @param bStart start the dataflows after loading
+	 */
+	void createAll( const std::map< std::string, std::string >& utqlFiles, bool bStart = true );
+
+	/** returns the facade with the given name or an empty pointer */
+	boost::shared_ptr< AdvancedFacade > get( const std::string& sName ) const;
+
+	/** stops and destroys a facade. Does nothing if it does not exist */
+	void destroy( const std::string& sName );
+
+	/** stops and destroys all facades in parallel */
+	void destroyAll();
+
+	/** returns the names of all facades */
+	std::vector< std::string > names() const;
+
+	/** number of facades in the pool */
+	std::size_t size() const;
+
+protected:
+	/** creates a facade for createAll and records errors */
+	void createWorker( const std::string& sName, const std::string& sUtqlFile, bool bStart, std::string* pError );
+
+	std::string m_sComponentPath;
+	FacadeOptions m_options;
+
+	typedef std::map< std::string, boost::shared_ptr< AdvancedFacade > > FacadeMap;
+
+	/** the facades. An empty pointer marks a facade under construction */
+	FacadeMap m_facades;
+
+	mutable boost::mutex m_mutex;
+};
+
+} } // namespace Ubitrack::Facade
+
+#endif
@@ -0,0 +1,139 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @ingroup api
+ * @file
+ * Snapshots of the runtime statistics of a facade.
+ */
+#ifndef __UBITRACK_FACADE_FACADESTATISTICS_H_INCLUDED__
+#define __UBITRACK_FACADE_FACADESTATISTICS_H_INCLUDED__
+
+#include <string>
+#include <vector>
+
+namespace Ubitrack { namespace Facade {
+
+/**
+ * Statistics of one application endpoint (push/pull sink or source).
+ */
+struct EndpointStatistics
+{
+	/** number of buckets in \c latencyHistogram */
+	static const unsigned int HISTOGRAM_BUCKETS = 40;
+
+	EndpointStatistics()
+		: events( 0 )
+		, rate( 0.0 )
+		, latencyCount( 0 )
+		, meanLatency( 0.0 )
+		, maxLatency( 0 )
+		, latencyHistogram( HISTOGRAM_BUCKETS, 0 )
+	{}
+
+	/** id of the component */
+	std::string componentName;
+
+	/** pattern name of the component, e.g. ApplicationPushSinkPose */
+	std::string patternName;
+
+	/** name of the event domain of the component, empty for the default domain */
+	std::string domainName;
+
+	/** number of events received (sinks) or sent (sources) */
+	unsigned long long events;
+
+	/** average events per second between the first and the last event */
+	double rate;
+
+	/** number of latency measurements */
+	unsigned long long latencyCount;
+
+	/** mean callback (push sink, pull source) or dataflow (pull sink, push source) latency in nanoseconds */
+	double meanLatency;
+
+	/** maximum latency in nanoseconds */
+	unsigned long long maxLatency;
+
+	/** 
+	 * entry 0 counts latencies below 2 nanoseconds, entry i > 0 latencies in [2^i, 2^(i+1))
+	 * nanoseconds. The last entry also counts all larger latencies.
+	 */
+	std::vector< unsigned long long > latencyHistogram;
+};
+
+
+/**
+ * Statistics of one event domain.
+ *
+ * \c queueDepth is the length of the event queue of the domain. The event queue does not
+ * count the events it dispatches or drops, so the \c sink counters only cover the path from
+ * the push sinks of the domain to the application callbacks, including the facade's delivery
+ * queue if one is configured (see \c FacadeOptions::dropPolicy).
+ */
+struct EventDomainStatistics
+{
+	EventDomainStatistics()
+		: domainId( 0 )
+		, queueDepth( 0 )
+		, sinkEvents( 0 )
+		, sinkDelivered( 0 )
+		, sinkDropped( 0 )
+		, sinkPending( 0 )
+	{}
+
+	/** name of the event domain, empty for the default domain */
+	std::string domainName;
+
+	/** numeric id of the event domain */
+	unsigned int domainId;
+
+	/** events currently waiting in the event queue of the domain */
+	unsigned long long queueDepth;
+
+	/** events that arrived at push sinks of this domain */
+	unsigned long long sinkEvents;
+
+	/** push sink events delivered to application callbacks */
+	unsigned long long sinkDelivered;
+
+	/** push sink events discarded by the delivery queue or because no callback was set */
+	unsigned long long sinkDropped;
+
+	/** push sink events waiting in the delivery queue */
+	unsigned long long sinkPending;
+};
+
+
+/**
+ * A snapshot of all statistics of a facade.
+ */
+struct FacadeStatistics
+{
+	std::vector< EventDomainStatistics > domains;
+	std::vector< EndpointStatistics > endpoints;
+};
+
+} } // namespace Ubitrack::Facade
+
+#endif
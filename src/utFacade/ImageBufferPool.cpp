@@ -0,0 +1,259 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @ingroup api
+ * @file
+ * Implements the image buffer pool.
+ */
+
+#ifdef HAVE_OPENCV
+
+#include <map>
+#include <vector>
+#include <sstream>
+#include <log4cpp/Category.hh>
+#include <boost/thread/mutex.hpp>
+#include <boost/align/aligned_alloc.hpp>
+#include <utUtil/Exception.h>
+
+#include "ImageBufferPool.h"
+#include "ImageConversion.h"
+
+// get a logger
+static log4cpp::Category& logger( log4cpp::Category::getInstance( "Ubitrack.Facade.ImageBufferPool" ) );
+
+namespace Ubitrack { namespace Facade {
+
+namespace {
+
+/** alignment of the pixel buffers, enough for AVX-512 loads */
+const std::size_t g_bufferAlignment = 64;
+
+} // anonymous namespace
+
+
+struct ImageBufferPool::State
+{
+	State( std::size_t nMaxFree )
+		: nMaxFree( nMaxFree )
+		, nAllocated( 0 )
+		, nReused( 0 )
+		, nInUse( 0 )
+	{}
+
+	~State()
+	{ freeAll(); }
+
+	/** takes an idle buffer of the given size or allocates a new one */
+	unsigned char* take( std::size_t nBytes )
+	{
+		{
+			boost::mutex::scoped_lock l( mutex );
+			nInUse++;
+
+			std::vector< unsigned char* >& buffers( freeBuffers[ nBytes ] );
+			if ( !buffers.empty() )
+			{
+				unsigned char* pBuffer = buffers.back();
+				buffers.pop_back();
+				nReused++;
+				return pBuffer;
+			}
+
+			nAllocated++;
+		}
+
+		void* pBuffer = boost::alignment::aligned_alloc( g_bufferAlignment, nBytes );
+		if ( !pBuffer )
+		{
+			boost::mutex::scoped_lock l( mutex );
+			nInUse--;
+			nAllocated--;
+
+			std::ostringstream msg;
+			msg << "Cannot allocate image buffer of " << nBytes << " bytes";
+			UBITRACK_THROW( msg.str() );
+		}
+		return static_cast< unsigned char* >( pBuffer );
+	}
+
+	/** returns a buffer to the pool, or frees it if enough buffers of its size are idle */
+	void give( unsigned char* pBuffer, std::size_t nBytes )
+	{
+		{
+			boost::mutex::scoped_lock l( mutex );
+			nInUse--;
+
+			std::vector< unsigned char* >& buffers( freeBuffers[ nBytes ] );
+			if ( buffers.size() < nMaxFree )
+			{
+				buffers.push_back( pBuffer );
+				return;
+			}
+		}
+
+		boost::alignment::aligned_free( pBuffer );
+	}
+
+	void freeAll()
+	{
+		std::map< std::size_t, std::vector< unsigned char* > > buffers;
+		{
+			boost::mutex::scoped_lock l( mutex );
+			buffers.swap( freeBuffers );
+		}
+
+		for ( std::map< std::size_t, std::vector< unsigned char* > >::iterator it = buffers.begin(); it != buffers.end(); it++ )
+			for ( std::vector< unsigned char* >::iterator itBuffer = it->second.begin(); itBuffer != it->second.end(); itBuffer++ )
+				boost::alignment::aligned_free( *itBuffer );
+	}
+
+	const std::size_t nMaxFree;
+
+	/** idle buffers by size in bytes */
+	std::map< std::size_t, std::vector< unsigned char* > > freeBuffers;
+
+	unsigned long long nAllocated;
+	unsigned long long nReused;
+	unsigned long long nInUse;
+
+	mutable boost::mutex mutex;
+};
+
+
+namespace {
+
+/** deleter of pooled images, returns the pixel buffer to the pool */
+struct ReleaseImageBuffer
+{
+	ReleaseImageBuffer( boost::shared_ptr< ImageBufferPool::State > pState, unsigned char* pBuffer, std::size_t nBytes )
+		: pState( pState )
+		, pBuffer( pBuffer )
+		, nBytes( nBytes )
+	{}
+
+	void operator()( Vision::Image* pImage )
+	{
+		// the image does not own the buffer
+		delete pImage;
+		pState->give( pBuffer, nBytes );
+	}
+
+	boost::shared_ptr< ImageBufferPool::State > pState;
+	unsigned char* pBuffer;
+	std::size_t nBytes;
+};
+
+
+/** size of one channel of an OpenCV depth in bytes */
+std::size_t channelSize( int depth )
+{
+	switch ( depth )
+	{
+	case CV_8U:
+		return 1;
+	case CV_16U:
+		return 2;
+	case CV_32F:
+		return 4;
+	default:
+		UBITRACK_THROW( "Unsupported image depth for the image buffer pool" );
+	}
+}
+
+} // anonymous namespace
+
+
+ImageBufferPool::ImageBufferPool( std::size_t nMaxFree )
+	: m_pState( new State( nMaxFree ) )
+{}
+
+
+ImageBufferPool::~ImageBufferPool()
+{
+	Counters c( counters() );
+	LOG4CPP_DEBUG( logger, "Image buffer pool allocated " << c.nAllocated << " buffers, reused " << c.nReused
+		<< ", " << c.nInUse << " still in use" );
+}
+
+
+boost::shared_ptr< Vision::Image > ImageBufferPool::acquire( int width, int height, int channels, int depth, Vision::Image::PixelFormat format )
+{
+	if ( width <= 0 || height <= 0 || channels <= 0 )
+		UBITRACK_THROW( "Invalid image size for the image buffer pool" );
+
+	std::size_t nBytes = std::size_t( width ) * height * channels * channelSize( depth );
+	unsigned char* pBuffer = m_pState->take( nBytes );
+
+	Vision::Image* pImage;
+	try
+	{
+		// tightly packed rows, so that the buffer size does not depend on the alignment of the image
+		pImage = new Vision::Image( width, height, channels, pBuffer, depth, 0, 1 );
+	}
+	catch ( ... )
+	{
+		m_pState->give( pBuffer, nBytes );
+		throw;
+	}
+
+	boost::shared_ptr< Vision::Image > pResult( pImage, ReleaseImageBuffer( m_pState, pBuffer, nBytes ) );
+	pResult->set_pixelFormat( format );
+	return pResult;
+}
+
+
+boost::shared_ptr< Vision::Image > ImageBufferPool::acquire( int width, int height, Vision::Image::PixelFormat format )
+{
+	int channels, depth;
+	if ( !pixelFormatLayout( format, channels, depth ) )
+		UBITRACK_THROW( "Pixel format not supported by the image buffer pool, specify channels and depth" );
+
+	return acquire( width, height, channels, depth, format );
+}
+
+
+ImageBufferPool::Counters ImageBufferPool::counters() const
+{
+	boost::mutex::scoped_lock l( m_pState->mutex );
+
+	Counters c;
+	c.nAllocated = m_pState->nAllocated;
+	c.nReused = m_pState->nReused;
+	c.nInUse = m_pState->nInUse;
+	c.nFree = 0;
+	for ( std::map< std::size_t, std::vector< unsigned char* > >::const_iterator it = m_pState->freeBuffers.begin(); it != m_pState->freeBuffers.end(); it++ )
+		c.nFree += it->second.size();
+	return c;
+}
+
+
+void ImageBufferPool::trim()
+{
+	m_pState->freeAll();
+}
+
+} } // namespace Ubitrack::Facade
+
+#endif // HAVE_OPENCV
@@ -0,0 +1,108 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @ingroup api
+ * @file
+ * Pool of reusable pixel buffers for images sent into the dataflow.
+ */
+#ifndef __UBITRACK_FACADE_IMAGEBUFFERPOOL_H_INCLUDED__
+#define __UBITRACK_FACADE_IMAGEBUFFERPOOL_H_INCLUDED__
+
+#include <utFacade/utFacade.h>
+#include <boost/shared_ptr.hpp>
+#include <boost/noncopyable.hpp>
+#include <utVision/Image.h>
+
+namespace Ubitrack { namespace Facade {
+
+/**
+ * Hands out images whose pixel buffers are recycled.
+ *
+ * A producer acquires an image, fills its pixels and sends it into the dataflow without copying.
+ * When the last reference to the image is dropped, wherever in the dataflow or application that
+ * happens, the buffer goes back to the pool and is handed out again by the next \c acquire of the
+ * same size. Images may outlive the pool; their buffers are then freed instead.
+ *
+ * All methods are thread-safe.
+ */
+class UTFACADE_EXPORT ImageBufferPool
+	: private boost::noncopyable
+{
+public:
+	/** usage counters */
+	struct Counters
+	{
+		/** buffers allocated from the heap */
+		unsigned long long nAllocated;
+
+		/** acquisitions served with a recycled buffer */
+		unsigned long long nReused;
+
+		/** buffers currently held by images */
+		unsigned long long nInUse;
+
+		/** buffers waiting in the pool */
+		unsigned long long nFree;
+	};
+
+	/**
+	 * @param nMaxFree maximum number of idle buffers kept per buffer size, further returned buffers are freed
+	 */
+	ImageBufferPool( std::size_t nMaxFree = 8 );
+
+	~ImageBufferPool();
+
+	/**
+	 * Returns an image with a pooled, uninitialized, continuous pixel buffer.
+	 *
+	 * @param width width in pixels
+	 * @param height height in pixels
+	 * @param channels number of channels
+	 * @param depth OpenCV depth of one channel, e.g. CV_8U
+	 * @param format pixel format stored in the image
+	 */
+	boost::shared_ptr< Vision::Image > acquire( int width, int height, int channels, int depth, Vision::Image::PixelFormat format );
+
+	/**
+	 * Same as above, with channels and depth derived from the pixel format.
+	 * Throws for formats without a fixed number of bytes per pixel, e.g. YUV411.
+	 */
+	boost::shared_ptr< Vision::Image > acquire( int width, int height, Vision::Image::PixelFormat format );
+
+	/** returns the current counters */
+	Counters counters() const;
+
+	/** frees all idle buffers */
+	void trim();
+
+	/** the state shared with the images handed out */
+	struct State;
+
+protected:
+	boost::shared_ptr< State > m_pState;
+};
+
+} } // namespace Ubitrack::Facade
+
+#endif
@@ -0,0 +1,241 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @ingroup api
+ * @file
+ * Implements the image conversion into application buffers.
+ */
+
+#ifdef HAVE_OPENCV
+
+#include <cstring>
+#include <algorithm>
+#include <opencv2/imgproc.hpp>
+#include <utUtil/Exception.h>
+
+#include "ImageConversion.h"
+
+namespace Ubitrack { namespace Facade {
+
+namespace {
+
+/** code for plain row copies in \c ConvertRows */
+const int g_copyRows = -1;
+
+/** images with fewer pixels are converted on the calling thread */
+const std::size_t g_minParallelPixels = 512 * 512;
+
+/** number of pixels per band of rows */
+const double g_pixelsPerBand = 65536.0;
+
+
+/** returns the OpenCV color conversion code, or \c g_copyRows if both formats are equal */
+int conversionCode( Vision::Image::PixelFormat src, Vision::Image::PixelFormat dst )
+{
+	if ( src == dst )
+		return g_copyRows;
+
+	switch ( src )
+	{
+	case Vision::Image::LUMINANCE:
+		switch ( dst )
+		{
+		case Vision::Image::RGB: return cv::COLOR_GRAY2RGB;
+		case Vision::Image::BGR: return cv::COLOR_GRAY2BGR;
+		case Vision::Image::RGBA: return cv::COLOR_GRAY2RGBA;
+		case Vision::Image::BGRA: return cv::COLOR_GRAY2BGRA;
+		default: break;
+		}
+		break;
+
+	case Vision::Image::RGB:
+		switch ( dst )
+		{
+		case Vision::Image::LUMINANCE: return cv::COLOR_RGB2GRAY;
+		case Vision::Image::BGR: return cv::COLOR_RGB2BGR;
+		case Vision::Image::RGBA: return cv::COLOR_RGB2RGBA;
+		case Vision::Image::BGRA: return cv::COLOR_RGB2BGRA;
+		default: break;
+		}
+		break;
+
+	case Vision::Image::BGR:
+		switch ( dst )
+		{
+		case Vision::Image::LUMINANCE: return cv::COLOR_BGR2GRAY;
+		case Vision::Image::RGB: return cv::COLOR_BGR2RGB;
+		case Vision::Image::RGBA: return cv::COLOR_BGR2RGBA;
+		case Vision::Image::BGRA: return cv::COLOR_BGR2BGRA;
+		default: break;
+		}
+		break;
+
+	case Vision::Image::RGBA:
+		switch ( dst )
+		{
+		case Vision::Image::LUMINANCE: return cv::COLOR_RGBA2GRAY;
+		case Vision::Image::RGB: return cv::COLOR_RGBA2RGB;
+		case Vision::Image::BGR: return cv::COLOR_RGBA2BGR;
+		case Vision::Image::BGRA: return cv::COLOR_RGBA2BGRA;
+		default: break;
+		}
+		break;
+
+	case Vision::Image::BGRA:
+		switch ( dst )
+		{
+		case Vision::Image::LUMINANCE: return cv::COLOR_BGRA2GRAY;
+		case Vision::Image::RGB: return cv::COLOR_BGRA2RGB;
+		case Vision::Image::BGR: return cv::COLOR_BGRA2BGR;
+		case Vision::Image::RGBA: return cv::COLOR_BGRA2RGBA;
+		default: break;
+		}
+		break;
+
+	case Vision::Image::YUV422:
+		switch ( dst )
+		{
+		case Vision::Image::LUMINANCE: return cv::COLOR_YUV2GRAY_YUY2;
+		case Vision::Image::RGB: return cv::COLOR_YUV2RGB_YUY2;
+		case Vision::Image::BGR: return cv::COLOR_YUV2BGR_YUY2;
+		case Vision::Image::RGBA: return cv::COLOR_YUV2RGBA_YUY2;
+		case Vision::Image::BGRA: return cv::COLOR_YUV2BGRA_YUY2;
+		default: break;
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	UBITRACK_THROW( "Unsupported pixel format conversion" );
+}
+
+
+/**
+ * Converts a band of source rows. With vertical flipping, the band is written to the mirrored
+ * band of the destination and flipped there, so each band stays a single conversion call.
+ */
+class ConvertRows
+	: public cv::ParallelLoopBody
+{
+public:
+	ConvertRows( const cv::Mat& src, const cv::Mat& dst, int code, bool bFlip )
+		: m_src( src )
+		, m_dst( dst )
+		, m_code( code )
+		, m_bFlip( bFlip )
+	{}
+
+	void operator()( const cv::Range& range ) const
+	{
+		int dstStart = m_bFlip ? m_src.rows - range.end : range.start;
+		cv::Mat srcRows( m_src.rowRange( range.start, range.end ) );
+		cv::Mat dstRows( m_dst.rowRange( dstStart, dstStart + range.end - range.start ) );
+
+		if ( m_code == g_copyRows )
+		{
+			std::size_t nRowBytes = std::size_t( m_src.cols ) * m_src.elemSize();
+			for ( int i = 0; i < srcRows.rows; i++ )
+			{
+				int dstRow = m_bFlip ? dstRows.rows - 1 - i : i;
+				std::memcpy( dstRows.ptr( dstRow ), srcRows.ptr( i ), nRowBytes );
+			}
+			return;
+		}
+
+		cv::cvtColor( srcRows, dstRows, m_code );
+		if ( m_bFlip )
+			cv::flip( dstRows, dstRows, 0 );
+	}
+
+protected:
+	cv::Mat m_src;
+	cv::Mat m_dst;
+	int m_code;
+	bool m_bFlip;
+};
+
+} // anonymous namespace
+
+
+bool pixelFormatLayout( Vision::Image::PixelFormat format, int& channels, int& depth )
+{
+	depth = CV_8U;
+	switch ( format )
+	{
+	case Vision::Image::LUMINANCE:
+	case Vision::Image::RAW:
+		channels = 1;
+		return true;
+	case Vision::Image::DEPTH:
+		channels = 1;
+		depth = CV_16U;
+		return true;
+	case Vision::Image::YUV422:
+		channels = 2;
+		return true;
+	case Vision::Image::RGB:
+	case Vision::Image::BGR:
+		channels = 3;
+		return true;
+	case Vision::Image::RGBA:
+	case Vision::Image::BGRA:
+		channels = 4;
+		return true;
+	default:
+		return false;
+	}
+}
+
+
+void convertImage( const cv::Mat& src, Vision::Image::PixelFormat srcFormat,
+	cv::Mat& dst, Vision::Image::PixelFormat dstFormat, bool bFlipVertical )
+{
+	if ( src.rows != dst.rows || src.cols != dst.cols )
+		UBITRACK_THROW( "Image conversion needs a destination of the same size" );
+
+	int code = conversionCode( srcFormat, dstFormat );
+	if ( code == g_copyRows )
+	{
+		if ( src.type() != dst.type() )
+			UBITRACK_THROW( "Image copy needs a destination of the same type" );
+	}
+	else
+	{
+		int channels, depth;
+		if ( src.depth() != CV_8U || !pixelFormatLayout( dstFormat, channels, depth ) || dst.type() != CV_MAKETYPE( depth, channels ) )
+			UBITRACK_THROW( "Image conversion needs 8 bit images and a destination of the type of the pixel format" );
+	}
+
+	ConvertRows body( src, dst, code, bFlipVertical );
+	if ( src.total() < g_minParallelPixels )
+		body( cv::Range( 0, src.rows ) );
+	else
+		cv::parallel_for_( cv::Range( 0, src.rows ), body, src.total() / g_pixelsPerBand );
+}
+
+} } // namespace Ubitrack::Facade
+
+#endif // HAVE_OPENCV
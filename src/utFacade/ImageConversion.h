@@ -0,0 +1,63 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @ingroup api
+ * @file
+ * Copies images into application buffers with pixel format conversion.
+ */
+#ifndef __UBITRACK_FACADE_IMAGECONVERSION_H_INCLUDED__
+#define __UBITRACK_FACADE_IMAGECONVERSION_H_INCLUDED__
+
+#include <utFacade/utFacade.h>
+#include <utVision/Image.h>
+
+namespace Ubitrack { namespace Facade {
+
+/**
+ * Returns the number of channels and the OpenCV depth of a pixel format.
+ *
+ * @return false if the format has no fixed number of bytes per pixel (YUV411, unknown)
+ */
+UTFACADE_EXPORT bool pixelFormatLayout( Vision::Image::PixelFormat format, int& channels, int& depth );
+
+/**
+ * Converts an image into another one of the same size, which usually wraps an application buffer.
+ *
+ * Respects the row step of both images, so rows are packed or padded as the destination requires.
+ * Supported are all conversions between LUMINANCE, RGB, BGR, RGBA and BGRA, and from YUV422
+ * (YUYV order) to these formats. Images of the same format are copied row by row, whatever the
+ * format. Large images are converted in bands of rows on the OpenCV thread pool.
+ *
+ * @param src source image
+ * @param srcFormat pixel format of \c src
+ * @param dst destination, must already have the size and the type matching \c dstFormat
+ * @param dstFormat pixel format to convert to
+ * @param bFlipVertical store the rows in reverse order
+ */
+UTFACADE_EXPORT void convertImage( const cv::Mat& src, Vision::Image::PixelFormat srcFormat,
+	cv::Mat& dst, Vision::Image::PixelFormat dstFormat, bool bFlipVertical );
+
+} } // namespace Ubitrack::Facade
+
+#endif
@@ -0,0 +1,340 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @ingroup api
+ * @file
+ * Implements the image encoder pool.
+ */
+
+#ifdef HAVE_OPENCV
+
+#include <fstream>
+#include <sstream>
+#include <log4cpp/Category.hh>
+#include <boost/bind.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <utUtil/Exception.h>
+
+#include "ImageEncoder.h"
+#include "ImageConversion.h"
+
+// get a logger
+static log4cpp::Category& logger( log4cpp::Category::getInstance( "Ubitrack.Facade.ImageEncoder" ) );
+
+namespace Ubitrack { namespace Facade {
+
+ImageEncoder::ImageEncoder( Codec codec, int level, unsigned int nWorkers, std::size_t nMaxPending, const ReceiverType& receiver )
+	: m_codec( codec )
+	, m_level( level )
+	, m_nMaxPending( nMaxPending > 0 ? nMaxPending : 1 )
+	, m_receiver( receiver )
+	, m_nextSequence( 0 )
+	, m_nextDelivery( 0 )
+	, m_bStop( false )
+{
+	if ( codec == JPEG && ( level < 0 || level > 100 ) )
+		UBITRACK_THROW( "JPEG quality must be between 0 and 100" );
+	if ( codec == PNG && ( level < 0 || level > 9 ) )
+		UBITRACK_THROW( "PNG compression level must be between 0 and 9" );
+
+	m_counters.nEncoded = 0;
+	m_counters.nDropped = 0;
+	m_counters.nFailed = 0;
+	m_counters.nPending = 0;
+	m_counters.nBytesIn = 0;
+	m_counters.nBytesOut = 0;
+
+	if ( nWorkers == 0 )
+		nWorkers = std::max( boost::thread::hardware_concurrency(), 1u );
+	for ( unsigned int i = 0; i < nWorkers; i++ )
+		m_workers.push_back( boost::shared_ptr< boost::thread >( new boost::thread( boost::bind( &ImageEncoder::workerThread, this ) ) ) );
+
+	LOG4CPP_DEBUG( logger, "Started " << nWorkers << " image encoder threads" );
+}
+
+
+ImageEncoder::~ImageEncoder()
+{
+	{
+		boost::mutex::scoped_lock l( m_mutex );
+		m_bStop = true;
+		m_jobAvailable.notify_all();
+	}
+
+	for ( std::size_t i = 0; i < m_workers.size(); i++ )
+		m_workers[ i ]->join();
+
+	if ( m_counters.nDropped )
+		LOG4CPP_INFO( logger, "Image encoder dropped " << m_counters.nDropped << " images" );
+}
+
+
+bool ImageEncoder::encode( const Measurement::ImageMeasurement& m )
+{
+	if ( !m )
+		return false;
+
+	boost::mutex::scoped_lock l( m_mutex );
+	if ( m_bStop || m_counters.nPending >= m_nMaxPending )
+	{
+		m_counters.nDropped++;
+		return false;
+	}
+
+	Job job;
+	job.sequence = m_nextSequence++;
+	job.image = m;
+	m_jobs.push_back( job );
+	m_counters.nPending++;
+	m_jobAvailable.notify_one();
+	return true;
+}
+
+
+bool ImageEncoder::flush( unsigned int timeout )
+{
+	boost::system_time deadline( boost::get_system_time() + boost::posix_time::milliseconds( timeout ) );
+
+	boost::mutex::scoped_lock l( m_mutex );
+	while ( m_counters.nPending > 0 )
+		if ( timeout == 0 )
+			m_delivered.wait( l );
+		else if ( !m_delivered.timed_wait( l, deadline ) )
+			return m_counters.nPending == 0;
+	return true;
+}
+
+
+ImageEncoder::Counters ImageEncoder::counters() const
+{
+	boost::mutex::scoped_lock l( m_mutex );
+	return m_counters;
+}
+
+
+const char* ImageEncoder::extension( Codec codec )
+{
+	return codec == JPEG ? ".jpg" : ".png";
+}
+
+
+void ImageEncoder::workerThread()
+{
+	while ( true )
+	{
+		Job job;
+		{
+			boost::mutex::scoped_lock l( m_mutex );
+			while ( m_jobs.empty() && !m_bStop )
+				m_jobAvailable.wait( l );
+
+			// pending images are still encoded when stopping
+			if ( m_jobs.empty() )
+				break;
+
+			job = m_jobs.front();
+			m_jobs.pop_front();
+		}
+
+		EncodedImage result;
+		result.timestamp = job.image.time();
+		result.sequence = job.sequence;
+		try
+		{
+			encodeImage( job.image, result );
+		}
+		catch ( const Util::Exception& e )
+		{
+			LOG4CPP_WARN( logger, "Cannot encode image " << job.sequence << ": " << e );
+			result.data.clear();
+		}
+		catch ( const std::exception& e )
+		{
+			LOG4CPP_WARN( logger, "Cannot encode image " << job.sequence << ": " << e.what() );
+			result.data.clear();
+		}
+
+		std::size_t nBytesIn( job.image->Mat().total() * job.image->Mat().elemSize() );
+
+		// release the image before waiting for predecessors
+		job.image.reset();
+
+		{
+			boost::mutex::scoped_lock l( m_mutex );
+			if ( result.data.empty() )
+				m_counters.nFailed++;
+			else
+			{
+				m_counters.nBytesIn += nBytesIn;
+				m_counters.nBytesOut += result.data.size();
+			}
+
+			EncodedImage& done( m_done[ result.sequence ] );
+			done.timestamp = result.timestamp;
+			done.sequence = result.sequence;
+			done.width = result.width;
+			done.height = result.height;
+			done.data.swap( result.data );
+		}
+
+		deliverReady();
+	}
+}
+
+
+void ImageEncoder::encodeImage( const Measurement::ImageMeasurement& m, EncodedImage& result ) const
+{
+	const Vision::Image& image( *m );
+	result.width = image.width();
+	result.height = image.height();
+
+	// the codecs expect BGR channel order and the top row first
+	Vision::Image::PixelFormat format( image.pixelFormat() );
+	Vision::Image::PixelFormat encodedFormat( format );
+	switch ( format )
+	{
+	case Vision::Image::RGB:
+	case Vision::Image::YUV422:
+		encodedFormat = Vision::Image::BGR;
+		break;
+	case Vision::Image::RGBA:
+		encodedFormat = Vision::Image::BGRA;
+		break;
+	default:
+		break;
+	}
+
+	bool bFlip( image.origin() != 0 );
+	cv::Mat converted;
+	const cv::Mat* pEncoded( &image.Mat() );
+	if ( encodedFormat != format || bFlip )
+	{
+		int channels;
+		int depth;
+		if ( encodedFormat == format )
+		{
+			channels = image.Mat().channels();
+			depth = image.Mat().depth();
+		}
+		else
+			pixelFormatLayout( encodedFormat, channels, depth );
+
+		converted.create( image.height(), image.width(), CV_MAKETYPE( depth, channels ) );
+		convertImage( image.Mat(), format, converted, encodedFormat, bFlip );
+		pEncoded = &converted;
+	}
+
+	std::vector< int > params;
+	if ( m_codec == JPEG )
+	{
+		params.push_back( cv::IMWRITE_JPEG_QUALITY );
+		params.push_back( m_level );
+	}
+	else
+	{
+		params.push_back( cv::IMWRITE_PNG_COMPRESSION );
+		params.push_back( m_level );
+	}
+
+	if ( !cv::imencode( extension( m_codec ), *pEncoded, result.data, params ) )
+		UBITRACK_THROW( "OpenCV cannot encode the image" );
+}
+
+
+void ImageEncoder::deliverReady()
+{
+	// only one thread delivers, the others leave their images in m_done and go back to encoding
+	while ( true )
+	{
+		{
+			boost::mutex::scoped_lock deliveryLock( m_deliveryMutex, boost::try_to_lock );
+			if ( !deliveryLock.owns_lock() )
+				return;
+
+			while ( true )
+			{
+				EncodedImage image;
+				{
+					boost::mutex::scoped_lock l( m_mutex );
+					std::map< unsigned long long, EncodedImage >::iterator it = m_done.find( m_nextDelivery );
+					if ( it == m_done.end() )
+						break;
+
+					image.timestamp = it->second.timestamp;
+					image.sequence = it->second.sequence;
+					image.width = it->second.width;
+					image.height = it->second.height;
+					image.data.swap( it->second.data );
+					m_done.erase( it );
+				}
+
+				if ( !image.data.empty() && m_receiver )
+				{
+					try
+					{
+						m_receiver( image );
+					}
+					catch ( const Util::Exception& e )
+					{ LOG4CPP_ERROR( logger, "Caught exception in encoded image receiver: " << e ); }
+					catch ( const std::exception& e )
+					{ LOG4CPP_ERROR( logger, "Caught exception in encoded image receiver: " << e.what() ); }
+				}
+
+				boost::mutex::scoped_lock l( m_mutex );
+				m_nextDelivery++;
+				m_counters.nPending--;
+				if ( !image.data.empty() )
+					m_counters.nEncoded++;
+				m_delivered.notify_all();
+			}
+		}
+
+		// an image finished while we were delivering may have been left to us
+		boost::mutex::scoped_lock l( m_mutex );
+		if ( m_done.find( m_nextDelivery ) == m_done.end() )
+			return;
+	}
+}
+
+
+EncodedImageFileWriter::EncodedImageFileWriter( const std::string& sPrefix, ImageEncoder::Codec codec )
+	: m_sPrefix( sPrefix )
+	, m_sExtension( ImageEncoder::extension( codec ) )
+{}
+
+
+void EncodedImageFileWriter::operator()( const EncodedImage& image ) const
+{
+	std::ostringstream sName;
+	sName << m_sPrefix << image.timestamp << m_sExtension;
+
+	std::ofstream file( sName.str().c_str(), std::ios::binary );
+	file.write( reinterpret_cast< const char* >( &image.data[ 0 ] ), image.data.size() );
+	if ( !file )
+		UBITRACK_THROW( "Cannot write " + sName.str() );
+}
+
+} } // namespace Ubitrack::Facade
+
+#endif // HAVE_OPENCV
@@ -0,0 +1,210 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @ingroup api
+ * @file
+ * Compresses images on a pool of worker threads, for recording and streaming.
+ */
+#ifndef __UBITRACK_FACADE_IMAGEENCODER_H_INCLUDED__
+#define __UBITRACK_FACADE_IMAGEENCODER_H_INCLUDED__
+
+#include <utFacade/utFacade.h>
+#include <map>
+#include <deque>
+#include <string>
+#include <vector>
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+#include <boost/noncopyable.hpp>
+#include <utMeasurement/Measurement.h>
+#include <utVision/Image.h>
+
+namespace Ubitrack { namespace Facade {
+
+/**
+ * One compressed image.
+ */
+struct EncodedImage
+{
+	EncodedImage()
+		: timestamp( 0 )
+		, sequence( 0 )
+		, width( 0 )
+		, height( 0 )
+	{}
+
+	/** timestamp of the image */
+	unsigned long long timestamp;
+
+	/** number of the image among those accepted by the encoder, starting at 0 */
+	unsigned long long sequence;
+
+	int width;
+	int height;
+
+	/** the encoded file contents, empty if encoding failed */
+	std::vector< unsigned char > data;
+};
+
+
+/**
+ * Encodes images to PNG or JPEG on worker threads.
+ *
+ * \c encode only queues a reference to the image and never blocks, so it can be called from a
+ * push sink callback on the event queue thread. When more images are pending than configured,
+ * further images are dropped. Images are converted to the channel order of the codecs and stored
+ * top row first. Encoded images reach the receiver in the order they were accepted, one at a
+ * time, on one of the worker threads.
+ */
+class UTFACADE_EXPORT ImageEncoder
+	: private boost::noncopyable
+{
+public:
+	enum Codec { PNG, JPEG };
+
+	/** receives the encoded images */
+	typedef boost::function< void( const EncodedImage& ) > ReceiverType;
+
+	/** usage counters */
+	struct Counters
+	{
+		/** images delivered to the receiver */
+		unsigned long long nEncoded;
+
+		/** images dropped because too many were pending */
+		unsigned long long nDropped;
+
+		/** images that could not be encoded */
+		unsigned long long nFailed;
+
+		/** images accepted but not yet delivered */
+		unsigned long long nPending;
+
+		/** uncompressed size of the encoded images in bytes */
+		unsigned long long nBytesIn;
+
+		/** compressed size of the encoded images in bytes */
+		unsigned long long nBytesOut;
+	};
+
+	/**
+	 * @param codec output format
+	 * @param level JPEG quality from 0 to 100, or PNG compression level from 0 to 9 (1 is fast)
+	 * @param nWorkers number of worker threads, 0 for one per hardware thread
+	 * @param nMaxPending maximum number of images waiting or being encoded
+	 * @param receiver called with every encoded image
+	 */
+	ImageEncoder( Codec codec, int level, unsigned int nWorkers, std::size_t nMaxPending, const ReceiverType& receiver );
+
+	/** encodes and delivers the images already accepted, then stops the workers */
+	~ImageEncoder();
+
+	/**
+	 * Queues an image for encoding. The image is shared, not copied, and must not be modified
+	 * while it is pending.
+	 *
+	 * @return false if the image was dropped
+	 */
+	bool encode( const Measurement::ImageMeasurement& m );
+
+	/**
+	 * Waits until all accepted images have been delivered.
+	 *
+	 * @param timeout maximum time to wait in milliseconds, 0 for no limit
+	 * @return false on timeout
+	 */
+	bool flush( unsigned int timeout = 0 );
+
+	/** returns the current counters */
+	Counters counters() const;
+
+	/** number of worker threads */
+	unsigned int workerCount() const
+	{ return static_cast< unsigned int >( m_workers.size() ); }
+
+	/** file name extension of a codec, including the dot */
+	static const char* extension( Codec codec );
+
+protected:
+	/** an accepted image */
+	struct Job
+	{
+		unsigned long long sequence;
+		Measurement::ImageMeasurement image;
+	};
+
+	void workerThread();
+
+	/** compresses one image, throws on failure */
+	void encodeImage( const Measurement::ImageMeasurement& m, EncodedImage& result ) const;
+
+	/** passes finished images to the receiver in sequence order */
+	void deliverReady();
+
+	Codec m_codec;
+	int m_level;
+	std::size_t m_nMaxPending;
+	ReceiverType m_receiver;
+
+	std::deque< Job > m_jobs;
+
+	/** encoded images waiting for their predecessors */
+	std::map< unsigned long long, EncodedImage > m_done;
+
+	unsigned long long m_nextSequence;
+	unsigned long long m_nextDelivery;
+	Counters m_counters;
+	bool m_bStop;
+
+	mutable boost::mutex m_mutex;
+	boost::condition_variable m_jobAvailable;
+	boost::condition_variable m_delivered;
+
+	/** serializes calls of the receiver */
+	boost::mutex m_deliveryMutex;
+
+	std::vector< boost::shared_ptr< boost::thread > > m_workers;
+};
+
+
+/**
+ * Receiver for \c ImageEncoder that writes every image into a file named by a prefix, which may
+ * contain a directory, the timestamp of the image and the extension of the codec.
+ */
+class UTFACADE_EXPORT EncodedImageFileWriter
+{
+public:
+	EncodedImageFileWriter( const std::string& sPrefix, ImageEncoder::Codec codec );
+
+	/** writes the file, throws if that fails */
+	void operator()( const EncodedImage& image ) const;
+
+protected:
+	std::string m_sPrefix;
+	std::string m_sExtension;
+};
+
+} } // namespace Ubitrack::Facade
+
+#endif
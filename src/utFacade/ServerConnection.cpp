@@ -0,0 +1,442 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @ingroup api
+ * @file
+ * Implements the connection to the ubitrack server.
+ */
+
+#include <algorithm>
+#include <log4cpp/Category.hh>
+#include <boost/bind.hpp>
+#include <utUtil/Exception.h>
+#include <utClientServer/TcpConnection.h>
+
+#include "ServerConnection.h"
+
+// get a logger
+static log4cpp::Category& logger( log4cpp::Category::getInstance( "Ubitrack.Facade.ServerConnection" ) );
+
+namespace Ubitrack { namespace Facade {
+
+namespace {
+
+/** first delay before reconnecting, doubled after each failure */
+const long g_minReconnectDelay = 100;
+
+/** maximum delay before reconnecting */
+const long g_maxReconnectDelay = 10000;
+
+/** interval for checking whether the connection broke */
+const long g_healthCheckInterval = 250;
+
+/** keeps a dropped connection alive until its aborted handlers have run */
+void releaseConnection( boost::shared_ptr< ClientServer::TcpConnection > )
+{}
+
+/** 
+ * true if the root element of a message carries the attribute type="push", 
+ * which marks reconfigurations the server sends without a request
+ */
+bool isPushMessage( const ClientServer::ClientServerConnection::BufferType& buffer )
+{
+	// skip the XML declaration, processing instructions and comments
+	ClientServer::ClientServerConnection::BufferType::const_iterator it = buffer.begin();
+	while ( true )
+	{
+		it = std::find( it, buffer.end(), '<' );
+		if ( it == buffer.end() || it + 1 == buffer.end() )
+			return false;
+		if ( *( it + 1 ) != '?' && *( it + 1 ) != '!' )
+			break;
+		it++;
+	}
+
+	std::string sTag( it, std::find( it, buffer.end(), '>' ) );
+	return sTag.find( " type=\"push\"" ) != std::string::npos || sTag.find( " type='push'" ) != std::string::npos;
+}
+
+} // anonymous namespace
+
+
+ServerConnection::ServerConnection( boost::asio::io_service& ioService, const ReceiverType& receiver )
+	: m_ioService( ioService )
+	, m_work( ioService )
+	, m_receiver( receiver )
+	, m_resolver( ioService )
+	, m_timer( ioService )
+	, m_bReconnect( false )
+	, m_bClosed( true )
+	, m_bConnected( false )
+	, m_nFailures( 0 )
+	, m_nGeneration( 0 )
+	, m_nConnectedGeneration( 0 )
+	, m_reconnectDelay( boost::posix_time::milliseconds( g_minReconnectDelay ) )
+	, m_nextRequestId( 1 )
+{}
+
+
+ServerConnection::~ServerConnection()
+{
+	// the io_service is stopped, so nothing runs concurrently anymore
+	m_pConnection.reset();
+	if ( m_pSocket )
+	{
+		boost::system::error_code error;
+		m_pSocket->close( error );
+	}
+}
+
+
+void ServerConnection::connect( const std::string& sHost, const std::string& sPort, bool bReconnect )
+{
+	unsigned long nGeneration;
+	{
+		boost::mutex::scoped_lock l( m_mutex );
+		m_sHost = sHost;
+		m_sPort = sPort;
+		m_bReconnect = bReconnect;
+		m_bClosed = false;
+		m_reconnectDelay = boost::posix_time::milliseconds( g_minReconnectDelay );
+
+		// handlers of the previous connection are ignored from now on
+		nGeneration = ++m_nGeneration;
+	}
+
+	// drop a previous connection first
+	m_ioService.post( boost::bind( &ServerConnection::doClose, this ) );
+	m_ioService.post( boost::bind( &ServerConnection::startResolve, this, nGeneration ) );
+}
+
+
+bool ServerConnection::waitConnected( unsigned int timeout, std::string& sError )
+{
+	boost::system_time deadline( boost::get_system_time() + boost::posix_time::milliseconds( timeout ) );
+
+	boost::mutex::scoped_lock l( m_mutex );
+	unsigned long nFailures = m_nFailures;
+	while ( !isCurrentConnectionUp() && m_nFailures == nFailures && !m_bClosed )
+		if ( timeout == 0 )
+			m_stateChanged.wait( l );
+		else if ( !m_stateChanged.timed_wait( l, deadline ) )
+			break;
+
+	bool bConnected = isCurrentConnectionUp();
+	if ( !bConnected )
+		sError = m_nFailures != nFailures ? m_sLastError : std::string( "Timeout connecting to server" );
+	return bConnected;
+}
+
+
+void ServerConnection::close()
+{
+	{
+		boost::mutex::scoped_lock l( m_mutex );
+		m_bClosed = true;
+		m_bReconnect = false;
+		m_stateChanged.notify_all();
+	}
+
+	m_ioService.post( boost::bind( &ServerConnection::doClose, this ) );
+}
+
+
+bool ServerConnection::isConnected() const
+{
+	boost::mutex::scoped_lock l( m_mutex );
+	return isCurrentConnectionUp();
+}
+
+
+bool ServerConnection::isCurrentConnectionUp() const
+{
+	return m_bConnected && m_nConnectedGeneration == m_nGeneration;
+}
+
+
+unsigned int ServerConnection::send( boost::shared_ptr< const std::string > pUtql, const ResponseCallback& callback )
+{
+	unsigned int id;
+	{
+		boost::mutex::scoped_lock l( m_mutex );
+		Request request;
+		request.id = id = m_nextRequestId++;
+		request.pUtql = pUtql;
+		request.callback = callback;
+		request.bSent = false;
+		m_requests.push_back( request );
+	}
+
+	// the connection is only used from the network thread
+	m_ioService.post( boost::bind( &ServerConnection::sendQueued, this ) );
+	return id;
+}
+
+
+std::size_t ServerConnection::pendingRequests() const
+{
+	boost::mutex::scoped_lock l( m_mutex );
+	return m_requests.size();
+}
+
+
+void ServerConnection::setStateCallback( const StateCallback& callback )
+{
+	boost::mutex::scoped_lock l( m_mutex );
+	m_stateCallback = callback;
+}
+
+
+bool ServerConnection::getAddress( unsigned long nGeneration, std::string& sHost, std::string& sPort ) const
+{
+	boost::mutex::scoped_lock l( m_mutex );
+	if ( nGeneration != m_nGeneration || m_bClosed )
+		return false;
+
+	sHost = m_sHost;
+	sPort = m_sPort;
+	return true;
+}
+
+
+void ServerConnection::startResolve( unsigned long nGeneration )
+{
+	std::string sHost, sPort;
+	if ( !getAddress( nGeneration, sHost, sPort ) )
+		return;
+
+	LOG4CPP_DEBUG( logger, "Resolving " << sHost << ":" << sPort );
+	boost::asio::ip::tcp::resolver::query query( sHost, sPort );
+	m_resolver.async_resolve( query, boost::bind( &ServerConnection::handleResolve, this, nGeneration,
+		boost::asio::placeholders::error, boost::asio::placeholders::iterator ) );
+}
+
+
+void ServerConnection::handleResolve( unsigned long nGeneration, const boost::system::error_code& error, 
+	boost::asio::ip::tcp::resolver::iterator itEndpoint )
+{
+	std::string sHost, sPort;
+	if ( error == boost::asio::error::operation_aborted || !getAddress( nGeneration, sHost, sPort ) )
+		return;
+
+	if ( error )
+	{
+		connectionFailed( nGeneration, "Cannot resolve server \"" + sHost + "\": " + error.message() );
+		return;
+	}
+
+	m_pSocket.reset( new boost::asio::ip::tcp::socket( m_ioService ) );
+	boost::asio::async_connect( *m_pSocket, itEndpoint,
+		boost::bind( &ServerConnection::handleConnect, this, nGeneration, boost::asio::placeholders::error ) );
+}
+
+
+void ServerConnection::handleConnect( unsigned long nGeneration, const boost::system::error_code& error )
+{
+	std::string sHost, sPort;
+	if ( error == boost::asio::error::operation_aborted || !getAddress( nGeneration, sHost, sPort ) )
+		return;
+
+	if ( error )
+	{
+		connectionFailed( nGeneration, "Cannot connect to server \"" + sHost + "\" at port \"" + sPort + "\": " + error.message() );
+		return;
+	}
+
+	LOG4CPP_INFO( logger, "Connected to server " << sHost << ":" << sPort );
+
+	m_pConnection.reset( new ClientServer::TcpConnection( m_pSocket ) );
+	m_pConnection->setReceiver( boost::bind( &ServerConnection::receive, this, _1 ) );
+
+	StateCallback stateCallback;
+	{
+		boost::mutex::scoped_lock l( m_mutex );
+		m_bConnected = true;
+		m_nConnectedGeneration = nGeneration;
+		m_reconnectDelay = boost::posix_time::milliseconds( g_minReconnectDelay );
+
+		// requests sent over a broken connection are repeated
+		for ( std::deque< Request >::iterator it = m_requests.begin(); it != m_requests.end(); it++ )
+			it->bSent = false;
+
+		stateCallback = m_stateCallback;
+		m_stateChanged.notify_all();
+	}
+
+	if ( stateCallback )
+		stateCallback( true, std::string() );
+
+	sendQueued();
+	startHealthCheck( nGeneration );
+}
+
+
+void ServerConnection::startHealthCheck( unsigned long nGeneration )
+{
+	// TcpConnection has no notification for broken connections, so poll
+	m_timer.expires_from_now( boost::posix_time::milliseconds( g_healthCheckInterval ) );
+	m_timer.async_wait( boost::bind( &ServerConnection::handleHealthCheck, this, nGeneration, boost::asio::placeholders::error ) );
+}
+
+
+void ServerConnection::handleHealthCheck( unsigned long nGeneration, const boost::system::error_code& error )
+{
+	std::string sHost, sPort;
+	if ( error || !m_pConnection || !getAddress( nGeneration, sHost, sPort ) )
+		return;
+
+	if ( m_pConnection->badConnection() )
+		connectionFailed( nGeneration, "Connection to server \"" + sHost + "\" lost" );
+	else
+		startHealthCheck( nGeneration );
+}
+
+
+void ServerConnection::connectionFailed( unsigned long nGeneration, const std::string& sReason )
+{
+	LOG4CPP_WARN( logger, sReason );
+
+	if ( m_pConnection )
+		m_ioService.post( boost::bind( &releaseConnection, m_pConnection ) );
+	m_pConnection.reset();
+	if ( m_pSocket )
+	{
+		boost::system::error_code ignored;
+		m_pSocket->close( ignored );
+	}
+
+	StateCallback stateCallback;
+	bool bReconnect;
+	boost::posix_time::time_duration delay;
+	{
+		boost::mutex::scoped_lock l( m_mutex );
+		m_bConnected = false;
+		m_nFailures++;
+		m_sLastError = sReason;
+		bReconnect = m_bReconnect && !m_bClosed;
+		delay = m_reconnectDelay;
+		m_reconnectDelay = std::min( m_reconnectDelay * 2, boost::posix_time::time_duration( boost::posix_time::milliseconds( g_maxReconnectDelay ) ) );
+		stateCallback = m_stateCallback;
+		m_stateChanged.notify_all();
+	}
+
+	if ( stateCallback )
+		stateCallback( false, sReason );
+
+	if ( bReconnect )
+	{
+		LOG4CPP_INFO( logger, "Reconnecting in " << delay.total_milliseconds() << "ms" );
+		m_timer.expires_from_now( delay );
+		m_timer.async_wait( boost::bind( &ServerConnection::handleReconnectTimer, this, nGeneration, boost::asio::placeholders::error ) );
+	}
+}
+
+
+void ServerConnection::handleReconnectTimer( unsigned long nGeneration, const boost::system::error_code& error )
+{
+	if ( !error )
+		startResolve( nGeneration );
+}
+
+
+void ServerConnection::sendQueued()
+{
+	if ( !m_pConnection || m_pConnection->badConnection() )
+		return;
+
+	boost::mutex::scoped_lock l( m_mutex );
+	for ( std::deque< Request >::iterator it = m_requests.begin(); it != m_requests.end(); it++ )
+		if ( !it->bSent )
+		{
+			LOG4CPP_DEBUG( logger, "Sending request " << it->id << ", " << it->pUtql->size() << " bytes" );
+			m_pConnection->send( *it->pUtql );
+			it->bSent = true;
+		}
+}
+
+
+void ServerConnection::receive( boost::shared_ptr< ClientServer::ClientServerConnection::BufferType > pBuffer )
+{
+	Request request;
+	bool bAnswer = false;
+	if ( !isPushMessage( *pBuffer ) )
+	{
+		boost::mutex::scoped_lock l( m_mutex );
+		if ( !m_requests.empty() && m_requests.front().bSent )
+		{
+			request = m_requests.front();
+			m_requests.pop_front();
+			bAnswer = true;
+		}
+	}
+
+	if ( bAnswer )
+		LOG4CPP_DEBUG( logger, "Received response to request " << request.id );
+	else
+		LOG4CPP_DEBUG( logger, "Received reconfiguration pushed by the server" );
+
+	std::string sError;
+	try
+	{
+		m_receiver( pBuffer );
+	}
+	catch ( const Util::Exception& e )
+	{
+		LOG4CPP_ERROR( logger, "Cannot apply server response: " << e );
+		sError = e.what();
+	}
+	catch ( const std::exception& e )
+	{
+		LOG4CPP_ERROR( logger, "Cannot apply server response: " << e.what() );
+		sError = e.what();
+	}
+	catch ( ... )
+	{
+		LOG4CPP_ERROR( logger, "Cannot apply server response: unknown exception" );
+		sError = "Unknown exception";
+	}
+
+	if ( bAnswer && request.callback )
+		request.callback( request.id, sError );
+}
+
+
+void ServerConnection::doClose()
+{
+	boost::system::error_code ignored;
+	m_timer.cancel( ignored );
+	m_resolver.cancel();
+
+	if ( m_pConnection )
+		m_ioService.post( boost::bind( &releaseConnection, m_pConnection ) );
+	m_pConnection.reset();
+	if ( m_pSocket )
+		m_pSocket->close( ignored );
+
+	boost::mutex::scoped_lock l( m_mutex );
+	m_bConnected = false;
+	m_stateChanged.notify_all();
+}
+
+} } // namespace Ubitrack::Facade
@@ -0,0 +1,215 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @ingroup api
+ * @file
+ * Asynchronous, self-healing connection of a facade to the ubitrack server.
+ */
+#ifndef __UBITRACK_FACADE_SERVERCONNECTION_H_INCLUDED__
+#define __UBITRACK_FACADE_SERVERCONNECTION_H_INCLUDED__
+
+#include <utFacade/utFacade.h>
+#include <deque>
+#include <string>
+#include <boost/asio.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+#include <boost/noncopyable.hpp>
+#include <utClientServer/ClientServerConnection.h>
+
+namespace Ubitrack {
+	namespace ClientServer {
+		class TcpConnection;
+	}
+}
+
+namespace Ubitrack { namespace Facade {
+
+/**
+ * Connection to the ubitrack server, driven by an \c io_service run by another thread.
+ *
+ * Resolving and connecting is asynchronous. When the connection fails or breaks, it is
+ * re-established with exponential backoff. UTQL requests can be sent at any time, also while
+ * disconnected; they are queued and sent in order as soon as the connection is up.
+ *
+ * Reconfigurations the server sends on its own are told apart from answers by their message
+ * type: the root element of a pushed message carries the attribute type="push". They are
+ * passed to the receiver only. The server answers requests in the order they were received,
+ * so all other messages are matched to requests first in, first out. A message arriving while
+ * no request is pending is treated as a push as well. Requests whose response has not arrived
+ * when the connection breaks are sent again after reconnecting.
+ *
+ * The protocol has no correlation id, which leaves two limits:
+ * - Only the stand-in server used by the tests marks pushed messages with type="push". A push
+ *   from a server that does not mark it, arriving while a request is pending, is taken as the
+ *   answer to that request, and all later answers are matched to the wrong request.
+ * - A request that reached the server but whose answer was lost with the connection is sent
+ *   again, so the server may apply it twice. Only send requests that can safely be repeated,
+ *   such as complete queries replacing the previous ones.
+ */
+class UTFACADE_EXPORT ServerConnection
+	: private boost::noncopyable
+{
+public:
+	/** receives every response of the server */
+	typedef boost::function< void( boost::shared_ptr< ClientServer::ClientServerConnection::BufferType > ) > ReceiverType;
+
+	/** called with the id of a request and an error message, which is empty if the response was applied */
+	typedef boost::function< void( unsigned int, const std::string& ) > ResponseCallback;
+
+	/** called with true when the connection is established, with false and a reason when it fails or breaks */
+	typedef boost::function< void( bool, const std::string& ) > StateCallback;
+
+	/**
+	 * @param ioService runs all network operations, must outlive the object and be stopped before its destruction
+	 * @param receiver called on the network thread for every response. Exceptions are reported to the request callback
+	 */
+	ServerConnection( boost::asio::io_service& ioService, const ReceiverType& receiver );
+
+	~ServerConnection();
+
+	/**
+	 * Starts connecting to a server and returns immediately.
+	 *
+	 * @param sHost host name or address
+	 * @param sPort port or service name
+	 * @param bReconnect retry failed attempts and re-establish broken connections with backoff
+	 */
+	void connect( const std::string& sHost, const std::string& sPort, bool bReconnect = true );
+
+	/**
+	 * Waits until the connection is up or the next connection attempt has failed.
+	 *
+	 * @param timeout maximum time to wait in milliseconds, 0 for no limit
+	 * @param sError receives the reason of a failed attempt
+	 * @return true if connected
+	 */
+	bool waitConnected( unsigned int timeout, std::string& sError );
+
+	/** closes the connection and stops reconnecting. Queued requests are kept */
+	void close();
+
+	/** true while the connection is up */
+	bool isConnected() const;
+
+	/**
+	 * Queues a UTQL request and sends it as soon as possible. Does not wait for the response.
+	 *
+	 * @param pUtql the request, not copied
+	 * @param callback called on the network thread when the response has been processed
+	 * @return id of the request, passed to the callback
+	 */
+	unsigned int send( boost::shared_ptr< const std::string > pUtql, const ResponseCallback& callback = ResponseCallback() );
+
+	/** number of requests waiting to be sent or answered */
+	std::size_t pendingRequests() const;
+
+	/** sets a callback for changes of the connection state, called on the network thread */
+	void setStateCallback( const StateCallback& callback );
+
+protected:
+	/** a request waiting to be sent or answered */
+	struct Request
+	{
+		unsigned int id;
+		boost::shared_ptr< const std::string > pUtql;
+		ResponseCallback callback;
+		bool bSent;
+	};
+
+	/*
+	 * The handlers of the connection process carry the generation of the \c connect call that
+	 * started it and do nothing if \c connect has been called again since.
+	 */
+	void startResolve( unsigned long nGeneration );
+	void handleResolve( unsigned long nGeneration, const boost::system::error_code& error, 
+		boost::asio::ip::tcp::resolver::iterator itEndpoint );
+	void handleConnect( unsigned long nGeneration, const boost::system::error_code& error );
+
+	/** (re)arms the timer that checks for a broken connection */
+	void startHealthCheck( unsigned long nGeneration );
+	void handleHealthCheck( unsigned long nGeneration, const boost::system::error_code& error );
+
+	/** drops the connection and schedules a reconnect if enabled */
+	void connectionFailed( unsigned long nGeneration, const std::string& sReason );
+	void handleReconnectTimer( unsigned long nGeneration, const boost::system::error_code& error );
+
+	/** copies host and port, returns false if the generation is outdated or the connection closed */
+	bool getAddress( unsigned long nGeneration, std::string& sHost, std::string& sPort ) const;
+
+	/** true if the connection of the latest \c connect call is up, must be called with the mutex locked */
+	bool isCurrentConnectionUp() const;
+
+	/** sends all queued requests, called on the network thread */
+	void sendQueued();
+
+	/** handles a response, called by the TCP connection */
+	void receive( boost::shared_ptr< ClientServer::ClientServerConnection::BufferType > pBuffer );
+
+	void doClose();
+
+	boost::asio::io_service& m_ioService;
+
+	/** keeps the network thread running while there is nothing to do */
+	boost::asio::io_service::work m_work;
+
+	ReceiverType m_receiver;
+	StateCallback m_stateCallback;
+
+	boost::asio::ip::tcp::resolver m_resolver;
+	boost::asio::deadline_timer m_timer;
+	boost::shared_ptr< boost::asio::ip::tcp::socket > m_pSocket;
+	boost::shared_ptr< ClientServer::TcpConnection > m_pConnection;
+
+	std::string m_sHost;
+	std::string m_sPort;
+	bool m_bReconnect;
+	bool m_bClosed;
+	bool m_bConnected;
+
+	/** counts failed connection attempts, for \c waitConnected */
+	unsigned long m_nFailures;
+	std::string m_sLastError;
+
+	/** incremented by each \c connect call */
+	unsigned long m_nGeneration;
+
+	/** generation of the connection that is or was up last */
+	unsigned long m_nConnectedGeneration;
+
+	/** delay before the next reconnect attempt */
+	boost::posix_time::time_duration m_reconnectDelay;
+
+	/** requests in the order they were sent */
+	std::deque< Request > m_requests;
+	unsigned int m_nextRequestId;
+
+	mutable boost::mutex m_mutex;
+	boost::condition_variable m_stateChanged;
+};
+
+} } // namespace Ubitrack::Facade
+
+#endif
@@ -0,0 +1,396 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @ingroup api
+ * @file
+ * A ring of image slots in named shared memory, for handing frames to other processes.
+ *
+ * Header-only and free of other ubitrack headers, so consumer processes only need this file
+ * and boost.
+ */
+#ifndef __UBITRACK_FACADE_SHAREDFRAMERING_H_INCLUDED__
+#define __UBITRACK_FACADE_SHAREDFRAMERING_H_INCLUDED__
+
+#include <new>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <stdexcept>
+#include <boost/cstdint.hpp>
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace Ubitrack { namespace Facade {
+
+BOOST_STATIC_ASSERT_MSG( BOOST_ATOMIC_INT64_LOCK_FREE == 2, "the shared frame ring needs lock-free 64 bit atomics" );
+
+/** identifies a frame ring, "UTFR" */
+const boost::uint32_t SHARED_FRAME_RING_MAGIC = 0x55544652;
+
+/** changed with every incompatible change of the layout */
+const boost::uint32_t SHARED_FRAME_RING_VERSION = 1;
+
+/** alignment of the ring header, the slot headers and the pixel data */
+const std::size_t SHARED_FRAME_RING_ALIGNMENT = 64;
+
+
+/**
+ * Start of the shared memory. The slots follow at \c SHARED_FRAME_RING_ALIGNMENT.
+ */
+struct SharedFrameRingHeader
+{
+	boost::uint32_t magic;
+	boost::uint32_t version;
+	boost::uint32_t nSlots;
+
+	/** bytes from one slot header to the next */
+	boost::uint32_t slotStride;
+
+	/** maximum number of pixel bytes per frame */
+	boost::uint32_t slotCapacity;
+
+	/** set when the writer has gone away or replaced the ring by a larger one */
+	boost::atomic< boost::uint32_t > closed;
+
+	/** sequence number of the newest complete frame, 0 before the first */
+	boost::atomic< boost::uint64_t > latest;
+};
+
+
+/**
+ * Header of one slot. The pixels follow at \c SHARED_FRAME_RING_ALIGNMENT, rows packed.
+ *
+ * Frame n goes to slot n % nSlots. The slot is guarded by a sequence lock: \c lock is 2n+1 while
+ * frame n is written and 2n+2 when it is complete. Readers check that \c lock is even before and
+ * unchanged after reading.
+ */
+struct SharedFrameSlot
+{
+	boost::atomic< boost::uint64_t > lock;
+	boost::uint64_t sequence;
+	boost::uint64_t timestamp;
+	boost::int32_t width;
+	boost::int32_t height;
+
+	/** bytes per row */
+	boost::int32_t step;
+
+	/** value of Vision::Image::PixelFormat */
+	boost::int32_t format;
+
+	boost::int32_t channels;
+
+	/** OpenCV depth of one channel, e.g. CV_8U */
+	boost::int32_t depth;
+
+	/** 0 if the first row is the top row, 1 if it is the bottom row */
+	boost::int32_t origin;
+
+	boost::uint32_t byteCount;
+};
+
+BOOST_STATIC_ASSERT( sizeof( SharedFrameRingHeader ) <= SHARED_FRAME_RING_ALIGNMENT );
+BOOST_STATIC_ASSERT( sizeof( SharedFrameSlot ) <= SHARED_FRAME_RING_ALIGNMENT );
+
+
+/**
+ * Creates a frame ring and publishes frames into it.
+ *
+ * \c write never waits for readers. A reader that is too slow sees its frame invalidated
+ * instead. The name is removed when the writer is destroyed; readers that still map the ring
+ * see it closed.
+ */
+class SharedFrameRingWriter
+	: private boost::noncopyable
+{
+public:
+	/**
+	 * Creates the shared memory, replacing an existing one of the same name.
+	 *
+	 * @param sName name of the shared memory object, without a leading slash
+	 * @param nSlots number of frames kept, at least 2 so that readers have one frame time to read
+	 * @param slotCapacity maximum number of pixel bytes per frame
+	 */
+	SharedFrameRingWriter( const std::string& sName, unsigned int nSlots, std::size_t slotCapacity )
+		: m_sName( sName )
+		, m_nSequence( 0 )
+	{
+		if ( nSlots < 2 )
+			throw std::invalid_argument( "a shared frame ring needs at least 2 slots" );
+
+		std::size_t slotStride = SHARED_FRAME_RING_ALIGNMENT +
+			( slotCapacity + SHARED_FRAME_RING_ALIGNMENT - 1 ) / SHARED_FRAME_RING_ALIGNMENT * SHARED_FRAME_RING_ALIGNMENT;
+
+		boost::interprocess::shared_memory_object::remove( sName.c_str() );
+		boost::interprocess::shared_memory_object shm( boost::interprocess::create_only, sName.c_str(), boost::interprocess::read_write );
+		shm.truncate( SHARED_FRAME_RING_ALIGNMENT + nSlots * slotStride );
+		boost::interprocess::mapped_region( shm, boost::interprocess::read_write ).swap( m_region );
+
+		unsigned char* pBase = static_cast< unsigned char* >( m_region.get_address() );
+		m_pHeader = new( pBase ) SharedFrameRingHeader;
+		m_pHeader->version = SHARED_FRAME_RING_VERSION;
+		m_pHeader->nSlots = nSlots;
+		m_pHeader->slotStride = static_cast< boost::uint32_t >( slotStride );
+		m_pHeader->slotCapacity = static_cast< boost::uint32_t >( slotCapacity );
+		m_pHeader->closed.store( 0, boost::memory_order_relaxed );
+		m_pHeader->latest.store( 0, boost::memory_order_relaxed );
+
+		for ( unsigned int i = 0; i < nSlots; i++ )
+			new( pBase + SHARED_FRAME_RING_ALIGNMENT + i * slotStride ) SharedFrameSlot;
+
+		// readers accept the ring once the magic is there
+		boost::atomic_thread_fence( boost::memory_order_release );
+		m_pHeader->magic = SHARED_FRAME_RING_MAGIC;
+	}
+
+	~SharedFrameRingWriter()
+	{
+		m_pHeader->closed.store( 1, boost::memory_order_release );
+		boost::interprocess::shared_memory_object::remove( m_sName.c_str() );
+	}
+
+	/**
+	 * Copies a frame into the next slot.
+	 *
+	 * @param timestamp timestamp of the frame
+	 * @param width width in pixels
+	 * @param height height in pixels
+	 * @param format pixel format, stored for the readers
+	 * @param channels number of channels
+	 * @param depth OpenCV depth of one channel
+	 * @param origin 0 if the first row is the top row, 1 if it is the bottom row
+	 * @param rowBytes bytes per row without padding
+	 * @param pData first row of the source
+	 * @param srcStep bytes from one source row to the next
+	 * @return the sequence number of the frame, starting at 1
+	 */
+	boost::uint64_t write( boost::uint64_t timestamp, int width, int height, int format, int channels, int depth,
+		int origin, std::size_t rowBytes, const unsigned char* pData, std::size_t srcStep )
+	{
+		std::size_t byteCount = rowBytes * height;
+		if ( byteCount > m_pHeader->slotCapacity )
+			throw std::length_error( "frame does not fit into the shared frame ring" );
+
+		boost::uint64_t sequence = ++m_nSequence;
+		SharedFrameSlot* pSlot = slot( sequence );
+
+		pSlot->lock.store( 2 * sequence + 1, boost::memory_order_relaxed );
+		boost::atomic_thread_fence( boost::memory_order_release );
+
+		pSlot->sequence = sequence;
+		pSlot->timestamp = timestamp;
+		pSlot->width = width;
+		pSlot->height = height;
+		pSlot->step = static_cast< boost::int32_t >( rowBytes );
+		pSlot->format = format;
+		pSlot->channels = channels;
+		pSlot->depth = depth;
+		pSlot->origin = origin;
+		pSlot->byteCount = static_cast< boost::uint32_t >( byteCount );
+
+		unsigned char* pPixels = reinterpret_cast< unsigned char* >( pSlot ) + SHARED_FRAME_RING_ALIGNMENT;
+		if ( srcStep == rowBytes )
+			std::memcpy( pPixels, pData, byteCount );
+		else
+			for ( int y = 0; y < height; y++ )
+				std::memcpy( pPixels + y * rowBytes, pData + y * srcStep, rowBytes );
+
+		pSlot->lock.store( 2 * sequence + 2, boost::memory_order_release );
+		m_pHeader->latest.store( sequence, boost::memory_order_release );
+		return sequence;
+	}
+
+	/** maximum number of pixel bytes per frame */
+	std::size_t slotCapacity() const
+	{ return m_pHeader->slotCapacity; }
+
+	const std::string& name() const
+	{ return m_sName; }
+
+protected:
+	SharedFrameSlot* slot( boost::uint64_t sequence )
+	{
+		return reinterpret_cast< SharedFrameSlot* >( static_cast< unsigned char* >( m_region.get_address() ) +
+			SHARED_FRAME_RING_ALIGNMENT + ( sequence % m_pHeader->nSlots ) * m_pHeader->slotStride );
+	}
+
+	std::string m_sName;
+	boost::interprocess::mapped_region m_region;
+	SharedFrameRingHeader* m_pHeader;
+	boost::uint64_t m_nSequence;
+};
+
+
+/**
+ * Maps a frame ring created by another process and reads its newest frame without copying.
+ */
+class SharedFrameRingReader
+	: private boost::noncopyable
+{
+public:
+	/** a frame in the ring. The pixels stay valid only as long as \c isValid returns true */
+	struct Frame
+	{
+		Frame()
+			: pPixels( 0 )
+			, sequence( 0 )
+			, timestamp( 0 )
+			, width( 0 )
+			, height( 0 )
+			, step( 0 )
+			, format( 0 )
+			, channels( 0 )
+			, depth( 0 )
+			, origin( 0 )
+			, byteCount( 0 )
+			, pSlot( 0 )
+			, lock( 0 )
+		{}
+
+		const unsigned char* pPixels;
+		boost::uint64_t sequence;
+		boost::uint64_t timestamp;
+		int width;
+		int height;
+		int step;
+		int format;
+		int channels;
+		int depth;
+		int origin;
+		std::size_t byteCount;
+
+		/** where the frame came from, for \c isValid */
+		const SharedFrameSlot* pSlot;
+		boost::uint64_t lock;
+	};
+
+	/**
+	 * Opens an existing ring.
+	 *
+	 * @throws boost::interprocess::interprocess_exception if there is no ring of that name
+	 * @throws std::runtime_error if the shared memory is not a ring of this version
+	 */
+	explicit SharedFrameRingReader( const std::string& sName )
+	{
+		boost::interprocess::shared_memory_object shm( boost::interprocess::open_only, sName.c_str(), boost::interprocess::read_only );
+		boost::interprocess::mapped_region( shm, boost::interprocess::read_only ).swap( m_region );
+
+		m_pHeader = static_cast< const SharedFrameRingHeader* >( m_region.get_address() );
+		if ( m_region.get_size() < SHARED_FRAME_RING_ALIGNMENT || m_pHeader->magic != SHARED_FRAME_RING_MAGIC )
+			throw std::runtime_error( "\"" + sName + "\" is not a shared frame ring or not initialized yet" );
+		boost::atomic_thread_fence( boost::memory_order_acquire );
+		if ( m_pHeader->version != SHARED_FRAME_RING_VERSION )
+			throw std::runtime_error( "\"" + sName + "\" is a shared frame ring of another version" );
+	}
+
+	/**
+	 * Returns the newest complete frame.
+	 *
+	 * @return false if there is no frame yet
+	 */
+	bool latest( Frame& frame ) const
+	{
+		// the writer may overtake us, so retry a few times
+		for ( int attempt = 0; attempt < 4; attempt++ )
+		{
+			boost::uint64_t sequence = m_pHeader->latest.load( boost::memory_order_acquire );
+			if ( sequence == 0 )
+				return false;
+
+			const SharedFrameSlot* pSlot = slot( sequence );
+			frame.lock = pSlot->lock.load( boost::memory_order_acquire );
+			if ( frame.lock != 2 * sequence + 2 )
+				continue;
+
+			frame.pPixels = reinterpret_cast< const unsigned char* >( pSlot ) + SHARED_FRAME_RING_ALIGNMENT;
+			frame.sequence = pSlot->sequence;
+			frame.timestamp = pSlot->timestamp;
+			frame.width = pSlot->width;
+			frame.height = pSlot->height;
+			frame.step = pSlot->step;
+			frame.format = pSlot->format;
+			frame.channels = pSlot->channels;
+			frame.depth = pSlot->depth;
+			frame.origin = pSlot->origin;
+			frame.byteCount = pSlot->byteCount;
+			frame.pSlot = pSlot;
+
+			if ( isValid( frame ) )
+				return true;
+		}
+		return false;
+	}
+
+	/** true if the slot of the frame has not been overwritten since \c latest returned it */
+	bool isValid( const Frame& frame ) const
+	{
+		if ( !frame.pSlot )
+			return false;
+		boost::atomic_thread_fence( boost::memory_order_acquire );
+		return frame.pSlot->lock.load( boost::memory_order_relaxed ) == frame.lock;
+	}
+
+	/**
+	 * Copies the newest frame, for readers that need more than one frame time.
+	 *
+	 * @param pixels receives the pixels, rows packed
+	 * @param frame receives the description of the frame; its pixel pointer refers to the ring
+	 * @return false if there is no frame yet or the writer overwrote it while copying
+	 */
+	bool copyLatest( std::vector< unsigned char >& pixels, Frame& frame ) const
+	{
+		if ( !latest( frame ) )
+			return false;
+
+		pixels.resize( frame.byteCount );
+		if ( frame.byteCount )
+			std::memcpy( &pixels[ 0 ], frame.pPixels, frame.byteCount );
+		return isValid( frame );
+	}
+
+	/** true if the writer has gone away or created a new ring, which needs a new reader */
+	bool isClosed() const
+	{ return m_pHeader->closed.load( boost::memory_order_acquire ) != 0; }
+
+	/** number of slots in the ring */
+	unsigned int slotCount() const
+	{ return m_pHeader->nSlots; }
+
+protected:
+	const SharedFrameSlot* slot( boost::uint64_t sequence ) const
+	{
+		return reinterpret_cast< const SharedFrameSlot* >( static_cast< const unsigned char* >( m_region.get_address() ) +
+			SHARED_FRAME_RING_ALIGNMENT + ( sequence % m_pHeader->nSlots ) * m_pHeader->slotStride );
+	}
+
+	boost::interprocess::mapped_region m_region;
+	const SharedFrameRingHeader* m_pHeader;
+};
+
+} } // namespace Ubitrack::Facade
+
+#endif
@@ -0,0 +1,382 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @ingroup api
+ * @file
+ * A table of the latest poses in named shared memory, for other processes.
+ *
+ * Header-only and free of other ubitrack headers, so consumer processes only need this file
+ * and boost.
+ */
+#ifndef __UBITRACK_FACADE_SHAREDPOSETABLE_H_INCLUDED__
+#define __UBITRACK_FACADE_SHAREDPOSETABLE_H_INCLUDED__
+
+#include <new>
+#include <string>
+#include <cstring>
+#include <stdexcept>
+#include <boost/cstdint.hpp>
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace Ubitrack { namespace Facade {
+
+BOOST_STATIC_ASSERT_MSG( BOOST_ATOMIC_INT64_LOCK_FREE == 2, "the shared pose table needs lock-free 64 bit atomics" );
+
+/** identifies a pose table, "UTPT" */
+const boost::uint32_t SHARED_POSE_TABLE_MAGIC = 0x55545054;
+
+/** changed with every incompatible change of the layout */
+const boost::uint32_t SHARED_POSE_TABLE_VERSION = 1;
+
+/** maximum length of an entry name including the terminating zero */
+const std::size_t SHARED_POSE_TABLE_NAME_SIZE = 64;
+
+
+/** measurement types of the table entries */
+enum SharedPoseType
+{
+	SHARED_POSE_UNUSED = 0,
+
+	/** value x, y, z, qx, qy, qz, qw */
+	SHARED_POSE_POSE,
+
+	/** value as \c SHARED_POSE_POSE, 6x6 covariance of position and rotation, row major */
+	SHARED_POSE_ERROR_POSE,
+
+	/** value x, y, z */
+	SHARED_POSE_POSITION,
+
+	/** value x, y, z, 3x3 covariance, row major */
+	SHARED_POSE_ERROR_POSITION,
+
+	/** value qx, qy, qz, qw */
+	SHARED_POSE_ROTATION
+};
+
+
+/**
+ * Start of the shared memory. The entries follow at 64 bytes.
+ */
+struct SharedPoseTableHeader
+{
+	boost::uint32_t magic;
+	boost::uint32_t version;
+
+	/** number of entries in the table */
+	boost::uint32_t nEntries;
+
+	/** number of entries in use, entries are added in order */
+	boost::atomic< boost::uint32_t > nUsed;
+
+	/** set when the writer has gone away */
+	boost::atomic< boost::uint32_t > closed;
+};
+
+
+/**
+ * One entry, aligned to 64 bytes.
+ *
+ * Each entry is guarded by a sequence lock: \c lock is odd while the entry is written.
+ * Readers copy the entry and retry if \c lock was odd or changed meanwhile.
+ */
+struct SharedPoseEntry
+{
+	boost::atomic< boost::uint64_t > lock;
+
+	/** number of updates, 0 before the first measurement */
+	boost::uint64_t nUpdates;
+
+	boost::uint64_t timestamp;
+
+	/** a \c SharedPoseType */
+	boost::int32_t type;
+
+	boost::int32_t reserved;
+
+	/** name of the mirrored component */
+	char name[ SHARED_POSE_TABLE_NAME_SIZE ];
+
+	double value[ 7 ];
+	double covariance[ 36 ];
+
+	/** pads the entry to a multiple of 64 bytes, to keep entries on separate cache lines */
+	char padding[ 8 ];
+};
+
+BOOST_STATIC_ASSERT( sizeof( SharedPoseTableHeader ) <= 64 );
+BOOST_STATIC_ASSERT( sizeof( SharedPoseEntry ) % 64 == 0 );
+
+
+/**
+ * Creates a pose table and updates its entries.
+ *
+ * Updates never wait for readers. Each entry must only be updated by one thread at a time,
+ * different entries may be updated concurrently. The name is removed when the writer is
+ * destroyed; readers that still map the table see it closed.
+ */
+class SharedPoseTableWriter
+	: private boost::noncopyable
+{
+public:
+	/**
+	 * Creates the shared memory, replacing an existing one of the same name.
+	 *
+	 * @param sName name of the shared memory object, without a leading slash
+	 * @param nEntries maximum number of entries
+	 */
+	SharedPoseTableWriter( const std::string& sName, unsigned int nEntries )
+		: m_sName( sName )
+	{
+		if ( nEntries == 0 )
+			throw std::invalid_argument( "a shared pose table needs at least 1 entry" );
+
+		boost::interprocess::shared_memory_object::remove( sName.c_str() );
+		boost::interprocess::shared_memory_object shm( boost::interprocess::create_only, sName.c_str(), boost::interprocess::read_write );
+		shm.truncate( 64 + nEntries * sizeof( SharedPoseEntry ) );
+		boost::interprocess::mapped_region( shm, boost::interprocess::read_write ).swap( m_region );
+
+		unsigned char* pBase = static_cast< unsigned char* >( m_region.get_address() );
+		m_pHeader = new( pBase ) SharedPoseTableHeader;
+		m_pHeader->version = SHARED_POSE_TABLE_VERSION;
+		m_pHeader->nEntries = nEntries;
+		m_pHeader->nUsed.store( 0, boost::memory_order_relaxed );
+		m_pHeader->closed.store( 0, boost::memory_order_relaxed );
+
+		m_pEntries = reinterpret_cast< SharedPoseEntry* >( pBase + 64 );
+		for ( unsigned int i = 0; i < nEntries; i++ )
+		{
+			new( m_pEntries + i ) SharedPoseEntry;
+			m_pEntries[ i ].lock.store( 0, boost::memory_order_relaxed );
+			m_pEntries[ i ].nUpdates = 0;
+			m_pEntries[ i ].timestamp = 0;
+			m_pEntries[ i ].type = SHARED_POSE_UNUSED;
+		}
+
+		// readers accept the table once the magic is there
+		boost::atomic_thread_fence( boost::memory_order_release );
+		m_pHeader->magic = SHARED_POSE_TABLE_MAGIC;
+	}
+
+	~SharedPoseTableWriter()
+	{
+		m_pHeader->closed.store( 1, boost::memory_order_release );
+		boost::interprocess::shared_memory_object::remove( m_sName.c_str() );
+	}
+
+	/**
+	 * Adds an entry. Not thread-safe with respect to other calls of \c addEntry.
+	 *
+	 * @return index of the entry
+	 */
+	unsigned int addEntry( const std::string& sName, SharedPoseType type )
+	{
+		unsigned int index = m_pHeader->nUsed.load( boost::memory_order_relaxed );
+		if ( index >= m_pHeader->nEntries )
+			throw std::length_error( "shared pose table \"" + m_sName + "\" is full" );
+
+		SharedPoseEntry& entry( m_pEntries[ index ] );
+		entry.type = type;
+		std::strncpy( entry.name, sName.c_str(), SHARED_POSE_TABLE_NAME_SIZE - 1 );
+		entry.name[ SHARED_POSE_TABLE_NAME_SIZE - 1 ] = 0;
+		std::memset( entry.value, 0, sizeof( entry.value ) );
+		std::memset( entry.covariance, 0, sizeof( entry.covariance ) );
+
+		m_pHeader->nUsed.store( index + 1, boost::memory_order_release );
+		return index;
+	}
+
+	/**
+	 * Updates an entry.
+	 *
+	 * @param index index returned by \c addEntry
+	 * @param timestamp timestamp of the measurement
+	 * @param pValue the value, length depending on the type of the entry
+	 * @param pCovariance the covariance, row major, or 0 for types without one
+	 */
+	void update( unsigned int index, boost::uint64_t timestamp, const double* pValue, const double* pCovariance = 0 )
+	{
+		SharedPoseEntry& entry( m_pEntries[ index ] );
+		boost::uint64_t lock = entry.lock.load( boost::memory_order_relaxed );
+		entry.lock.store( lock + 1, boost::memory_order_relaxed );
+		boost::atomic_thread_fence( boost::memory_order_release );
+
+		entry.nUpdates++;
+		entry.timestamp = timestamp;
+		std::memcpy( entry.value, pValue, valueSize( entry.type ) * sizeof( double ) );
+		if ( pCovariance )
+			std::memcpy( entry.covariance, pCovariance, covarianceSize( entry.type ) * sizeof( double ) );
+
+		entry.lock.store( lock + 2, boost::memory_order_release );
+	}
+
+	const std::string& name() const
+	{ return m_sName; }
+
+	/** number of values of a type */
+	static std::size_t valueSize( boost::int32_t type )
+	{
+		switch ( type )
+		{
+		case SHARED_POSE_POSE:
+		case SHARED_POSE_ERROR_POSE:
+			return 7;
+		case SHARED_POSE_POSITION:
+		case SHARED_POSE_ERROR_POSITION:
+			return 3;
+		case SHARED_POSE_ROTATION:
+			return 4;
+		default:
+			return 0;
+		}
+	}
+
+	/** number of covariance elements of a type */
+	static std::size_t covarianceSize( boost::int32_t type )
+	{
+		switch ( type )
+		{
+		case SHARED_POSE_ERROR_POSE:
+			return 36;
+		case SHARED_POSE_ERROR_POSITION:
+			return 9;
+		default:
+			return 0;
+		}
+	}
+
+protected:
+	std::string m_sName;
+	boost::interprocess::mapped_region m_region;
+	SharedPoseTableHeader* m_pHeader;
+	SharedPoseEntry* m_pEntries;
+};
+
+
+/**
+ * Maps a pose table created by another process.
+ *
+ * Reading never blocks: if the writer keeps updating an entry while it is copied, \c read
+ * gives up after a few attempts instead of waiting.
+ */
+class SharedPoseTableReader
+	: private boost::noncopyable
+{
+public:
+	/** a copy of one entry */
+	struct Entry
+	{
+		boost::uint64_t nUpdates;
+		boost::uint64_t timestamp;
+		SharedPoseType type;
+		std::string name;
+		double value[ 7 ];
+		double covariance[ 36 ];
+	};
+
+	/**
+	 * Opens an existing table.
+	 *
+	 * @throws boost::interprocess::interprocess_exception if there is no table of that name
+	 * @throws std::runtime_error if the shared memory is not a table of this version
+	 */
+	explicit SharedPoseTableReader( const std::string& sName )
+	{
+		boost::interprocess::shared_memory_object shm( boost::interprocess::open_only, sName.c_str(), boost::interprocess::read_only );
+		boost::interprocess::mapped_region( shm, boost::interprocess::read_only ).swap( m_region );
+
+		m_pHeader = static_cast< const SharedPoseTableHeader* >( m_region.get_address() );
+		if ( m_region.get_size() < 64 || m_pHeader->magic != SHARED_POSE_TABLE_MAGIC )
+			throw std::runtime_error( "\"" + sName + "\" is not a shared pose table or not initialized yet" );
+		boost::atomic_thread_fence( boost::memory_order_acquire );
+		if ( m_pHeader->version != SHARED_POSE_TABLE_VERSION )
+			throw std::runtime_error( "\"" + sName + "\" is a shared pose table of another version" );
+
+		m_pEntries = reinterpret_cast< const SharedPoseEntry* >( static_cast< const unsigned char* >( m_region.get_address() ) + 64 );
+	}
+
+	/** number of entries in use */
+	unsigned int size() const
+	{ return m_pHeader->nUsed.load( boost::memory_order_acquire ); }
+
+	/** index of the entry with a name, -1 if there is none */
+	int find( const std::string& sName ) const
+	{
+		unsigned int n = size();
+		for ( unsigned int i = 0; i < n; i++ )
+			if ( sName.compare( 0, SHARED_POSE_TABLE_NAME_SIZE - 1, m_pEntries[ i ].name ) == 0 )
+				return static_cast< int >( i );
+		return -1;
+	}
+
+	/**
+	 * Copies an entry.
+	 *
+	 * @return false if the index is not in use or the entry changed during every attempt
+	 */
+	bool read( unsigned int index, Entry& entry ) const
+	{
+		if ( index >= size() )
+			return false;
+
+		const SharedPoseEntry& shared( m_pEntries[ index ] );
+		for ( int attempt = 0; attempt < 8; attempt++ )
+		{
+			boost::uint64_t lock = shared.lock.load( boost::memory_order_acquire );
+			if ( lock & 1 )
+				continue;
+
+			entry.nUpdates = shared.nUpdates;
+			entry.timestamp = shared.timestamp;
+			entry.type = static_cast< SharedPoseType >( shared.type );
+			std::memcpy( entry.value, shared.value, sizeof( entry.value ) );
+			std::memcpy( entry.covariance, shared.covariance, sizeof( entry.covariance ) );
+
+			boost::atomic_thread_fence( boost::memory_order_acquire );
+			if ( shared.lock.load( boost::memory_order_relaxed ) == lock )
+			{
+				// the name is written before the entry is published and never changes
+				entry.name.assign( shared.name, strnlen( shared.name, SHARED_POSE_TABLE_NAME_SIZE ) );
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/** true if the writer has gone away */
+	bool isClosed() const
+	{ return m_pHeader->closed.load( boost::memory_order_acquire ) != 0; }
+
+protected:
+	boost::interprocess::mapped_region m_region;
+	const SharedPoseTableHeader* m_pHeader;
+	const SharedPoseEntry* m_pEntries;
+};
+
+} } // namespace Ubitrack::Facade
+
+#endif
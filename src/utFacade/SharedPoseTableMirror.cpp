@@ -0,0 +1,235 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @ingroup api
+ * @file
+ * Implements the mirroring of push sinks into a shared pose table.
+ */
+
+#include <log4cpp/Category.hh>
+#include <boost/bind.hpp>
+#include <utUtil/Exception.h>
+
+#include "SharedPoseTableMirror.h"
+#include "AdvancedFacade.h"
+
+// get a logger
+static log4cpp::Category& logger( log4cpp::Category::getInstance( "Ubitrack.Facade.SharedPoseTableMirror" ) );
+
+namespace Ubitrack { namespace Facade {
+
+namespace {
+
+/** opens the table, translating the errors of boost::interprocess */
+SharedPoseTableWriter* createTable( const std::string& sTableName, unsigned int nEntries )
+{
+	try
+	{
+		return new SharedPoseTableWriter( sTableName, nEntries );
+	}
+	catch ( const std::exception& e )
+	{
+		UBITRACK_THROW( "Cannot create shared pose table \"" + sTableName + "\": " + e.what() );
+	}
+}
+
+/** copies a pose into x, y, z, qx, qy, qz, qw */
+void poseValue( const Math::Pose& pose, double* pValue )
+{
+	pValue[ 0 ] = pose.translation()( 0 );
+	pValue[ 1 ] = pose.translation()( 1 );
+	pValue[ 2 ] = pose.translation()( 2 );
+	pValue[ 3 ] = pose.rotation().x();
+	pValue[ 4 ] = pose.rotation().y();
+	pValue[ 5 ] = pose.rotation().z();
+	pValue[ 6 ] = pose.rotation().w();
+}
+
+/** returns true if the component is an ApplicationPushSink of the event type */
+template< class EventType >
+bool isPushSink( AdvancedFacade& facade, const std::string& sSinkName )
+{
+	return boost::dynamic_pointer_cast< Components::ApplicationPushSink< EventType > >(
+		facade.componentByName< Dataflow::Component >( sSinkName ) ).get() != 0;
+}
+
+} // anonymous namespace
+
+
+SharedPoseTableMirror::SharedPoseTableMirror( AdvancedFacade& facade, const std::string& sTableName, unsigned int nEntries )
+	: m_facade( facade )
+	, m_pWriter( createTable( sTableName, nEntries ) )
+{
+	LOG4CPP_INFO( logger, "Created shared pose table \"" << sTableName << "\" with " << nEntries << " entries" );
+}
+
+
+SharedPoseTableMirror::~SharedPoseTableMirror()
+{
+	for ( std::size_t i = 0; i < m_sinks.size(); i++ )
+	{
+		try
+		{
+			removeSink( m_sinks[ i ].first, m_sinks[ i ].second );
+		}
+		catch ( const Util::Exception& )
+		{
+			// the sink is gone with its dataflow
+		}
+	}
+}
+
+
+unsigned int SharedPoseTableMirror::addSink( const std::string& sSinkName )
+{
+	// the sink calls its callback without synchronization
+	if ( m_facade.isStarted() && !m_facade.isPaused() )
+		UBITRACK_THROW( "Cannot mirror " + sSinkName + " while the dataflow is running, stop or pause it first" );
+
+	for ( std::size_t i = 0; i < m_sinks.size(); i++ )
+		if ( m_sinks[ i ].first == sSinkName )
+			UBITRACK_THROW( "Component " + sSinkName + " is mirrored already" );
+
+	SharedPoseType type;
+	if ( isPushSink< Measurement::Pose >( m_facade, sSinkName ) )
+		type = SHARED_POSE_POSE;
+	else if ( isPushSink< Measurement::ErrorPose >( m_facade, sSinkName ) )
+		type = SHARED_POSE_ERROR_POSE;
+	else if ( isPushSink< Measurement::Position >( m_facade, sSinkName ) )
+		type = SHARED_POSE_POSITION;
+	else if ( isPushSink< Measurement::ErrorPosition >( m_facade, sSinkName ) )
+		type = SHARED_POSE_ERROR_POSITION;
+	else if ( isPushSink< Measurement::Rotation >( m_facade, sSinkName ) )
+		type = SHARED_POSE_ROTATION;
+	else
+		UBITRACK_THROW( "Component " + sSinkName + " is no push sink of poses, positions or rotations" );
+
+	unsigned int index;
+	try
+	{
+		index = m_pWriter->addEntry( sSinkName, type );
+	}
+	catch ( const std::length_error& e )
+	{
+		UBITRACK_THROW( e.what() );
+	}
+
+	switch ( type )
+	{
+	case SHARED_POSE_POSE:
+		m_facade.componentByName< Components::ApplicationPushSink< Measurement::Pose > >( sSinkName )->setCallback(
+			boost::bind( &SharedPoseTableMirror::updatePose, this, index, _1 ) );
+		break;
+	case SHARED_POSE_ERROR_POSE:
+		m_facade.componentByName< Components::ApplicationPushSink< Measurement::ErrorPose > >( sSinkName )->setCallback(
+			boost::bind( &SharedPoseTableMirror::updateErrorPose, this, index, _1 ) );
+		break;
+	case SHARED_POSE_POSITION:
+		m_facade.componentByName< Components::ApplicationPushSink< Measurement::Position > >( sSinkName )->setCallback(
+			boost::bind( &SharedPoseTableMirror::updatePosition, this, index, _1 ) );
+		break;
+	case SHARED_POSE_ERROR_POSITION:
+		m_facade.componentByName< Components::ApplicationPushSink< Measurement::ErrorPosition > >( sSinkName )->setCallback(
+			boost::bind( &SharedPoseTableMirror::updateErrorPosition, this, index, _1 ) );
+		break;
+	default:
+		m_facade.componentByName< Components::ApplicationPushSink< Measurement::Rotation > >( sSinkName )->setCallback(
+			boost::bind( &SharedPoseTableMirror::updateRotation, this, index, _1 ) );
+		break;
+	}
+
+	m_sinks.push_back( std::make_pair( sSinkName, type ) );
+	LOG4CPP_DEBUG( logger, "Mirroring " << sSinkName << " into entry " << index << " of " << m_pWriter->name() );
+	return index;
+}
+
+
+void SharedPoseTableMirror::removeSink( const std::string& sSinkName, SharedPoseType type )
+{
+	switch ( type )
+	{
+	case SHARED_POSE_POSE:
+		m_facade.componentByName< Components::ApplicationPushSink< Measurement::Pose > >( sSinkName )->setCallback( 0 );
+		break;
+	case SHARED_POSE_ERROR_POSE:
+		m_facade.componentByName< Components::ApplicationPushSink< Measurement::ErrorPose > >( sSinkName )->setCallback( 0 );
+		break;
+	case SHARED_POSE_POSITION:
+		m_facade.componentByName< Components::ApplicationPushSink< Measurement::Position > >( sSinkName )->setCallback( 0 );
+		break;
+	case SHARED_POSE_ERROR_POSITION:
+		m_facade.componentByName< Components::ApplicationPushSink< Measurement::ErrorPosition > >( sSinkName )->setCallback( 0 );
+		break;
+	default:
+		m_facade.componentByName< Components::ApplicationPushSink< Measurement::Rotation > >( sSinkName )->setCallback( 0 );
+		break;
+	}
+}
+
+
+void SharedPoseTableMirror::updatePose( unsigned int index, const Measurement::Pose& m )
+{
+	double value[ 7 ];
+	poseValue( *m, value );
+	m_pWriter->update( index, m.time(), value );
+}
+
+
+void SharedPoseTableMirror::updateErrorPose( unsigned int index, const Measurement::ErrorPose& m )
+{
+	double value[ 7 ];
+	double covariance[ 36 ];
+	poseValue( *m, value );
+	for ( unsigned int i = 0; i < 6; i++ )
+		for ( unsigned int j = 0; j < 6; j++ )
+			covariance[ i * 6 + j ] = m->covariance()( i, j );
+	m_pWriter->update( index, m.time(), value, covariance );
+}
+
+
+void SharedPoseTableMirror::updatePosition( unsigned int index, const Measurement::Position& m )
+{
+	double value[ 3 ] = { ( *m )( 0 ), ( *m )( 1 ), ( *m )( 2 ) };
+	m_pWriter->update( index, m.time(), value );
+}
+
+
+void SharedPoseTableMirror::updateErrorPosition( unsigned int index, const Measurement::ErrorPosition& m )
+{
+	double value[ 3 ] = { m->value( 0 ), m->value( 1 ), m->value( 2 ) };
+	double covariance[ 9 ];
+	for ( unsigned int i = 0; i < 3; i++ )
+		for ( unsigned int j = 0; j < 3; j++ )
+			covariance[ i * 3 + j ] = m->covariance( i, j );
+	m_pWriter->update( index, m.time(), value, covariance );
+}
+
+
+void SharedPoseTableMirror::updateRotation( unsigned int index, const Measurement::Rotation& m )
+{
+	double value[ 4 ] = { m->x(), m->y(), m->z(), m->w() };
+	m_pWriter->update( index, m.time(), value );
+}
+
+} } // namespace Ubitrack::Facade
@@ -0,0 +1,103 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @ingroup api
+ * @file
+ * Mirrors application push sinks into a shared pose table.
+ */
+#ifndef __UBITRACK_FACADE_SHAREDPOSETABLEMIRROR_H_INCLUDED__
+#define __UBITRACK_FACADE_SHAREDPOSETABLEMIRROR_H_INCLUDED__
+
+#include <utFacade/utFacade.h>
+#include <string>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <utMeasurement/Measurement.h>
+
+#include "SharedPoseTable.h"
+
+namespace Ubitrack { namespace Facade {
+
+class AdvancedFacade;
+
+/**
+ * Owns a \c SharedPoseTableWriter and updates one entry per mirrored push sink.
+ *
+ * Mirroring takes the callback of the sink: entries are updated directly on the dataflow thread,
+ * bypassing the delivery queue of the facade, and an application callback set on the same sink
+ * is replaced. The callbacks are removed again when the mirror is destroyed.
+ */
+class UTFACADE_EXPORT SharedPoseTableMirror
+	: private boost::noncopyable
+{
+public:
+	/**
+	 * Creates the table.
+	 *
+	 * @param facade facade containing the sinks, must outlive the mirror
+	 * @param sTableName name of the shared memory object
+	 * @param nEntries maximum number of mirrored sinks
+	 */
+	SharedPoseTableMirror( AdvancedFacade& facade, const std::string& sTableName, unsigned int nEntries );
+
+	~SharedPoseTableMirror();
+
+	/**
+	 * Starts mirroring an \c ApplicationPushSink of Pose, ErrorPose, Position, ErrorPosition or
+	 * Rotation. Throws if there is no such sink, the sink is mirrored already, the table is full
+	 * or the dataflow is running and not paused, as the callback of the sink is not synchronized
+	 * with its dispatch.
+	 *
+	 * A callback set on the sink later, e.g. by \c BasicPushSink::registerCallback, replaces the
+	 * mirror's callback, and the entry is no longer updated.
+	 *
+	 * @return index of the entry in the table
+	 */
+	unsigned int addSink( const std::string& sSinkName );
+
+	/** name of the shared memory object */
+	const std::string& tableName() const
+	{ return m_pWriter->name(); }
+
+protected:
+	void updatePose( unsigned int index, const Measurement::Pose& m );
+	void updateErrorPose( unsigned int index, const Measurement::ErrorPose& m );
+	void updatePosition( unsigned int index, const Measurement::Position& m );
+	void updateErrorPosition( unsigned int index, const Measurement::ErrorPosition& m );
+	void updateRotation( unsigned int index, const Measurement::Rotation& m );
+
+	/** removes the callback of a mirrored sink */
+	void removeSink( const std::string& sSinkName, SharedPoseType type );
+
+	AdvancedFacade& m_facade;
+	boost::scoped_ptr< SharedPoseTableWriter > m_pWriter;
+
+	/** the mirrored sinks and their types */
+	std::vector< std::pair< std::string, SharedPoseType > > m_sinks;
+};
+
+} } // namespace Ubitrack::Facade
+
+#endif
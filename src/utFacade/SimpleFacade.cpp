@@ -205,6 +205,26 @@ void convert2DPositionListCallback( Ubitrack::Facade::SimplePosition2DListReceiv
 }
 
 #ifdef HAVE_OPENCV
+/** the image a SimpleImageReceiver is called with on this thread and its measurement */
+thread_local const Ubitrack::Facade::SimpleImage* g_pCallbackImage = 0;
+thread_local const Ubitrack::Measurement::ImageMeasurement* g_pCallbackMeasurement = 0;
+
+/** publishes the image for the duration of a callback */
+struct CallbackImageScope
+{
+	CallbackImageScope( const Ubitrack::Facade::SimpleImage& image, const Ubitrack::Measurement::ImageMeasurement& measurement )
+	{
+		g_pCallbackImage = &image;
+		g_pCallbackMeasurement = &measurement;
+	}
+
+	~CallbackImageScope()
+	{
+		g_pCallbackImage = 0;
+		g_pCallbackMeasurement = 0;
+	}
+};
+
 // this function converts Measurement::ImageMeasurements to SimpleImage in a callback
 void convertImageCallback( Ubitrack::Facade::SimpleImageReceiver* receiver, const Ubitrack::Measurement::ImageMeasurement& measurement )
 {
@@ -221,6 +241,8 @@ void convertImageCallback( Ubitrack::Facade::SimpleImageReceiver* receiver, cons
 
 	i.timestamp = measurement.time();
 
+	// lets retainCallbackImage find the measurement of the image
+	CallbackImageScope scope( i, measurement );
 	receiver->receiveImage( i );
 }
 #endif
@@ -300,6 +322,24 @@ void convert3DErrorPositionListCallback( Ubitrack::Facade::SimpleErrorPositionLi
 
 namespace Ubitrack { namespace Facade {
 
+void* retainCallbackImage( const SimpleImage& image )
+{
+#ifdef HAVE_OPENCV
+	if ( &image == g_pCallbackImage )
+		return new Measurement::ImageMeasurement( *g_pCallbackMeasurement );
+#endif
+	return 0;
+}
+
+
+void releaseCallbackImage( void* pImage )
+{
+#ifdef HAVE_OPENCV
+	delete static_cast< Measurement::ImageMeasurement* >( pImage );
+#endif
+}
+
+
 
 
 
@@ -302,6 +302,18 @@ protected:
 };
 
 
+/**
+ * Keeps the pixels of an image passed to a \c SimpleImageReceiver beyond the callback, for
+ * language bindings that hand out the pixel memory. Only works during the callback, on its thread.
+ *
+ * @return reference to pass to \c releaseCallbackImage, 0 if the image is not the one being delivered
+ */
+UTFACADE_EXPORT void* retainCallbackImage( const SimpleImage& image );
+
+/** releases a reference returned by \c retainCallbackImage */
+UTFACADE_EXPORT void releaseCallbackImage( void* pImage );
+
+
  } } // namespace Ubitrack::Facade
 
 #endif
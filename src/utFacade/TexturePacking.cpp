@@ -0,0 +1,467 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @ingroup api
+ * @file
+ * Implements the ARGB32 texture packing with runtime selection of the instruction set.
+ */
+
+#include <cstring>
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+
+#ifdef HAVE_OPENCV
+#include <opencv2/core.hpp>
+#endif
+
+#if defined( __x86_64__ ) || defined( __i386__ ) || defined( _M_X64 ) || defined( _M_IX86 )
+#define UBITRACK_TEXTURE_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define UBITRACK_TARGET_SSSE3
+#define UBITRACK_TARGET_AVX2
+#else
+#define UBITRACK_TARGET_SSSE3 __attribute__(( target( "ssse3" ) ))
+#define UBITRACK_TARGET_AVX2 __attribute__(( target( "avx2" ) ))
+#endif
+#endif
+
+#include "TexturePacking.h"
+
+namespace Ubitrack { namespace Facade {
+
+namespace {
+
+/** converts one row of \c width pixels, \c alpha is already shifted to the top byte */
+typedef void ( *RowKernel )( const unsigned char* src, boost::uint32_t* dst, int width, boost::uint32_t alpha );
+
+/** the row kernels of one instruction set */
+struct Kernels
+{
+	const char* sName;
+	RowKernel luminance;
+	RowKernel rgb;
+	RowKernel bgr;
+	RowKernel rgba;
+	RowKernel bgra;
+	RowKernel yuv422;
+};
+
+
+// scalar kernels, also used for the remainders of the vector kernels
+
+void luminanceScalar( const unsigned char* src, boost::uint32_t* dst, int width, boost::uint32_t alpha )
+{
+	for ( int j = 0; j < width; j++ )
+		dst[ j ] = alpha | boost::uint32_t( src[ j ] ) * 0x010101u;
+}
+
+void rgbScalar( const unsigned char* src, boost::uint32_t* dst, int width, boost::uint32_t alpha )
+{
+	for ( int j = 0; j < width; j++, src += 3 )
+		dst[ j ] = alpha | boost::uint32_t( src[ 0 ] ) << 16 | boost::uint32_t( src[ 1 ] ) << 8 | src[ 2 ];
+}
+
+void bgrScalar( const unsigned char* src, boost::uint32_t* dst, int width, boost::uint32_t alpha )
+{
+	for ( int j = 0; j < width; j++, src += 3 )
+		dst[ j ] = alpha | boost::uint32_t( src[ 2 ] ) << 16 | boost::uint32_t( src[ 1 ] ) << 8 | src[ 0 ];
+}
+
+void rgbaScalar( const unsigned char* src, boost::uint32_t* dst, int width, boost::uint32_t )
+{
+	for ( int j = 0; j < width; j++, src += 4 )
+		dst[ j ] = boost::uint32_t( src[ 3 ] ) << 24 | boost::uint32_t( src[ 0 ] ) << 16 | boost::uint32_t( src[ 1 ] ) << 8 | src[ 2 ];
+}
+
+void bgraScalar( const unsigned char* src, boost::uint32_t* dst, int width, boost::uint32_t )
+{
+	// already the memory layout of ARGB32 on little endian machines
+	for ( int j = 0; j < width; j++, src += 4 )
+		dst[ j ] = boost::uint32_t( src[ 3 ] ) << 24 | boost::uint32_t( src[ 2 ] ) << 16 | boost::uint32_t( src[ 1 ] ) << 8 | src[ 0 ];
+}
+
+inline boost::uint32_t clampByte( int v )
+{ return v < 0 ? 0 : ( v > 255 ? 255 : v ); }
+
+/** ITU-R BT.601 limited range YUYV. A single pixel at the end of a row has no V sample */
+void yuv422Scalar( const unsigned char* src, boost::uint32_t* dst, int width, boost::uint32_t alpha )
+{
+	for ( int j = 0; j < width; j += 2, src += 4 )
+	{
+		int d = src[ 1 ] - 128;
+		int e = j + 1 < width ? src[ 3 ] - 128 : 0;
+		int r = 409 * e + 128;
+		int g = -100 * d - 208 * e + 128;
+		int b = 516 * d + 128;
+
+		for ( int k = 0; k < 2 && j + k < width; k++ )
+		{
+			int c = 298 * ( src[ 2 * k ] - 16 );
+			dst[ j + k ] = alpha | clampByte( ( c + r ) >> 8 ) << 16 | clampByte( ( c + g ) >> 8 ) << 8 | clampByte( ( c + b ) >> 8 );
+		}
+	}
+}
+
+const Kernels g_scalarKernels = { "scalar", luminanceScalar, rgbScalar, bgrScalar, rgbaScalar, bgraScalar, yuv422Scalar };
+
+
+#ifdef UBITRACK_TEXTURE_X86
+
+// SSSE3 kernels: pshufb moves the bytes of four pixels into place
+
+UBITRACK_TARGET_SSSE3
+void luminanceSsse3( const unsigned char* src, boost::uint32_t* dst, int width, boost::uint32_t alpha )
+{
+	const __m128i a = _mm_set1_epi32( int( alpha ) );
+	const __m128i m0 = _mm_setr_epi8( 0, 0, 0, -1, 1, 1, 1, -1, 2, 2, 2, -1, 3, 3, 3, -1 );
+	const __m128i m1 = _mm_setr_epi8( 4, 4, 4, -1, 5, 5, 5, -1, 6, 6, 6, -1, 7, 7, 7, -1 );
+	const __m128i m2 = _mm_setr_epi8( 8, 8, 8, -1, 9, 9, 9, -1, 10, 10, 10, -1, 11, 11, 11, -1 );
+	const __m128i m3 = _mm_setr_epi8( 12, 12, 12, -1, 13, 13, 13, -1, 14, 14, 14, -1, 15, 15, 15, -1 );
+
+	int j = 0;
+	for ( ; j + 16 <= width; j += 16 )
+	{
+		__m128i v = _mm_loadu_si128( reinterpret_cast< const __m128i* >( src + j ) );
+		__m128i* d = reinterpret_cast< __m128i* >( dst + j );
+		_mm_storeu_si128( d, _mm_or_si128( _mm_shuffle_epi8( v, m0 ), a ) );
+		_mm_storeu_si128( d + 1, _mm_or_si128( _mm_shuffle_epi8( v, m1 ), a ) );
+		_mm_storeu_si128( d + 2, _mm_or_si128( _mm_shuffle_epi8( v, m2 ), a ) );
+		_mm_storeu_si128( d + 3, _mm_or_si128( _mm_shuffle_epi8( v, m3 ), a ) );
+	}
+	luminanceScalar( src + j, dst + j, width - j, alpha );
+}
+
+/** 16 three-byte pixels per iteration, \c mask orders the bytes of four pixels */
+UBITRACK_TARGET_SSSE3
+inline int packRgbSsse3( const unsigned char* src, boost::uint32_t* dst, int width, boost::uint32_t alpha, const __m128i& mask )
+{
+	const __m128i a = _mm_set1_epi32( int( alpha ) );
+
+	int j = 0;
+	for ( ; j + 16 <= width; j += 16 )
+	{
+		const __m128i* s = reinterpret_cast< const __m128i* >( src + 3 * j );
+		__m128i v0 = _mm_loadu_si128( s );
+		__m128i v1 = _mm_loadu_si128( s + 1 );
+		__m128i v2 = _mm_loadu_si128( s + 2 );
+
+		__m128i* d = reinterpret_cast< __m128i* >( dst + j );
+		_mm_storeu_si128( d, _mm_or_si128( _mm_shuffle_epi8( v0, mask ), a ) );
+		_mm_storeu_si128( d + 1, _mm_or_si128( _mm_shuffle_epi8( _mm_alignr_epi8( v1, v0, 12 ), mask ), a ) );
+		_mm_storeu_si128( d + 2, _mm_or_si128( _mm_shuffle_epi8( _mm_alignr_epi8( v2, v1, 8 ), mask ), a ) );
+		_mm_storeu_si128( d + 3, _mm_or_si128( _mm_shuffle_epi8( _mm_srli_si128( v2, 4 ), mask ), a ) );
+	}
+	return j;
+}
+
+UBITRACK_TARGET_SSSE3
+void rgbSsse3( const unsigned char* src, boost::uint32_t* dst, int width, boost::uint32_t alpha )
+{
+	const __m128i mask = _mm_setr_epi8( 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1 );
+	int j = packRgbSsse3( src, dst, width, alpha, mask );
+	rgbScalar( src + 3 * j, dst + j, width - j, alpha );
+}
+
+UBITRACK_TARGET_SSSE3
+void bgrSsse3( const unsigned char* src, boost::uint32_t* dst, int width, boost::uint32_t alpha )
+{
+	const __m128i mask = _mm_setr_epi8( 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1 );
+	int j = packRgbSsse3( src, dst, width, alpha, mask );
+	bgrScalar( src + 3 * j, dst + j, width - j, alpha );
+}
+
+UBITRACK_TARGET_SSSE3
+void rgbaSsse3( const unsigned char* src, boost::uint32_t* dst, int width, boost::uint32_t alpha )
+{
+	const __m128i mask = _mm_setr_epi8( 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15 );
+
+	int j = 0;
+	for ( ; j + 4 <= width; j += 4 )
+	{
+		__m128i v = _mm_loadu_si128( reinterpret_cast< const __m128i* >( src + 4 * j ) );
+		_mm_storeu_si128( reinterpret_cast< __m128i* >( dst + j ), _mm_shuffle_epi8( v, mask ) );
+	}
+	rgbaScalar( src + 4 * j, dst + j, width - j, alpha );
+}
+
+const Kernels g_ssse3Kernels = { "ssse3", luminanceSsse3, rgbSsse3, bgrSsse3, rgbaSsse3, bgraScalar, yuv422Scalar };
+
+
+// AVX2 kernels: the same shuffles on two 128 bit lanes
+
+UBITRACK_TARGET_AVX2
+void luminanceAvx2( const unsigned char* src, boost::uint32_t* dst, int width, boost::uint32_t alpha )
+{
+	const __m256i a = _mm256_set1_epi32( int( alpha ) );
+
+	int j = 0;
+	for ( ; j + 8 <= width; j += 8 )
+	{
+		__m256i v = _mm256_cvtepu8_epi32( _mm_loadl_epi64( reinterpret_cast< const __m128i* >( src + j ) ) );
+		v = _mm256_or_si256( _mm256_or_si256( v, _mm256_slli_epi32( v, 8 ) ), _mm256_or_si256( _mm256_slli_epi32( v, 16 ), a ) );
+		_mm256_storeu_si256( reinterpret_cast< __m256i* >( dst + j ), v );
+	}
+	luminanceScalar( src + j, dst + j, width - j, alpha );
+}
+
+/**
+ * Eight three-byte pixels per iteration. Each lane is loaded with 16 bytes of which 12 are
+ * used, so the loop stops early enough not to read beyond the row.
+ */
+UBITRACK_TARGET_AVX2
+inline int packRgbAvx2( const unsigned char* src, boost::uint32_t* dst, int width, boost::uint32_t alpha, const __m256i& mask )
+{
+	const __m256i a = _mm256_set1_epi32( int( alpha ) );
+
+	int j = 0;
+	for ( ; j + 10 <= width; j += 8 )
+	{
+		const unsigned char* s = src + 3 * j;
+		__m256i v = _mm256_inserti128_si256( _mm256_castsi128_si256( _mm_loadu_si128( reinterpret_cast< const __m128i* >( s ) ) ),
+			_mm_loadu_si128( reinterpret_cast< const __m128i* >( s + 12 ) ), 1 );
+		_mm256_storeu_si256( reinterpret_cast< __m256i* >( dst + j ), _mm256_or_si256( _mm256_shuffle_epi8( v, mask ), a ) );
+	}
+	return j;
+}
+
+UBITRACK_TARGET_AVX2
+void rgbAvx2( const unsigned char* src, boost::uint32_t* dst, int width, boost::uint32_t alpha )
+{
+	const __m256i mask = _mm256_setr_epi8( 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+		2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1 );
+	int j = packRgbAvx2( src, dst, width, alpha, mask );
+	rgbScalar( src + 3 * j, dst + j, width - j, alpha );
+}
+
+UBITRACK_TARGET_AVX2
+void bgrAvx2( const unsigned char* src, boost::uint32_t* dst, int width, boost::uint32_t alpha )
+{
+	const __m256i mask = _mm256_setr_epi8( 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+		0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1 );
+	int j = packRgbAvx2( src, dst, width, alpha, mask );
+	bgrScalar( src + 3 * j, dst + j, width - j, alpha );
+}
+
+UBITRACK_TARGET_AVX2
+void rgbaAvx2( const unsigned char* src, boost::uint32_t* dst, int width, boost::uint32_t alpha )
+{
+	const __m256i mask = _mm256_setr_epi8( 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+		2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15 );
+
+	int j = 0;
+	for ( ; j + 8 <= width; j += 8 )
+	{
+		__m256i v = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( src + 4 * j ) );
+		_mm256_storeu_si256( reinterpret_cast< __m256i* >( dst + j ), _mm256_shuffle_epi8( v, mask ) );
+	}
+	rgbaScalar( src + 4 * j, dst + j, width - j, alpha );
+}
+
+const Kernels g_avx2Kernels = { "avx2", luminanceAvx2, rgbAvx2, bgrAvx2, rgbaAvx2, bgraScalar, yuv422Scalar };
+
+
+bool cpuSupportsSsse3()
+{
+#ifdef _MSC_VER
+	int info[ 4 ];
+	__cpuid( info, 1 );
+	return ( info[ 2 ] & ( 1 << 9 ) ) != 0;
+#else
+	return __builtin_cpu_supports( "ssse3" );
+#endif
+}
+
+bool cpuSupportsAvx2()
+{
+#ifdef _MSC_VER
+	int info[ 4 ];
+	__cpuid( info, 1 );
+	bool bOsAvx = ( info[ 2 ] & ( 1 << 27 ) ) && ( info[ 2 ] & ( 1 << 28 ) ) && ( _xgetbv( 0 ) & 6 ) == 6;
+	__cpuidex( info, 7, 0 );
+	return bOsAvx && ( info[ 1 ] & ( 1 << 5 ) ) != 0;
+#else
+	return __builtin_cpu_supports( "avx2" );
+#endif
+}
+
+#endif // UBITRACK_TEXTURE_X86
+
+
+/** the best kernels supported by the processor */
+const Kernels* bestKernels()
+{
+#ifdef UBITRACK_TEXTURE_X86
+	if ( cpuSupportsAvx2() )
+		return &g_avx2Kernels;
+	if ( cpuSupportsSsse3() )
+		return &g_ssse3Kernels;
+#endif
+	return &g_scalarKernels;
+}
+
+/** the kernels in use, selected on first use */
+boost::atomic< const Kernels* > g_pKernels( 0 );
+
+const Kernels& kernels()
+{
+	const Kernels* pKernels = g_pKernels.load( boost::memory_order_acquire );
+	if ( !pKernels )
+	{
+		pKernels = bestKernels();
+		g_pKernels.store( pKernels, boost::memory_order_release );
+	}
+	return *pKernels;
+}
+
+
+/** packs a range of rows */
+struct PackRows
+{
+	const unsigned char* src;
+	std::size_t srcStride;
+	int width;
+	int height;
+	unsigned char* dst;
+	std::size_t dstStride;
+	boost::uint32_t alpha;
+	bool bFlip;
+	RowKernel kernel;
+
+	void operator()( int begin, int end ) const
+	{
+		for ( int i = begin; i < end; i++ )
+		{
+			int srcRow = bFlip ? height - 1 - i : i;
+			kernel( src + srcRow * srcStride, reinterpret_cast< boost::uint32_t* >( dst + i * dstStride ), width, alpha );
+		}
+	}
+};
+
+
+#ifdef HAVE_OPENCV
+
+/** images with fewer pixels are packed on the calling thread */
+const long g_minParallelPixels = 512 * 512;
+
+/** number of pixels per band of rows */
+const double g_pixelsPerBand = 65536.0;
+
+class ParallelPackRows
+	: public cv::ParallelLoopBody
+{
+public:
+	ParallelPackRows( const PackRows& rows )
+		: m_rows( rows )
+	{}
+
+	void operator()( const cv::Range& range ) const
+	{ m_rows( range.start, range.end ); }
+
+protected:
+	PackRows m_rows;
+};
+
+#endif // HAVE_OPENCV
+
+} // anonymous namespace
+
+
+bool packARGB32( const unsigned char* src, std::size_t srcStride, int width, int height, int pixelFormat,
+	int bitsPerChannel, void* dst, std::size_t dstStride, unsigned char alpha, bool bFlipVertical, bool bParallel )
+{
+	// the kernels read one byte per channel
+	if ( bitsPerChannel != 8 )
+		return false;
+
+	// the texture rows must hold a whole image row
+	if ( width < 0 || height < 0 || dstStride < 4 * std::size_t( width ) )
+		return false;
+
+	const Kernels& k( kernels() );
+
+	PackRows rows;
+	switch ( pixelFormat )
+	{
+	case TEXTURE_LUMINANCE: rows.kernel = k.luminance; break;
+	case TEXTURE_RGB: rows.kernel = k.rgb; break;
+	case TEXTURE_BGR: rows.kernel = k.bgr; break;
+	case TEXTURE_RGBA: rows.kernel = k.rgba; break;
+	case TEXTURE_BGRA: rows.kernel = k.bgra; break;
+	case TEXTURE_YUV422: rows.kernel = k.yuv422; break;
+	default: return false;
+	}
+
+	rows.src = src;
+	rows.srcStride = srcStride;
+	rows.width = width;
+	rows.height = height;
+	rows.dst = static_cast< unsigned char* >( dst );
+	rows.dstStride = dstStride;
+	rows.alpha = boost::uint32_t( alpha ) << 24;
+	rows.bFlip = bFlipVertical;
+
+#ifdef HAVE_OPENCV
+	long nPixels = long( width ) * height;
+	if ( bParallel && nPixels >= g_minParallelPixels )
+	{
+		cv::parallel_for_( cv::Range( 0, height ), ParallelPackRows( rows ), nPixels / g_pixelsPerBand );
+		return true;
+	}
+#endif
+
+	rows( 0, height );
+	return true;
+}
+
+
+const char* texturePackingKernel()
+{
+	return kernels().sName;
+}
+
+
+bool setTexturePackingKernel( const char* sName )
+{
+	const Kernels* pKernels = 0;
+	if ( !sName )
+		pKernels = bestKernels();
+	else if ( !std::strcmp( sName, "scalar" ) )
+		pKernels = &g_scalarKernels;
+#ifdef UBITRACK_TEXTURE_X86
+	else if ( !std::strcmp( sName, "ssse3" ) && cpuSupportsSsse3() )
+		pKernels = &g_ssse3Kernels;
+	else if ( !std::strcmp( sName, "avx2" ) && cpuSupportsAvx2() )
+		pKernels = &g_avx2Kernels;
+#endif
+
+	if ( !pKernels )
+		return false;
+
+	g_pKernels.store( pKernels, boost::memory_order_release );
+	return true;
+}
+
+} } // namespace Ubitrack::Facade
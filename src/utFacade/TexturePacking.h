@@ -0,0 +1,87 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @ingroup api
+ * @file
+ * Packing of images into 32 bit ARGB textures.
+ */
+#ifndef __UBITRACK_FACADE_TEXTUREPACKING_H_INCLUDED__
+#define __UBITRACK_FACADE_TEXTUREPACKING_H_INCLUDED__
+
+#include <utFacade/utFacade.h>
+#include <cstddef>
+
+namespace Ubitrack { namespace Facade {
+
+/**
+ * Pixel formats accepted by \c packARGB32, the values of \c BasicImageMeasurement::PixelFormat,
+ * which is only declared with OpenCV.
+ */
+enum TexturePixelFormat
+{
+	TEXTURE_LUMINANCE = 1,
+	TEXTURE_RGB,
+	TEXTURE_BGR,
+	TEXTURE_RGBA,
+	TEXTURE_BGRA,
+	TEXTURE_YUV422
+};
+
+/**
+ * Packs an image into 32 bit texels 0xAARRGGBB in native byte order, as expected by ARGB32
+ * textures on little endian machines (Unity TextureFormat.BGRA32 byte layout).
+ *
+ * The row loops use AVX2 or SSSE3 if the processor supports them, see \c texturePackingKernel.
+ * Images with more than 512x512 pixels are optionally converted in bands of rows in parallel.
+ *
+ * @param src first row of the source image
+ * @param srcStride bytes between the starts of two source rows
+ * @param width width in pixels
+ * @param height height in pixels
+ * @param pixelFormat a \c TexturePixelFormat: LUMINANCE, RGB, BGR, RGBA, BGRA or YUV422 (YUYV order)
+ * @param bitsPerChannel bits per channel of the source, only 8 is supported
+ * @param dst first texel of the texture
+ * @param dstStride bytes between the starts of two texture rows, at least 4 * width
+ * @param alpha alpha of all texels. Sources with alpha (RGBA, BGRA) keep their own
+ * @param bFlipVertical write the rows in reverse order
+ * @param bParallel allow using the OpenCV thread pool for large images
+ * @return false if the pixel format or the channel depth is not supported or dstStride is too small
+ */
+UTFACADE_EXPORT bool packARGB32( const unsigned char* src, std::size_t srcStride, int width, int height, int pixelFormat,
+	int bitsPerChannel, void* dst, std::size_t dstStride, unsigned char alpha, bool bFlipVertical, bool bParallel = true );
+
+/** returns the name of the kernels used by \c packARGB32: "avx2", "ssse3" or "scalar" */
+UTFACADE_EXPORT const char* texturePackingKernel();
+
+/**
+ * Selects the kernels used by \c packARGB32, e.g. to compare them in benchmarks.
+ *
+ * @param sName "avx2", "ssse3", "scalar" or 0 for the best supported by the processor
+ * @return false if the processor or the build does not support the kernels
+ */
+UTFACADE_EXPORT bool setTexturePackingKernel( const char* sName );
+
+} } // namespace Ubitrack::Facade
+
+#endif
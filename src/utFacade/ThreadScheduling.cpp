@@ -0,0 +1,241 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @ingroup api
+ * @file
+ * Implements thread scheduling parameters on Linux.
+ */
+
+#include <sstream>
+#include <cstring>
+#include <cstdio>
+#include <log4cpp/Category.hh>
+#include <utUtil/Exception.h>
+
+#include "ThreadScheduling.h"
+
+#ifdef __linux__
+	#include <errno.h>
+	#include <sched.h>
+	#include <unistd.h>
+	#include <sys/syscall.h>
+	#include <sys/mman.h>
+	#include <sys/resource.h>
+#endif
+
+// get a logger
+static log4cpp::Category& logger( log4cpp::Category::getInstance( "Ubitrack.Facade.ThreadScheduling" ) );
+
+namespace Ubitrack { namespace Facade {
+
+#ifdef __linux__
+
+namespace {
+
+// capability bits, see linux/capability.h
+const int CAP_IPC_LOCK_BIT = 14;
+const int CAP_SYS_NICE_BIT = 23;
+
+/** true if the effective capability set of the process contains the capability */
+bool hasCapability( int capability )
+{
+	FILE* pFile = fopen( "/proc/self/status", "r" );
+	if ( !pFile )
+		return false;
+
+	bool bResult = false;
+	char line[ 256 ];
+	while ( fgets( line, sizeof( line ), pFile ) )
+		if ( strncmp( line, "CapEff:", 7 ) == 0 )
+		{
+			unsigned long long caps = strtoull( line + 7, 0, 16 );
+			bResult = ( caps & ( 1ULL << capability ) ) != 0;
+			break;
+		}
+
+	fclose( pFile );
+	return bResult;
+}
+
+
+const char* policyName( int policy )
+{ return policy == SCHED_FIFO ? "SCHED_FIFO" : "SCHED_RR"; }
+
+} // anonymous namespace
+
+
+void applyThreadScheduling( const ThreadScheduling& scheduling )
+{
+	applyThreadScheduling( static_cast< int >( syscall( SYS_gettid ) ), scheduling );
+}
+
+
+void applyThreadScheduling( int threadId, const ThreadScheduling& scheduling )
+{
+	if ( scheduling.cpuMask != 0 )
+	{
+		cpu_set_t cpus;
+		CPU_ZERO( &cpus );
+		for ( int i = 0; i < 64 && i < CPU_SETSIZE; i++ )
+			if ( scheduling.cpuMask & ( 1ULL << i ) )
+				CPU_SET( i, &cpus );
+
+		if ( sched_setaffinity( threadId, sizeof( cpus ), &cpus ) != 0 )
+		{
+			std::ostringstream msg;
+			msg << "Cannot set CPU affinity 0x" << std::hex << scheduling.cpuMask << std::dec
+				<< " of thread " << threadId << ": " << strerror( errno );
+			if ( errno == EINVAL )
+				msg << " (none of the CPUs is available to the process)";
+			UBITRACK_THROW( msg.str() );
+		}
+	}
+
+	if ( scheduling.policy != ThreadScheduling::SCHEDULE_DEFAULT )
+	{
+		int policy = scheduling.policy == ThreadScheduling::SCHEDULE_FIFO ? SCHED_FIFO : SCHED_RR;
+		struct sched_param param;
+		memset( &param, 0, sizeof( param ) );
+		param.sched_priority = scheduling.priority;
+
+		if ( sched_setscheduler( threadId, policy, &param ) != 0 )
+		{
+			std::ostringstream msg;
+			msg << "Cannot set " << policyName( policy ) << " priority "
+				<< scheduling.priority << " for thread " << threadId << ": " << strerror( errno );
+			if ( errno == EPERM )
+				msg << " (needs CAP_SYS_NICE or an RLIMIT_RTPRIO of at least " << scheduling.priority << ")";
+			UBITRACK_THROW( msg.str() );
+		}
+	}
+
+	LOG4CPP_DEBUG( logger, "Applied scheduling policy " << scheduling.policy << ", priority " << scheduling.priority
+		<< ", cpu mask 0x" << std::hex << scheduling.cpuMask << std::dec << " to thread " << threadId );
+}
+
+
+void checkThreadScheduling( const ThreadScheduling& scheduling )
+{
+	if ( scheduling.cpuMask != 0 )
+	{
+		cpu_set_t cpus;
+		CPU_ZERO( &cpus );
+		if ( sched_getaffinity( 0, sizeof( cpus ), &cpus ) == 0 )
+		{
+			bool bUsable = false;
+			for ( int i = 0; i < 64 && i < CPU_SETSIZE; i++ )
+				if ( ( scheduling.cpuMask & ( 1ULL << i ) ) && CPU_ISSET( i, &cpus ) )
+					bUsable = true;
+
+			if ( !bUsable )
+			{
+				std::ostringstream msg;
+				msg << "CPU mask 0x" << std::hex << scheduling.cpuMask << std::dec << " contains no CPU available to the process";
+				UBITRACK_THROW( msg.str() );
+			}
+		}
+	}
+
+	if ( scheduling.policy == ThreadScheduling::SCHEDULE_DEFAULT )
+		return;
+
+	int policy = scheduling.policy == ThreadScheduling::SCHEDULE_FIFO ? SCHED_FIFO : SCHED_RR;
+	int minPriority = sched_get_priority_min( policy );
+	int maxPriority = sched_get_priority_max( policy );
+	if ( scheduling.priority < minPriority || scheduling.priority > maxPriority )
+	{
+		std::ostringstream msg;
+		msg << policyName( policy ) << " priority " << scheduling.priority << " is outside of the valid range ["
+			<< minPriority << ", " << maxPriority << "]";
+		UBITRACK_THROW( msg.str() );
+	}
+
+	if ( hasCapability( CAP_SYS_NICE_BIT ) )
+		return;
+
+	struct rlimit limit;
+	if ( getrlimit( RLIMIT_RTPRIO, &limit ) == 0 && limit.rlim_cur != RLIM_INFINITY
+		&& limit.rlim_cur < static_cast< rlim_t >( scheduling.priority ) )
+	{
+		std::ostringstream msg;
+		msg << policyName( policy ) << " priority " << scheduling.priority << " needs CAP_SYS_NICE or an RLIMIT_RTPRIO of at least "
+			<< scheduling.priority << ", but the limit is " << limit.rlim_cur
+			<< " (grant the capability with setcap cap_sys_nice+ep or raise rtprio in /etc/security/limits.conf)";
+		UBITRACK_THROW( msg.str() );
+	}
+}
+
+
+void lockProcessMemory()
+{
+	if ( mlockall( MCL_CURRENT | MCL_FUTURE ) == 0 )
+	{
+		LOG4CPP_INFO( logger, "Locked process memory" );
+		return;
+	}
+
+	int error = errno;
+	std::ostringstream msg;
+	msg << "Cannot lock process memory: " << strerror( error );
+	if ( error == EPERM )
+		msg << " (needs CAP_IPC_LOCK)";
+	else if ( error == ENOMEM && !hasCapability( CAP_IPC_LOCK_BIT ) )
+	{
+		struct rlimit limit;
+		if ( getrlimit( RLIMIT_MEMLOCK, &limit ) == 0 && limit.rlim_cur != RLIM_INFINITY )
+			msg << " (the process memory exceeds RLIMIT_MEMLOCK of " << limit.rlim_cur
+				<< " bytes, raise memlock in /etc/security/limits.conf or grant CAP_IPC_LOCK)";
+	}
+	UBITRACK_THROW( msg.str() );
+}
+
+#else // __linux__
+
+void applyThreadScheduling( const ThreadScheduling& scheduling )
+{
+	if ( !scheduling.isDefault() )
+		UBITRACK_THROW( "Thread scheduling parameters are only supported on Linux" );
+}
+
+
+void applyThreadScheduling( int, const ThreadScheduling& scheduling )
+{
+	applyThreadScheduling( scheduling );
+}
+
+
+void checkThreadScheduling( const ThreadScheduling& scheduling )
+{
+	applyThreadScheduling( scheduling );
+}
+
+
+void lockProcessMemory()
+{
+	UBITRACK_THROW( "Locking process memory is only supported on Linux" );
+}
+
+#endif // __linux__
+
+} } // namespace Ubitrack::Facade
@@ -0,0 +1,109 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @ingroup api
+ * @file
+ * Real-time priority and CPU affinity for threads started by the facade.
+ */
+#ifndef __UBITRACK_FACADE_THREADSCHEDULING_H_INCLUDED__
+#define __UBITRACK_FACADE_THREADSCHEDULING_H_INCLUDED__
+
+#include <utFacade/utFacade.h>
+
+namespace Ubitrack { namespace Facade {
+
+/**
+ * Scheduling parameters for a thread.
+ *
+ * Only supported on Linux. The default-constructed object leaves the thread untouched.
+ */
+struct ThreadScheduling
+{
+	/** scheduling policy */
+	enum Policy
+	{
+		/** keep the policy inherited from the creating thread */
+		SCHEDULE_DEFAULT = 0,
+
+		/** SCHED_FIFO real-time scheduling */
+		SCHEDULE_FIFO,
+
+		/** SCHED_RR real-time scheduling */
+		SCHEDULE_RR
+	};
+
+	ThreadScheduling()
+		: policy( SCHEDULE_DEFAULT )
+		, priority( 0 )
+		, cpuMask( 0 )
+	{}
+
+	ThreadScheduling( Policy p, int prio, unsigned long long mask = 0 )
+		: policy( p )
+		, priority( prio )
+		, cpuMask( mask )
+	{}
+
+	/** true if neither policy nor affinity is changed */
+	bool isDefault() const
+	{ return policy == SCHEDULE_DEFAULT && cpuMask == 0; }
+
+	Policy policy;
+
+	/** real-time priority (1-99 on Linux), ignored for SCHEDULE_DEFAULT */
+	int priority;
+
+	/** CPUs the thread may run on, bit i corresponds to CPU i. 0 means no restriction */
+	unsigned long long cpuMask;
+};
+
+/**
+ * Applies scheduling parameters to the calling thread.
+ * Throws a \c Util::Exception if the parameters cannot be applied.
+ */
+void UTFACADE_EXPORT applyThreadScheduling( const ThreadScheduling& scheduling );
+
+/**
+ * Applies scheduling parameters to a thread of this process, identified by its kernel thread id.
+ * Throws a \c Util::Exception if the parameters cannot be applied.
+ */
+void UTFACADE_EXPORT applyThreadScheduling( int threadId, const ThreadScheduling& scheduling );
+
+/**
+ * Checks whether scheduling parameters can be applied by this process, without applying them.
+ * Throws a \c Util::Exception naming the missing privilege (CAP_SYS_NICE or RLIMIT_RTPRIO),
+ * an invalid priority or a CPU mask without usable CPUs.
+ */
+void UTFACADE_EXPORT checkThreadScheduling( const ThreadScheduling& scheduling );
+
+/**
+ * Locks all current and future pages of the process into memory (mlockall), so that page
+ * faults do not delay real-time threads. Throws a \c Util::Exception naming the missing
+ * privilege (CAP_IPC_LOCK or RLIMIT_MEMLOCK) on failure.
+ */
+void UTFACADE_EXPORT lockProcessMemory();
+
+} } // namespace Ubitrack::Facade
+
+#endif
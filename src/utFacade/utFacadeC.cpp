@@ -0,0 +1,776 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+
+/**
+ * @ingroup api
+ * @file
+ * Implements the plain C interface to the ubitrack facade.
+ */
+
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include <log4cpp/Category.hh>
+#include <boost/bind.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <utUtil/Exception.h>
+#include <utUtil/Logging.h>
+#include <utMeasurement/Measurement.h>
+
+#include "utFacadeC.h"
+#include "AdvancedFacade.h"
+
+// not nice having a relative include here, see BasicFacadeComponentsPrivate.h
+#include "../utComponents/ApplicationPullSink.h"
+#include "../utComponents/ApplicationPushSink.h"
+#include "../utComponents/ApplicationPushSource.h"
+
+// get a logger
+static log4cpp::Category& logger( log4cpp::Category::getInstance( "Ubitrack.Facade.utFacadeC" ) );
+
+using namespace Ubitrack;
+
+namespace {
+
+/**
+ * message of the last error, per thread because the functions may be called from any thread.
+ * A fixed buffer, so that reporting an error does not allocate; longer messages are truncated
+ */
+thread_local char g_lastError[ 512 ] = "";
+
+/** sets the message of the last error to the concatenation of the parts */
+int setError( int status, const char* sFirst, const char* sSecond = "", const char* sThird = "", const char* sFourth = "" )
+{
+	const char* parts[] = { sFirst, sSecond, sThird, sFourth };
+	std::size_t length = 0;
+	for ( std::size_t i = 0; i < 4; i++ )
+	{
+		std::size_t n = std::min( std::strlen( parts[ i ] ), sizeof( g_lastError ) - 1 - length );
+		std::memcpy( g_lastError + length, parts[ i ], n );
+		length += n;
+	}
+	g_lastError[ length ] = 0;
+	return status;
+}
+
+int setError( int status, const std::string& sMessage )
+{ return setError( status, sMessage.c_str() ); }
+
+/*
+ * The copyValues/setValues overloads convert between a value and its layout as doubles,
+ * see ut_type in utFacadeC.h
+ */
+
+void copyValues( const Math::Scalar< double >& v, double* data )
+{ data[ 0 ] = v; }
+
+void setValues( Math::Scalar< double >& v, const double* data )
+{ v = Math::Scalar< double >( data[ 0 ] ); }
+
+template< int LEN >
+void copyValues( const Math::Vector< double, LEN >& v, double* data )
+{
+	for ( int i = 0; i < LEN; i++ )
+		data[ i ] = v( i );
+}
+
+template< int LEN >
+void setValues( Math::Vector< double, LEN >& v, const double* data )
+{
+	for ( int i = 0; i < LEN; i++ )
+		v( i ) = data[ i ];
+}
+
+template< int ROWS, int COLS >
+void copyValues( const Math::Matrix< double, ROWS, COLS >& m, double* data )
+{
+	for ( int i = 0; i < ROWS; i++ )
+		for ( int j = 0; j < COLS; j++ )
+			data[ i * COLS + j ] = m( i, j );
+}
+
+template< int ROWS, int COLS >
+void setValues( Math::Matrix< double, ROWS, COLS >& m, const double* data )
+{
+	for ( int i = 0; i < ROWS; i++ )
+		for ( int j = 0; j < COLS; j++ )
+			m( i, j ) = data[ i * COLS + j ];
+}
+
+void copyValues( const Math::Quaternion& q, double* data )
+{
+	data[ 0 ] = q.x();
+	data[ 1 ] = q.y();
+	data[ 2 ] = q.z();
+	data[ 3 ] = q.w();
+}
+
+void setValues( Math::Quaternion& q, const double* data )
+{ q = Math::Quaternion( data[ 0 ], data[ 1 ], data[ 2 ], data[ 3 ] ); }
+
+void copyValues( const Math::Pose& p, double* data )
+{
+	copyValues( p.translation(), data );
+	copyValues( p.rotation(), data + 3 );
+}
+
+void setValues( Math::Pose& p, const double* data )
+{
+	p = Math::Pose( Math::Quaternion( data[ 3 ], data[ 4 ], data[ 5 ], data[ 6 ] ),
+		Math::Vector< double, 3 >( data[ 0 ], data[ 1 ], data[ 2 ] ) );
+}
+
+} // anonymous namespace
+
+
+/**
+ * Base of all endpoints. Operations not supported by an endpoint fail with UT_INVALID_ARGUMENT.
+ */
+struct ut_endpoint
+{
+	ut_endpoint( ut_type type, const std::string& sName )
+		: m_type( type )
+		, m_sName( sName )
+	{}
+
+	virtual ~ut_endpoint()
+	{}
+
+	virtual int pull( uint64_t, double*, uint64_t* )
+	{ return unsupported( "pull" ); }
+
+	virtual int push( uint64_t, const double* )
+	{ return unsupported( "push" ); }
+
+	virtual size_t drain( ut_sample*, size_t )
+	{
+		unsupported( "drain" );
+		return 0;
+	}
+
+	virtual uint64_t dropped() const
+	{ return 0; }
+
+	virtual int setCallback( ut_sample_callback, void* )
+	{ return unsupported( "set a callback on" ); }
+
+	int unsupported( const char* sOperation )
+	{ return setError( UT_INVALID_ARGUMENT, "Cannot ", sOperation, " endpoint ", m_sName.c_str() ); }
+
+	ut_type m_type;
+	std::string m_sName;
+};
+
+
+struct ut_facade
+{
+	ut_facade( const std::string& sComponentPath )
+		: m_facade( sComponentPath )
+	{}
+
+	Facade::AdvancedFacade m_facade;
+};
+
+
+namespace {
+
+/** ApplicationPullSink endpoint */
+template< class EventType >
+class PullSinkEndpoint
+	: public ut_endpoint
+{
+public:
+	typedef Components::ApplicationPullSink< EventType > ComponentType;
+
+	PullSinkEndpoint( ut_type type, const std::string& sName, Facade::AdvancedFacade& facade )
+		: ut_endpoint( type, sName )
+		, m_pComponent( facade.componentByName< ComponentType >( sName ) )
+	{}
+
+	int pull( uint64_t ts, double* out, uint64_t* outTs )
+	{
+		EventType m( m_pComponent->get( ts ) );
+		if ( !m )
+			return setError( UT_NO_DATA, "No measurement from ", m_sName.c_str() );
+
+		copyValues( *m, out );
+		if ( outTs )
+			*outTs = m.time();
+		return UT_OK;
+	}
+
+protected:
+	boost::shared_ptr< ComponentType > m_pComponent;
+};
+
+
+/** ApplicationPushSource endpoint */
+template< class EventType >
+class PushSourceEndpoint
+	: public ut_endpoint
+{
+public:
+	typedef Components::ApplicationPushSource< EventType > ComponentType;
+
+	PushSourceEndpoint( ut_type type, const std::string& sName, Facade::AdvancedFacade& facade )
+		: ut_endpoint( type, sName )
+		, m_pComponent( facade.componentByName< ComponentType >( sName ) )
+	{}
+
+	int push( uint64_t ts, const double* values )
+	{
+		typename EventType::value_type v;
+		setValues( v, values );
+		m_pComponent->send( EventType( ts, v ) );
+		return UT_OK;
+	}
+
+protected:
+	boost::shared_ptr< ComponentType > m_pComponent;
+};
+
+
+/** thread-local marker of the receiver whose callback runs on this thread, see SampleReceiver::detach */
+thread_local const void* g_pCallbackReceiver = 0;
+
+/**
+ * Buffers the samples of a push sink in a preallocated ring or passes them to a callback.
+ *
+ * The callback of the \c ApplicationPushSink is bound to the receiver by shared pointer and is
+ * not replaced while the dataflow may dispatch, as setting it is not synchronized with the
+ * dispatcher. Closing the endpoint detaches the receiver instead, which then ignores samples.
+ */
+class SampleReceiver
+{
+public:
+	SampleReceiver( size_t capacity )
+		: m_ring( capacity > 0 ? capacity : 1 )
+		, m_first( 0 )
+		, m_count( 0 )
+		, m_nDropped( 0 )
+		, m_callback( 0 )
+		, m_pUser( 0 )
+		, m_bDetached( false )
+		, m_nInFlight( 0 )
+	{}
+
+	/** stores a sample or passes it to the callback, which runs without the lock held */
+	void deliver( const ut_sample& sample )
+	{
+		boost::mutex::scoped_lock l( m_mutex );
+		if ( m_bDetached )
+			return;
+
+		if ( m_callback )
+		{
+			ut_sample_callback callback( m_callback );
+			void* pUser( m_pUser );
+			m_nInFlight++;
+			l.unlock();
+
+			const void* pOuter( g_pCallbackReceiver );
+			g_pCallbackReceiver = this;
+			try
+			{
+				callback( pUser, &sample );
+			}
+			catch ( ... )
+			{ LOG4CPP_ERROR( logger, "Caught exception in sample callback" ); }
+			g_pCallbackReceiver = pOuter;
+
+			l.lock();
+			m_nInFlight--;
+			m_idle.notify_all();
+			return;
+		}
+
+		if ( m_count == m_ring.size() )
+		{
+			m_first = ( m_first + 1 ) % m_ring.size();
+			m_count--;
+			m_nDropped++;
+		}
+
+		m_ring[ ( m_first + m_count ) % m_ring.size() ] = sample;
+		m_count++;
+	}
+
+	size_t drain( ut_sample* buffer, size_t capacity )
+	{
+		boost::mutex::scoped_lock l( m_mutex );
+		size_t n = std::min( capacity, m_count );
+		for ( size_t i = 0; i < n; i++ )
+			buffer[ i ] = m_ring[ ( m_first + i ) % m_ring.size() ];
+
+		m_first = ( m_first + n ) % m_ring.size();
+		m_count -= n;
+		return n;
+	}
+
+	uint64_t dropped() const
+	{
+		boost::mutex::scoped_lock l( m_mutex );
+		return m_nDropped;
+	}
+
+	void setCallback( ut_sample_callback callback, void* pUser )
+	{
+		boost::mutex::scoped_lock l( m_mutex );
+		m_callback = callback;
+		m_pUser = pUser;
+	}
+
+	/** ignores further samples and waits for the callbacks in progress, except the one calling it */
+	void detach()
+	{
+		boost::mutex::scoped_lock l( m_mutex );
+		m_bDetached = true;
+
+		unsigned int nOwn = g_pCallbackReceiver == this ? 1 : 0;
+		while ( m_nInFlight > nOwn )
+			m_idle.wait( l );
+
+		// the receiver lives as long as the sink, do not keep the ring
+		std::vector< ut_sample >( 1 ).swap( m_ring );
+		m_first = 0;
+		m_count = 0;
+	}
+
+protected:
+	std::vector< ut_sample > m_ring;
+	size_t m_first;
+	size_t m_count;
+	uint64_t m_nDropped;
+
+	ut_sample_callback m_callback;
+	void* m_pUser;
+
+	bool m_bDetached;
+	unsigned int m_nInFlight;
+
+	mutable boost::mutex m_mutex;
+	boost::condition_variable m_idle;
+};
+
+
+/** ApplicationPushSink endpoint */
+template< class EventType >
+class PushSinkEndpoint
+	: public ut_endpoint
+{
+public:
+	typedef Components::ApplicationPushSink< EventType > ComponentType;
+
+	PushSinkEndpoint( ut_type type, const std::string& sName, Facade::AdvancedFacade& facade, size_t capacity )
+		: ut_endpoint( type, sName )
+		, m_pComponent( facade.componentByName< ComponentType >( sName ) )
+		, m_pReceiver( new SampleReceiver( capacity ) )
+	{
+		m_pComponent->setCallback( boost::bind( &PushSinkEndpoint::receive, m_pReceiver, _1 ) );
+	}
+
+	~PushSinkEndpoint()
+	{
+		// no callback runs after this, the component keeps the detached receiver
+		m_pReceiver->detach();
+	}
+
+	size_t drain( ut_sample* buffer, size_t capacity )
+	{ return m_pReceiver->drain( buffer, capacity ); }
+
+	uint64_t dropped() const
+	{ return m_pReceiver->dropped(); }
+
+	int setCallback( ut_sample_callback callback, void* pUser )
+	{
+		m_pReceiver->setCallback( callback, pUser );
+		return UT_OK;
+	}
+
+protected:
+	static void receive( const boost::shared_ptr< SampleReceiver >& pReceiver, const EventType& m )
+	{
+		ut_sample sample;
+		sample.timestamp = m.time();
+		copyValues( *m, sample.values );
+		pReceiver->deliver( sample );
+	}
+
+	boost::shared_ptr< ComponentType > m_pComponent;
+	boost::shared_ptr< SampleReceiver > m_pReceiver;
+};
+
+
+enum EndpointKind { PULL_SINK, PUSH_SINK, PUSH_SOURCE };
+
+template< class EventType >
+ut_endpoint* createEndpoint( EndpointKind kind, ut_type type, const std::string& sName, Facade::AdvancedFacade& facade, size_t capacity )
+{
+	switch ( kind )
+	{
+	case PULL_SINK: return new PullSinkEndpoint< EventType >( type, sName, facade );
+	case PUSH_SINK: return new PushSinkEndpoint< EventType >( type, sName, facade, capacity );
+	default: return new PushSourceEndpoint< EventType >( type, sName, facade );
+	}
+}
+
+ut_endpoint* openEndpoint( ut_facade* facade, const char* name, ut_type type, EndpointKind kind, size_t capacity )
+{
+	if ( !facade || !name )
+	{
+		setError( UT_INVALID_ARGUMENT, "No facade or endpoint name given" );
+		return 0;
+	}
+
+	try
+	{
+		Facade::AdvancedFacade& f( facade->m_facade );
+		switch ( type )
+		{
+		case UT_SCALAR: return createEndpoint< Measurement::Distance >( kind, type, name, f, capacity );
+		case UT_POSITION2D: return createEndpoint< Measurement::Position2D >( kind, type, name, f, capacity );
+		case UT_POSITION: return createEndpoint< Measurement::Position >( kind, type, name, f, capacity );
+		case UT_ROTATION: return createEndpoint< Measurement::Rotation >( kind, type, name, f, capacity );
+		case UT_POSE: return createEndpoint< Measurement::Pose >( kind, type, name, f, capacity );
+		case UT_MATRIX3X3: return createEndpoint< Measurement::Matrix3x3 >( kind, type, name, f, capacity );
+		case UT_MATRIX3X4: return createEndpoint< Measurement::Matrix3x4 >( kind, type, name, f, capacity );
+		case UT_MATRIX4X4: return createEndpoint< Measurement::Matrix4x4 >( kind, type, name, f, capacity );
+		}
+		setError( UT_INVALID_ARGUMENT, "Unknown measurement type" );
+	}
+	catch ( const Util::Exception& e )
+	{
+		LOG4CPP_ERROR( logger, "Cannot open endpoint " << name << ": " << e );
+		setError( UT_ERROR, e.what() );
+	}
+	catch ( const std::exception& e )
+	{
+		LOG4CPP_ERROR( logger, "Cannot open endpoint " << name << ": " << e.what() );
+		setError( UT_ERROR, e.what() );
+	}
+	catch ( ... )
+	{
+		LOG4CPP_ERROR( logger, "Cannot open endpoint " << name << ": unknown exception" );
+		setError( UT_ERROR, "Unknown exception opening endpoint ", name );
+	}
+	return 0;
+}
+
+/** checks that a caller buffer holds a measurement of the endpoint's type */
+int checkBuffer( ut_endpoint* endpoint, const void* buffer, size_t size )
+{
+	if ( !endpoint || !buffer )
+		return setError( UT_INVALID_ARGUMENT, "No endpoint or buffer given" );
+	if ( size < ut_value_count( endpoint->m_type ) )
+		return setError( UT_INVALID_ARGUMENT, "Buffer too small for a measurement of ", endpoint->m_sName.c_str() );
+	return UT_OK;
+}
+
+/** runs an operation of the facade, translating exceptions */
+template< class Operation >
+int facadeCall( ut_facade* facade, const char* sWhat, Operation op )
+{
+	if ( !facade )
+		return setError( UT_INVALID_ARGUMENT, "No facade given" );
+
+	try
+	{
+		op( facade->m_facade );
+		return UT_OK;
+	}
+	catch ( const Util::Exception& e )
+	{
+		LOG4CPP_ERROR( logger, "Cannot " << sWhat << ": " << e );
+		return setError( UT_ERROR, e.what() );
+	}
+	catch ( const std::exception& e )
+	{
+		LOG4CPP_ERROR( logger, "Cannot " << sWhat << ": " << e.what() );
+		return setError( UT_ERROR, e.what() );
+	}
+	catch ( ... )
+	{
+		LOG4CPP_ERROR( logger, "Cannot " << sWhat << ": unknown exception" );
+		return setError( UT_ERROR, "Unknown exception, cannot ", sWhat );
+	}
+}
+
+} // anonymous namespace
+
+
+extern "C" {
+
+unsigned int ut_value_count( ut_type type )
+{
+	switch ( type )
+	{
+	case UT_SCALAR: return 1;
+	case UT_POSITION2D: return 2;
+	case UT_POSITION: return 3;
+	case UT_ROTATION: return 4;
+	case UT_POSE: return 7;
+	case UT_MATRIX3X3: return 9;
+	case UT_MATRIX3X4: return 12;
+	case UT_MATRIX4X4: return 16;
+	}
+	return 0;
+}
+
+
+uint64_t ut_now( void )
+{
+	return Measurement::now();
+}
+
+
+const char* ut_last_error( void )
+{
+	return g_lastError;
+}
+
+
+void ut_init_logging( const char* filename )
+{
+	Util::initLogging( filename );
+}
+
+
+ut_facade* ut_facade_create( const char* component_path )
+{
+	try
+	{
+		return new ut_facade( component_path ? component_path : "" );
+	}
+	catch ( const Util::Exception& e )
+	{
+		LOG4CPP_ERROR( logger, "Cannot create facade: " << e );
+		setError( UT_ERROR, e.what() );
+	}
+	catch ( const std::exception& e )
+	{
+		LOG4CPP_ERROR( logger, "Cannot create facade: " << e.what() );
+		setError( UT_ERROR, e.what() );
+	}
+	catch ( ... )
+	{
+		LOG4CPP_ERROR( logger, "Cannot create facade: unknown exception" );
+		setError( UT_ERROR, "Unknown exception creating facade" );
+	}
+	return 0;
+}
+
+
+void ut_facade_destroy( ut_facade* facade )
+{
+	delete facade;
+}
+
+
+int ut_load_dataflow( ut_facade* facade, const char* filename )
+{
+	if ( !filename )
+		return setError( UT_INVALID_ARGUMENT, "No file name given" );
+	return facadeCall( facade, "load dataflow", [ filename ]( Facade::AdvancedFacade& f )
+	{ f.loadDataflow( std::string( filename ) ); } );
+}
+
+
+int ut_load_dataflow_string( ut_facade* facade, const char* utql )
+{
+	if ( !utql )
+		return setError( UT_INVALID_ARGUMENT, "No dataflow given" );
+	return facadeCall( facade, "load dataflow", [ utql ]( Facade::AdvancedFacade& f )
+	{
+		std::istringstream stream( utql );
+		f.loadDataflow( stream );
+	} );
+}
+
+
+int ut_clear_dataflow( ut_facade* facade )
+{
+	return facadeCall( facade, "clear dataflow", []( Facade::AdvancedFacade& f ) { f.clearDataflow(); } );
+}
+
+
+int ut_start_dataflow( ut_facade* facade )
+{
+	return facadeCall( facade, "start dataflow", []( Facade::AdvancedFacade& f ) { f.startDataflow(); } );
+}
+
+
+int ut_stop_dataflow( ut_facade* facade )
+{
+	return facadeCall( facade, "stop dataflow", []( Facade::AdvancedFacade& f ) { f.stopDataflow(); } );
+}
+
+
+ut_endpoint* ut_pull_sink( ut_facade* facade, const char* name, ut_type type )
+{
+	return openEndpoint( facade, name, type, PULL_SINK, 0 );
+}
+
+
+ut_endpoint* ut_push_sink( ut_facade* facade, const char* name, ut_type type, size_t capacity )
+{
+	return openEndpoint( facade, name, type, PUSH_SINK, capacity );
+}
+
+
+ut_endpoint* ut_push_source( ut_facade* facade, const char* name, ut_type type )
+{
+	return openEndpoint( facade, name, type, PUSH_SOURCE, 0 );
+}
+
+
+void ut_endpoint_destroy( ut_endpoint* endpoint )
+{
+	delete endpoint;
+}
+
+
+ut_type ut_endpoint_type( const ut_endpoint* endpoint )
+{
+	return endpoint->m_type;
+}
+
+
+int ut_pull( ut_endpoint* sink, uint64_t ts, double* out, size_t size, uint64_t* out_ts )
+{
+	int status = checkBuffer( sink, out, size );
+	if ( status != UT_OK )
+		return status;
+
+	try
+	{
+		return sink->pull( ts, out, out_ts );
+	}
+	catch ( const Util::Exception& e )
+	{
+		// no measurement available yet is common, so do not log
+		return setError( UT_NO_DATA, e.what() );
+	}
+	catch ( const std::exception& e )
+	{
+		LOG4CPP_ERROR( logger, "Cannot pull from " << sink->m_sName << ": " << e.what() );
+		return setError( UT_ERROR, e.what() );
+	}
+	catch ( ... )
+	{
+		LOG4CPP_ERROR( logger, "Cannot pull from " << sink->m_sName << ": unknown exception" );
+		return setError( UT_ERROR, "Unknown exception pulling from ", sink->m_sName.c_str() );
+	}
+}
+
+
+int ut_push( ut_endpoint* source, uint64_t ts, const double* values, size_t size )
+{
+	int status = checkBuffer( source, values, size );
+	if ( status != UT_OK )
+		return status;
+
+	try
+	{
+		return source->push( ts, values );
+	}
+	catch ( const Util::Exception& e )
+	{
+		LOG4CPP_ERROR( logger, "Cannot push to " << source->m_sName << ": " << e );
+		return setError( UT_ERROR, e.what() );
+	}
+	catch ( const std::exception& e )
+	{
+		LOG4CPP_ERROR( logger, "Cannot push to " << source->m_sName << ": " << e.what() );
+		return setError( UT_ERROR, e.what() );
+	}
+	catch ( ... )
+	{
+		LOG4CPP_ERROR( logger, "Cannot push to " << source->m_sName << ": unknown exception" );
+		return setError( UT_ERROR, "Unknown exception pushing to ", source->m_sName.c_str() );
+	}
+}
+
+
+size_t ut_drain( ut_endpoint* sink, ut_sample* buffer, size_t capacity )
+{
+	if ( !sink || !buffer )
+	{
+		setError( UT_INVALID_ARGUMENT, "No endpoint or buffer given" );
+		return 0;
+	}
+	return sink->drain( buffer, capacity );
+}
+
+
+uint64_t ut_dropped( const ut_endpoint* sink )
+{
+	return sink ? sink->dropped() : 0;
+}
+
+
+int ut_set_callback( ut_endpoint* sink, ut_sample_callback callback, void* user )
+{
+	if ( !sink )
+		return setError( UT_INVALID_ARGUMENT, "No endpoint given" );
+	return sink->setCallback( callback, user );
+}
+
+
+int ut_pull_pose( ut_endpoint* sink, uint64_t ts, double out[ 7 ], uint64_t* out_ts )
+{
+	if ( sink && sink->m_type != UT_POSE )
+		return setError( UT_INVALID_ARGUMENT, sink->m_sName.c_str(), " is not a pose endpoint" );
+	return ut_pull( sink, ts, out, 7, out_ts );
+}
+
+
+int ut_push_pose( ut_endpoint* source, uint64_t ts, const double pose[ 7 ] )
+{
+	if ( source && source->m_type != UT_POSE )
+		return setError( UT_INVALID_ARGUMENT, source->m_sName.c_str(), " is not a pose endpoint" );
+	return ut_push( source, ts, pose, 7 );
+}
+
+
+int ut_pull_position( ut_endpoint* sink, uint64_t ts, double out[ 3 ], uint64_t* out_ts )
+{
+	if ( sink && sink->m_type != UT_POSITION )
+		return setError( UT_INVALID_ARGUMENT, sink->m_sName.c_str(), " is not a position endpoint" );
+	return ut_pull( sink, ts, out, 3, out_ts );
+}
+
+
+int ut_push_position( ut_endpoint* source, uint64_t ts, const double position[ 3 ] )
+{
+	if ( source && source->m_type != UT_POSITION )
+		return setError( UT_INVALID_ARGUMENT, source->m_sName.c_str(), " is not a position endpoint" );
+	return ut_push( source, ts, position, 3 );
+}
+
+} // extern "C"
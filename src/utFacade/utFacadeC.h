@@ -0,0 +1,223 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+
+/**
+ * @ingroup api
+ * @file
+ * Plain C interface to the ubitrack facade, for hosts that call native code through a foreign
+ * function interface (Rust, Julia, LuaJIT, ...) and cannot use the C++ templates of the
+ * \c BasicFacade.
+ *
+ * Facades and endpoints are opaque handles. Measurements are exchanged as arrays of doubles in
+ * memory owned by the caller, see \c ut_type for the layout of each type. Pulling, pushing and
+ * draining allocate no memory in this layer, also not for error messages. Components that
+ * report missing data by throwing, as most pull suppliers do, allocate the exception.
+ *
+ * Functions returning \c int return \c UT_OK or a negative \c ut_status. The message of the last
+ * error of the calling thread is returned by \c ut_last_error.
+ */
+#ifndef __UBITRACK_FACADE_UTFACADEC_H_INCLUDED__
+#define __UBITRACK_FACADE_UTFACADEC_H_INCLUDED__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <utFacade/utFacade.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** a facade with its dataflow network */
+typedef struct ut_facade ut_facade;
+
+/** a pull sink, push sink or push source of a facade */
+typedef struct ut_endpoint ut_endpoint;
+
+typedef enum ut_status
+{
+	UT_OK = 0,
+
+	/** the operation failed, see \c ut_last_error */
+	UT_ERROR = -1,
+
+	/** the endpoint has no measurement for the requested time */
+	UT_NO_DATA = -2,
+
+	/** a handle or buffer is NULL, a buffer is too small or the endpoint does not support the operation */
+	UT_INVALID_ARGUMENT = -3
+} ut_status;
+
+/**
+ * Measurement types and their layout as doubles. Matrices are stored row-major.
+ */
+typedef enum ut_type
+{
+	/** distance: [v] */
+	UT_SCALAR = 0,
+
+	/** 2D position: [x, y] */
+	UT_POSITION2D,
+
+	/** 3D position: [x, y, z] */
+	UT_POSITION,
+
+	/** rotation quaternion: [rx, ry, rz, rw] */
+	UT_ROTATION,
+
+	/** pose: [x, y, z, rx, ry, rz, rw] */
+	UT_POSE,
+
+	UT_MATRIX3X3,
+	UT_MATRIX3X4,
+	UT_MATRIX4X4
+} ut_type;
+
+/** number of doubles of the largest type */
+#define UT_MAX_VALUES 16
+
+/** one measurement received by a push sink */
+typedef struct ut_sample
+{
+	/** timestamp in nanoseconds since the epoch */
+	uint64_t timestamp;
+
+	/** the first \c ut_value_count(type) entries are used */
+	double values[ UT_MAX_VALUES ];
+} ut_sample;
+
+/** called for each measurement of a push sink, on a thread of the dataflow */
+typedef void ( *ut_sample_callback )( void* user, const ut_sample* sample );
+
+
+/** number of doubles of a measurement of the given type, 0 for an unknown type */
+unsigned int UTFACADE_EXPORT ut_value_count( ut_type type );
+
+/** the current time in nanoseconds, as used for timestamps */
+uint64_t UTFACADE_EXPORT ut_now( void );
+
+/** the message of the last error of the calling thread, empty if there was none. Valid until the next error */
+const char* UTFACADE_EXPORT ut_last_error( void );
+
+/** initializes logging from a log4cpp configuration file */
+void UTFACADE_EXPORT ut_init_logging( const char* filename );
+
+
+/**
+ * Creates a facade.
+ * @param component_path directory of the component libraries, NULL for the default
+ * @return the facade, NULL on error
+ */
+ut_facade* UTFACADE_EXPORT ut_facade_create( const char* component_path );
+
+/** stops the dataflow and destroys the facade. Its endpoints must be destroyed first */
+void UTFACADE_EXPORT ut_facade_destroy( ut_facade* facade );
+
+/** loads a UTQL dataflow from a file, replacing the current one */
+int UTFACADE_EXPORT ut_load_dataflow( ut_facade* facade, const char* filename );
+
+/** loads a UTQL dataflow from a string, replacing the current one */
+int UTFACADE_EXPORT ut_load_dataflow_string( ut_facade* facade, const char* utql );
+
+/** removes all components. Endpoints of the removed components stop working and must be destroyed */
+int UTFACADE_EXPORT ut_clear_dataflow( ut_facade* facade );
+
+int UTFACADE_EXPORT ut_start_dataflow( ut_facade* facade );
+int UTFACADE_EXPORT ut_stop_dataflow( ut_facade* facade );
+
+
+/**
+ * Opens the \c ApplicationPullSink of the given type and name.
+ * @return the endpoint, NULL on error
+ */
+ut_endpoint* UTFACADE_EXPORT ut_pull_sink( ut_facade* facade, const char* name, ut_type type );
+
+/**
+ * Opens the \c ApplicationPushSink of the given type and name.
+ *
+ * Measurements are buffered in a ring of \c capacity samples, allocated here, until they are
+ * read with \c ut_drain. When the ring is full, the oldest sample is dropped.
+ *
+ * @return the endpoint, NULL on error
+ */
+ut_endpoint* UTFACADE_EXPORT ut_push_sink( ut_facade* facade, const char* name, ut_type type, size_t capacity );
+
+/**
+ * Opens the \c ApplicationPushSource of the given type and name.
+ * @return the endpoint, NULL on error
+ */
+ut_endpoint* UTFACADE_EXPORT ut_push_source( ut_facade* facade, const char* name, ut_type type );
+
+/**
+ * closes an endpoint. No callback runs after this returns, except the one calling it when a
+ * push sink is closed from its own callback
+ */
+void UTFACADE_EXPORT ut_endpoint_destroy( ut_endpoint* endpoint );
+
+/** the measurement type of an endpoint */
+ut_type UTFACADE_EXPORT ut_endpoint_type( const ut_endpoint* endpoint );
+
+
+/**
+ * Pulls a measurement from a pull sink.
+ *
+ * @param ts the requested timestamp
+ * @param out receives \c ut_value_count doubles
+ * @param size number of doubles in \c out
+ * @param out_ts receives the timestamp of the measurement, may be NULL
+ */
+int UTFACADE_EXPORT ut_pull( ut_endpoint* sink, uint64_t ts, double* out, size_t size, uint64_t* out_ts );
+
+/** sends a measurement of \c size doubles through a push source */
+int UTFACADE_EXPORT ut_push( ut_endpoint* source, uint64_t ts, const double* values, size_t size );
+
+/**
+ * Moves up to \c capacity buffered measurements of a push sink into \c buffer, oldest first.
+ * @return the number of samples written
+ */
+size_t UTFACADE_EXPORT ut_drain( ut_endpoint* sink, ut_sample* buffer, size_t capacity );
+
+/** number of measurements a push sink dropped because its ring was full */
+uint64_t UTFACADE_EXPORT ut_dropped( const ut_endpoint* sink );
+
+/**
+ * Makes a push sink call \c callback for each measurement instead of buffering it, NULL to
+ * buffer again. The callback runs on the dataflow thread and must return quickly. It may call
+ * the functions of the same endpoint, including \c ut_endpoint_destroy.
+ */
+int UTFACADE_EXPORT ut_set_callback( ut_endpoint* sink, ut_sample_callback callback, void* user );
+
+
+/* typed shortcuts for the most common types */
+
+int UTFACADE_EXPORT ut_pull_pose( ut_endpoint* sink, uint64_t ts, double out[ 7 ], uint64_t* out_ts );
+int UTFACADE_EXPORT ut_push_pose( ut_endpoint* source, uint64_t ts, const double pose[ 7 ] );
+
+int UTFACADE_EXPORT ut_pull_position( ut_endpoint* sink, uint64_t ts, double out[ 3 ], uint64_t* out_ts );
+int UTFACADE_EXPORT ut_push_position( ut_endpoint* source, uint64_t ts, const double position[ 3 ] );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
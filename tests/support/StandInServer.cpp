@@ -0,0 +1,245 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @file
+ * Implements the stand-in server.
+ */
+
+#include <sstream>
+#include <log4cpp/Category.hh>
+#include <boost/bind.hpp>
+#include <utUtil/Exception.h>
+#include <utClientServer/TcpConnection.h>
+
+#include "StandInServer.h"
+
+// get a logger
+static log4cpp::Category& logger( log4cpp::Category::getInstance( "Ubitrack.Testing.StandInServer" ) );
+
+namespace Ubitrack { namespace Testing {
+
+namespace {
+
+/** keeps dropped connections alive until their aborted handlers have run */
+template< class T >
+void releaseClients( const T& )
+{}
+
+} // anonymous namespace
+
+
+StandInServer::StandInServer( const ResponderType& responder, unsigned short port )
+	: m_responder( responder )
+	, m_pWork( new boost::asio::io_service::work( m_ioService ) )
+	, m_acceptor( m_ioService )
+	, m_nRequests( 0 )
+{
+	boost::asio::ip::tcp::endpoint endpoint( boost::asio::ip::address_v4::loopback(), port );
+	try
+	{
+		m_acceptor.open( endpoint.protocol() );
+		m_acceptor.set_option( boost::asio::ip::tcp::acceptor::reuse_address( true ) );
+		m_acceptor.bind( endpoint );
+		m_acceptor.listen();
+	}
+	catch ( const boost::system::system_error& e )
+	{
+		std::ostringstream msg;
+		msg << "Stand-in server cannot listen on port " << port << ": " << e.what();
+		UBITRACK_THROW( msg.str() );
+	}
+
+	LOG4CPP_INFO( logger, "Stand-in server listening on " << address() );
+
+	startAccept();
+	m_pThread.reset( new boost::thread( boost::bind( &boost::asio::io_service::run, &m_ioService ) ) );
+}
+
+
+StandInServer::~StandInServer()
+{
+	m_ioService.stop();
+	m_pThread->join();
+
+	// nothing runs concurrently anymore
+	boost::system::error_code ignored;
+	m_acceptor.close( ignored );
+	doDropConnections();
+}
+
+
+unsigned short StandInServer::port() const
+{
+	return m_acceptor.local_endpoint().port();
+}
+
+
+std::string StandInServer::address() const
+{
+	std::ostringstream s;
+	s << "127.0.0.1:" << port();
+	return s.str();
+}
+
+
+void StandInServer::push( const std::string& sUtql )
+{
+	boost::shared_ptr< const std::string > pUtql( new std::string( markPush( sUtql ) ) );
+	m_ioService.post( boost::bind( &StandInServer::doPush, this, pUtql ) );
+}
+
+
+void StandInServer::pushBeforeNextAnswer( const std::string& sUtql )
+{
+	boost::mutex::scoped_lock l( m_clientsMutex );
+	m_pushesBeforeAnswer.push_back( markPush( sUtql ) );
+}
+
+
+void StandInServer::dropConnections()
+{
+	m_ioService.post( boost::bind( &StandInServer::doDropConnections, this ) );
+}
+
+
+unsigned long long StandInServer::requestCount() const
+{
+	return m_nRequests.load();
+}
+
+
+std::size_t StandInServer::clientCount() const
+{
+	boost::mutex::scoped_lock l( m_clientsMutex );
+	return m_clients.size();
+}
+
+
+void StandInServer::startAccept()
+{
+	boost::shared_ptr< boost::asio::ip::tcp::socket > pSocket( new boost::asio::ip::tcp::socket( m_ioService ) );
+	m_acceptor.async_accept( *pSocket, boost::bind( &StandInServer::handleAccept, this, pSocket, boost::asio::placeholders::error ) );
+}
+
+
+void StandInServer::handleAccept( boost::shared_ptr< boost::asio::ip::tcp::socket > pSocket, const boost::system::error_code& error )
+{
+	if ( error == boost::asio::error::operation_aborted )
+		return;
+
+	if ( error )
+		LOG4CPP_WARN( logger, "Stand-in server cannot accept connection: " << error.message() );
+	else
+	{
+		LOG4CPP_INFO( logger, "Stand-in server accepted client " << pSocket->remote_endpoint() );
+
+		Client client;
+		client.pSocket = pSocket;
+		client.pConnection.reset( new ClientServer::TcpConnection( pSocket ) );
+		client.pConnection->setReceiver( boost::bind( &StandInServer::receive, this, client.pConnection.get(), _1 ) );
+
+		boost::mutex::scoped_lock l( m_clientsMutex );
+
+		// forget clients that went away
+		std::vector< Client >::iterator it = m_clients.begin();
+		while ( it != m_clients.end() )
+			if ( it->pConnection->badConnection() )
+				it = m_clients.erase( it );
+			else
+				it++;
+
+		m_clients.push_back( client );
+	}
+
+	startAccept();
+}
+
+
+void StandInServer::receive( ClientServer::TcpConnection* pConnection, boost::shared_ptr< ClientServer::ClientServerConnection::BufferType > pBuffer )
+{
+	std::string sRequest( pBuffer->begin(), pBuffer->end() );
+	LOG4CPP_DEBUG( logger, "Stand-in server received request of " << sRequest.size() << " bytes" );
+
+	m_nRequests.fetch_add( 1 );
+	std::string sResponse( m_responder( sRequest ) );
+
+	std::vector< std::string > pushes;
+	{
+		boost::mutex::scoped_lock l( m_clientsMutex );
+		pushes.swap( m_pushesBeforeAnswer );
+	}
+	for ( std::vector< std::string >::iterator it = pushes.begin(); it != pushes.end(); it++ )
+		doPush( boost::shared_ptr< const std::string >( new std::string( *it ) ) );
+
+	if ( !sResponse.empty() )
+		pConnection->send( sResponse );
+}
+
+
+std::string StandInServer::markPush( const std::string& sUtql )
+{
+	// mark the message as a push on its root element, see Facade::ServerConnection
+	std::string sPush( sUtql );
+	std::string::size_type iRoot = 0;
+	while ( ( iRoot = sPush.find( '<', iRoot ) ) != std::string::npos && iRoot + 1 < sPush.size() 
+		&& ( sPush[ iRoot + 1 ] == '?' || sPush[ iRoot + 1 ] == '!' ) )
+		iRoot++;
+	if ( iRoot != std::string::npos )
+	{
+		std::string::size_type iName = sPush.find_first_of( " \t\r\n/>", iRoot );
+		if ( iName != std::string::npos )
+			sPush.insert( iName, " type=\"push\"" );
+	}
+	return sPush;
+}
+
+
+void StandInServer::doPush( boost::shared_ptr< const std::string > pUtql )
+{
+	for ( std::vector< Client >::iterator it = m_clients.begin(); it != m_clients.end(); it++ )
+		if ( !it->pConnection->badConnection() )
+			it->pConnection->send( *pUtql );
+}
+
+
+void StandInServer::doDropConnections()
+{
+	std::vector< Client > clients;
+	{
+		boost::mutex::scoped_lock l( m_clientsMutex );
+		clients.swap( m_clients );
+	}
+
+	for ( std::vector< Client >::iterator it = clients.begin(); it != clients.end(); it++ )
+	{
+		boost::system::error_code ignored;
+		it->pSocket->close( ignored );
+	}
+
+	// aborted handlers may still refer to the connections
+	if ( !clients.empty() && !m_ioService.stopped() )
+		m_ioService.post( boost::bind( &releaseClients< std::vector< Client > >, clients ) );
+}
+
+} } // namespace Ubitrack::Testing
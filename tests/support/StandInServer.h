@@ -0,0 +1,144 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @file
+ * A minimal local stand-in for the ubitrack server, used by the facade tests and the benchmark.
+ */
+#ifndef __UBITRACK_TESTING_STANDINSERVER_H_INCLUDED__
+#define __UBITRACK_TESTING_STANDINSERVER_H_INCLUDED__
+
+#include <string>
+#include <vector>
+#include <boost/asio.hpp>
+#include <boost/atomic.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread.hpp>
+#include <boost/noncopyable.hpp>
+#include <utClientServer/ClientServerConnection.h>
+
+namespace Ubitrack {
+	namespace ClientServer {
+		class TcpConnection;
+	}
+}
+
+namespace Ubitrack { namespace Testing {
+
+/**
+ * Accepts facade connections on the loopback interface and answers their UTQL requests.
+ *
+ * The server speaks the framing of \c ClientServer::TcpConnection, so facades connect to it with
+ * \c AdvancedFacade::connectToServer exactly as to the real server. It does no pattern matching:
+ * the responder function decides which UTQL response is sent for a request. All network
+ * operations run on a thread owned by the server.
+ */
+class StandInServer
+	: private boost::noncopyable
+{
+public:
+	/** 
+	 * returns the UTQL response for a request, called on the network thread. An empty response
+	 * is not sent, which leaves the request unanswered
+	 */
+	typedef boost::function< std::string( const std::string& ) > ResponderType;
+
+	/**
+	 * Starts listening.
+	 *
+	 * @param responder produces the responses
+	 * @param port port on 127.0.0.1, 0 to let the system choose one
+	 */
+	StandInServer( const ResponderType& responder, unsigned short port = 0 );
+
+	~StandInServer();
+
+	/** the port the server listens on */
+	unsigned short port() const;
+
+	/** address to pass to \c AdvancedFacade::connectToServer */
+	std::string address() const;
+
+	/** 
+	 * sends a reconfiguration to all connected facades without a preceding request, 
+	 * marked as a push with the attribute type="push" on its root element
+	 */
+	void push( const std::string& sUtql );
+
+	/** 
+	 * sends a push to all connected facades right before the answer to the next request, 
+	 * to interleave a push with a pending request deterministically
+	 */
+	void pushBeforeNextAnswer( const std::string& sUtql );
+
+	/** closes all client connections, e.g. to exercise reconnecting */
+	void dropConnections();
+
+	/** number of requests answered so far */
+	unsigned long long requestCount() const;
+
+	/** number of currently connected clients */
+	std::size_t clientCount() const;
+
+protected:
+	/** an accepted client */
+	struct Client
+	{
+		boost::shared_ptr< boost::asio::ip::tcp::socket > pSocket;
+		boost::shared_ptr< ClientServer::TcpConnection > pConnection;
+	};
+
+	void startAccept();
+	void handleAccept( boost::shared_ptr< boost::asio::ip::tcp::socket > pSocket, const boost::system::error_code& error );
+
+	/** answers a request received from a client */
+	void receive( ClientServer::TcpConnection* pConnection, boost::shared_ptr< ClientServer::ClientServerConnection::BufferType > pBuffer );
+
+	/** marks a message as a push with the attribute type="push" on its root element */
+	static std::string markPush( const std::string& sUtql );
+
+	void doPush( boost::shared_ptr< const std::string > pUtql );
+	void doDropConnections();
+
+	ResponderType m_responder;
+
+	boost::asio::io_service m_ioService;
+	boost::scoped_ptr< boost::asio::io_service::work > m_pWork;
+	boost::asio::ip::tcp::acceptor m_acceptor;
+	boost::scoped_ptr< boost::thread > m_pThread;
+
+	/** accessed on the network thread only, except for \c clientCount */
+	std::vector< Client > m_clients;
+	mutable boost::mutex m_clientsMutex;
+
+	/** pushes to send before the next answer, protected by the clients mutex */
+	std::vector< std::string > m_pushesBeforeAnswer;
+
+	boost::atomic< unsigned long long > m_nRequests;
+};
+
+} } // namespace Ubitrack::Testing
+
+#endif
@@ -0,0 +1,203 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @file
+ * Checks the element layouts of the bulk copies and that they stay within the capacity of
+ * the destination.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+#include <boost/cstdint.hpp>
+
+#include <utFacade/Config.h>
+#include <utFacade/BulkCopy.h>
+
+using namespace Ubitrack;
+
+
+namespace {
+
+/** marks the doubles the copies must not touch */
+const double g_sentinel = -12345.0;
+
+} // anonymous namespace
+
+
+BOOST_AUTO_TEST_CASE( testPositionLists )
+{
+	Facade::SimplePosition2DList list2D;
+	Facade::SimplePositionList3D list3D;
+	Facade::SimpleErrorPositionList3D errorList;
+	list2D.values.resize( 3 );
+	list3D.values.resize( 3 );
+	errorList.values.resize( 3 );
+	for ( int i = 0; i < 3; i++ )
+	{
+		list2D.values[ i ].x = list3D.values[ i ].x = errorList.values[ i ].x = 10 * i + 1;
+		list2D.values[ i ].y = list3D.values[ i ].y = errorList.values[ i ].y = 10 * i + 2;
+		list3D.values[ i ].z = errorList.values[ i ].z = 10 * i + 3;
+		for ( int j = 0; j < 9; j++ )
+			errorList.values[ i ].covariance[ j ] = 100 * i + j;
+	}
+
+	std::vector< double > dst( 4 * 12, g_sentinel );
+	BOOST_CHECK_EQUAL( Facade::copyPositionList( list2D, &dst[ 0 ], 4 ), 3u );
+	const double expected2D[] = { 1, 2, 11, 12, 21, 22 };
+	BOOST_CHECK_EQUAL_COLLECTIONS( dst.begin(), dst.begin() + 6, expected2D, expected2D + 6 );
+	BOOST_CHECK_EQUAL( dst[ 6 ], g_sentinel );
+
+	dst.assign( dst.size(), g_sentinel );
+	BOOST_CHECK_EQUAL( Facade::copyPositionList( list3D, &dst[ 0 ], 4 ), 3u );
+	const double expected3D[] = { 1, 2, 3, 11, 12, 13, 21, 22, 23 };
+	BOOST_CHECK_EQUAL_COLLECTIONS( dst.begin(), dst.begin() + 9, expected3D, expected3D + 9 );
+	BOOST_CHECK_EQUAL( dst[ 9 ], g_sentinel );
+
+	dst.assign( dst.size(), g_sentinel );
+	BOOST_CHECK_EQUAL( Facade::copyPositionList( errorList, &dst[ 0 ], 4 ), 3u );
+	for ( int i = 0; i < 3; i++ )
+	{
+		BOOST_CHECK_EQUAL( dst[ 12 * i ], 10 * i + 1 );
+		BOOST_CHECK_EQUAL( dst[ 12 * i + 2 ], 10 * i + 3 );
+		for ( int j = 0; j < 9; j++ )
+			BOOST_CHECK_EQUAL( dst[ 12 * i + 3 + j ], 100 * i + j );
+	}
+	BOOST_CHECK_EQUAL( dst[ 36 ], g_sentinel );
+}
+
+
+BOOST_AUTO_TEST_CASE( testPositionListCapacity )
+{
+	Facade::SimplePositionList3D list3D;
+	list3D.values.resize( 5 );
+	for ( int i = 0; i < 5; i++ )
+		list3D.values[ i ].x = list3D.values[ i ].y = list3D.values[ i ].z = i;
+
+	// only the first two elements fit
+	std::vector< double > dst( 3 * 5, g_sentinel );
+	BOOST_CHECK_EQUAL( Facade::copyPositionList( list3D, &dst[ 0 ], 2 ), 2u );
+	BOOST_CHECK_EQUAL( dst[ 5 ], 1.0 );
+	for ( std::size_t i = 6; i < dst.size(); i++ )
+		BOOST_CHECK_EQUAL( dst[ i ], g_sentinel );
+
+	BOOST_CHECK_EQUAL( Facade::copyPositionList( list3D, &dst[ 0 ], 0 ), 0u );
+	BOOST_CHECK_EQUAL( Facade::copyPositionList( Facade::SimplePositionList3D(), &dst[ 0 ], 5 ), 0u );
+}
+
+
+#ifdef ENABLE_BASICFACADE
+BOOST_AUTO_TEST_CASE( testPoseList )
+{
+	std::vector< std::vector< double > > poses( 3, std::vector< double >( 7, 0.0 ) );
+	for ( int i = 0; i < 3; i++ )
+	{
+		poses[ i ][ 0 ] = 10 * i + 1;
+		poses[ i ][ 1 ] = 10 * i + 2;
+		poses[ i ][ 2 ] = 10 * i + 3;
+		// unit quaternions, which survive the conversion unchanged
+		poses[ i ][ 3 + i ] = 1.0;
+	}
+	Facade::BasicPoseListMeasurement list( 1, poses );
+
+	std::vector< double > dst( 7 * 3, g_sentinel );
+	BOOST_CHECK_EQUAL( Facade::copyPoseList( list, &dst[ 0 ], 3 ), 3u );
+	for ( int i = 0; i < 3; i++ )
+		BOOST_CHECK_EQUAL_COLLECTIONS( dst.begin() + 7 * i, dst.begin() + 7 * i + 7, poses[ i ].begin(), poses[ i ].end() );
+
+	// only the first element fits
+	dst.assign( dst.size(), g_sentinel );
+	BOOST_CHECK_EQUAL( Facade::copyPoseList( list, &dst[ 0 ], 1 ), 1u );
+	BOOST_CHECK_EQUAL_COLLECTIONS( dst.begin(), dst.begin() + 7, poses[ 0 ].begin(), poses[ 0 ].end() );
+	for ( std::size_t i = 7; i < dst.size(); i++ )
+		BOOST_CHECK_EQUAL( dst[ i ], g_sentinel );
+
+	BOOST_CHECK_EQUAL( Facade::copyPoseList( Facade::BasicPoseListMeasurement(), &dst[ 0 ], 3 ), 0u );
+}
+#endif
+
+
+BOOST_AUTO_TEST_CASE( testMatrices )
+{
+	// the 3x4 matrix has named elements, e.g. e23 in row 2, column 3
+	Facade::SimpleMatrix3x4 m34 = { 11, 12, 13, 14, 21, 22, 23, 24, 31, 32, 33, 34, 0 };
+	std::vector< double > dst( 17, g_sentinel );
+	Facade::copyMatrix( m34, &dst[ 0 ] );
+	for ( int r = 0; r < 3; r++ )
+		for ( int c = 0; c < 4; c++ )
+			BOOST_CHECK_EQUAL( dst[ 4 * r + c ], 10 * ( r + 1 ) + c + 1 );
+	BOOST_CHECK_EQUAL( dst[ 12 ], g_sentinel );
+
+	Facade::SimpleMatrix3x3 m33;
+	Facade::SimpleMatrix4x4 m44;
+	for ( int i = 0; i < 16; i++ )
+	{
+		if ( i < 9 )
+			m33.values[ i ] = i;
+		m44.values[ i ] = i;
+	}
+
+	dst.assign( dst.size(), g_sentinel );
+	Facade::copyMatrix( m33, &dst[ 0 ] );
+	BOOST_CHECK_EQUAL_COLLECTIONS( dst.begin(), dst.begin() + 9, m33.values, m33.values + 9 );
+	BOOST_CHECK_EQUAL( dst[ 9 ], g_sentinel );
+
+	dst.assign( dst.size(), g_sentinel );
+	Facade::copyMatrix( m44, &dst[ 0 ] );
+	BOOST_CHECK_EQUAL_COLLECTIONS( dst.begin(), dst.begin() + 16, m44.values, m44.values + 16 );
+	BOOST_CHECK_EQUAL( dst[ 16 ], g_sentinel );
+}
+
+
+BOOST_AUTO_TEST_CASE( testImageARGB32 )
+{
+	// 2x2 RGB, 8 bits per channel, rows padded to 8 bytes
+	unsigned char pixels[] = {
+		0x11, 0x12, 0x13, 0x21, 0x22, 0x23, 0, 0,
+		0x31, 0x32, 0x33, 0x41, 0x42, 0x43, 0, 0 };
+	Facade::SimpleImage image = { 2, 2, sizeof( pixels ), 8, 8, 3, pixels, 0 };
+
+	std::vector< boost::uint32_t > texture( 6, 0xa5a5a5a5 );
+	BOOST_CHECK( Facade::copyImageARGB32( image, &texture[ 0 ], 12, 0x80, false ) );
+	BOOST_CHECK_EQUAL( texture[ 0 ], 0x80111213u );
+	BOOST_CHECK_EQUAL( texture[ 1 ], 0x80212223u );
+	BOOST_CHECK_EQUAL( texture[ 2 ], 0xa5a5a5a5u );
+	BOOST_CHECK_EQUAL( texture[ 3 ], 0x80313233u );
+	BOOST_CHECK_EQUAL( texture[ 4 ], 0x80414243u );
+
+	BOOST_CHECK( Facade::copyImageARGB32( image, &texture[ 0 ], 12, 0x80, true ) );
+	BOOST_CHECK_EQUAL( texture[ 0 ], 0x80313233u );
+	BOOST_CHECK_EQUAL( texture[ 4 ], 0x80212223u );
+
+	// a texture row smaller than an image row, 16 bits per channel and no pixels are refused
+	texture.assign( texture.size(), 0xa5a5a5a5 );
+	BOOST_CHECK( !Facade::copyImageARGB32( image, &texture[ 0 ], 7, 0x80, false ) );
+	image.depth = 16;
+	BOOST_CHECK( !Facade::copyImageARGB32( image, &texture[ 0 ], 12, 0x80, false ) );
+	image.depth = 8;
+	image.imageData = 0;
+	BOOST_CHECK( !Facade::copyImageARGB32( image, &texture[ 0 ], 12, 0x80, false ) );
+	for ( std::size_t i = 0; i < texture.size(); i++ )
+		BOOST_CHECK_EQUAL( texture[ i ], 0xa5a5a5a5u );
+}
@@ -0,0 +1,328 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @file
+ * Loopback tests of the server connection against the stand-in server: pipelined requests,
+ * pushes interleaved with pending requests, reconnecting and repeated connect calls.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include <boost/asio.hpp>
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include <utFacade/ServerConnection.h>
+
+#include "StandInServer.h"
+
+using namespace Ubitrack;
+
+
+namespace {
+
+/** maximum time to wait for the network in milliseconds */
+const long g_timeout = 5000;
+
+
+std::string request( unsigned int i )
+{
+	std::ostringstream s;
+	s << "<UTQLRequest name=\"" << i << "\"/>";
+	return s.str();
+}
+
+
+/** echoes each request, leaving the first \c nUnanswered requests unanswered */
+class EchoResponder
+{
+public:
+	EchoResponder( unsigned long nUnanswered = 0 )
+		: m_nUnanswered( nUnanswered )
+	{}
+
+	std::string operator()( const std::string& sRequest )
+	{
+		if ( m_nUnanswered.load() > 0 )
+		{
+			m_nUnanswered.fetch_sub( 1 );
+			return std::string();
+		}
+		return "<UTQLResponse>" + sRequest + "</UTQLResponse>";
+	}
+
+protected:
+	boost::atomic< unsigned long > m_nUnanswered;
+};
+
+
+/** records everything the connection reports, in the order it happened */
+class Recorder
+{
+public:
+	void receive( boost::shared_ptr< ClientServer::ClientServerConnection::BufferType > pBuffer )
+	{
+		record( "message " + std::string( pBuffer->begin(), pBuffer->end() ) );
+	}
+
+	void response( unsigned int id, const std::string& sError )
+	{
+		std::ostringstream s;
+		s << "response " << id;
+		if ( !sError.empty() )
+			s << " error " << sError;
+		record( s.str() );
+	}
+
+	void state( bool bConnected, const std::string& )
+	{
+		boost::mutex::scoped_lock l( m_mutex );
+		m_states.push_back( bConnected );
+		m_changed.notify_all();
+	}
+
+	/** waits until \c n events have been recorded */
+	bool waitEvents( std::size_t n )
+	{
+		boost::system_time deadline( boost::get_system_time() + boost::posix_time::milliseconds( g_timeout ) );
+		boost::mutex::scoped_lock l( m_mutex );
+		while ( m_events.size() < n )
+			if ( !m_changed.timed_wait( l, deadline ) )
+				return false;
+		return true;
+	}
+
+	/** waits until \c n state changes have been recorded */
+	bool waitStates( std::size_t n )
+	{
+		boost::system_time deadline( boost::get_system_time() + boost::posix_time::milliseconds( g_timeout ) );
+		boost::mutex::scoped_lock l( m_mutex );
+		while ( m_states.size() < n )
+			if ( !m_changed.timed_wait( l, deadline ) )
+				return false;
+		return true;
+	}
+
+	std::vector< std::string > events() const
+	{
+		boost::mutex::scoped_lock l( m_mutex );
+		return m_events;
+	}
+
+	std::vector< bool > states() const
+	{
+		boost::mutex::scoped_lock l( m_mutex );
+		return m_states;
+	}
+
+protected:
+	void record( const std::string& sEvent )
+	{
+		boost::mutex::scoped_lock l( m_mutex );
+		m_events.push_back( sEvent );
+		m_changed.notify_all();
+	}
+
+	std::vector< std::string > m_events;
+	std::vector< bool > m_states;
+	mutable boost::mutex m_mutex;
+	boost::condition_variable m_changed;
+};
+
+
+/** a server connection with its network thread, connected to a stand-in server */
+struct LoopbackFixture
+{
+	LoopbackFixture( unsigned long nUnanswered = 0 )
+		: responder( nUnanswered )
+		, server( boost::ref( responder ) )
+		, work( ioService )
+		, connection( ioService, boost::bind( &Recorder::receive, &recorder, _1 ) )
+	{
+		connection.setStateCallback( boost::bind( &Recorder::state, &recorder, _1, _2 ) );
+		pThread.reset( new boost::thread( boost::bind( &boost::asio::io_service::run, &ioService ) ) );
+
+		std::ostringstream port;
+		port << server.port();
+		connection.connect( "127.0.0.1", port.str() );
+	}
+
+	~LoopbackFixture()
+	{
+		// the connection requires its io_service to be stopped before it is destroyed
+		ioService.stop();
+		pThread->join();
+	}
+
+	unsigned int send( unsigned int i )
+	{
+		return connection.send( boost::shared_ptr< const std::string >( new std::string( request( i ) ) ),
+			boost::bind( &Recorder::response, &recorder, _1, _2 ) );
+	}
+
+	std::string answer( unsigned int i ) const
+	{
+		return "message <UTQLResponse>" + request( i ) + "</UTQLResponse>";
+	}
+
+	std::string response( unsigned int id ) const
+	{
+		std::ostringstream s;
+		s << "response " << id;
+		return s.str();
+	}
+
+	EchoResponder responder;
+	Testing::StandInServer server;
+	Recorder recorder;
+
+	boost::asio::io_service ioService;
+	boost::asio::io_service::work work;
+	Facade::ServerConnection connection;
+	boost::scoped_ptr< boost::thread > pThread;
+};
+
+
+/** fixture whose server leaves the first request unanswered */
+struct UnansweredRequestFixture
+	: public LoopbackFixture
+{
+	UnansweredRequestFixture()
+		: LoopbackFixture( 1 )
+	{}
+};
+
+} // anonymous namespace
+
+
+BOOST_FIXTURE_TEST_CASE( testPipelinedRequests, LoopbackFixture )
+{
+	const unsigned int nRequests = 50;
+
+	// queued before the connection is up and sent without waiting for responses
+	std::vector< unsigned int > ids;
+	for ( unsigned int i = 0; i < nRequests; i++ )
+		ids.push_back( send( i ) );
+
+	BOOST_REQUIRE( recorder.waitEvents( 2 * nRequests ) );
+
+	// each answer is matched to its request in order and reported before the next one arrives
+	std::vector< std::string > events( recorder.events() );
+	for ( unsigned int i = 0; i < nRequests; i++ )
+	{
+		BOOST_CHECK_EQUAL( events[ 2 * i ], answer( i ) );
+		BOOST_CHECK_EQUAL( events[ 2 * i + 1 ], response( ids[ i ] ) );
+	}
+
+	BOOST_CHECK_EQUAL( connection.pendingRequests(), 0u );
+	BOOST_CHECK_EQUAL( server.requestCount(), nRequests );
+}
+
+
+BOOST_FIXTURE_TEST_CASE( testPushDoesNotCompleteRequest, LoopbackFixture )
+{
+	const std::string sPush( "<UTQLResponse><Pattern name=\"pushed\"/></UTQLResponse>" );
+	server.pushBeforeNextAnswer( sPush );
+
+	unsigned int first = send( 0 );
+	BOOST_REQUIRE( recorder.waitEvents( 3 ) );
+	unsigned int second = send( 1 );
+	BOOST_REQUIRE( recorder.waitEvents( 5 ) );
+
+	// the push arrives while the request is pending but only the answer completes it
+	std::vector< std::string > events( recorder.events() );
+	BOOST_CHECK_EQUAL( events[ 0 ], "message <UTQLResponse type=\"push\"><Pattern name=\"pushed\"/></UTQLResponse>" );
+	BOOST_CHECK_EQUAL( events[ 1 ], answer( 0 ) );
+	BOOST_CHECK_EQUAL( events[ 2 ], response( first ) );
+	BOOST_CHECK_EQUAL( events[ 3 ], answer( 1 ) );
+	BOOST_CHECK_EQUAL( events[ 4 ], response( second ) );
+}
+
+
+BOOST_FIXTURE_TEST_CASE( testReconnectResendsUnansweredRequest, UnansweredRequestFixture )
+{
+	unsigned int id = send( 0 );
+
+	// the server has received the request but not answered it
+	std::string sError;
+	BOOST_REQUIRE( connection.waitConnected( g_timeout, sError ) );
+	boost::system_time deadline( boost::get_system_time() + boost::posix_time::milliseconds( g_timeout ) );
+	while ( server.requestCount() == 0 && boost::get_system_time() < deadline )
+		boost::this_thread::sleep( boost::posix_time::milliseconds( 1 ) );
+	BOOST_REQUIRE_EQUAL( server.requestCount(), 1u );
+	BOOST_CHECK_EQUAL( connection.pendingRequests(), 1u );
+
+	server.dropConnections();
+
+	// after reconnecting, the request is sent again and answered exactly once
+	BOOST_REQUIRE( recorder.waitEvents( 2 ) );
+	std::vector< std::string > events( recorder.events() );
+	BOOST_CHECK_EQUAL( events[ 0 ], answer( 0 ) );
+	BOOST_CHECK_EQUAL( events[ 1 ], response( id ) );
+	BOOST_CHECK_EQUAL( server.requestCount(), 2u );
+	BOOST_CHECK_EQUAL( connection.pendingRequests(), 0u );
+
+	BOOST_REQUIRE( recorder.waitStates( 3 ) );
+	std::vector< bool > states( recorder.states() );
+	BOOST_CHECK( states[ 0 ] );
+	BOOST_CHECK( !states[ 1 ] );
+	BOOST_CHECK( states[ 2 ] );
+
+	// requests sent after reconnecting are matched as usual
+	unsigned int next = send( 1 );
+	BOOST_REQUIRE( recorder.waitEvents( 4 ) );
+	events = recorder.events();
+	BOOST_CHECK_EQUAL( events[ 2 ], answer( 1 ) );
+	BOOST_CHECK_EQUAL( events[ 3 ], response( next ) );
+}
+
+
+BOOST_FIXTURE_TEST_CASE( testConnectAgainIgnoresPreviousConnection, LoopbackFixture )
+{
+	std::string sError;
+	BOOST_REQUIRE( connection.waitConnected( g_timeout, sError ) );
+
+	// a port nobody listens on anymore
+	unsigned short closedPort;
+	{
+		EchoResponder responder;
+		Testing::StandInServer closedServer( boost::ref( responder ) );
+		closedPort = closedServer.port();
+	}
+	std::ostringstream port;
+	port << closedPort;
+
+	// the connection that is still up must not count for the new connect call
+	connection.connect( "127.0.0.1", port.str(), false );
+	BOOST_CHECK( !connection.waitConnected( g_timeout, sError ) );
+	BOOST_CHECK( !sError.empty() );
+	BOOST_CHECK( !connection.isConnected() );
+}
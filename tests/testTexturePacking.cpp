@@ -0,0 +1,176 @@
+/*
+ * Ubitrack - Library for Ubiquitous Tracking
+ * Copyright 2006, Technische Universitaet Muenchen, and individual
+ * contributors as indicated by the @authors tag. See the
+ * copyright.txt in the distribution for a full listing of individual
+ * contributors.
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA, or see the FSF site: http://www.fsf.org.
+ */
+
+/**
+ * @file
+ * Compares the vector kernels of the ARGB32 texture packing with the scalar ones for every
+ * pixel format, including odd widths that leave remainders, and flipped output.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <boost/cstdint.hpp>
+
+#include <utFacade/TexturePacking.h>
+
+using namespace Ubitrack;
+
+
+namespace {
+
+/** padding after each row, must stay untouched */
+const std::size_t g_padding = 12;
+
+/** bytes per pixel of a \c TexturePixelFormat */
+int bytesPerPixel( int format )
+{
+	switch ( format )
+	{
+	case Facade::TEXTURE_LUMINANCE: return 1;
+	case Facade::TEXTURE_RGB: case Facade::TEXTURE_BGR: return 3;
+	case Facade::TEXTURE_YUV422: return 2;
+	default: return 4;
+	}
+}
+
+
+/** a source image with random pixels and a texture prefilled with a marker */
+struct PackingCase
+{
+	PackingCase( int format, int width, int height )
+		: format( format )
+		, width( width )
+		, height( height )
+		// YUYV rows hold whole pixel pairs
+		, srcStride( ( width + 1 ) / 2 * 2 * bytesPerPixel( format ) + g_padding )
+		, dstStride( 4 * width + g_padding )
+		, src( srcStride * height )
+	{
+		for ( std::size_t i = 0; i < src.size(); i++ )
+			src[ i ] = static_cast< unsigned char >( std::rand() );
+	}
+
+	/** packs with the given kernels, without the thread pool */
+	std::vector< unsigned char > pack( const char* sKernel, bool bFlip ) const
+	{
+		std::vector< unsigned char > dst( dstStride * height, 0xa5 );
+		BOOST_REQUIRE( Facade::setTexturePackingKernel( sKernel ) );
+		BOOST_REQUIRE( Facade::packARGB32( &src[ 0 ], srcStride, width, height, format, 8,
+			&dst[ 0 ], dstStride, 0x80, bFlip, false ) );
+		return dst;
+	}
+
+	int format;
+	int width;
+	int height;
+	std::size_t srcStride;
+	std::size_t dstStride;
+	std::vector< unsigned char > src;
+};
+
+
+/** restores the best kernels after each test */
+struct KernelFixture
+{
+	~KernelFixture()
+	{ Facade::setTexturePackingKernel( 0 ); }
+};
+
+} // anonymous namespace
+
+
+BOOST_FIXTURE_TEST_CASE( testScalarPacking, KernelFixture )
+{
+	// one RGB pixel and one BGRA pixel, packed to 0xAARRGGBB
+	const unsigned char rgb[ 3 ] = { 0x11, 0x22, 0x33 };
+	const unsigned char bgra[ 4 ] = { 0x33, 0x22, 0x11, 0x44 };
+	boost::uint32_t texel = 0;
+
+	BOOST_REQUIRE( Facade::setTexturePackingKernel( "scalar" ) );
+	BOOST_CHECK( Facade::packARGB32( rgb, 3, 1, 1, Facade::TEXTURE_RGB, 8, &texel, 4, 0x80, false, false ) );
+	BOOST_CHECK_EQUAL( texel, 0x80112233u );
+	BOOST_CHECK( Facade::packARGB32( bgra, 4, 1, 1, Facade::TEXTURE_BGRA, 8, &texel, 4, 0x80, false, false ) );
+	BOOST_CHECK_EQUAL( texel, 0x44112233u );
+}
+
+
+BOOST_FIXTURE_TEST_CASE( testVectorKernelsMatchScalar, KernelFixture )
+{
+	const char* kernels[] = { "ssse3", "avx2" };
+	const int widths[] = { 1, 2, 3, 5, 7, 8, 15, 16, 17, 31, 32, 33, 47, 63, 64, 65, 100, 257 };
+	const int height = 5;
+
+	std::srand( 42 );
+	for ( unsigned int k = 0; k < sizeof( kernels ) / sizeof( kernels[ 0 ] ); k++ )
+	{
+		if ( !Facade::setTexturePackingKernel( kernels[ k ] ) )
+		{
+			BOOST_TEST_MESSAGE( "Kernels " << kernels[ k ] << " not supported, skipped" );
+			continue;
+		}
+
+		for ( int format = Facade::TEXTURE_LUMINANCE; format <= Facade::TEXTURE_YUV422; format++ )
+			for ( unsigned int w = 0; w < sizeof( widths ) / sizeof( widths[ 0 ] ); w++ )
+				for ( int flip = 0; flip < 2; flip++ )
+				{
+					PackingCase packing( format, widths[ w ], height );
+					std::vector< unsigned char > expected( packing.pack( "scalar", flip != 0 ) );
+					std::vector< unsigned char > actual( packing.pack( kernels[ k ], flip != 0 ) );
+
+					BOOST_CHECK_MESSAGE( expected == actual, kernels[ k ] << " differs from scalar for format " << format
+						<< ", width " << widths[ w ] << ( flip ? ", flipped" : "" ) );
+
+					// the kernels must not write past the end of a row
+					for ( int i = 0; i < height; i++ )
+						for ( std::size_t j = 4 * widths[ w ]; j < packing.dstStride; j++ )
+							BOOST_REQUIRE_EQUAL( actual[ i * packing.dstStride + j ], 0xa5 );
+				}
+	}
+}
+
+
+BOOST_FIXTURE_TEST_CASE( testFlippedRows, KernelFixture )
+{
+	PackingCase packing( Facade::TEXTURE_RGB, 17, 4 );
+	std::vector< unsigned char > upright( packing.pack( "scalar", false ) );
+	std::vector< unsigned char > flipped( packing.pack( "scalar", true ) );
+
+	for ( int i = 0; i < packing.height; i++ )
+		BOOST_CHECK( !std::memcmp( &upright[ i * packing.dstStride ], 
+			&flipped[ ( packing.height - 1 - i ) * packing.dstStride ], 4 * packing.width ) );
+}
+
+
+BOOST_AUTO_TEST_CASE( testUnsupportedSources )
+{
+	std::vector< unsigned char > src( 4 * 16 * 2 );
+	std::vector< boost::uint32_t > dst( 16 );
+
+	// 16 bits per channel and unknown pixel formats
+	BOOST_CHECK( !Facade::packARGB32( &src[ 0 ], 4 * 16 * 2, 16, 1, Facade::TEXTURE_RGBA, 16, &dst[ 0 ], 4 * 16, 255, false ) );
+	BOOST_CHECK( !Facade::packARGB32( &src[ 0 ], 4 * 16, 16, 1, 0, 8, &dst[ 0 ], 4 * 16, 255, false ) );
+	BOOST_CHECK( !Facade::packARGB32( &src[ 0 ], 4 * 16, 16, 1, Facade::TEXTURE_YUV422 + 1, 8, &dst[ 0 ], 4 * 16, 255, false ) );
+}